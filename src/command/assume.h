@@ -38,6 +38,9 @@ public:
   /** Get the query */
   const system::state_formula* get_assumption() const { return d_assumption_state; }
 
+  /** Get the transition assumption (null if a state assumption) */
+  const system::transition_formula* get_transition_assumption() const { return d_assumption_transition; }
+
   /** Run the command on an engine */
   void run(system::context* ctx, engine* e);
 
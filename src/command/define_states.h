@@ -24,6 +24,9 @@ public:
   /** Deletes the formula if not used */
   ~define_states();
 
+  /** Get the id of the formula */
+  std::string get_id() const { return d_id; }
+
   /** Get the state formula */
   const system::state_formula* get_state_formula() const { return d_formula; }
 
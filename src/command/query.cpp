@@ -1,6 +1,7 @@
 #include "query.h"
 
 #include <iostream>
+#include <fstream>
 
 namespace sally {
 namespace cmd {
@@ -27,6 +28,33 @@ void query::to_stream(std::ostream& out) const  {
   out << "]";
 }
 
+void query::show_trace(system::context* ctx, const system::trace_helper* trace) const {
+  const options& opts = ctx->get_options();
+  system::trace_format format = system::TRACE_FULL;
+  if (opts.has_option("trace-format")) {
+    format = system::trace_writer::format_from_string(opts.get_string("trace-format"));
+  }
+  if (opts.has_option("trace-file")) {
+    // Traces of one run go into the same file, one after the other
+    static bool truncate = true;
+    std::ios_base::openmode mode = std::ios_base::out | std::ios_base::binary;
+    mode |= truncate ? std::ios_base::trunc : std::ios_base::app;
+    truncate = false;
+    std::ofstream out(opts.get_string("trace-file").c_str(), mode);
+    if (!out) {
+      throw exception("Can't open trace file ") << opts.get_string("trace-file");
+    }
+    out.copyfmt(std::cout);
+    trace->to_stream(out, format);
+    if (format != system::TRACE_BINARY) {
+      out << std::endl;
+    }
+  } else {
+    trace->to_stream(std::cout, format);
+    std::cout << std::endl;
+  }
+}
+
 void query::run(system::context* ctx, engine* e) {
   // If in parse only mode, we're done
   if (ctx->get_options().has_option("parse-only")) { return; }
@@ -44,7 +72,7 @@ void query::run(system::context* ctx, engine* e) {
     // If invalid, and asked to, show the trace
     if ((result == engine::INVALID || result == engine::SILENT_WITH_TRACE) && ctx->get_options().has_option("show-trace")) {
       const system::trace_helper* trace = e->get_trace();
-      std::cout << *trace << std::endl;
+      show_trace(ctx, trace);
     }
     // If valid, and asked to, show the invariant
     if (result == engine::VALID && ctx->get_options().has_option("show-invariant")) {
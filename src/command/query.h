@@ -4,6 +4,7 @@
 
 #include "system/context.h"
 #include "system/state_formula.h"
+#include "system/trace_helper.h"
 
 #include <vector>
 
@@ -19,6 +20,9 @@ class query : public command {
   /** The formulas to query */
   std::vector<system::state_formula*> d_queries;
 
+  /** Output the trace as asked by the options (trace-format, trace-file) */
+  void show_trace(system::context* ctx, const system::trace_helper* trace) const;
+
 public:
 
   /** Query takes over the state formula */
@@ -33,6 +37,9 @@ public:
   /** Get the id of the system */
   std::string get_system_id() const { return d_system_id; }
 
+  /** Get the formulas to query */
+  const std::vector<system::state_formula*>& get_queries() const { return d_queries; }
+
   /** Run the command on an engine */
   void run(system::context* ctx, engine* e);
 
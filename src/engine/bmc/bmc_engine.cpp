@@ -17,6 +17,7 @@
  */
 
 #include "engine/bmc/bmc_engine.h"
+#include "engine/checkpoint.h"
 
 #include "smt/factory.h"
 #include "utils/trace.h"
@@ -37,6 +38,8 @@ bmc_engine::~bmc_engine() {}
 
 engine::result bmc_engine::query(const system::transition_system* ts, const system::state_formula* sf) {
 
+  smt::query_site site("bmc::query");
+
   // Make the solver
   smt::solver::ref d_solver(smt::factory::mk_default_solver(tm(), ctx().get_options(), ctx().get_statistics()));
 
@@ -63,11 +66,22 @@ engine::result bmc_engine::query(const system::transition_system* ts, const syst
   // Did we get an unknown result
   bool unknown = false;
 
+  // Checkpoints, and the bound to resume from (smaller bounds are done)
+  checkpoint_timer checkpoints(ctx());
+  size_t bmc_resume = 0;
+  checkpoint_reader* checkpoint = checkpoint_reader::open(ctx(), "bmc", ts, sf);
+  if (checkpoint) {
+    bmc_resume = checkpoint->read_uint();
+    unknown = checkpoint->read_uint();
+    delete checkpoint;
+    MSG(1) << "BMC: resuming at " << bmc_resume << std::endl;
+  }
+
   // BMC loop
   for (size_t k = 0; k <= bmc_max; ++ k) {
   
     // Check the current unrolling
-    if (k >= bmc_min) {
+    if (k >= bmc_min && k >= bmc_resume) {
 
       MSG(1) << "BMC: checking " << k << std::endl;
 
@@ -127,6 +141,15 @@ engine::result bmc_engine::query(const system::transition_system* ts, const syst
     d_solver->add_variables(input_vars.begin(), input_vars.end(), smt::solver::CLASS_A);
     // Unroll once more
     d_solver->add(d_trace->get_transition_formula(transition_formula, k), smt::solver::CLASS_A);
+
+    // Save the bound (done with k)
+    if (checkpoints.due()) {
+      MSG(1) << "BMC: saving checkpoint at " << k + 1 << std::endl;
+      checkpoint_writer checkpoint(ctx(), "bmc", ts, sf);
+      checkpoint.write_uint(k + 1);
+      checkpoint.write_uint(unknown);
+      checkpoint.save(checkpoints.get_filename());
+    }
   }
 
   d_last_result = UNKNOWN;
@@ -134,6 +157,12 @@ engine::result bmc_engine::query(const system::transition_system* ts, const syst
   return UNKNOWN;
 }
 
+void bmc_engine::memory_usage(utils::memory_report& report) const {
+  if (d_trace) {
+    d_trace->memory_usage(report);
+  }
+}
+
 const system::trace_helper* bmc_engine::get_trace() {
   return d_trace;
 }
@@ -53,6 +53,9 @@ public:
 
   /** Nothing to collect */
   void gc_collect(const expr::gc_relocator& gc_reloc) {}
+
+  /** The trace (solvers only live during the query) */
+  void memory_usage(utils::memory_report& report) const;
 };
 
 }
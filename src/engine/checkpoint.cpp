@@ -0,0 +1,191 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "engine/checkpoint.h"
+#include "utils/trace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace sally {
+
+/** The magic at the start of the checkpoint */
+static const char checkpoint_magic[8] = { 'S', 'A', 'L', 'L', 'Y', 'C', 'K', 'P' };
+
+/** The version of the format, change when the format or the term ops change */
+static const uint64_t checkpoint_version = 1;
+
+/** The variable classes of state types, in the order they are indexed */
+static const system::state_type::var_class checkpoint_var_classes[3] = {
+  system::state_type::STATE_CURRENT,
+  system::state_type::STATE_INPUT,
+  system::state_type::STATE_NEXT
+};
+
+checkpoint_writer::checkpoint_writer(const system::context& ctx, std::string engine_id, const system::transition_system* ts, const system::state_formula* sf)
+: d_terms(ctx.tm())
+{
+  const system::state_type* st = ts->get_state_type();
+  expr::write_string(d_header, engine_id);
+  // Names of the current and input variables, all variables are indexed
+  for (size_t i = 0; i < 3; ++ i) {
+    const std::vector<expr::term_ref>& vars = st->get_variables(checkpoint_var_classes[i]);
+    if (checkpoint_var_classes[i] != system::state_type::STATE_NEXT) {
+      expr::write_uint(d_header, vars.size());
+      for (size_t j = 0; j < vars.size(); ++ j) {
+        expr::write_string(d_header, ctx.tm().get_variable_name(vars[j]));
+      }
+    }
+    for (size_t j = 0; j < vars.size(); ++ j) {
+      d_terms.index_term(vars[j]);
+    }
+  }
+  // The property is the first field
+  write_term(sf->get_formula());
+}
+
+void checkpoint_writer::write_uint(uint64_t value) {
+  expr::write_uint(d_fields, value);
+}
+
+void checkpoint_writer::write_double(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  expr::write_uint(d_fields, bits);
+}
+
+void checkpoint_writer::write_term(expr::term_ref t) {
+  expr::write_uint(d_fields, d_terms.add_term(t));
+}
+
+void checkpoint_writer::save(std::string filename) {
+  std::string out(checkpoint_magic, sizeof(checkpoint_magic));
+  expr::write_uint(out, checkpoint_version);
+  out.append(d_header);
+  d_terms.write_records(out);
+  out.append(d_fields);
+
+  // Write aside and rename, so that a checkpoint is never half written
+  std::string tmp = filename + ".tmp";
+  std::ofstream file(tmp.c_str(), std::ios::binary);
+  file.write(out.data(), out.size());
+  file.close();
+  if (!file || std::rename(tmp.c_str(), filename.c_str()) != 0) {
+    throw exception("can't write checkpoint ") << filename;
+  }
+}
+
+void checkpoint_reader::reader::error(const char* msg) const {
+  throw exception("checkpoint ") << d_filename << ": " << msg;
+}
+
+checkpoint_reader::checkpoint_reader(const system::context& ctx, std::string filename, const system::transition_system* ts)
+: d_file(filename)
+, d_reader(ctx.tm(), filename)
+{
+  if (d_file.size() < sizeof(checkpoint_magic) || memcmp(d_file.begin(), checkpoint_magic, sizeof(checkpoint_magic)) != 0) {
+    throw exception("not a checkpoint: ") << filename;
+  }
+  d_reader.set_input(d_file.begin() + sizeof(checkpoint_magic), d_file.end());
+  if (d_reader.read_uint() != checkpoint_version) {
+    throw exception("unsupported checkpoint version: ") << filename;
+  }
+  d_engine_id = d_reader.read_string();
+
+  // The variables must match the system
+  const system::state_type* st = ts->get_state_type();
+  for (size_t i = 0; i < 3; ++ i) {
+    const std::vector<expr::term_ref>& vars = st->get_variables(checkpoint_var_classes[i]);
+    if (checkpoint_var_classes[i] != system::state_type::STATE_NEXT) {
+      bool match = d_reader.read_uint() == vars.size();
+      for (size_t j = 0; match && j < vars.size(); ++ j) {
+        match = d_reader.read_string() == ctx.tm().get_variable_name(vars[j]);
+      }
+      if (!match) {
+        throw exception("checkpoint ") << filename << " is for a different system";
+      }
+    }
+    for (size_t j = 0; j < vars.size(); ++ j) {
+      d_reader.index_term(vars[j]);
+    }
+  }
+
+  d_reader.read_records();
+  d_property = d_reader.read_term();
+}
+
+uint64_t checkpoint_reader::read_uint() {
+  return d_reader.read_uint();
+}
+
+double checkpoint_reader::read_double() {
+  uint64_t bits = d_reader.read_uint();
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+expr::term_ref checkpoint_reader::read_term() {
+  return d_reader.read_term();
+}
+
+checkpoint_reader* checkpoint_reader::open(const system::context& ctx, std::string engine_id, const system::transition_system* ts, const system::state_formula* sf) {
+  const options& opts = ctx.get_options();
+  if (!opts.has_option("resume")) {
+    return 0;
+  }
+  checkpoint_reader* checkpoint = new checkpoint_reader(ctx, opts.get_string("resume"), ts);
+  if (checkpoint->get_engine_id() != engine_id) {
+    std::string id = checkpoint->get_engine_id();
+    delete checkpoint;
+    throw exception("checkpoint was made by engine ") << id << ", can't resume with " << engine_id;
+  }
+  if (checkpoint->get_property() != sf->get_formula()) {
+    MSG(1) << "checkpoint is for another query, starting over" << std::endl;
+    delete checkpoint;
+    return 0;
+  }
+  MSG(1) << "resuming from checkpoint " << opts.get_string("resume") << std::endl;
+  return checkpoint;
+}
+
+checkpoint_timer::checkpoint_timer(const system::context& ctx)
+: d_interval(0)
+, d_last(std::chrono::steady_clock::now())
+{
+  const options& opts = ctx.get_options();
+  if (opts.has_option("checkpoint")) {
+    d_filename = opts.get_string("checkpoint");
+    d_interval = opts.get_double("checkpoint-interval");
+  }
+}
+
+bool checkpoint_timer::due() {
+  if (!enabled()) {
+    return false;
+  }
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (std::chrono::duration<double>(now - d_last).count() < d_interval) {
+    return false;
+  }
+  d_last = now;
+  return true;
+}
+
+}
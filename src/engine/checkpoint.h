@@ -0,0 +1,159 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "expr/term_io.h"
+#include "system/context.h"
+#include "system/transition_system.h"
+#include "system/state_formula.h"
+#include "utils/mapped_file.h"
+
+#include <chrono>
+#include <string>
+
+namespace sally {
+
+/**
+ * Writes a checkpoint of an engine working on a query, so that a later run
+ * can continue the search (option --resume). The engine writes the fields
+ * it needs to continue (numbers and terms, e.g. frames and bounds), and the
+ * solvers are rebuilt from them when resuming. The terms are written as by
+ * expr::term_writer, before the fields. The variables of the state type are
+ * indexed and not written, so a checkpoint is loaded over the same system
+ * parsed again. The header has the engine, the names of the state type
+ * variables and the property of the query, so that a checkpoint is only
+ * used for the same query with the same engine.
+ */
+class checkpoint_writer {
+
+  /** The terms */
+  expr::term_writer d_terms;
+
+  /** The header (engine, variables, property) */
+  std::string d_header;
+
+  /** The fields */
+  std::string d_fields;
+
+public:
+
+  /** Start a checkpoint of the engine for the query */
+  checkpoint_writer(const system::context& ctx, std::string engine_id, const system::transition_system* ts, const system::state_formula* sf);
+
+  /** Write a number */
+  void write_uint(uint64_t value);
+
+  /** Write a double */
+  void write_double(double value);
+
+  /** Write a term */
+  void write_term(expr::term_ref t);
+
+  /** Save the checkpoint to the file (replaces the file only when fully written) */
+  void save(std::string filename);
+};
+
+/**
+ * Reads a checkpoint written by checkpoint_writer. The fields must be read
+ * in the order they were written. The reader keeps the terms alive, so the
+ * engine should take them before garbage collection.
+ */
+class checkpoint_reader {
+
+  /** The checkpoint */
+  utils::mapped_file d_file;
+
+  /** Reads the terms and the fields, errors are reported for the checkpoint */
+  class reader : public expr::term_reader {
+    std::string d_filename;
+  protected:
+    void error(const char* msg) const;
+  public:
+    reader(expr::term_manager& tm, std::string filename)
+    : term_reader(tm), d_filename(filename) {}
+  };
+
+  /** The terms, and the reader of the fields */
+  reader d_reader;
+
+  /** The engine that made the checkpoint */
+  std::string d_engine_id;
+
+  /** The property of the query */
+  expr::term_ref d_property;
+
+public:
+
+  /** Load the checkpoint of a query on the system */
+  checkpoint_reader(const system::context& ctx, std::string filename, const system::transition_system* ts);
+
+  /** The engine that made the checkpoint */
+  const std::string& get_engine_id() const { return d_engine_id; }
+
+  /** The property of the query */
+  expr::term_ref get_property() const { return d_property; }
+
+  /** Read a number */
+  uint64_t read_uint();
+
+  /** Read a double */
+  double read_double();
+
+  /** Read a term */
+  expr::term_ref read_term();
+
+  /**
+   * Open the checkpoint given with --resume, if any, for the engine working
+   * on the query. Returns null if there is no checkpoint or if it is for
+   * another query. Throws if the checkpoint is from another engine.
+   */
+  static checkpoint_reader* open(const system::context& ctx, std::string engine_id, const system::transition_system* ts, const system::state_formula* sf);
+};
+
+/**
+ * Decides when to save the checkpoints, from the options --checkpoint (the
+ * file) and --checkpoint-interval. Engines ask at the points where they can
+ * save (e.g. when a frame or a bound is done).
+ */
+class checkpoint_timer {
+
+  /** The file, empty if no checkpoints */
+  std::string d_filename;
+
+  /** Interval between the checkpoints (in seconds) */
+  double d_interval;
+
+  /** Time of the last checkpoint */
+  std::chrono::steady_clock::time_point d_last;
+
+public:
+
+  checkpoint_timer(const system::context& ctx);
+
+  /** Are checkpoints enabled */
+  bool enabled() const { return !d_filename.empty(); }
+
+  /** Is a checkpoint due (then the interval starts over) */
+  bool due();
+
+  /** The file of the checkpoints */
+  const std::string& get_filename() const { return d_filename; }
+};
+
+}
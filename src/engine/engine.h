@@ -98,6 +98,10 @@ public:
   /** Get the result of the last query */
   std::string get_last_result_string() const { return result_to_string(d_last_result); }
 
+  /** Add the memory of the engine (trace, solvers) to the report */
+  virtual
+  void memory_usage(utils::memory_report& report) const {}
+
 };
 
 std::ostream& operator << (std::ostream& out, engine::result result);
@@ -17,6 +17,7 @@
  */
 
 #include "engine/kind/kind_engine.h"
+#include "engine/checkpoint.h"
 
 #include "smt/factory.h"
 #include "utils/trace.h"
@@ -93,6 +94,16 @@ engine::result kind_engine::query(const system::transition_system* ts, const sys
   unsigned kind_min = ctx().get_options().get_unsigned("kind-min");
   unsigned kind_max = ctx().get_options().get_unsigned("kind-max");
 
+  // Checkpoints, and the step to resume from (both checks are done before it)
+  checkpoint_timer checkpoints(ctx());
+  unsigned kind_resume = 0;
+  checkpoint_reader* checkpoint = checkpoint_reader::open(ctx(), "kind", ts, sf);
+  if (checkpoint) {
+    kind_resume = checkpoint->read_uint();
+    delete checkpoint;
+    MSG(1) << "K-Induction: resuming at " << kind_resume << std::endl;
+  }
+
   // Induction loop
   unsigned k = 0;
   while (true) {
@@ -103,37 +114,44 @@ engine::result kind_engine::query(const system::transition_system* ts, const sys
       return UNKNOWN;
     }
 
-    MSG(1) << "K-Induction: checking initialization " << k << std::endl;
+    // Is this step done already
+    bool resumed = k < kind_resume;
 
     // Check the current unrolling (1)
-    solver1->push();
-    solver1->add(property_not_k, smt::solver::CLASS_A);
-    smt::solver::result r_1 = solver1->check();
-
-    MSG(1) << "K-Induction: got " << r_1 << std::endl;
-
-    // See what happened
-    switch(r_1) {
-    case smt::solver::SAT: {
-      // Get the model
-      expr::model::ref m = solver1->get_model();
-      // Add model to trace
-      d_trace->set_model(m,0, k);
-      d_last_result = INVALID;
-      return INVALID;
-    }
-    case smt::solver::UNKNOWN:
-      d_last_result = UNKNOWN;
-      return UNKNOWN;
-    case smt::solver::UNSAT:
-      // No counterexample found, continue
-      break;
-    default:
-      assert(false);
-    }
+    if (!resumed) {
+
+      MSG(1) << "K-Induction: checking initialization " << k << std::endl;
 
-    // Pop the solver
-    solver1->pop();
+      smt::query_site base_site("kind::base");
+      solver1->push();
+      solver1->add(property_not_k, smt::solver::CLASS_A);
+      smt::solver::result r_1 = solver1->check();
+
+      MSG(1) << "K-Induction: got " << r_1 << std::endl;
+
+      // See what happened
+      switch(r_1) {
+      case smt::solver::SAT: {
+        // Get the model
+        expr::model::ref m = solver1->get_model();
+        // Add model to trace
+        d_trace->set_model(m,0, k);
+        d_last_result = INVALID;
+        return INVALID;
+      }
+      case smt::solver::UNKNOWN:
+        d_last_result = UNKNOWN;
+        return UNKNOWN;
+      case smt::solver::UNSAT:
+        // No counterexample found, continue
+        break;
+      default:
+        assert(false);
+      }
+
+      // Pop the solver
+      solver1->pop();
+    }
 
     // Variables of the transition
     solver2->add_variables(d_trace->get_input_variables(k), smt::solver::CLASS_A);
@@ -151,7 +169,7 @@ engine::result kind_engine::query(const system::transition_system* ts, const sys
     solver2->add(transition_k, smt::solver::CLASS_A);
 
     // Should we do the check at k
-    bool check_consecution = k >= kind_min;
+    bool check_consecution = k >= kind_min && !resumed;
     if (check_consecution) {
       MSG(1) << "K-Induction: checking consecution " << k << std::endl;
     }
@@ -163,6 +181,7 @@ engine::result kind_engine::query(const system::transition_system* ts, const sys
 
     // Check the current unrolling (2)
     if (check_consecution) {
+      smt::query_site step_site("kind::step");
       solver2->push();
       solver2->add(property_not_k, smt::solver::CLASS_A);
       smt::solver::result r_2 = solver2->check_relaxed();
@@ -191,6 +210,14 @@ engine::result kind_engine::query(const system::transition_system* ts, const sys
 
     // One more transition for solver 1
     solver1->add(transition_k, smt::solver::CLASS_A);
+
+    // Save the step (done with both checks)
+    if (checkpoints.due()) {
+      MSG(1) << "K-Induction: saving checkpoint at " << k << std::endl;
+      checkpoint_writer checkpoint(ctx(), "kind", ts, sf);
+      checkpoint.write_uint(k);
+      checkpoint.save(checkpoints.get_filename());
+    }
   }
 
   d_last_result = UNKNOWN;
@@ -198,6 +225,12 @@ engine::result kind_engine::query(const system::transition_system* ts, const sys
   return UNKNOWN;
 }
 
+void kind_engine::memory_usage(utils::memory_report& report) const {
+  if (d_trace) {
+    d_trace->memory_usage(report);
+  }
+}
+
 const system::trace_helper* kind_engine::get_trace() {
   return d_trace;
 }
@@ -17,6 +17,7 @@
  */
 
 #include "cex_manager.h"
+#include "engine/checkpoint.h"
 
 #include <iostream>
 #include <limits>
@@ -60,6 +61,46 @@ void cex_manager::mark_root(expr::term_ref A, size_t property_id) {
   d_roots.push_back(cex_root(A, property_id));
 }
 
+void cex_manager::save(checkpoint_writer& out) const {
+  out.write_uint(d_cex_graph.size());
+  cex_graph::const_iterator it = d_cex_graph.begin();
+  for (; it != d_cex_graph.end(); ++ it) {
+    out.write_term(it->first);
+    out.write_uint(it->second.size());
+    edge_list::const_iterator edge = it->second.begin();
+    for (; edge != it->second.end(); ++ edge) {
+      out.write_term(edge->B);
+      out.write_uint(edge->edge_length);
+      out.write_uint(edge->property_id);
+    }
+  }
+  out.write_uint(d_roots.size());
+  for (size_t i = 0; i < d_roots.size(); ++ i) {
+    out.write_term(d_roots[i].A);
+    out.write_uint(d_roots[i].property_id);
+  }
+}
+
+void cex_manager::load(checkpoint_reader& in) {
+  size_t nodes = in.read_uint();
+  for (size_t i = 0; i < nodes; ++ i) {
+    edge_list& edges = d_cex_graph[in.read_term()];
+    size_t size = in.read_uint();
+    for (size_t j = 0; j < size; ++ j) {
+      expr::term_ref B = in.read_term();
+      size_t edge_length = in.read_uint();
+      size_t property_id = in.read_uint();
+      edges.push_back(cex_edge(B, edge_length, property_id));
+    }
+  }
+  size_t roots = in.read_uint();
+  for (size_t i = 0; i < roots; ++ i) {
+    expr::term_ref A = in.read_term();
+    size_t property_id = in.read_uint();
+    d_roots.push_back(cex_root(A, property_id));
+  }
+}
+
 const size_t infty = -1;
 
 /** Comparison for Dijkstra, comapre based on shortest paths */
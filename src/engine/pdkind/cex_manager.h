@@ -26,6 +26,10 @@
 #include <iosfwd>
 
 namespace sally {
+
+class checkpoint_writer;
+class checkpoint_reader;
+
 namespace pdkind {
 
 /**
@@ -111,6 +115,12 @@ public:
   /** Print to stream */
   void to_stream(std::ostream& out) const;
 
+  /** Save the graph and the roots to the checkpoint */
+  void save(checkpoint_writer& out) const;
+
+  /** Load the graph and the roots from the checkpoint (the manager must be empty) */
+  void load(checkpoint_reader& in);
+
 };
 
 std::ostream& operator << (std::ostream& out, const cex_manager& cm);
@@ -0,0 +1,372 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "engine/pdkind/minimizer.h"
+
+#include "smt/factory.h"
+#include "utils/trace.h"
+
+#include <algorithm>
+#include <boost/thread.hpp>
+
+namespace sally {
+namespace pdkind {
+
+minimizer::minimizer(const system::context& ctx)
+: d_ctx(ctx)
+, d_tm(ctx.tm())
+, d_checks(0)
+{
+  d_stats.minimizations = static_cast<utils::stat_int*>(ctx.get_statistics().register_stat("pdkind::minimizations"));
+  d_stats.checks = static_cast<utils::stat_int*>(ctx.get_statistics().register_stat("pdkind::minimization_checks"));
+}
+
+void minimizer::reset() {
+  d_literals_declared.clear();
+}
+
+void minimizer::declare_literals(smt::solver* solver, size_t n) {
+  // Make the literals
+  while (d_literals.size() < n) {
+    expr::term_ref b = d_tm.mk_variable(d_tm.boolean_type());
+    d_literal_index[b] = d_literals.size();
+    d_literals.push_back(expr::term_ref_strong(d_tm, b));
+  }
+  // Declare the new ones to the solver
+  size_t& declared = d_literals_declared[solver];
+  for (; declared < n; ++ declared) {
+    solver->add_variable(d_literals[declared], smt::solver::CLASS_A);
+  }
+}
+
+void minimizer::assert_guarded(smt::solver* solver, const transformer* transform, const std::vector<expr::term_ref>& formulas, const index_set& indices) {
+  for (size_t k = 0; k < indices.size(); ++ k) {
+    size_t i = indices[k];
+    expr::term_ref f = transform ? (*transform)(formulas[i]) : formulas[i];
+    solver->add(d_tm.mk_term(expr::TERM_IMPLIES, d_literals[i], f), smt::solver::CLASS_A);
+  }
+}
+
+smt::solver::result minimizer::check(smt::solver* solver, const index_set& indices, index_set* core) {
+  d_checks ++;
+  smt::solver_scope scope(solver);
+  scope.push();
+  for (size_t k = 0; k < indices.size(); ++ k) {
+    solver->add(d_literals[indices[k]], smt::solver::CLASS_A);
+  }
+  smt::solver::result result = solver->check();
+  if (result == smt::solver::UNSAT && core) {
+    std::vector<expr::term_ref> core_terms;
+    solver->get_unsat_core(core_terms);
+    core->clear();
+    for (size_t k = 0; k < core_terms.size(); ++ k) {
+      boost::unordered_map<expr::term_ref, size_t, expr::term_ref_hasher>::const_iterator find = d_literal_index.find(core_terms[k]);
+      if (find != d_literal_index.end()) {
+        core->push_back(find->second);
+      }
+    }
+    std::sort(core->begin(), core->end());
+  }
+  return result;
+}
+
+/** Elements of a that are also in sorted b */
+static
+void intersect(const std::vector<size_t>& a, const std::vector<size_t>& b_sorted, std::vector<size_t>& out) {
+  out.clear();
+  for (size_t k = 0; k < a.size(); ++ k) {
+    if (std::binary_search(b_sorted.begin(), b_sorted.end(), a[k])) {
+      out.push_back(a[k]);
+    }
+  }
+}
+
+void minimizer::quickxplain(smt::solver* solver, index_set& fixed, const index_set& to_minimize, size_t begin, size_t end, index_set& out) {
+
+  // Fixed part already unsat, done
+  if (check(solver, fixed, 0) == smt::solver::UNSAT) {
+    return;
+  }
+
+  assert(begin < end);
+
+  if (begin + 1 == end) {
+    // Only one left, we keep it, since we're SAT without it
+    out.push_back(to_minimize[begin]);
+    return;
+  }
+
+  // Split: how many in first half?
+  size_t n = (end - begin) / 2;
+  size_t fixed_size = fixed.size();
+
+  // Assume first half and minimize the second
+  fixed.insert(fixed.end(), to_minimize.begin() + begin, to_minimize.begin() + begin + n);
+  size_t old_out_size = out.size();
+  quickxplain(solver, fixed, to_minimize, begin + n, end, out);
+  fixed.resize(fixed_size);
+
+  // Now, assume the minimized second half, and minimize the first half
+  fixed.insert(fixed.end(), out.begin() + old_out_size, out.end());
+  quickxplain(solver, fixed, to_minimize, begin, begin + n, out);
+  fixed.resize(fixed_size);
+}
+
+void minimizer::minimize(smt::solver* solver, const index_set& fixed, const index_set& to_minimize, index_set& out) {
+
+  // Already unsat, nothing needed
+  if (check(solver, fixed, 0) == smt::solver::UNSAT) {
+    return;
+  }
+
+  bool use_core = solver->supports(smt::solver::UNSAT_CORE);
+
+  // Check with everything
+  index_set all(fixed), core, candidates(to_minimize), tmp;
+  all.insert(all.end(), to_minimize.begin(), to_minimize.end());
+  if (check(solver, all, use_core ? &core : 0) != smt::solver::UNSAT) {
+    // Can't refute, keep everything
+    out.insert(out.end(), to_minimize.begin(), to_minimize.end());
+    return;
+  }
+
+  // Shrink with the cores while they get smaller
+  while (use_core) {
+    intersect(candidates, core, tmp);
+    if (tmp.size() == candidates.size()) {
+      break;
+    }
+    candidates.swap(tmp);
+    all.resize(fixed.size());
+    all.insert(all.end(), candidates.begin(), candidates.end());
+    if (check(solver, all, &core) != smt::solver::UNSAT) {
+      // Shouldn't happen, but be safe and keep the previous set
+      candidates.swap(tmp);
+      break;
+    }
+  }
+
+  TRACE("pdkind::min") << "min: core " << to_minimize.size() << " -> " << candidates.size() << std::endl;
+
+  // Quickxplain the rest
+  if (candidates.size() > 0) {
+    index_set fixed_copy(fixed);
+    quickxplain(solver, fixed_copy, candidates, 0, candidates.size(), out);
+  }
+}
+
+size_t minimizer::minimize(const std::vector<target>& targets, const std::vector<expr::term_ref>& formulas, std::vector<expr::term_ref>& out) {
+  smt::query_site site("pdkind::minimize");
+
+  d_checks = 0;
+  d_stats.minimizations->increment();
+
+  if (formulas.size() == 0) {
+    return 0;
+  }
+
+  index_set all;
+  for (size_t i = 0; i < formulas.size(); ++ i) {
+    all.push_back(i);
+  }
+
+  // The selected formulas (anything selected for a target is assumed for the next one)
+  index_set selected;
+
+  for (size_t t = 0; t < targets.size(); ++ t) {
+    smt::solver* solver = targets[t].solver;
+    smt::solver_scope scope(solver);
+    scope.push();
+
+    // Assert the guarded formulas
+    declare_literals(solver, formulas.size());
+    assert_guarded(solver, targets[t].transform, formulas, all);
+
+    // Minimize the ones not selected yet
+    index_set sorted_selected(selected), to_minimize, result;
+    std::sort(sorted_selected.begin(), sorted_selected.end());
+    for (size_t i = 0; i < all.size(); ++ i) {
+      if (!std::binary_search(sorted_selected.begin(), sorted_selected.end(), all[i])) {
+        to_minimize.push_back(all[i]);
+      }
+    }
+    minimize(solver, selected, to_minimize, result);
+    selected.insert(selected.end(), result.begin(), result.end());
+  }
+
+  // Output in the original order
+  std::sort(selected.begin(), selected.end());
+  for (size_t k = 0; k < selected.size(); ++ k) {
+    out.push_back(formulas[selected[k]]);
+  }
+
+  d_stats.checks->add(d_checks);
+  return d_checks;
+}
+
+/** Runs the check of a solver in a separate thread (at the site of the caller) */
+struct check_worker {
+  smt::solver* solver;
+  smt::solver::result* result;
+  const char* site;
+  check_worker(smt::solver* solver, smt::solver::result* result)
+  : solver(solver), result(result), site(smt::query_site::current()) {}
+  void operator () () {
+    smt::query_site worker_site(site);
+    *result = solver->check();
+  }
+};
+
+size_t minimizer::minimize_parallel(size_t workers, const std::vector<expr::term_ref>& variables, const std::vector<expr::term_ref>& background, const std::vector<expr::term_ref>& formulas, std::vector<expr::term_ref>& out) {
+  smt::query_site site("pdkind::minimize");
+
+  assert(workers > 0);
+
+  d_checks = 0;
+  d_stats.minimizations->increment();
+
+  if (formulas.size() == 0) {
+    return 0;
+  }
+
+  index_set all;
+  for (size_t i = 0; i < formulas.size(); ++ i) {
+    all.push_back(i);
+  }
+
+  // Create the solvers
+  std::vector<smt::solver*> solvers;
+  for (size_t j = 0; j < workers; ++ j) {
+    smt::solver* solver = smt::factory::mk_default_solver(d_tm, d_ctx.get_options(), d_ctx.get_statistics());
+    solver->add_variables(variables, smt::solver::CLASS_A);
+    declare_literals(solver, formulas.size());
+    for (size_t i = 0; i < background.size(); ++ i) {
+      solver->add(background[i], smt::solver::CLASS_A);
+    }
+    assert_guarded(solver, 0, formulas, all);
+    solvers.push_back(solver);
+  }
+
+  // The checks run in other threads, so the solvers can't touch the terms there
+  if (!solvers[0]->supports(smt::solver::CONCURRENT_CHECK)) {
+    std::string name = solvers[0]->get_name();
+    for (size_t j = 0; j < solvers.size(); ++ j) {
+      d_literals_declared.erase(solvers[j]);
+      delete solvers[j];
+    }
+    throw exception("--pdkind-minimize-parallel needs a solver that can be checked concurrently (solver ") << name << ")";
+  }
+
+  bool use_core = solvers[0]->supports(smt::solver::UNSAT_CORE);
+
+  // Start with everything (or the core)
+  index_set current(all), core;
+  if (check(solvers[0], all, use_core ? &core : 0) == smt::solver::UNSAT) {
+    if (use_core) {
+      current.swap(core);
+    }
+
+    // Formulas that we know are needed
+    std::vector<bool> needed(formulas.size(), false);
+    std::vector<smt::solver::result> results(workers);
+
+    for (;;) {
+
+      // Pick the candidates to remove
+      index_set to_remove;
+      for (size_t k = 0; k < current.size() && to_remove.size() < workers; ++ k) {
+        if (!needed[current[k]]) {
+          to_remove.push_back(current[k]);
+        }
+      }
+      if (to_remove.empty()) {
+        break;
+      }
+
+      // Setup the checks: current without the candidate
+      for (size_t j = 0; j < to_remove.size(); ++ j) {
+        solvers[j]->push();
+        for (size_t k = 0; k < current.size(); ++ k) {
+          if (current[k] != to_remove[j]) {
+            solvers[j]->add(d_literals[current[k]], smt::solver::CLASS_A);
+          }
+        }
+        solvers[j]->flush();
+      }
+
+      // Run the checks
+      boost::thread_group threads;
+      for (size_t j = 0; j < to_remove.size(); ++ j) {
+        threads.create_thread(check_worker(solvers[j], &results[j]));
+      }
+      threads.join_all();
+      d_checks += to_remove.size();
+
+      // Satisfiable without it => needed in any subset. First unsatisfiable
+      // one, we remove.
+      bool removed = false;
+      index_set next;
+      for (size_t j = 0; j < to_remove.size(); ++ j) {
+        if (results[j] != smt::solver::UNSAT) {
+          needed[to_remove[j]] = true;
+        } else if (!removed) {
+          removed = true;
+          if (use_core) {
+            std::vector<expr::term_ref> core_terms;
+            solvers[j]->get_unsat_core(core_terms);
+            for (size_t k = 0; k < core_terms.size(); ++ k) {
+              if (d_literal_index.count(core_terms[k])) {
+                next.push_back(d_literal_index[core_terms[k]]);
+              }
+            }
+            std::sort(next.begin(), next.end());
+          } else {
+            for (size_t k = 0; k < current.size(); ++ k) {
+              if (current[k] != to_remove[j]) {
+                next.push_back(current[k]);
+              }
+            }
+          }
+        }
+      }
+      for (size_t j = 0; j < to_remove.size(); ++ j) {
+        solvers[j]->pop();
+      }
+      if (removed) {
+        current.swap(next);
+      }
+    }
+  }
+
+  // Delete the solvers
+  for (size_t j = 0; j < solvers.size(); ++ j) {
+    d_literals_declared.erase(solvers[j]);
+    delete solvers[j];
+  }
+
+  // Output
+  for (size_t k = 0; k < current.size(); ++ k) {
+    out.push_back(formulas[current[k]]);
+  }
+
+  d_stats.checks->add(d_checks);
+  return d_checks;
+}
+
+}
+}
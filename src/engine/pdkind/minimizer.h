@@ -0,0 +1,144 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <map>
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+#include "smt/solver.h"
+#include "expr/term_manager.h"
+#include "system/context.h"
+
+namespace sally {
+namespace pdkind {
+
+/**
+ * Minimization of a set of formulas F = { f_1, ..., f_n } with respect to a
+ * set of solvers (targets): find a small subset S of F such that each target
+ * solver becomes unsatisfiable once S is asserted.
+ *
+ * Instead of asserting the formulas directly, each formula f_i is guarded by
+ * an activation literal b_i, i.e. we assert (b_i => f_i) once, and subsets
+ * are checked by asserting the literals only. If the solver supports unsat
+ * cores, the core is used to drop the formulas that are not needed at once,
+ * before the (quickxplain) recursive halving is done.
+ *
+ * In parallel mode, subsets are checked with deletion-based minimization on
+ * several solvers at once. Since we can't copy a solver, the parallel solvers
+ * are created from scratch with the given background formulas. All terms are
+ * created and asserted in the calling thread, and the solvers are flushed
+ * there (see solver::flush()), so that only the checks run in parallel. The
+ * solvers must support solver::CONCURRENT_CHECK.
+ */
+class minimizer {
+
+public:
+
+  /** Transformation to apply to a formula before asserting it to a target */
+  class transformer {
+  public:
+    virtual ~transformer() {}
+    virtual expr::term_ref operator () (expr::term_ref f) const = 0;
+  };
+
+  /** A solver to minimize for */
+  struct target {
+    /** The solver */
+    smt::solver* solver;
+    /** The transformation of formulas (0 for none) */
+    const transformer* transform;
+    target(smt::solver* solver, const transformer* transform = 0)
+    : solver(solver), transform(transform) {}
+  };
+
+  minimizer(const system::context& ctx);
+
+  /**
+   * Forget about the solvers that were used. Should be called whenever any
+   * of the target solvers are deleted.
+   */
+  void reset();
+
+  /**
+   * Minimize the formulas so that all the targets are unsat. The minimized
+   * formulas are appended to out. Returns the number of checks performed.
+   */
+  size_t minimize(const std::vector<target>& targets, const std::vector<expr::term_ref>& formulas, std::vector<expr::term_ref>& out);
+
+  /**
+   * Minimize the formulas so that background and formulas are unsat, using
+   * the given number of solvers in parallel. The variables are the class A
+   * variables of the problem. The minimized formulas are appended to out.
+   * Returns the number of checks performed.
+   */
+  size_t minimize_parallel(size_t workers, const std::vector<expr::term_ref>& variables, const std::vector<expr::term_ref>& background, const std::vector<expr::term_ref>& formulas, std::vector<expr::term_ref>& out);
+
+private:
+
+  typedef std::vector<size_t> index_set;
+
+  /** Context */
+  const system::context& d_ctx;
+
+  /** Term manager */
+  expr::term_manager& d_tm;
+
+  /** The activation literals */
+  std::vector<expr::term_ref_strong> d_literals;
+
+  /** Map from literals to their indices */
+  boost::unordered_map<expr::term_ref, size_t, expr::term_ref_hasher> d_literal_index;
+
+  /** Number of literals declared to each solver */
+  std::map<smt::solver*, size_t> d_literals_declared;
+
+  /** Number of checks of the current minimization */
+  size_t d_checks;
+
+  struct stats {
+    utils::stat_int* minimizations;
+    utils::stat_int* checks;
+  } d_stats;
+
+  /** Make sure there are n literals and the solver knows about them */
+  void declare_literals(smt::solver* solver, size_t n);
+
+  /** Assert (b_i => f_i) for all i in the set (within the current scope) */
+  void assert_guarded(smt::solver* solver, const transformer* transform, const std::vector<expr::term_ref>& formulas, const index_set& indices);
+
+  /**
+   * Check the solver with the literals of indices asserted. If unsat, and
+   * core is not null, the core (indices used) is returned there.
+   */
+  smt::solver::result check(smt::solver* solver, const index_set& indices, index_set* core);
+
+  /**
+   * Minimize range of to_minimize so that solver + fixed + out is unsat
+   * (quickxplain).
+   */
+  void quickxplain(smt::solver* solver, index_set& fixed, const index_set& to_minimize, size_t begin, size_t end, index_set& out);
+
+  /** Minimize the given indices for a single solver, result in out */
+  void minimize(smt::solver* solver, const index_set& fixed, const index_set& to_minimize, index_set& out);
+
+};
+
+}
+}
@@ -33,6 +33,7 @@
 #include <algorithm>
 
 #include "system/trace_helper.h"
+#include "system/trace_replay.h"
 
 #define unused_var(x) { (void)x; }
 
@@ -61,6 +62,7 @@ pdkind_engine::pdkind_engine(const system::context& ctx)
   d_stats.frame_pushed = static_cast<utils::stat_int*>(stats.register_stat("pdkind::frame_pushed"));
   d_stats.queue_size = static_cast<utils::stat_int*>(stats.register_stat("pdkind::queue_size"));
   d_stats.max_cex_depth = static_cast<utils::stat_int*>(stats.register_stat("pdkind::max_cex_depth"));
+  d_stats.cex_replayed = static_cast<utils::stat_int*>(stats.register_stat("pdkind::cex_replayed"));
 }
 
 pdkind_engine::~pdkind_engine() {
@@ -275,6 +277,9 @@ void pdkind_engine::push_current_frame() {
 
 engine::result pdkind_engine::search() {
 
+  // When to save the checkpoints
+  checkpoint_timer checkpoints(ctx());
+
   // Push frame by frame */
   for(;;) {
 
@@ -353,6 +358,11 @@ engine::result pdkind_engine::search() {
     d_stats.frame_index->set_value(d_induction_frame_index);
     d_stats.induction_depth->set_value(d_induction_frame_depth);
 
+    // Save the new frame
+    if (checkpoints.due()) {
+      save_checkpoint(checkpoints.get_filename());
+    }
+
     // Do garbage collection
     d_smt->gc();
   }
@@ -385,19 +395,31 @@ engine::result pdkind_engine::query(const system::transition_system* ts, const s
   // Initialize the reachability solver
   d_reachability.init(d_transition_system, d_smt);
 
-  // Initialize the induction solver
-  d_induction_frame_index = 0;
-  d_induction_frame_depth = 1;
-  d_smt->reset_induction_solver(1);
-
-  // Add the property we're trying to prove (if not already invalid at frame 0)
-  bool ok = add_property(d_property->get_formula());
-  if (!ok) {
+  // Continue from the checkpoint, if resuming
+  checkpoint_reader* checkpoint = checkpoint_reader::open(ctx(), "pdkind", ts, sf);
+  if (checkpoint) {
+    try {
+      load_checkpoint(*checkpoint);
+    } catch (...) {
+      delete checkpoint;
+      throw;
+    }
+    delete checkpoint;
+  } else {
+    // Initialize the induction solver
+    d_induction_frame_index = 0;
+    d_induction_frame_depth = 1;
+    d_smt->reset_induction_solver(1);
+
+    // Add the property we're trying to prove (if not already invalid at frame 0)
+    bool ok = add_property(d_property->get_formula());
+    if (!ok) {
 #ifndef NDEBUG
-    // Check trace generation if not asked for explicityly
-    if (!ctx().get_options().has_option("show-trace")) { get_trace(); }  
+      // Check trace generation if not asked for explicityly
+      if (!ctx().get_options().has_option("show-trace")) { get_trace(); }
 #endif
-    return engine::INVALID;
+      return engine::INVALID;
+    }
   }
 
   while (r == UNKNOWN) {
@@ -426,6 +448,75 @@ engine::result pdkind_engine::query(const system::transition_system* ts, const s
   return r;
 }
 
+void pdkind_engine::save_checkpoint(std::string filename) const {
+
+  MSG(1) << "pdkind: saving checkpoint at frame " << d_induction_frame_index << std::endl;
+
+  checkpoint_writer checkpoint(ctx(), "pdkind", d_transition_system, d_property);
+
+  // The induction frame
+  checkpoint.write_uint(d_induction_frame_index);
+  checkpoint.write_uint(d_induction_frame_depth);
+  checkpoint.write_uint(d_properties.size());
+  std::set<expr::term_ref>::const_iterator P_it = d_properties.begin();
+  for (; P_it != d_properties.end(); ++ P_it) {
+    checkpoint.write_term(*P_it);
+  }
+  checkpoint.write_uint(d_induction_frame.size());
+  induction_frame_type::const_iterator it = d_induction_frame.begin();
+  for (; it != d_induction_frame.end(); ++ it) {
+    checkpoint.write_term(it->F_fwd);
+    checkpoint.write_term(it->F_cex);
+    checkpoint.write_uint(it->d);
+    checkpoint.write_double(it->score);
+    checkpoint.write_uint(it->refined);
+  }
+
+  // Reachability and counter-examples
+  d_reachability.save(checkpoint);
+  d_cex_manager.save(checkpoint);
+
+  checkpoint.save(filename);
+}
+
+void pdkind_engine::load_checkpoint(checkpoint_reader& checkpoint) {
+
+  // The induction frame, all obligations in the queue
+  d_induction_frame_index = checkpoint.read_uint();
+  d_induction_frame_depth = checkpoint.read_uint();
+  if (d_induction_frame_depth == 0) {
+    throw exception("pdkind: invalid checkpoint");
+  }
+  d_smt->reset_induction_solver(d_induction_frame_depth);
+  size_t properties = checkpoint.read_uint();
+  for (size_t i = 0; i < properties; ++ i) {
+    d_properties.insert(checkpoint.read_term());
+  }
+  size_t frame_size = checkpoint.read_uint();
+  for (size_t i = 0; i < frame_size; ++ i) {
+    expr::term_ref F_fwd = checkpoint.read_term();
+    expr::term_ref F_cex = checkpoint.read_term();
+    size_t d = checkpoint.read_uint();
+    double score = checkpoint.read_double();
+    size_t refined = checkpoint.read_uint();
+    induction_obligation ind(tm(), F_fwd, F_cex, d, score, refined);
+    d_smt->add_to_induction_solver(F_fwd, solvers::INDUCTION_FIRST);
+    d_smt->add_to_induction_solver(F_fwd, solvers::INDUCTION_INTERMEDIATE);
+    d_induction_frame.insert(ind);
+    enqueue_induction_obligation(ind);
+  }
+
+  // Reachability and counter-examples
+  d_reachability.load(checkpoint);
+  d_cex_manager.load(checkpoint);
+
+  MSG(1) << "pdkind: resuming at frame " << d_induction_frame_index << " (" << d_induction_frame.size() << ") with induction depth " << d_induction_frame_depth << std::endl;
+
+  d_stats.frame_index->set_value(d_induction_frame_index);
+  d_stats.induction_depth->set_value(d_induction_frame_depth);
+  d_stats.frame_size->set_value(d_induction_frame.size());
+}
+
 bool pdkind_engine::add_property(expr::term_ref P) {
   // Add to cex manager
   expr::term_ref P_cex = tm().mk_not(P);
@@ -452,6 +543,7 @@ bool pdkind_engine::add_property(expr::term_ref P) {
 }
 
 const system::trace_helper* pdkind_engine::get_trace() {
+  smt::query_site site("pdkind::get_trace");
 
   MSG(1) << "pdkind: constructing counter-example" << std::endl;
 
@@ -503,6 +595,10 @@ const system::trace_helper* pdkind_engine::get_trace() {
   // Add model to trace
   d_trace->set_model(model, 0, 0);
 
+  // Replay the steps by evaluation if the transition relation defines the next states
+  system::trace_replay replay(d_transition_system, d_trace);
+  bool use_replay = replay.has_definitions() && !ctx().get_options().has_option("pdkind-no-cex-replay");
+
   // Construct the counter-example
   size_t current_depth = 0;
   for (size_t i = 0; i < cex_edges.size(); ++ i) {
@@ -515,6 +611,17 @@ const system::trace_helper* pdkind_engine::get_trace() {
 
     TRACE("pdkind::cex") << "at " << current_depth << ", step = " << cex_step << std::endl;
 
+    // Try the replay first, otherwise solve for the whole step
+    if (use_replay) {
+      if (replay.extend(current_depth, cex_step, cex_next, solver)) {
+        d_stats.cex_replayed->add(cex_step);
+        current_depth += cex_step;
+        continue;
+      }
+      TRACE("pdkind::cex") << "replay failed, solving" << std::endl;
+      model = d_trace->get_model();
+    }
+
     // Push the solver scope
     scope.push();
 
@@ -572,6 +679,15 @@ void pdkind_engine::gc_collect(const expr::gc_relocator& gc_reloc) {
   d_reachability.gc_collect(gc_reloc);
 }
 
+void pdkind_engine::memory_usage(utils::memory_report& report) const {
+  if (d_trace) {
+    d_trace->memory_usage(report);
+  }
+  if (d_smt) {
+    d_smt->memory_usage(report);
+  }
+}
+
 engine::invariant pdkind_engine::get_invariant() {
   return d_invariant;
 }
@@ -26,6 +26,7 @@
 #include "smt/solver.h"
 #include "system/context.h"
 #include "engine/engine.h"
+#include "engine/checkpoint.h"
 #include "expr/term.h"
 #include "expr/term_map.h"
 
@@ -109,6 +110,7 @@ class pdkind_engine : public engine {
     utils::stat_int* frame_pushed;
     utils::stat_int* queue_size;
     utils::stat_int* max_cex_depth;
+    utils::stat_int* cex_replayed;
   } d_stats;
 
 
@@ -202,6 +204,15 @@ class pdkind_engine : public engine {
   /** Reset the engine */
   void reset();
 
+  /**
+   * Save the current induction frame (with the obligation scores), the
+   * reachability frames and the counter-example graph to the file.
+   */
+  void save_checkpoint(std::string filename) const;
+
+  /** Start from the checkpoint, instead of the property at frame 0 */
+  void load_checkpoint(checkpoint_reader& checkpoint);
+
   /** GC the solvers */
   void gc_solvers();
 
@@ -235,6 +246,9 @@ public:
   /** Collect terms */
   void gc_collect(const expr::gc_relocator& gc_reloc);
 
+  /** The trace and the solvers */
+  void memory_usage(utils::memory_report& report) const;
+
 };
 
 }
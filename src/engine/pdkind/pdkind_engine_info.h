@@ -38,8 +38,11 @@ struct pdkind_engine_info {
         ("pdkind-induction-max", value<unsigned>()->default_value(0), "Max induction depth")
         ("pdkind-minimize-interpolants", "Try to minimize interpolants")
         ("pdkind-minimize-generalizations", "Try to minimize generalizations")
+        ("pdkind-minimize-parallel", value<unsigned>()->default_value(0), "Number of solvers to use in parallel when minimizing generalizations (needs a solver that can be checked concurrently, e.g. bitblast, without --solver-slow-queries).")
         ("pdkind-minimize-frames", "Try to minimize frames")
+        ("pdkind-rewrite", value<std::string>()->implicit_value("all"), "Simplify generalizations and interpolants with the given rule sets (comma separated list of bool, arith, bv, all).")
         ("pdkind-output-cex-graph", value<std::string>(), "Print the CEX graph into this file when done.")
+        ("pdkind-no-cex-replay", "Construct the counter-examples with the solver only, without evaluating the transition relation.")
         ;
   }
 
@@ -1,8 +1,10 @@
 #include "reachability.h"
 
 #include "system/state_type.h"
+#include "engine/checkpoint.h"
 #include "utils/trace.h"
 
+#include <chrono>
 #include <vector>
 #include <iostream>
 
@@ -21,13 +23,14 @@ reachability::reachability(const system::context& ctx, cex_manager& cm)
   d_stats.reachable = static_cast<utils::stat_int*>(stats.register_stat("pdkind::reachable"));
   d_stats.unreachable = static_cast<utils::stat_int*>(stats.register_stat("pdkind::unreachable"));
   d_stats.queries = static_cast<utils::stat_int*>(stats.register_stat("pdkind::queries"));
+  d_stats.query_time = static_cast<utils::stat_histogram*>(stats.register_stat("pdkind::query_time"));
 }
 
 solvers::query_result reachability::check_one_step_reachable(size_t k, expr::term_ref F) {
   assert(k > 0);
   ensure_frame(k-1);
 
-  d_stats.queries->set_value(d_stats.queries->get_value() + 1);
+  d_stats.queries->increment();
 
   // The state type
   const system::state_type* state_type = d_transition_system->get_state_type();
@@ -36,7 +39,10 @@ solvers::query_result reachability::check_one_step_reachable(size_t k, expr::ter
   expr::term_ref F_next = state_type->change_formula_vars(system::state_type::STATE_CURRENT, system::state_type::STATE_NEXT, F);
 
   // Query
-  return d_smt->query_with_transition_at(k-1, F_next, smt::solver::CLASS_B);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  solvers::query_result result = d_smt->query_with_transition_at(k-1, F_next, smt::solver::CLASS_B);
+  d_stats.query_time->record(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  return result;
 }
 
 
@@ -163,11 +169,11 @@ reachability::result reachability::check_reachable(size_t k, expr::term_ref f, s
   // All discharged, so it's not reachable
   if (reachable) {
     TRACE("pdkind") << "pdkind: checking reachability at " << k << ": reachable" << std::endl;
-    d_stats.reachable->set_value(d_stats.reachable->get_value() + 1);
+    d_stats.reachable->increment();
     return REACHABLE;
   } else {
     TRACE("pdkind") << "pdkind: checking reachability at " << k << ": unreachable" << std::endl;
-    d_stats.unreachable->set_value(d_stats.unreachable->get_value() + 1);
+    d_stats.unreachable->increment();
     return UNREACHABLE;
   }
 }
@@ -224,6 +230,28 @@ void reachability::clear() {
   d_frame_content.clear();
 }
 
+void reachability::save(checkpoint_writer& out) const {
+  out.write_uint(d_frame_content.size());
+  for (size_t k = 0; k < d_frame_content.size(); ++ k) {
+    out.write_uint(d_frame_content[k].size());
+    formula_set::const_iterator it = d_frame_content[k].begin();
+    for (; it != d_frame_content[k].end(); ++ it) {
+      out.write_term(*it);
+    }
+  }
+}
+
+void reachability::load(checkpoint_reader& in) {
+  size_t frames = in.read_uint();
+  for (size_t k = 0; k < frames; ++ k) {
+    ensure_frame(k);
+    size_t size = in.read_uint();
+    for (size_t i = 0; i < size; ++ i) {
+      add_to_frame(k, in.read_term());
+    }
+  }
+}
+
 void reachability::gc_collect(const expr::gc_relocator& gc_reloc) {
   // TODO
 }
@@ -57,6 +57,8 @@ private:
   struct stats {
     /** Number of reachability SMT queries */
     utils::stat_int* queries;
+    /** Time of the reachability SMT queries */
+    utils::stat_histogram* query_time;
     /** Number of reachable results */
     utils::stat_int* reachable;
     /** Number of unreachable reasults */
@@ -118,6 +120,12 @@ public:
    */
   status check_reachable(size_t start, size_t end, expr::term_ref f, size_t property_id);
 
+  /** Save the frames to the checkpoint */
+  void save(checkpoint_writer& out) const;
+
+  /** Load the frames from the checkpoint, adding them to the solvers (after init) */
+  void load(checkpoint_reader& in);
+
   /** Collect terms */
   void gc_collect(const expr::gc_relocator& gc_reloc);
 
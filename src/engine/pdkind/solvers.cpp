@@ -42,7 +42,13 @@ solvers::solvers(const system::context& ctx, const system::transition_system* tr
 , d_minimization_solver(0)
 , d_induction_solver_depth(0)
 , d_generate_models_for_queries(false)
+, d_minimizer(ctx)
+, d_rewriter(0)
 {
+  const options& opts = ctx.get_options();
+  if (opts.has_option("pdkind-rewrite")) {
+    d_rewriter = new expr::term_rewriter(d_tm, expr::term_rewriter::parse_rules(opts.get_string("pdkind-rewrite")));
+  }
 }
 
 solvers::~solvers() {
@@ -51,9 +57,11 @@ solvers::~solvers() {
   delete d_induction_solver;
   delete d_induction_generalizer;
   delete d_minimization_solver;
+  delete d_rewriter;
   for (size_t k = 0; k < d_reachability_solvers.size(); ++ k) {
     delete d_reachability_solvers[k];
   }
+  clear_model_evaluators();
 }
 
 void solvers::reset(const std::vector<solvers::formula_set>& frames) {
@@ -89,6 +97,9 @@ void solvers::reset(const std::vector<solvers::formula_set>& frames) {
   delete d_minimization_solver;
   d_minimization_solver = 0;
 
+  // Solvers are gone, so is the minimizer info
+  d_minimizer.reset();
+
   assert(d_size == frames.size());
 
   // Add the frame content
@@ -202,6 +213,7 @@ solvers::query_result::query_result()
 }
 
 smt::solver::result solvers::query_at_init(expr::term_ref f) {
+  smt::query_site site("pdkind::query_at_init");
   smt::solver* solver = get_initial_solver();
   smt::solver_scope scope(solver);
   scope.push();
@@ -213,6 +225,7 @@ smt::solver::result solvers::query_at_init(expr::term_ref f) {
 }
 
 solvers::query_result solvers::query_with_transition_at(size_t k, expr::term_ref f, smt::solver::formula_class f_class) {
+  smt::query_site site("pdkind::query_with_transition_at");
 
   smt::solver* solver = 0;
   query_result result;
@@ -295,26 +308,14 @@ expr::term_ref solvers::generalize_sat(smt::solver* solver) {
   std::vector<expr::term_ref> generalization_facts;
   solver->generalize(smt::solver::GENERALIZE_BACKWARD, generalization_facts);
   if (d_ctx.get_options().get_bool("pdkind-minimize-generalizations")) {
-    // Add negation of generalization
-    smt::solver* minimization_solver = get_minimization_solver();
-    smt::solver_scope scope(minimization_solver);
-    scope.push();
-    minimization_solver->add(d_tm.mk_not(d_tm.mk_and(generalization_facts)), smt::solver::CLASS_A);
-    // Get all the conjuncts
-    std::set<expr::term_ref> conjuncts;
-    for (size_t i = 0; i < generalization_facts.size(); ++ i) {
-      d_tm.get_conjuncts(generalization_facts[i], conjuncts);
-    }
-    std::vector<expr::term_ref> conjuncts_vec(conjuncts.begin(), conjuncts.end()), minimized_vec;
-    // Minimize
-    quickxplain_generalization(minimization_solver, conjuncts_vec, 0, conjuncts_vec.size(), minimized_vec);
-    TRACE("pdkind::mingen") << "min: old_size = " << conjuncts_vec.size() << ", new_size = " << minimized_vec.size() << std::endl;
+    std::vector<expr::term_ref> minimized_vec;
+    minimize_generalization(generalization_facts, minimized_vec);
     generalization_facts.swap(minimized_vec);
   }
   expr::term_ref G = d_tm.mk_and(generalization_facts);
   // Move variables back to regular state instead of trace state
   G = d_trace->get_state_formula(0, G);
-  return G;
+  return simplify(G);
 }
 
 expr::term_ref solvers::generalize_sat(smt::solver* solver, expr::model::ref m) {
@@ -322,140 +323,76 @@ expr::term_ref solvers::generalize_sat(smt::solver* solver, expr::model::ref m)
   std::vector<expr::term_ref> generalization_facts;
   solver->generalize(smt::solver::GENERALIZE_BACKWARD, m, generalization_facts);
   if (d_ctx.get_options().get_bool("pdkind-minimize-generalizations")) {
-    // Add negation of generalization
-    smt::solver* minimization_solver = get_minimization_solver();
-    smt::solver_scope scope(minimization_solver);
-    scope.push();
-    minimization_solver->add(d_tm.mk_not(d_tm.mk_and(generalization_facts)), smt::solver::CLASS_A);
-    // Get all the conjuncts
-    std::set<expr::term_ref> conjuncts;
-    for (size_t i = 0; i < generalization_facts.size(); ++ i) {
-      d_tm.get_conjuncts(generalization_facts[i], conjuncts);
-    }
-    // Minimize
-    std::vector<expr::term_ref> conjuncts_vec(conjuncts.begin(), conjuncts.end()), minimized_vec;
-    quickxplain_generalization(minimization_solver, conjuncts_vec, 0, conjuncts_vec.size(), minimized_vec);
-    TRACE("pdkind::mingen") << "min: old_size = " << conjuncts_vec.size() << ", new_size = " << minimized_vec.size() << std::endl;
+    std::vector<expr::term_ref> minimized_vec;
+    minimize_generalization(generalization_facts, minimized_vec);
     generalization_facts.swap(minimized_vec);
   }
   expr::term_ref G = d_tm.mk_and(generalization_facts);
   // Move variables back to regular state instead of trace state
   G = d_trace->get_state_formula(0, G);
-  return G;
+  return simplify(G);
 }
 
-void solvers::quickxplain_interpolant(bool negate, smt::solver* I_solver, smt::solver* T_solver, const std::vector<expr::term_ref>& formulas, size_t begin, size_t end, std::vector<expr::term_ref>& out) {
+void solvers::minimize_generalization(const std::vector<expr::term_ref>& generalization_facts, std::vector<expr::term_ref>& out) {
 
-  // TRACE("pdkind::min") << "min: begin = " << begin << ", end = " << end << std::endl;
-
-  smt::solver_scope I_solver_scope(I_solver);
-  smt::solver_scope T_solver_scope(T_solver);
-
-  smt::solver::result I_solver_result = smt::solver::UNSAT;
-  smt::solver::result T_solver_result = smt::solver::UNSAT;
-
-  if (I_solver) { I_solver_result = I_solver->check(); }
-  if (T_solver) { T_solver_result = T_solver->check(); }
-
-  if (I_solver_result == smt::solver::UNSAT && T_solver_result == smt::solver::UNSAT) {
-    // Solver state already unsat, done
-    return;
+  // Get all the conjuncts
+  std::set<expr::term_ref> conjuncts;
+  for (size_t i = 0; i < generalization_facts.size(); ++ i) {
+    d_tm.get_conjuncts(generalization_facts[i], conjuncts);
   }
+  std::vector<expr::term_ref> conjuncts_vec(conjuncts.begin(), conjuncts.end());
 
-  // If only one solver is unsat, we don't use it anymore
-  if (I_solver_result == smt::solver::UNSAT) { I_solver = 0; }
-  if (T_solver_result == smt::solver::UNSAT) { T_solver = 0; }
-
-  assert(begin < end);
-
-  if (begin + 1 == end) {
-    // Only one left, we keep it, since we're SAT in one of the solvers
-    out.push_back(formulas[begin]);
-    return;
-  }
-
-  // Split: how many in first half?
-  size_t n = (end - begin) / 2;
-
-  // Assert first half and minimize the second
-  if (I_solver) I_solver_scope.push();
-  if (T_solver) T_solver_scope.push();
-  for (size_t i = begin; i < begin + n; ++ i) {
-    expr::term_ref to_assert = negate ? d_tm.mk_term(expr::TERM_NOT, formulas[i])  : formulas[i];
-    // Add to initial solver
-    if (I_solver) {
-      I_solver->add(to_assert, smt::solver::CLASS_A);
-    }
-    // Add to transition solver
-    if (T_solver) {
-      to_assert = d_transition_system->get_state_type()->change_formula_vars(system::state_type::STATE_CURRENT, system::state_type::STATE_NEXT, to_assert);
-      T_solver->add(to_assert, smt::solver::CLASS_A);
-    }
-  }
-  size_t old_out_size = out.size();
-  quickxplain_interpolant(negate, I_solver, T_solver, formulas, begin + n, end, out);
-  if (I_solver) I_solver_scope.pop();
-  if (T_solver) T_solver_scope.pop();
-
-  // Now, assert the minimized second half, and minimize the first half
-  if (I_solver) I_solver_scope.push();
-  if (T_solver) T_solver_scope.push();
-  for (size_t i = old_out_size; i < out.size(); ++ i) {
-    expr::term_ref to_assert = negate ? d_tm.mk_term(expr::TERM_NOT, out[i]) : out[i];
-    // Add to initial solver
-    if (I_solver) {
-      I_solver->add(to_assert, smt::solver::CLASS_A);
-    }
-    // Add to transition solver
-    if (T_solver) {
-      to_assert = d_transition_system->get_state_type()->change_formula_vars(system::state_type::STATE_CURRENT, system::state_type::STATE_NEXT, to_assert);
-      T_solver->add(to_assert, smt::solver::CLASS_A);
+  // Minimize so that the conjuncts imply the generalization
+  expr::term_ref G_not = d_tm.mk_not(d_tm.mk_and(generalization_facts));
+  size_t checks = 0;
+  unsigned workers = d_ctx.get_options().get_unsigned("pdkind-minimize-parallel");
+  if (workers > 1) {
+    const std::vector<expr::term_ref>& x = d_transition_system->get_state_type()->get_variables(system::state_type::STATE_CURRENT);
+    std::vector<expr::term_ref> background(1, G_not);
+    checks = d_minimizer.minimize_parallel(workers, x, background, conjuncts_vec, out);
+  } else {
+    smt::solver* minimization_solver = get_minimization_solver();
+    smt::solver_scope scope(minimization_solver);
+    scope.push();
+    minimization_solver->add(G_not, smt::solver::CLASS_A);
+    std::vector<minimizer::target> targets(1, minimizer::target(minimization_solver));
+    checks = d_minimizer.minimize(targets, conjuncts_vec, out);
+  }
+
+  TRACE("pdkind::mingen") << "min: old_size = " << conjuncts_vec.size() << ", new_size = " << out.size() << ", checks = " << checks << std::endl;
+}
+
+/** Transformation of interpolant formulas: negate and/or move to next state */
+class interpolant_transformer : public minimizer::transformer {
+  expr::term_manager& d_tm;
+  const system::state_type* d_state_type;
+  bool d_negate;
+  bool d_next;
+public:
+  interpolant_transformer(expr::term_manager& tm, const system::state_type* state_type, bool negate, bool next)
+  : d_tm(tm), d_state_type(state_type), d_negate(negate), d_next(next) {}
+  expr::term_ref operator () (expr::term_ref f) const {
+    expr::term_ref result = d_negate ? d_tm.mk_term(expr::TERM_NOT, f) : f;
+    if (d_next) {
+      result = d_state_type->change_formula_vars(system::state_type::STATE_CURRENT, system::state_type::STATE_NEXT, result);
     }
+    return result;
   }
-  quickxplain_interpolant(negate, I_solver, T_solver, formulas, begin, begin + n, out);
-  if (I_solver) I_solver_scope.pop();
-  if (T_solver) T_solver_scope.pop();
-}
-
-void solvers::quickxplain_generalization(smt::solver* solver, const std::vector<expr::term_ref>& conjuncts, size_t begin, size_t end, std::vector<expr::term_ref>& out) {
-
-  // TRACE("pdkind::min") << "min: begin = " << begin << ", end = " << end << std::endl;
-
-  smt::solver_scope solver_scope(solver);
-  smt::solver::result solver_result = solver->check();
+};
 
-  if (solver_result == smt::solver::UNSAT) {
-    // Solver state already unsat, done
-    return;
-  }
+void solvers::minimize_interpolant(bool negate, smt::solver* I_solver, smt::solver* T_solver, const std::vector<expr::term_ref>& formulas, std::vector<expr::term_ref>& out) {
 
-  assert(begin < end);
-
-  if (begin + 1 == end) {
-    // Only one left, we keep it, since we're SAT in one of the solvers
-    out.push_back(conjuncts[begin]);
-    return;
-  }
+  const system::state_type* state_type = d_transition_system->get_state_type();
+  interpolant_transformer I_transform(d_tm, state_type, negate, false);
+  interpolant_transformer T_transform(d_tm, state_type, negate, true);
 
-  // Split: how many in first half?
-  size_t n = (end - begin) / 2;
+  std::vector<minimizer::target> targets;
+  if (I_solver) { targets.push_back(minimizer::target(I_solver, &I_transform)); }
+  if (T_solver) { targets.push_back(minimizer::target(T_solver, &T_transform)); }
 
-  // Assert first half and minimize the second
-  solver_scope.push();
-  for (size_t i = begin; i < begin + n; ++ i) {
-    solver->add(conjuncts[i], smt::solver::CLASS_A);
-  }
-  size_t old_out_size = out.size();
-  quickxplain_generalization(solver, conjuncts, begin + n, end, out);
-  solver_scope.pop();
+  size_t checks = d_minimizer.minimize(targets, formulas, out);
 
-  // Now, assert the minimized second half, and minimize the first half
-  solver_scope.push();
-  for (size_t i = old_out_size; i < out.size(); ++ i) {
-    solver->add(out[i], smt::solver::CLASS_A);
-  }
-  quickxplain_generalization(solver, conjuncts, begin, begin + n, out);
-  solver_scope.pop();
+  TRACE("pdkind::min") << "min: old_size = " << formulas.size() << ", new_size = " << out.size() << ", checks = " << checks << std::endl;
 }
 
 struct interpolant_cmp {
@@ -467,6 +404,7 @@ struct interpolant_cmp {
 };
 
 expr::term_ref solvers::learn_forward(size_t k, expr::term_ref G) {
+  smt::query_site site("pdkind::learn_forward");
 
   TRACE("pdkind") << "learning forward to refute: " << G << std::endl;
 
@@ -487,7 +425,7 @@ expr::term_ref solvers::learn_forward(size_t k, expr::term_ref G) {
     d_tm.get_conjuncts(G, G_conjuncts);
     interpolant_cmp cmp(d_tm);
     std::sort(G_conjuncts.begin(), G_conjuncts.end(), cmp);
-    quickxplain_interpolant(false, I_solver, T_solver, G_conjuncts, 0, G_conjuncts.size(), G_conjuncts_min);
+    minimize_interpolant(false, I_solver, T_solver, G_conjuncts, G_conjuncts_min);
     G = d_tm.mk_and(G_conjuncts_min);
   }
 
@@ -526,8 +464,7 @@ expr::term_ref solvers::learn_forward(size_t k, expr::term_ref G) {
     std::vector<expr::term_ref> disjuncts_vec(disjuncts.begin(), disjuncts.end()), minimized_vec;
     interpolant_cmp cmp(d_tm);
     std::sort(disjuncts_vec.begin(), disjuncts_vec.end(), cmp);
-    quickxplain_interpolant(true, I_solver, T_solver, disjuncts_vec, 0, disjuncts_vec.size(), minimized_vec);
-    TRACE("pdkind::min") << "min: old_size = " << disjuncts_vec.size() << ", new_size = " << minimized_vec.size() << std::endl;
+    minimize_interpolant(true, I_solver, T_solver, disjuncts_vec, minimized_vec);
     learnt = d_tm.mk_or(minimized_vec);
   } else {
     // Result is the disjunction of the two
@@ -538,13 +475,65 @@ expr::term_ref solvers::learn_forward(size_t k, expr::term_ref G) {
     }
   }
 
+  learnt = simplify(learnt);
+
   TRACE("pdkind") << "learned: " << learnt << std::endl;
 
   return learnt;
 }
 
+expr::term_ref solvers::simplify(expr::term_ref f) {
+  if (d_rewriter == 0) {
+    return f;
+  }
+  return d_rewriter->rewrite(f);
+}
+
 
 void solvers::gc_collect(const expr::gc_relocator& gc_reloc) {
+  // Formulas might be gone, just recompile
+  clear_model_evaluators();
+  if (d_rewriter) {
+    d_rewriter->gc_collect(gc_reloc);
+  }
+}
+
+void solvers::memory_usage(utils::memory_report& report) const {
+  for (size_t k = 0; k < d_reachability_solvers.size(); ++ k) {
+    if (d_reachability_solvers[k]) {
+      d_reachability_solvers[k]->memory_usage(report);
+    }
+  }
+  smt::solver* others[] = { d_reachability_solver, d_initial_solver, d_induction_solver, d_induction_generalizer, d_minimization_solver };
+  for (size_t i = 0; i < sizeof(others)/sizeof(others[0]); ++ i) {
+    if (others[i]) {
+      others[i]->memory_usage(report);
+    }
+  }
+}
+
+/** Most compiled evaluators kept, they are all dropped when one more is needed */
+static const size_t max_model_evaluators = 1024;
+
+const expr::model_evaluator& solvers::get_model_evaluator(expr::term_ref f) {
+  model_evaluator_map::const_iterator find = d_model_evaluators.find(f);
+  if (find != d_model_evaluators.end()) {
+    return *find->second;
+  }
+  if (d_model_evaluators.size() >= max_model_evaluators) {
+    clear_model_evaluators();
+  }
+  expr::model_evaluator* evaluator = new expr::model_evaluator(d_tm, f);
+  d_model_evaluators[f] = evaluator;
+  return *evaluator;
+}
+
+void solvers::clear_model_evaluators() {
+  model_evaluator_map::iterator it = d_model_evaluators.begin();
+  for (; it != d_model_evaluators.end(); ++ it) {
+    delete it->second;
+  }
+  d_model_evaluators.clear();
 }
 
 void solvers::add_to_reachability_solver(size_t k, expr::term_ref f)  {
@@ -643,6 +632,7 @@ void solvers::add_to_induction_solver(expr::term_ref f, induction_assertion_type
 }
 
 solvers::query_result solvers::check_inductive(expr::term_ref f) {
+  smt::query_site site("pdkind::check_inductive");
 
   assert(d_induction_solver != 0);
   assert(d_induction_generalizer != 0);
@@ -680,13 +670,14 @@ solvers::query_result solvers::check_inductive(expr::term_ref f) {
 }
 
 solvers::query_result solvers::check_inductive_model(expr::model::ref m, expr::term_ref f) {
+  smt::query_site site("pdkind::check_inductive_model");
   assert(d_induction_solver != 0);
   assert(d_induction_generalizer != 0);
 
   solvers::query_result result;
 
   expr::term_ref f_next = d_trace->get_state_formula(f, d_induction_solver_depth);
-  if (m->is_true(f_next)) {
+  if (get_model_evaluator(f_next).is_true(*m)) {
     result.model = m;
     result.result = smt::solver::SAT;
 
@@ -827,6 +818,7 @@ void solvers::quickxplain_frame(smt::solver* solver, const std::vector<induction
 }
 
 void solvers::minimize_frame(std::vector<induction_obligation>& frame) {
+  smt::query_site site("pdkind::minimize_frame");
   std::vector<induction_obligation> out;
   smt::solver* solver = get_minimization_solver();
   std::sort(frame.begin(), frame.end(), induction_obligation_cmp_better());
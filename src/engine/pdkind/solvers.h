@@ -20,15 +20,19 @@
 
 #include <set>
 #include <vector>
+#include <boost/unordered_map.hpp>
 
 #include "../../system/trace_helper.h"
 #include "smt/solver.h"
 #include "expr/term_manager.h"
 #include "expr/gc_relocator.h"
+#include "expr/model_evaluator.h"
+#include "expr/term_rewriter.h"
 #include "system/transition_system.h"
 #include "system/context.h"
 
 #include "induction_obligation.h"
+#include "minimizer.h"
 
 namespace sally {
 namespace pdkind {
@@ -112,11 +116,31 @@ class solvers {
   /** Whether to generate models for queries */
   bool d_generate_models_for_queries;
 
-  /** Use quickxplain to minimize the interpolant */
-  void quickxplain_interpolant(bool negate, smt::solver* I_solver, smt::solver* T_solver, const std::vector<expr::term_ref>& formulas, size_t begin, size_t end, std::vector<expr::term_ref>& out);
+  /** Minimizer for generalizations and interpolants */
+  minimizer d_minimizer;
 
-  /** Use quickxplain to minimize the generalization */
-  void quickxplain_generalization(smt::solver* solver, const std::vector<expr::term_ref>& disjuncts, size_t begin, size_t end, std::vector<expr::term_ref>& out);
+  /** Rewriter for generalizations and interpolants (null if not enabled) */
+  expr::term_rewriter* d_rewriter;
+
+  /** Simplify the learned formula with the rewriter, if enabled */
+  expr::term_ref simplify(expr::term_ref f);
+
+  /** Minimize the interpolant (negated) formulas with respect to initial and transition solver */
+  void minimize_interpolant(bool negate, smt::solver* I_solver, smt::solver* T_solver, const std::vector<expr::term_ref>& formulas, std::vector<expr::term_ref>& out);
+
+  /** Minimize the generalization conjuncts */
+  void minimize_generalization(const std::vector<expr::term_ref>& generalization_facts, std::vector<expr::term_ref>& out);
+
+  typedef boost::unordered_map<expr::term_ref, expr::model_evaluator*, expr::term_ref_hasher> model_evaluator_map;
+
+  /** Compiled evaluators of the formulas checked in induction models (bounded, see get_model_evaluator) */
+  model_evaluator_map d_model_evaluators;
+
+  /** Get the compiled evaluator of f */
+  const expr::model_evaluator& get_model_evaluator(expr::term_ref f);
+
+  /** Remove all the compiled evaluators */
+  void clear_model_evaluators();
 
   /** Use quickxplain to minimize the frame */
   void quickxplain_frame(smt::solver* solver, const std::vector<induction_obligation>& frame, size_t begin, size_t end, std::vector<induction_obligation>& out);
@@ -205,6 +229,9 @@ public:
   /** Collect term manager garbage */
   void gc_collect(const expr::gc_relocator& gc_reloc);
 
+  /** Add the memory of all the solvers to the report */
+  void memory_usage(utils::memory_report& report) const;
+
   /** Rewrite equalitites to inequalities */
   expr::term_ref eq_to_ineq(expr::term_ref G);
 
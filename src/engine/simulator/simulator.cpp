@@ -37,6 +37,8 @@ simulator::~simulator() {}
 
 engine::result simulator::query(const system::transition_system* ts, const system::state_formula* sf) {
 
+  smt::query_site site("simulator::query");
+
   // Make the solver
   smt::solver::ref d_solver(smt::factory::mk_default_solver(tm(), ctx().get_options(), ctx().get_statistics()));
 
@@ -19,6 +19,7 @@
 #include "engine/translator/translator.h"
 
 #include "smt/factory.h"
+#include "expr/term_definitions.h"
 #include "utils/output.h"
 
 #include <sstream>
@@ -44,33 +45,33 @@ void translator::to_stream_mcmt(std::ostream& out) const {
   // Output the state type
   const system::state_type* state_type = d_ts->get_state_type();
   state_type->use_namespace();
-  out << ";; State type" << std::endl;
-  out << "(define-state-type state_type " << state_type->get_state_type_var() << " " << state_type->get_input_type_var() << ")" << std::endl;
-  out << std::endl;
+  out << ";; State type\n";
+  out << "(define-state-type state_type " << state_type->get_state_type_var() << " " << state_type->get_input_type_var() << ")\n";
+  out << "\n";
 
   // Output the initial state
   state_type->use_namespace(system::state_type::STATE_CURRENT);
   expr::term_ref initial_states = d_ts->get_initial_states();
-  out << ";; Initial states" << std::endl;
-  out << "(define-states initial_states state_type " << initial_states << ")" << std::endl;
-  out << std::endl;
+  out << ";; Initial states\n";
+  out << "(define-states initial_states state_type " << initial_states << ")\n";
+  out << "\n";
   ctx().tm().pop_namespace();
 
   // Output the transition relation
   expr::term_ref transition_relation = d_ts->get_transition_relation();
-  out << ";; Transition relation" << std::endl;
-  out << "(define-transition transition state_type " << transition_relation << ")" << std::endl;
-  out << std::endl;
+  out << ";; Transition relation\n";
+  out << "(define-transition transition state_type " << transition_relation << ")\n";
+  out << "\n";
 
   // Output the transition system
-  out << ";; Transition system" << std::endl;
-  out << "(define-transition-system T state_type initial_states transition)" << std::endl;
-  out << std::endl;
+  out << ";; Transition system\n";
+  out << "(define-transition-system T state_type initial_states transition)\n";
+  out << "\n";
 
   // Output the query
   state_type->use_namespace(system::state_type::STATE_CURRENT);
-  out << ";; Query " << std::endl;
-  out << "(query T " << d_sf->get_formula() << ")" << std::endl;
+  out << ";; Query \n";
+  out << "(query T " << d_sf->get_formula() << ")\n";
   ctx().tm().pop_namespace();
 
   // State type namespace
@@ -108,29 +109,29 @@ void translator::to_stream_nuxmv(std::ostream& out) const {
   const system::state_type* st = d_ts->get_state_type();
   st->use_namespace();
 
-  out << "MODULE main" << std::endl;
+  out << "MODULE main\n";
 
   // Declare state variables
   const std::vector<expr::term_ref>& state_vars = st->get_variables(system::state_type::STATE_CURRENT);
-  out << "VAR" << std::endl;
+  out << "VAR\n";
   for (size_t i = 0; i < state_vars.size(); ++ i) {
     expr::term_ref var = state_vars[i];
     const expr::term& var_term = tm().term_of(var);
     std::string var_name = name_transformer->apply(tm().get_variable_name(var_term));
-    out << "    " << var_name << ": " << tm().type_of(var_term) << ";" << std::endl;
+    out << "    " << var_name << ": " << tm().type_of(var_term) << ";\n";
   }
-  out << std::endl;
+  out << "\n";
 
   const std::vector<expr::term_ref>& input_vars = st->get_variables(system::state_type::STATE_INPUT);
   if (input_vars.size() > 0) {
-    out << "IVAR" << std::endl;
+    out << "IVAR\n";
     for (size_t i = 0; i < input_vars.size(); ++ i) {
       expr::term_ref var = input_vars[i];
       const expr::term& var_term = tm().term_of(var);
       std::string var_name = name_transformer->apply(tm().get_variable_name(var_term));
-      out << "    " << var_name << ": " << tm().type_of(var_term) << ";" << std::endl;
+      out << "    " << var_name << ": " << tm().type_of(var_term) << ";\n";
     }
-    out << std::endl;
+    out << "\n";
   }
 
   // Get the let definitions
@@ -138,46 +139,46 @@ void translator::to_stream_nuxmv(std::ostream& out) const {
   const expr::term& init = tm().term_of(d_ts->get_initial_states());
   const expr::term& invar = tm().term_of(d_sf->get_formula());
 
-  expr::term::expr_let_cache let_cache;
+  expr::term_definitions defs(tm(), "_def");
   std::vector<expr::term_ref> definitions;
-  trans.mk_let_cache(tm(), let_cache, definitions);
-  init.mk_let_cache(tm(), let_cache, definitions);
-  invar.mk_let_cache(tm(), let_cache, definitions);
+  defs.add(d_ts->get_transition_relation(), definitions);
+  defs.add(d_ts->get_initial_states(), definitions);
+  defs.add(d_sf->get_formula(), definitions);
 
   if (definitions.size()) {
-    out << "DEFINE" << std::endl;
+    out << "DEFINE\n";
     for (size_t i = 0; i < definitions.size(); ++ i) {
-      expr::term::expr_let_cache::const_iterator find = let_cache.find(definitions[i]);
-      assert(find != let_cache.end());
-      out << "    " << find->second << " := ";
-      tm().term_of(definitions[i]).to_stream_nuxmv_without_let(out, tm(), let_cache, false);
-      out << ";" << std::endl;
+      out << "    ";
+      defs.output_name(out, definitions[i]);
+      out << " := ";
+      tm().term_of(definitions[i]).to_stream_nuxmv_without_let(out, tm(), defs, false);
+      out << ";\n";
     }
   }
-  out << std::endl;
+  out << "\n";
 
   // The transition relation
-  out << "TRANS" << std::endl;
+  out << "TRANS\n";
   out << "    ";
-  trans.to_stream_nuxmv_without_let(out, tm(), let_cache);
-  out << ";" << std::endl;
-  out << std::endl;
+  trans.to_stream_nuxmv_without_let(out, tm(), defs);
+  out << ";\n";
+  out << "\n";
 
   // The initial state
   st->use_namespace(system::state_type::STATE_CURRENT);
-  out << "INIT" << std::endl;
+  out << "INIT\n";
   out << "    ";
-  init.to_stream_nuxmv_without_let(out, tm(), let_cache);
-  out << ";" << std::endl;
-  out << std::endl;
+  init.to_stream_nuxmv_without_let(out, tm(), defs);
+  out << ";\n";
+  out << "\n";
   ctx().tm().pop_namespace();
 
   // Output the query
   st->use_namespace(system::state_type::STATE_CURRENT);
-  out << "INVARSPEC" << std::endl;
+  out << "INVARSPEC\n";
   out << "    ";
-  invar.to_stream_nuxmv_without_let(out, tm(), let_cache);
-  out << ";" << std::endl;
+  invar.to_stream_nuxmv_without_let(out, tm(), defs);
+  out << ";\n";
   ctx().tm().pop_namespace();
 
   // State type namespace
@@ -217,7 +218,7 @@ void translator::to_stream_horn(std::ostream& out) const {
   quant_vars_state << expr::set_output_language(output::HORN);
   quant_vars_state << expr::set_tm(ctx().tm());
 
-  out << "(set-logic HORN)" << std::endl;
+  out << "(set-logic HORN)\n";
 
   // The invariant we're looking for
   out << "(declare-fun invariant (";
@@ -242,19 +243,19 @@ void translator::to_stream_horn(std::ostream& out) const {
     quant_vars_state << "(" << state_id << " " << type << ")";
     quant_vars_trans << " (" << next_id << " " << type << ")";
   }
-  out << ") Bool)" << std::endl;
-  out << std::endl;
+  out << ") Bool)\n";
+  out << "\n";
 
   // The initial state
   expr::term_ref I = d_ts->get_initial_states();
-  out << ";; Initial state" << std::endl;
-  out << "(assert" << std::endl;
-  out << "  (forall (" << quant_vars_state.str() << ")" << std::endl;
-  out << "    (=> " << I << std::endl;
-  out << "        (invariant " << state_vars.str() << "))" << std::endl;
-  out << "  )" << std::endl;
-  out << ")" << std::endl;
-  out << std::endl;
+  out << ";; Initial state\n";
+  out << "(assert\n";
+  out << "  (forall (" << quant_vars_state.str() << ")\n";
+  out << "    (=> " << I << "\n";
+  out << "        (invariant " << state_vars.str() << "))\n";
+  out << "  )\n";
+  out << ")\n";
+  out << "\n";
 
   // Add input vars to the transition quant
   const expr::term& input_type_term = tm().term_of(state_type->get_input_type_var());
@@ -268,32 +269,32 @@ void translator::to_stream_horn(std::ostream& out) const {
 
   // The transition relation
   expr::term_ref T = d_ts->get_transition_relation();
-  out << ";; Transition relation" << std::endl;
-  out << "(assert" << std::endl;
-  out << "  (forall (" << quant_vars_trans.str() << ")" << std::endl;
-  out << "    (=> (and (invariant " << state_vars.str() << ")" << std::endl;
-  out << "             " << T << std::endl;
-  out << "        )" << std::endl;
-  out << "        (invariant " << next_vars.str() << ")" << std::endl;
-  out << "    )" << std::endl;
-  out << "  )" << std::endl;
-  out << ")" << std::endl;
-  out << std::endl;
+  out << ";; Transition relation\n";
+  out << "(assert\n";
+  out << "  (forall (" << quant_vars_trans.str() << ")\n";
+  out << "    (=> (and (invariant " << state_vars.str() << ")\n";
+  out << "             " << T << "\n";
+  out << "        )\n";
+  out << "        (invariant " << next_vars.str() << ")\n";
+  out << "    )\n";
+  out << "  )\n";
+  out << ")\n";
+  out << "\n";
 
   // The query
   expr::term_ref Q = d_sf->get_formula();
-  out << ";; Property" << std::endl;
-  out << "(assert" << std::endl;
-  out << "  (forall (" << quant_vars_state.str() << ")" << std::endl;
-  out << "    (=> (invariant " << state_vars.str() << ")" << std::endl;
-  out << "        " << Q << std::endl;
-  out << "    )" << std::endl;
-  out << "  )" << std::endl;
-  out << ")" << std::endl;
-  out << std::endl;
-
-  out << ";; Check the property" << std::endl;
-  out << "(check-sat)" << std::endl;
+  out << ";; Property\n";
+  out << "(assert\n";
+  out << "  (forall (" << quant_vars_state.str() << ")\n";
+  out << "    (=> (invariant " << state_vars.str() << ")\n";
+  out << "        " << Q << "\n";
+  out << "    )\n";
+  out << "  )\n";
+  out << ")\n";
+  out << "\n";
+
+  out << ";; Check the property\n";
+  out << "(check-sat)\n";
 
   // State type namespace
   ctx().tm().pop_namespace();
@@ -319,6 +320,7 @@ engine::result translator::query(const system::transition_system* ts, const syst
   default:
     throw exception("Unsupported translation language");
   }
+  std::cout.flush();
 
   d_last_result = SILENT;
 
@@ -17,16 +17,44 @@
  */
 
 #include "expr/bitvector.h"
+#include "expr/bitvector_word.h"
 #include "utils/output.h"
 
 #include <iostream>
 #include <cassert>
+#include <cstring>
 
 namespace sally {
 namespace expr {
 
+bitvector bitvector::from_word(size_t size, uint64_t word) {
+  assert(size <= 64 && (word & ~bv_word::mask(size)) == 0);
+  bitvector result(size);
+  result.d_word = word;
+  return result;
+}
+
+void bitvector::set_value(const mpz_class& z) {
+  assert(sgn() == 0 && d_word == 0);
+  if (is_word()) {
+    if (mpz_sizeinbase(z.get_mpz_t(), 2) <= 64) {
+      d_word = mpz_get_ui(z.get_mpz_t()) & bv_word::mask(d_size);
+    } else {
+      mpz_class r;
+      mpz_fdiv_r_2exp(r.get_mpz_t(), z.get_mpz_t(), d_size);
+      d_word = mpz_get_ui(r.get_mpz_t());
+    }
+  } else {
+    d_gmp_int = z;
+    if (mpz_sizeinbase(d_gmp_int.get_mpz_t(), 2) > d_size) {
+      mpz_fdiv_r_2exp(d_gmp_int.get_mpz_t(), d_gmp_int.get_mpz_t(), d_size);
+    }
+  }
+}
+
 bitvector::bitvector(size_t size)
 : d_size(size)
+, d_word(0)
 {
   assert(size > 0);
 }
@@ -34,70 +62,92 @@ bitvector::bitvector(size_t size)
 bitvector::bitvector(const bitvector& other)
 : integer(other)
 , d_size(other.d_size)
+, d_word(other.d_word)
+{
+}
+
+bitvector::bitvector(bitvector&& other)
+: integer(std::move(other))
+, d_size(other.d_size)
+, d_word(other.d_word)
 {
 }
 
 /** Construct from integer */
 bitvector::bitvector(size_t size, const integer& z)
-: integer(z)
-, d_size(size)
+: d_size(size)
+, d_word(0)
 {
   assert(size > 0);
   assert(z.sgn() >= 0);
-  if (mpz_sizeinbase(d_gmp_int.get_mpz_t(), 2) > size) {
-    mpz_fdiv_r_2exp(d_gmp_int.get_mpz_t(), d_gmp_int.get_mpz_t(), size);
-  }
+  set_value(z.mpz());
 }
 
 bitvector::bitvector(size_t size, long x)
-: integer(x)
-, d_size(size)
+: d_size(size)
+, d_word(0)
 {
   assert(size > 0);
   assert(x >= 0);
-  if (mpz_sizeinbase(d_gmp_int.get_mpz_t(), 2) > size) {
-    mpz_fdiv_r_2exp(d_gmp_int.get_mpz_t(), d_gmp_int.get_mpz_t(), size);
+  if (is_word()) {
+    d_word = (uint64_t) x & bv_word::mask(size);
+  } else {
+    d_gmp_int = x;
   }
 }
 
+bitvector& bitvector::operator = (const bitvector& other) {
+  integer::operator = (other);
+  d_size = other.d_size;
+  d_word = other.d_word;
+  return *this;
+}
+
+bitvector& bitvector::operator = (bitvector&& other) {
+  integer::operator = (std::move(other));
+  d_size = other.d_size;
+  d_word = other.d_word;
+  return *this;
+}
+
 bitvector bitvector::one(size_t size) {
   assert(size > 0);
+  if (size <= 64) {
+    return from_word(size, bv_word::mask(size));
+  }
   return bitvector(size, integer((mpz_class(1) << size) - 1));
 }
 
+mpz_class bitvector::mpz() const {
+  if (is_word()) {
+    return mpz_class((unsigned long) d_word);
+  }
+  return d_gmp_int;
+}
+
 size_t bitvector::hash() const {
   utils::sequence_hash hasher;
-  hasher.add(d_gmp_int.get_ui());
+  hasher.add(is_word() ? d_word : d_gmp_int.get_ui());
   hasher.add(d_size);
   return hasher.get();
 }
 
 bitvector::bitvector(const char* bits, size_t base, size_t size)
-: integer(bits, base)
+: d_size(size == 0 ? strlen(bits) : size)
+, d_word(0)
 {
-  if (size == 0) {
-    d_size = strlen(bits);
-  } else {
-    d_size = size;
-  }
-  assert(sgn() >= 0);
-  if (mpz_sizeinbase(d_gmp_int.get_mpz_t(), 2) > d_size) {
-    mpz_fdiv_r_2exp(d_gmp_int.get_mpz_t(), d_gmp_int.get_mpz_t(), d_size);
-  }
+  mpz_class z(bits, base);
+  assert(mpz_sgn(z.get_mpz_t()) >= 0);
+  set_value(z);
 }
 
 bitvector::bitvector(std::string bits, size_t base, size_t size)
-: integer(bits, base)
+: d_size(size == 0 ? bits.size() : size)
+, d_word(0)
 {
-  if (size == 0) {
-    d_size = bits.size();
-  } else {
-    d_size = size;
-  }
-  assert(sgn() >= 0);
-  if (mpz_sizeinbase(d_gmp_int.get_mpz_t(), 2) > d_size) {
-    mpz_fdiv_r_2exp(d_gmp_int.get_mpz_t(), d_gmp_int.get_mpz_t(), d_size);
-  }
+  mpz_class z(bits, base);
+  assert(mpz_sgn(z.get_mpz_t()) >= 0);
+  set_value(z);
 }
 
 void bitvector::to_stream(std::ostream& out) const {
@@ -108,12 +158,21 @@ void bitvector::to_stream(std::ostream& out) const {
   case output::HORN:
   {
     out << "(_ bv";
-    integer::to_stream(out);
+    if (is_word()) {
+      out << d_word;
+    } else {
+      integer::to_stream(out);
+    }
     out  << " " << size() << ")";
     break;
   }
   case output::NUXMV:
-    out << "0d" << d_size << d_gmp_int.get_str();
+    out << "0d" << d_size;
+    if (is_word()) {
+      out << d_word;
+    } else {
+      out << d_gmp_int.get_str();
+    }
     break;
   default:
     assert(false);
@@ -147,6 +206,10 @@ std::ostream& operator << (std::ostream& out, const bitvector& bv) {
 
 bitvector& bitvector::set_bit(size_t i, bool value) {
   assert(i < d_size);
+  if (is_word()) {
+    d_word = value ? d_word | ((uint64_t) 1 << i) : d_word & ~((uint64_t) 1 << i);
+    return *this;
+  }
   if (value) {
     mpz_setbit(d_gmp_int.get_mpz_t(), i);
   } else {
@@ -157,13 +220,19 @@ bitvector& bitvector::set_bit(size_t i, bool value) {
 
 bool bitvector::get_bit(size_t i) const {
   assert(i < d_size);
+  if (is_word()) {
+    return (d_word >> i) & 1;
+  }
   return mpz_tstbit(d_gmp_int.get_mpz_t(), i);
 }
 
 integer bitvector::get_signed() const {
-  if (mpz_sizeinbase(d_gmp_int.get_mpz_t(), 2) == d_size) {
-    // The subtraction is integer here
-    return bitvector(d_size-1, d_gmp_int) - bitvector(d_size).set_bit(d_size-1, true);
+  if (is_word()) {
+    return integer((long) bv_word::to_signed(d_word, d_size));
+  }
+  if (get_bit(d_size-1)) {
+    // Negative, value - 2^size (also for size 1)
+    return integer(mpz_class(d_gmp_int - (mpz_class(1) << d_size)));
   } else {
     // No first bit
     return d_gmp_int;
@@ -171,8 +240,11 @@ integer bitvector::get_signed() const {
 }
 
 bitvector bitvector::concat(const bitvector& rhs) const {
+  if (d_size + rhs.d_size <= 64) {
+    return from_word(d_size + rhs.d_size, (d_word << rhs.d_size) | rhs.d_word);
+  }
   size_t size = d_size + rhs.d_size;
-  integer value((d_gmp_int << rhs.d_size) + rhs.d_gmp_int);
+  integer value((mpz() << rhs.d_size) + rhs.mpz());
   return bitvector(size, value);
 }
 
@@ -180,72 +252,114 @@ bitvector bitvector::extract(size_t low, size_t high) const {
   assert(low <= high);
   assert(high < d_size);
   size_t size = high-low+1;
+  if (is_word()) {
+    return from_word(size, (d_word >> low) & bv_word::mask(size));
+  }
   integer value(d_gmp_int >> low);
   return bitvector(size, value);
 }
 
 bool bitvector::uleq(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return d_word <= rhs.d_word;
+  }
   return *this <= rhs;
 }
 
 bool bitvector::sleq(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return bv_word::to_signed(d_word, d_size) <= bv_word::to_signed(rhs.d_word, d_size);
+  }
   return get_signed() <= rhs.get_signed();
 }
 
 bool bitvector::ult(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return d_word < rhs.d_word;
+  }
   return *this < rhs;
 }
 
 bool bitvector::slt(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return bv_word::to_signed(d_word, d_size) < bv_word::to_signed(rhs.d_word, d_size);
+  }
   return get_signed() < rhs.get_signed();
 }
 
 bool bitvector::ugeq(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return d_word >= rhs.d_word;
+  }
   return *this >= rhs;
 }
 
 bool bitvector::sgeq(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return bv_word::to_signed(d_word, d_size) >= bv_word::to_signed(rhs.d_word, d_size);
+  }
   return get_signed() >= rhs.get_signed();
 }
 
 bool bitvector::ugt(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return d_word > rhs.d_word;
+  }
   return *this > rhs;
 }
 
 bool bitvector::sgt(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return bv_word::to_signed(d_word, d_size) > bv_word::to_signed(rhs.d_word, d_size);
+  }
   return get_signed() > rhs.get_signed();
 }
 
 bitvector bitvector::add(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return from_word(d_size, (d_word + rhs.d_word) & bv_word::mask(d_size));
+  }
   return bitvector(d_size, *this + rhs);
 }
 
 bitvector bitvector::sub(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return from_word(d_size, (d_word - rhs.d_word) & bv_word::mask(d_size));
+  }
   // x + (-y)
   return add(rhs.neg());
 }
 
 bitvector bitvector::neg() const {
+  if (is_word()) {
+    return from_word(d_size, bv_word::neg(d_word, d_size));
+  }
   return bvnot().add(bitvector(d_size, 1));
 }
 
 bitvector bitvector::mul(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return from_word(d_size, (d_word * rhs.d_word) & bv_word::mask(d_size));
+  }
   return bitvector(d_size, *this * rhs);
 }
 
 bitvector bitvector::udiv(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return from_word(d_size, bv_word::udiv(d_word, rhs.d_word, d_size));
+  }
   // unsigned division, truncating towards 0. x/0 = 1...1
   if (rhs.sgn() == 0) {
     return one(d_size);
@@ -256,6 +370,9 @@ bitvector bitvector::udiv(const bitvector& rhs) const {
 
 bitvector bitvector::sdiv(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return from_word(d_size, bv_word::sdiv(d_word, rhs.d_word, d_size));
+  }
 //  (bvsdiv s t) abbreviates
 //        (let ((?msb_s ((_ extract |m-1| |m-1|) s))
 //              (?msb_t ((_ extract |m-1| |m-1|) t)))
@@ -282,6 +399,9 @@ bitvector bitvector::sdiv(const bitvector& rhs) const {
 }
 
 bitvector bitvector::urem(const bitvector& rhs) const {
+  if (is_word()) {
+    return from_word(d_size, bv_word::urem(d_word, rhs.d_word));
+  }
   // unsigned remainder from truncating division. x = 1...1*0 + y = rem = x
   assert(d_size == rhs.d_size);
   if (rhs.sgn() == 0) {
@@ -293,6 +413,9 @@ bitvector bitvector::urem(const bitvector& rhs) const {
 
 bitvector bitvector::srem(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return from_word(d_size, bv_word::srem(d_word, rhs.d_word, d_size));
+  }
 //  (bvsrem s t) abbreviates
 //     (let ((?msb_s ((_ extract |m-1| |m-1|) s))
 //           (?msb_t ((_ extract |m-1| |m-1|) t)))
@@ -320,6 +443,9 @@ bitvector bitvector::srem(const bitvector& rhs) const {
 
 bitvector bitvector::smod(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return from_word(d_size, bv_word::smod(d_word, rhs.d_word, d_size));
+  }
 //  (bvsmod s t) abbreviates
 //     (let ((?msb_s ((_ extract |m-1| |m-1|) s))
 //           (?msb_t ((_ extract |m-1| |m-1|) t)))
@@ -339,13 +465,13 @@ bitvector bitvector::smod(const bitvector& rhs) const {
   // get absolute value
   bitvector abs(*this), rhs_abs(rhs);
   if (msb()) {
-    abs.neg();
+    abs = abs.neg();
   }
   if (rhs.msb()) {
-    rhs.neg();
+    rhs_abs = rhs.neg();
   }
 
-  bitvector u = abs.udiv(rhs_abs);
+  bitvector u = abs.urem(rhs_abs);
   if (u == bitvector(d_size)) {
     return u;
   } else {
@@ -367,6 +493,9 @@ bitvector bitvector::smod(const bitvector& rhs) const {
 
 bitvector bitvector::shl(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return from_word(d_size, bv_word::shl(d_word, rhs.d_word, d_size));
+  }
   if (rhs.d_gmp_int >= d_size) {
     // shift more than size => 0
     return bitvector(d_size);
@@ -382,6 +511,9 @@ bitvector bitvector::shl(const bitvector& rhs) const {
 
 bitvector bitvector::lshr(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return from_word(d_size, bv_word::lshr(d_word, rhs.d_word, d_size));
+  }
   if (d_size <= rhs.d_gmp_int) {
     // Shift more than size => 0
     return bitvector(d_size);
@@ -397,6 +529,9 @@ bitvector bitvector::lshr(const bitvector& rhs) const {
 
 bitvector bitvector::ashr(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return from_word(d_size, bv_word::ashr(d_word, rhs.d_word, d_size));
+  }
   if (d_size <= rhs.d_gmp_int) {
     // Shift more than size => 0 or 1 depending on top bit
     if (get_bit(d_size-1)) {
@@ -421,20 +556,32 @@ bitvector bitvector::ashr(const bitvector& rhs) const {
 
 bitvector bitvector::bvxor(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return from_word(d_size, d_word ^ rhs.d_word);
+  }
   return bitvector(d_size, integer(d_gmp_int ^ rhs.d_gmp_int));
 }
 
 bitvector bitvector::bvand(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return from_word(d_size, d_word & rhs.d_word);
+  }
   return bitvector(d_size, integer(d_gmp_int & rhs.d_gmp_int));
 }
 
 bitvector bitvector::bvor(const bitvector& rhs) const {
   assert(d_size == rhs.d_size);
+  if (is_word()) {
+    return from_word(d_size, d_word | rhs.d_word);
+  }
   return bitvector(d_size, integer(d_gmp_int | rhs.d_gmp_int));
 }
 
 bitvector bitvector::bvnot() const {
+  if (is_word()) {
+    return from_word(d_size, ~d_word & bv_word::mask(d_size));
+  }
   return bvxor(one(d_size));
 }
 
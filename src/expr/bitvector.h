@@ -19,25 +19,39 @@
 #pragma once
 
 #include <iosfwd>
+#include <stdint.h>
 #include "expr/integer.h"
 #include "utils/hash.h"
 
 namespace sally {
 namespace expr {
 
+/**
+ * Bit-vectors of a fixed size. Bit-vectors of at most 64 bits are kept in a
+ * machine word (the integer base is then unused), larger ones in the integer.
+ */
 class bitvector : protected integer {
 
   /** The size in bits */
   size_t d_size;
 
+  /** The value, if d_size <= 64 */
+  uint64_t d_word;
+
+  /** Set the value to z mod 2^d_size */
+  void set_value(const mpz_class& z);
+
 public:
 
   /** Construct 0 of size 1 */
-  bitvector(): d_size(1) {}
+  bitvector(): d_size(1), d_word(0) {}
 
   /** Copy constructor */
   bitvector(const bitvector& other);
 
+  /** Move constructor */
+  bitvector(bitvector&& other);
+
   /** Construct 0 */
   explicit bitvector(size_t size);
 
@@ -53,23 +67,37 @@ public:
   /** Construct from a string representation */
   explicit bitvector(std::string bits, size_t base = 2, size_t size = 0);
 
+  /** Assignment */
+  bitvector& operator = (const bitvector& other);
+
+  /** Move assignment */
+  bitvector& operator = (bitvector&& other);
+
   /** Get the size of the bitvector */
   size_t size() const { return d_size; }
 
+  /** Is the value kept in a machine word */
+  bool is_word() const { return d_size <= 64; }
+
+  /** Get the value as a word (only if is_word()) */
+  uint64_t get_word() const { return d_word; }
+
+  /** Construct from a word, size <= 64 (assumes the bits above size are 0) */
+  static bitvector from_word(size_t size, uint64_t word);
+
   /** Return bitvector 1..1 */
   static bitvector one(size_t size);
 
   /** Get the integer */
-  const mpz_class& mpz() const {
-    return d_gmp_int;
-  }
+  mpz_class mpz() const;
 
   /** Hash */
   size_t hash() const;
 
   /** Compare */
   bool operator == (const bitvector& other) const {
-    return d_size == other.d_size && cmp(other) == 0;
+    if (d_size != other.d_size) return false;
+    return is_word() ? d_word == other.d_word : cmp(other) == 0;
   }
 
   /** Output to stream */
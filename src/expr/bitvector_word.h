@@ -0,0 +1,111 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace sally {
+namespace expr {
+
+/**
+ * Bit-vector operations on machine words, for widths 1 to 64. The words are
+ * always kept with the bits above the width cleared. The semantics are the
+ * same as the ones of expr::bitvector.
+ */
+namespace bv_word {
+
+/** Mask of the lower width bits */
+inline uint64_t mask(unsigned width) {
+  return width >= 64 ? ~(uint64_t)0 : (((uint64_t)1 << width) - 1);
+}
+
+/** The most significant bit */
+inline bool msb(uint64_t x, unsigned width) {
+  return (x >> (width - 1)) & 1;
+}
+
+/** Signed interpretation */
+inline int64_t to_signed(uint64_t x, unsigned width) {
+  return ((int64_t)(x << (64 - width))) >> (64 - width);
+}
+
+inline uint64_t neg(uint64_t x, unsigned width) {
+  return (-x) & mask(width);
+}
+
+/** Unsigned division, x/0 = 1...1 */
+inline uint64_t udiv(uint64_t x, uint64_t y, unsigned width) {
+  return y == 0 ? mask(width) : x / y;
+}
+
+/** Unsigned remainder, x%0 = x */
+inline uint64_t urem(uint64_t x, uint64_t y) {
+  return y == 0 ? x : x % y;
+}
+
+/** Signed division, truncating (reduced to unsigned division) */
+inline uint64_t sdiv(uint64_t x, uint64_t y, unsigned width) {
+  bool x_neg = msb(x, width), y_neg = msb(y, width);
+  uint64_t q = udiv(x_neg ? neg(x, width) : x, y_neg ? neg(y, width) : y, width);
+  return x_neg != y_neg ? neg(q, width) : q;
+}
+
+/** Signed remainder (sign follows the dividend) */
+inline uint64_t srem(uint64_t x, uint64_t y, unsigned width) {
+  bool x_neg = msb(x, width), y_neg = msb(y, width);
+  uint64_t r = urem(x_neg ? neg(x, width) : x, y_neg ? neg(y, width) : y);
+  return x_neg ? neg(r, width) : r;
+}
+
+/** Signed modulus (sign follows the divisor) */
+inline uint64_t smod(uint64_t x, uint64_t y, unsigned width) {
+  bool x_neg = msb(x, width), y_neg = msb(y, width);
+  uint64_t u = urem(x_neg ? neg(x, width) : x, y_neg ? neg(y, width) : y);
+  if (u == 0 || x_neg == y_neg) {
+    return x_neg ? neg(u, width) : u;
+  } else if (x_neg) {
+    return (neg(u, width) + y) & mask(width);
+  } else {
+    return (u + y) & mask(width);
+  }
+}
+
+/** Shift left, 0 if shifting by width or more */
+inline uint64_t shl(uint64_t x, uint64_t y, unsigned width) {
+  return y >= width ? 0 : (x << y) & mask(width);
+}
+
+/** Logical shift right, 0 if shifting by width or more */
+inline uint64_t lshr(uint64_t x, uint64_t y, unsigned width) {
+  return y >= width ? 0 : x >> y;
+}
+
+/** Arithmetic shift right */
+inline uint64_t ashr(uint64_t x, uint64_t y, unsigned width) {
+  if (y >= width) {
+    return msb(x, width) ? mask(width) : 0;
+  } else {
+    return (uint64_t)(to_signed(x, width) >> y) & mask(width);
+  }
+}
+
+}
+
+}
+}
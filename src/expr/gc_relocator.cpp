@@ -105,18 +105,7 @@ void gc_relocator::reloc(std::set<term_ref_strong>& t_set) const {
 }
 
 void gc_relocator::reloc(expr::term_manager::substitution_map& t_map) const {
-  expr::term_manager::substitution_map new_map;
-  expr::term_manager::substitution_map::const_iterator it = t_map.begin(), it_end = t_map.end();
-  for (; it != it_end; ++ it) {
-    expr::term_ref key = it->first;
-    expr::term_ref value = it->second;
-    reloc(key);
-    reloc(value);
-    if (!key.is_null() && !value.is_null()) {
-      new_map[key] = value;
-    }
-  }
-  new_map.swap(t_map);
+  t_map.reloc(*this);
 }
 
 
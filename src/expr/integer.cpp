@@ -28,16 +28,17 @@ namespace sally {
 namespace expr {
 
 integer::integer(const rational& q, bool round_up)
-: d_gmp_int(0)
+: d_gmp_int()
 {
+  mpq_class q_gmp = q.mpq();
   if (round_up) {
-    mpz_fdiv_q(d_gmp_int.get_mpz_t(),
-        q.mpq().get_num_mpz_t(),
-        q.mpq().get_den_mpz_t());
-  } else {
     mpz_cdiv_q(d_gmp_int.get_mpz_t(),
-        q.mpq().get_num_mpz_t(),
-        q.mpq().get_den_mpz_t());
+        q_gmp.get_num_mpz_t(),
+        q_gmp.get_den_mpz_t());
+  } else {
+    mpz_fdiv_q(d_gmp_int.get_mpz_t(),
+        q_gmp.get_num_mpz_t(),
+        q_gmp.get_den_mpz_t());
   }
 }
 
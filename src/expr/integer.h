@@ -20,6 +20,7 @@
 
 #include <iosfwd>
 #include <cstddef>
+#include <utility>
 #include <gmpxx.h>
 
 #include "utils/hash.h"
@@ -41,10 +42,12 @@ protected:
 
 public:
 
-  /** Default construct a 0 */
-  integer(): d_gmp_int(0) {}
+  /** Default construct a 0 (GMP doesn't allocate until needed) */
+  integer(): d_gmp_int() {}
   /** Copy construct */
   integer(const integer& z): d_gmp_int(z.d_gmp_int) {}
+  /** Move construct */
+  integer(integer&& z): d_gmp_int(std::move(z.d_gmp_int)) {}
   /** Construct from GMP */
   integer(const mpz_class& z) : d_gmp_int(z) {}
   /** Construct from GMP */
@@ -58,6 +61,11 @@ public:
   /** Construct from rational: round_up ? ceil : floor */
   integer(const rational& q, bool round_up = false);
 
+  /** Assignment */
+  integer& operator = (const integer& z) { d_gmp_int = z.d_gmp_int; return *this; }
+  /** Move assignment */
+  integer& operator = (integer&& z) { d_gmp_int.swap(z.d_gmp_int); return *this; }
+
   // Arithmetic
 
   integer operator + (const integer& other) const;
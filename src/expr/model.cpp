@@ -127,6 +127,17 @@ value model::get_variable_value(expr::term_ref var, const expr::term_manager::su
   }
 }
 
+const value& model::get_variable_value_ref(expr::term_ref var) const {
+  assert(d_tm.term_of(var).op() == expr::VARIABLE);
+  const_iterator find = d_variable_to_value_map.find(var);
+  if (find == d_variable_to_value_map.end()) {
+    std::stringstream ss;
+    ss << set_tm(d_tm) << "Variable " << var << " is not part of the model.";
+    throw exception(ss.str());
+  }
+  return find->second;
+}
+
 value model::get_term_value(expr::term_ref t) const {
   expr::term_manager::substitution_map renaming;
   return get_term_value(t, renaming);
@@ -568,6 +579,12 @@ bool model::is_false(expr::term_ref f, const expr::term_manager::substitution_ma
   return get_term_value(f, var_renaming) == d_false;
 }
 
+size_t model::memory_size() const {
+  // Tree nodes have the pair, three pointers and the color
+  size_t node_size = sizeof(term_to_value_map::value_type) + 4*sizeof(void*);
+  return sizeof(model) + utils::memory_of(d_variables) + d_variable_to_value_map.size()*node_size;
+}
+
 bool model::has_value(expr::term_ref var) const {
   assert(d_tm.term_of(var).op() == expr::VARIABLE);
   return d_variable_to_value_map.find(var) != d_variable_to_value_map.end();
@@ -54,6 +54,9 @@ public:
   /** Get the size of the model (number of variables) */
   size_t size() const { return d_variables.size(); }
 
+  /** Estimate of the bytes used by the model (map nodes are estimated) */
+  size_t memory_size() const;
+
   /** Clear the model */
   void clear();
 
@@ -63,6 +66,12 @@ public:
   /** Get the value of a term in the model (not just variables) */
   value get_variable_value(term_ref var) const;
 
+  /**
+   * Get the value of a variable without copying it. The variable must have a
+   * value in the model (defaults are not used).
+   */
+  const value& get_variable_value_ref(term_ref var) const;
+
   /** Get the value of a term in the model (not just variables) */
   value get_variable_value(term_ref var, const expr::term_manager::substitution_map& var_renaming) const;
 
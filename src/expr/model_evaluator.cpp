@@ -0,0 +1,830 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "expr/model_evaluator.h"
+#include "expr/bitvector_word.h"
+#include "expr/term_traversal.h"
+#include "expr/gc_relocator.h"
+#include "utils/exception.h"
+#include "utils/trace.h"
+
+#include <map>
+#include <sstream>
+#include <cassert>
+#include <boost/unordered_map.hpp>
+
+namespace sally {
+namespace expr {
+
+/** Get the word of a Boolean or bit-vector value */
+static inline uint64_t to_word(const value& v) {
+  if (v.is_bool()) {
+    return v.get_bool();
+  } else {
+    assert(v.get_bitvector().size() <= 64);
+    return v.get_bitvector().get_word();
+  }
+}
+
+/** Get the value of the word (width 0 for Booleans) */
+static inline value to_value(uint64_t x, unsigned width) {
+  if (width == 0) {
+    return value(x != 0);
+  } else {
+    return value(bitvector::from_word(width, x));
+  }
+}
+
+/** Compiles the terms bottom-up, one register per term */
+class model_evaluator::compiler {
+
+  typedef boost::unordered_map<term_ref, reg, term_ref_hasher> reg_map;
+
+  model_evaluator& d_ev;
+  term_manager& d_tm;
+  const term_manager::substitution_map& d_var_renaming;
+
+  /** Registers of the compiled terms */
+  reg_map d_regs;
+
+  /** Value registers of the converted word registers */
+  std::map<unsigned, unsigned> d_to_value;
+
+  /** Registers of the children of the current term */
+  std::vector<reg> d_children;
+
+  /** Arguments of the current instruction */
+  std::vector<unsigned> d_args;
+
+  reg new_word(unsigned width) {
+    d_ev.d_word_constants.push_back(0);
+    return reg(true, d_ev.d_word_constants.size() - 1, width);
+  }
+
+  reg new_value() {
+    d_ev.d_value_constants.push_back(value());
+    return reg(false, d_ev.d_value_constants.size() - 1, 0);
+  }
+
+  void emit(opcode op, reg dst, unsigned width = 0, unsigned aux = 0, unsigned ext = 0) {
+    instruction ins;
+    ins.op = op;
+    ins.dst = dst.index;
+    ins.first = d_ev.d_arguments.size();
+    ins.size = d_args.size();
+    ins.width = width;
+    ins.aux = aux;
+    ins.ext = ext;
+    d_ev.d_arguments.insert(d_ev.d_arguments.end(), d_args.begin(), d_args.end());
+    d_ev.d_program.push_back(ins);
+    d_args.clear();
+  }
+
+  /** Get the register as a value register, converting if necessary */
+  unsigned as_value(const reg& r) {
+    if (!r.is_word) {
+      return r.index;
+    }
+    std::map<unsigned, unsigned>::const_iterator find = d_to_value.find(r.index);
+    if (find != d_to_value.end()) {
+      return find->second;
+    }
+    reg v = new_value();
+    d_args.push_back(r.index);
+    emit(OP_TO_VALUE, v, r.width);
+    d_to_value[r.index] = v.index;
+    return v.index;
+  }
+
+  /** Add all the children as word arguments */
+  void add_word_args() {
+    for (size_t i = 0; i < d_children.size(); ++ i) {
+      assert(d_children[i].is_word);
+      d_args.push_back(d_children[i].index);
+    }
+  }
+
+  /** Add all the children as value arguments */
+  void add_value_args() {
+    std::vector<unsigned> args;
+    for (size_t i = 0; i < d_children.size(); ++ i) {
+      args.push_back(as_value(d_children[i]));
+    }
+    d_args.swap(args);
+  }
+
+  /** Are all the children in words */
+  bool children_words() const {
+    for (size_t i = 0; i < d_children.size(); ++ i) {
+      if (!d_children[i].is_word) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /** Make the result register of t of given type */
+  reg new_result(const term& t, bool& is_word) {
+    term_ref type = d_tm.base_type_of(t);
+    const term& type_term = d_tm.term_of(type);
+    switch (type_term.op()) {
+    case TYPE_BOOL:
+      is_word = true;
+      return new_word(0);
+    case TYPE_BITVECTOR: {
+      size_t width = d_tm.get_bitvector_type_size(type);
+      if (width <= 64) {
+        is_word = true;
+        return new_word(width);
+      }
+      break;
+    }
+    default:
+      break;
+    }
+    is_word = false;
+    return new_value();
+  }
+
+  /** Compile a bit-vector operation with children in words */
+  void compile_bv_word(term_ref t, const term& t_term, reg r) {
+    unsigned width = d_children[0].width;
+    add_word_args();
+    switch (t_term.op()) {
+    case TERM_BV_ADD: emit(OP_BV_ADD, r, width); break;
+    case TERM_BV_SUB: emit(d_children.size() == 1 ? OP_BV_NEG : OP_BV_SUB, r, width); break;
+    case TERM_BV_NEG: emit(OP_BV_NEG, r, width); break;
+    case TERM_BV_MUL: emit(OP_BV_MUL, r, width); break;
+    case TERM_BV_UDIV: emit(OP_BV_UDIV, r, width); break;
+    case TERM_BV_SDIV: emit(OP_BV_SDIV, r, width); break;
+    case TERM_BV_UREM: emit(OP_BV_UREM, r, width); break;
+    case TERM_BV_SREM: emit(OP_BV_SREM, r, width); break;
+    case TERM_BV_SMOD: emit(OP_BV_SMOD, r, width); break;
+    case TERM_BV_SHL: emit(OP_BV_SHL, r, width); break;
+    case TERM_BV_LSHR: emit(OP_BV_LSHR, r, width); break;
+    case TERM_BV_ASHR: emit(OP_BV_ASHR, r, width); break;
+    case TERM_BV_NOT: emit(OP_BV_NOT, r, width); break;
+    case TERM_BV_AND: emit(OP_BV_AND, r, width); break;
+    case TERM_BV_OR: emit(OP_BV_OR, r, width); break;
+    case TERM_BV_XOR: emit(OP_BV_XOR, r, width); break;
+    case TERM_BV_NAND: emit(OP_BV_NAND, r, width); break;
+    case TERM_BV_NOR: emit(OP_BV_NOR, r, width); break;
+    case TERM_BV_XNOR: emit(OP_BV_XNOR, r, width); break;
+    case TERM_BV_ULEQ: emit(OP_BV_ULEQ, r, width); break;
+    case TERM_BV_SLEQ: emit(OP_BV_SLEQ, r, width); break;
+    case TERM_BV_ULT: emit(OP_BV_ULT, r, width); break;
+    case TERM_BV_SLT: emit(OP_BV_SLT, r, width); break;
+    case TERM_BV_UGEQ: emit(OP_BV_UGEQ, r, width); break;
+    case TERM_BV_SGEQ: emit(OP_BV_SGEQ, r, width); break;
+    case TERM_BV_UGT: emit(OP_BV_UGT, r, width); break;
+    case TERM_BV_SGT: emit(OP_BV_SGT, r, width); break;
+    case TERM_BV_EXTRACT:
+      emit(OP_BV_EXTRACT, r, r.width, 0, d_tm.get_bitvector_extract(t_term).low);
+      break;
+    case TERM_BV_EXTEND:
+      emit(OP_BV_EXTEND, r, width, 0, d_tm.get_bitvector_sgn_extend(t_term).size);
+      break;
+    case TERM_BV_SGN_EXTEND:
+      emit(OP_BV_SGN_EXTEND, r, width, 0, d_tm.get_bitvector_sgn_extend(t_term).size);
+      break;
+    case TERM_BV_CONCAT: {
+      // Chain of binary concatenations
+      d_args.clear();
+      reg acc = d_children[0];
+      for (size_t i = 1; i < d_children.size(); ++ i) {
+        reg dst = i + 1 == d_children.size() ? r : new_word(acc.width + d_children[i].width);
+        d_args.push_back(acc.index);
+        d_args.push_back(d_children[i].index);
+        emit(OP_BV_CONCAT, dst, dst.width, 0, d_children[i].width);
+        acc = dst;
+      }
+      break;
+    }
+    default: {
+      std::stringstream ss;
+      ss << set_tm(d_tm) << "model_evaluator: can't evaluate " << t;
+      throw exception(ss.str());
+    }
+    }
+  }
+
+public:
+
+  compiler(model_evaluator& ev, const term_manager::substitution_map& var_renaming)
+  : d_ev(ev)
+  , d_tm(ev.d_tm)
+  , d_var_renaming(var_renaming)
+  {}
+
+  // Visit the terms not compiled yet, but not the variable types
+  visitor_match_result match(term_ref t) {
+    if (d_regs.find(t) != d_regs.end()) {
+      return DONT_VISIT_AND_BREAK;
+    }
+    if (d_tm.term_of(t).op() == VARIABLE) {
+      return VISIT_AND_BREAK;
+    }
+    return VISIT_AND_CONTINUE;
+  }
+
+  void visit(term_ref t) {
+
+    const term& t_term = d_tm.term_of(t);
+    term_op op = t_term.op();
+
+    // Registers of children
+    d_children.clear();
+    if (op != VARIABLE) {
+      for (size_t i = 0; i < t_term.size(); ++ i) {
+        reg_map::const_iterator find = d_regs.find(t_term[i]);
+        assert(find != d_regs.end());
+        d_children.push_back(find->second);
+      }
+    }
+
+    // Conversion to real is a no-op
+    if (op == TERM_TO_REAL) {
+      d_regs[t] = d_children[0];
+      return;
+    }
+
+    bool is_word;
+    reg r = new_result(t_term, is_word);
+
+    switch (op) {
+    case VARIABLE: {
+      term_manager::substitution_map::const_iterator find = d_var_renaming.find(t);
+      d_ev.d_variables.push_back(find == d_var_renaming.end() ? t : find->second);
+      emit(is_word ? OP_LOAD_WORD : OP_LOAD_VALUE, r, r.width, d_ev.d_variables.size() - 1);
+      break;
+    }
+    case CONST_BOOL:
+      d_ev.d_word_constants[r.index] = d_tm.get_boolean_constant(t_term);
+      break;
+    case CONST_BITVECTOR: {
+      bitvector bv = d_tm.get_bitvector_constant(t_term);
+      if (is_word) {
+        d_ev.d_word_constants[r.index] = bv.get_word();
+      } else {
+        d_ev.d_value_constants[r.index] = value(bv);
+      }
+      break;
+    }
+    case CONST_RATIONAL:
+      d_ev.d_value_constants[r.index] = value(d_tm.get_rational_constant(t_term));
+      break;
+    case CONST_ENUM:
+      d_ev.d_value_constants[r.index] = value(d_tm.get_enum_constant(t_term));
+      break;
+    case TERM_ITE:
+      if (is_word) {
+        add_word_args();
+        emit(OP_ITE_WORD, r);
+      } else {
+        unsigned c = d_children[0].index;
+        unsigned t_value = as_value(d_children[1]);
+        unsigned f_value = as_value(d_children[2]);
+        d_args.push_back(c);
+        d_args.push_back(t_value);
+        d_args.push_back(f_value);
+        emit(OP_ITE_VALUE, r);
+      }
+      break;
+    case TERM_EQ:
+      if (children_words()) {
+        add_word_args();
+        emit(OP_EQ_WORD, r);
+      } else {
+        add_value_args();
+        emit(OP_EQ_VALUE, r);
+      }
+      break;
+    case TERM_AND:
+      add_word_args();
+      emit(OP_AND, r);
+      break;
+    case TERM_OR:
+      add_word_args();
+      emit(OP_OR, r);
+      break;
+    case TERM_NOT:
+      add_word_args();
+      emit(OP_NOT, r);
+      break;
+    case TERM_IMPLIES:
+      add_word_args();
+      emit(OP_IMPLIES, r);
+      break;
+    case TERM_XOR:
+      add_word_args();
+      emit(OP_XOR, r);
+      break;
+    case TERM_ADD:
+      add_value_args();
+      emit(OP_ADD, r);
+      break;
+    case TERM_SUB:
+      add_value_args();
+      emit(d_children.size() == 1 ? OP_NEG : OP_SUB, r);
+      break;
+    case TERM_MUL:
+      add_value_args();
+      emit(OP_MUL, r);
+      break;
+    case TERM_DIV:
+      add_value_args();
+      emit(OP_DIV, r);
+      break;
+    case TERM_LEQ:
+      add_value_args();
+      emit(OP_LEQ, r);
+      break;
+    case TERM_LT:
+      add_value_args();
+      emit(OP_LT, r);
+      break;
+    case TERM_GEQ:
+      add_value_args();
+      emit(OP_GEQ, r);
+      break;
+    case TERM_GT:
+      add_value_args();
+      emit(OP_GT, r);
+      break;
+    case TERM_TO_INT:
+      add_value_args();
+      emit(OP_TO_INT, r);
+      break;
+    case TERM_IS_INT:
+      add_value_args();
+      emit(OP_IS_INT, r);
+      break;
+    case TERM_BV_ADD:
+    case TERM_BV_SUB:
+    case TERM_BV_NEG:
+    case TERM_BV_MUL:
+    case TERM_BV_UDIV:
+    case TERM_BV_SDIV:
+    case TERM_BV_UREM:
+    case TERM_BV_SREM:
+    case TERM_BV_SMOD:
+    case TERM_BV_SHL:
+    case TERM_BV_LSHR:
+    case TERM_BV_ASHR:
+    case TERM_BV_NOT:
+    case TERM_BV_AND:
+    case TERM_BV_OR:
+    case TERM_BV_XOR:
+    case TERM_BV_NAND:
+    case TERM_BV_NOR:
+    case TERM_BV_XNOR:
+    case TERM_BV_CONCAT:
+    case TERM_BV_EXTRACT:
+    case TERM_BV_EXTEND:
+    case TERM_BV_SGN_EXTEND:
+    case TERM_BV_ULEQ:
+    case TERM_BV_SLEQ:
+    case TERM_BV_ULT:
+    case TERM_BV_SLT:
+    case TERM_BV_UGEQ:
+    case TERM_BV_SGEQ:
+    case TERM_BV_UGT:
+    case TERM_BV_SGT:
+      if (is_word && children_words()) {
+        compile_bv_word(t, t_term, r);
+      } else {
+        // Wide bit-vectors go through expr::bitvector
+        unsigned ext = 0;
+        if (op == TERM_BV_EXTRACT) {
+          ext = d_tm.get_bitvector_extract(t_term).low;
+        } else if (op == TERM_BV_EXTEND || op == TERM_BV_SGN_EXTEND) {
+          ext = d_tm.get_bitvector_sgn_extend(t_term).size;
+        }
+        add_value_args();
+        if (is_word) {
+          reg v = new_value();
+          emit(OP_BV_VALUE, v, r.width, op, ext);
+          d_args.push_back(v.index);
+          emit(OP_TO_WORD, r);
+        } else {
+          emit(OP_BV_VALUE, r, d_tm.get_bitvector_size(t), op, ext);
+        }
+      }
+      break;
+    default: {
+      std::stringstream ss;
+      ss << set_tm(d_tm) << "model_evaluator: can't evaluate " << t;
+      throw exception(ss.str());
+    }
+    }
+
+    d_regs[t] = r;
+  }
+
+  reg get_reg(term_ref t) const {
+    reg_map::const_iterator find = d_regs.find(t);
+    assert(find != d_regs.end());
+    return find->second;
+  }
+};
+
+model_evaluator::model_evaluator(term_manager& tm, term_ref t)
+: d_tm(tm)
+, d_lanes(0)
+{
+  term_manager::substitution_map renaming;
+  compile(t, renaming);
+}
+
+model_evaluator::model_evaluator(term_manager& tm, term_ref t, const term_manager::substitution_map& var_renaming)
+: d_tm(tm)
+, d_lanes(0)
+{
+  compile(t, var_renaming);
+}
+
+void model_evaluator::compile(term_ref t, const term_manager::substitution_map& var_renaming) {
+  compiler c(*this, var_renaming);
+  term_traversal traversal(d_tm);
+  traversal.run(c, t);
+  d_result = c.get_reg(t);
+  TRACE("expr::model_evaluator") << "model_evaluator: compiled " << set_tm(d_tm) << t << " to " << d_program.size() << " instructions" << std::endl;
+}
+
+void model_evaluator::ensure_lanes(size_t n) const {
+  // New models get a copy of the constants
+  for (; d_lanes < n; ++ d_lanes) {
+    d_words.insert(d_words.end(), d_word_constants.begin(), d_word_constants.end());
+    d_values.insert(d_values.end(), d_value_constants.begin(), d_value_constants.end());
+  }
+}
+
+void model_evaluator::run(const model* const* models, size_t n) const {
+  assert(n <= s_max_lanes);
+  ensure_lanes(n);
+  for (size_t i = 0; i < d_program.size(); ++ i) {
+    const instruction& ins = d_program[i];
+    for (size_t k = 0; k < n; ++ k) {
+      execute(ins, k, *models[k]);
+    }
+  }
+}
+
+void model_evaluator::execute(const instruction& ins, size_t k, const model& m) const {
+
+  word* W = d_word_constants.empty() ? 0 : &d_words[k * d_word_constants.size()];
+  value* V = d_value_constants.empty() ? 0 : &d_values[k * d_value_constants.size()];
+  const unsigned* a = ins.size == 0 ? 0 : &d_arguments[ins.first];
+  unsigned width = ins.width;
+  word mask = bv_word::mask(width);
+
+  switch (ins.op) {
+  case OP_LOAD_WORD:
+    W[ins.dst] = to_word(m.get_variable_value(d_variables[ins.aux]));
+    break;
+  case OP_LOAD_VALUE:
+    V[ins.dst] = m.get_variable_value(d_variables[ins.aux]);
+    break;
+  case OP_TO_WORD:
+    W[ins.dst] = to_word(V[a[0]]);
+    break;
+  case OP_TO_VALUE:
+    V[ins.dst] = to_value(W[a[0]], width);
+    break;
+  case OP_NOT:
+    W[ins.dst] = !W[a[0]];
+    break;
+  case OP_AND: {
+    word result = 1;
+    for (size_t i = 0; result && i < ins.size; ++ i) {
+      result = W[a[i]];
+    }
+    W[ins.dst] = result;
+    break;
+  }
+  case OP_OR: {
+    word result = 0;
+    for (size_t i = 0; !result && i < ins.size; ++ i) {
+      result = W[a[i]];
+    }
+    W[ins.dst] = result;
+    break;
+  }
+  case OP_XOR: {
+    word result = 0;
+    for (size_t i = 0; i < ins.size; ++ i) {
+      result ^= W[a[i]];
+    }
+    W[ins.dst] = result;
+    break;
+  }
+  case OP_IMPLIES:
+    W[ins.dst] = !W[a[0]] || W[a[1]];
+    break;
+  case OP_EQ_WORD:
+    W[ins.dst] = W[a[0]] == W[a[1]];
+    break;
+  case OP_ITE_WORD:
+    W[ins.dst] = W[a[0]] ? W[a[1]] : W[a[2]];
+    break;
+  case OP_EQ_VALUE:
+    W[ins.dst] = V[a[0]] == V[a[1]];
+    break;
+  case OP_ITE_VALUE:
+    V[ins.dst] = W[a[0]] ? V[a[1]] : V[a[2]];
+    break;
+  case OP_ADD: {
+    value& v = V[ins.dst];
+    v = V[a[0]];
+    for (size_t i = 1; i < ins.size; ++ i) {
+      v += V[a[i]];
+    }
+    break;
+  }
+  case OP_SUB:
+    V[ins.dst] = V[a[0]] - V[a[1]];
+    break;
+  case OP_NEG:
+    V[ins.dst] = -V[a[0]];
+    break;
+  case OP_MUL: {
+    value& v = V[ins.dst];
+    v = V[a[0]];
+    for (size_t i = 1; i < ins.size; ++ i) {
+      v *= V[a[i]];
+    }
+    break;
+  }
+  case OP_DIV:
+    V[ins.dst] = V[a[0]] / V[a[1]];
+    break;
+  case OP_LEQ:
+    W[ins.dst] = V[a[0]] <= V[a[1]];
+    break;
+  case OP_LT:
+    W[ins.dst] = V[a[0]] < V[a[1]];
+    break;
+  case OP_GEQ:
+    W[ins.dst] = V[a[0]] >= V[a[1]];
+    break;
+  case OP_GT:
+    W[ins.dst] = V[a[0]] > V[a[1]];
+    break;
+  case OP_TO_INT:
+    V[ins.dst] = V[a[0]].floor();
+    break;
+  case OP_IS_INT:
+    W[ins.dst] = V[a[0]].is_integer();
+    break;
+  case OP_BV_ADD: {
+    word result = W[a[0]];
+    for (size_t i = 1; i < ins.size; ++ i) {
+      result += W[a[i]];
+    }
+    W[ins.dst] = result & mask;
+    break;
+  }
+  case OP_BV_SUB:
+    W[ins.dst] = (W[a[0]] - W[a[1]]) & mask;
+    break;
+  case OP_BV_NEG:
+    W[ins.dst] = bv_word::neg(W[a[0]], width);
+    break;
+  case OP_BV_MUL: {
+    word result = W[a[0]];
+    for (size_t i = 1; i < ins.size; ++ i) {
+      result *= W[a[i]];
+    }
+    W[ins.dst] = result & mask;
+    break;
+  }
+  case OP_BV_UDIV:
+    W[ins.dst] = bv_word::udiv(W[a[0]], W[a[1]], width);
+    break;
+  case OP_BV_SDIV:
+    W[ins.dst] = bv_word::sdiv(W[a[0]], W[a[1]], width);
+    break;
+  case OP_BV_UREM:
+    W[ins.dst] = bv_word::urem(W[a[0]], W[a[1]]);
+    break;
+  case OP_BV_SREM:
+    W[ins.dst] = bv_word::srem(W[a[0]], W[a[1]], width);
+    break;
+  case OP_BV_SMOD:
+    W[ins.dst] = bv_word::smod(W[a[0]], W[a[1]], width);
+    break;
+  case OP_BV_SHL:
+    W[ins.dst] = bv_word::shl(W[a[0]], W[a[1]], width);
+    break;
+  case OP_BV_LSHR:
+    W[ins.dst] = bv_word::lshr(W[a[0]], W[a[1]], width);
+    break;
+  case OP_BV_ASHR:
+    W[ins.dst] = bv_word::ashr(W[a[0]], W[a[1]], width);
+    break;
+  case OP_BV_NOT:
+    W[ins.dst] = ~W[a[0]] & mask;
+    break;
+  case OP_BV_AND:
+  case OP_BV_NAND: {
+    word result = W[a[0]];
+    for (size_t i = 1; i < ins.size; ++ i) {
+      result &= W[a[i]];
+    }
+    W[ins.dst] = ins.op == OP_BV_AND ? result : ~result & mask;
+    break;
+  }
+  case OP_BV_OR:
+  case OP_BV_NOR: {
+    word result = W[a[0]];
+    for (size_t i = 1; i < ins.size; ++ i) {
+      result |= W[a[i]];
+    }
+    W[ins.dst] = ins.op == OP_BV_OR ? result : ~result & mask;
+    break;
+  }
+  case OP_BV_XOR:
+  case OP_BV_XNOR: {
+    word result = W[a[0]];
+    for (size_t i = 1; i < ins.size; ++ i) {
+      result ^= W[a[i]];
+    }
+    W[ins.dst] = ins.op == OP_BV_XOR ? result : ~result & mask;
+    break;
+  }
+  case OP_BV_CONCAT:
+    W[ins.dst] = (W[a[0]] << ins.ext) | W[a[1]];
+    break;
+  case OP_BV_EXTRACT:
+    W[ins.dst] = (W[a[0]] >> ins.ext) & mask;
+    break;
+  case OP_BV_EXTEND:
+    W[ins.dst] = W[a[0]];
+    break;
+  case OP_BV_SGN_EXTEND:
+    W[ins.dst] = (word)bv_word::to_signed(W[a[0]], width) & bv_word::mask(width + ins.ext);
+    break;
+  case OP_BV_ULEQ:
+    W[ins.dst] = W[a[0]] <= W[a[1]];
+    break;
+  case OP_BV_SLEQ:
+    W[ins.dst] = bv_word::to_signed(W[a[0]], width) <= bv_word::to_signed(W[a[1]], width);
+    break;
+  case OP_BV_ULT:
+    W[ins.dst] = W[a[0]] < W[a[1]];
+    break;
+  case OP_BV_SLT:
+    W[ins.dst] = bv_word::to_signed(W[a[0]], width) < bv_word::to_signed(W[a[1]], width);
+    break;
+  case OP_BV_UGEQ:
+    W[ins.dst] = W[a[0]] >= W[a[1]];
+    break;
+  case OP_BV_SGEQ:
+    W[ins.dst] = bv_word::to_signed(W[a[0]], width) >= bv_word::to_signed(W[a[1]], width);
+    break;
+  case OP_BV_UGT:
+    W[ins.dst] = W[a[0]] > W[a[1]];
+    break;
+  case OP_BV_SGT:
+    W[ins.dst] = bv_word::to_signed(W[a[0]], width) > bv_word::to_signed(W[a[1]], width);
+    break;
+  case OP_BV_VALUE: {
+    const bitvector& lhs = V[a[0]].get_bitvector();
+    bitvector result;
+    switch ((term_op) ins.aux) {
+    case TERM_BV_ADD:
+    case TERM_BV_MUL:
+    case TERM_BV_AND:
+    case TERM_BV_OR:
+    case TERM_BV_XOR:
+    case TERM_BV_NAND:
+    case TERM_BV_NOR:
+    case TERM_BV_XNOR:
+    case TERM_BV_CONCAT:
+      result = lhs;
+      for (size_t i = 1; i < ins.size; ++ i) {
+        const bitvector& rhs = V[a[i]].get_bitvector();
+        switch ((term_op) ins.aux) {
+        case TERM_BV_ADD: result = result.add(rhs); break;
+        case TERM_BV_MUL: result = result.mul(rhs); break;
+        case TERM_BV_AND: case TERM_BV_NAND: result = result.bvand(rhs); break;
+        case TERM_BV_OR: case TERM_BV_NOR: result = result.bvor(rhs); break;
+        case TERM_BV_XOR: case TERM_BV_XNOR: result = result.bvxor(rhs); break;
+        default: result = result.concat(rhs);
+        }
+      }
+      if ((term_op) ins.aux == TERM_BV_NAND || (term_op) ins.aux == TERM_BV_NOR || (term_op) ins.aux == TERM_BV_XNOR) {
+        result = result.bvnot();
+      }
+      break;
+    case TERM_BV_SUB:
+      result = ins.size == 1 ? lhs.neg() : lhs.sub(V[a[1]].get_bitvector());
+      break;
+    case TERM_BV_NEG: result = lhs.neg(); break;
+    case TERM_BV_NOT: result = lhs.bvnot(); break;
+    case TERM_BV_UDIV: result = lhs.udiv(V[a[1]].get_bitvector()); break;
+    case TERM_BV_SDIV: result = lhs.sdiv(V[a[1]].get_bitvector()); break;
+    case TERM_BV_UREM: result = lhs.urem(V[a[1]].get_bitvector()); break;
+    case TERM_BV_SREM: result = lhs.srem(V[a[1]].get_bitvector()); break;
+    case TERM_BV_SMOD: result = lhs.smod(V[a[1]].get_bitvector()); break;
+    case TERM_BV_SHL: result = lhs.shl(V[a[1]].get_bitvector()); break;
+    case TERM_BV_LSHR: result = lhs.lshr(V[a[1]].get_bitvector()); break;
+    case TERM_BV_ASHR: result = lhs.ashr(V[a[1]].get_bitvector()); break;
+    case TERM_BV_EXTRACT: result = lhs.extract(ins.ext, ins.ext + width - 1); break;
+    case TERM_BV_EXTEND:
+      result = ins.ext == 0 ? lhs : bitvector(ins.ext).concat(lhs);
+      break;
+    case TERM_BV_SGN_EXTEND:
+      if (ins.ext == 0) {
+        result = lhs;
+      } else {
+        result = lhs.msb() ? bitvector::one(ins.ext).concat(lhs) : bitvector(ins.ext).concat(lhs);
+      }
+      break;
+    case TERM_BV_ULEQ: V[ins.dst] = lhs.uleq(V[a[1]].get_bitvector()); return;
+    case TERM_BV_SLEQ: V[ins.dst] = lhs.sleq(V[a[1]].get_bitvector()); return;
+    case TERM_BV_ULT: V[ins.dst] = lhs.ult(V[a[1]].get_bitvector()); return;
+    case TERM_BV_SLT: V[ins.dst] = lhs.slt(V[a[1]].get_bitvector()); return;
+    case TERM_BV_UGEQ: V[ins.dst] = lhs.ugeq(V[a[1]].get_bitvector()); return;
+    case TERM_BV_SGEQ: V[ins.dst] = lhs.sgeq(V[a[1]].get_bitvector()); return;
+    case TERM_BV_UGT: V[ins.dst] = lhs.ugt(V[a[1]].get_bitvector()); return;
+    case TERM_BV_SGT: V[ins.dst] = lhs.sgt(V[a[1]].get_bitvector()); return;
+    default:
+      assert(false);
+    }
+    V[ins.dst] = result;
+    break;
+  }
+  }
+}
+
+value model_evaluator::get_result(size_t k) const {
+  if (d_result.is_word) {
+    return to_value(d_words[k * d_word_constants.size() + d_result.index], d_result.width);
+  } else {
+    return d_values[k * d_value_constants.size() + d_result.index];
+  }
+}
+
+value model_evaluator::evaluate(const model& m) const {
+  const model* models[1] = { &m };
+  run(models, 1);
+  return get_result(0);
+}
+
+void model_evaluator::evaluate(const std::vector<model::ref>& models, std::vector<value>& out) const {
+  std::vector<const model*> batch;
+  for (size_t start = 0; start < models.size(); start += s_max_lanes) {
+    batch.clear();
+    for (size_t k = start; k < models.size() && k < start + s_max_lanes; ++ k) {
+      batch.push_back(&*models[k]);
+    }
+    run(&batch[0], batch.size());
+    for (size_t k = 0; k < batch.size(); ++ k) {
+      out.push_back(get_result(k));
+    }
+  }
+}
+
+bool model_evaluator::is_true(const model& m) const {
+  const model* models[1] = { &m };
+  run(models, 1);
+  if (d_result.is_word) {
+    return d_result.width == 0 && d_words[d_result.index] != 0;
+  } else {
+    return d_values[d_result.index] == value(true);
+  }
+}
+
+void model_evaluator::is_true(const std::vector<model::ref>& models, std::vector<bool>& out) const {
+  std::vector<value> values;
+  evaluate(models, values);
+  value v_true(true);
+  for (size_t i = 0; i < values.size(); ++ i) {
+    out.push_back(values[i] == v_true);
+  }
+}
+
+void model_evaluator::gc_collect(const gc_relocator& gc_reloc) {
+  for (size_t i = 0; i < d_variables.size(); ++ i) {
+    gc_reloc.reloc(d_variables[i]);
+  }
+}
+
+}
+}
@@ -0,0 +1,226 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "expr/term_manager.h"
+#include "expr/model.h"
+#include "expr/value.h"
+
+#include <vector>
+#include <stdint.h>
+
+namespace sally {
+namespace expr {
+
+class gc_relocator;
+
+/**
+ * Compiled evaluation of a term in models. The term DAG is lowered once into
+ * a linear register program, which can then be run against many models. The
+ * registers are typed: Booleans and bit-vectors of at most 64 bits are kept
+ * in machine words, everything else (arithmetic, enums, wide bit-vectors) in
+ * expr::value registers.
+ *
+ * Several models can be evaluated in one pass, in which case every
+ * instruction is executed for all the models before moving on to the next
+ * one. The register file is owned by the evaluator, so the evaluation is not
+ * reentrant.
+ */
+class model_evaluator {
+
+public:
+
+  /** Compile the term */
+  model_evaluator(term_manager& tm, term_ref t);
+
+  /** Compile the term, modulo the renaming (x_t -> x_model) */
+  model_evaluator(term_manager& tm, term_ref t, const term_manager::substitution_map& var_renaming);
+
+  /** Get the value of the term in the model */
+  value evaluate(const model& m) const;
+
+  /** Get the values of the term in all the models */
+  void evaluate(const std::vector<model::ref>& models, std::vector<value>& out) const;
+
+  /** Is the formula true in the model */
+  bool is_true(const model& m) const;
+
+  /** Is the formula true in the models */
+  void is_true(const std::vector<model::ref>& models, std::vector<bool>& out) const;
+
+  /** Number of instructions in the program */
+  size_t size() const { return d_program.size(); }
+
+  /** Relocate the variables of the program */
+  void gc_collect(const gc_relocator& gc_reloc);
+
+private:
+
+  typedef uint64_t word;
+
+  /** The operations of the program */
+  enum opcode {
+    // Loading variables from the model
+    OP_LOAD_WORD,
+    OP_LOAD_VALUE,
+    // Conversions between words and values
+    OP_TO_WORD,
+    OP_TO_VALUE,
+    // Boolean words
+    OP_NOT,
+    OP_AND,
+    OP_OR,
+    OP_XOR,
+    OP_IMPLIES,
+    OP_EQ_WORD,
+    OP_ITE_WORD,
+    // Values
+    OP_EQ_VALUE,
+    OP_ITE_VALUE,
+    OP_ADD,
+    OP_SUB,
+    OP_NEG,
+    OP_MUL,
+    OP_DIV,
+    OP_LEQ,
+    OP_LT,
+    OP_GEQ,
+    OP_GT,
+    OP_TO_INT,
+    OP_IS_INT,
+    // Bit-vector words
+    OP_BV_ADD,
+    OP_BV_SUB,
+    OP_BV_NEG,
+    OP_BV_MUL,
+    OP_BV_UDIV,
+    OP_BV_SDIV,
+    OP_BV_UREM,
+    OP_BV_SREM,
+    OP_BV_SMOD,
+    OP_BV_SHL,
+    OP_BV_LSHR,
+    OP_BV_ASHR,
+    OP_BV_NOT,
+    OP_BV_AND,
+    OP_BV_OR,
+    OP_BV_XOR,
+    OP_BV_NAND,
+    OP_BV_NOR,
+    OP_BV_XNOR,
+    OP_BV_CONCAT,
+    OP_BV_EXTRACT,
+    OP_BV_EXTEND,
+    OP_BV_SGN_EXTEND,
+    OP_BV_ULEQ,
+    OP_BV_SLEQ,
+    OP_BV_ULT,
+    OP_BV_SLT,
+    OP_BV_UGEQ,
+    OP_BV_SGEQ,
+    OP_BV_UGT,
+    OP_BV_SGT,
+    // Bit-vector values (wider than a word), aux is the term operation
+    OP_BV_VALUE
+  };
+
+  /** An instruction dst = op(arguments) */
+  struct instruction {
+    opcode op;
+    /** The destination register */
+    unsigned dst;
+    /** Index of the first argument register in d_arguments */
+    unsigned first;
+    /** Number of arguments */
+    unsigned size;
+    /** Bit-vector width of the arguments, or of the result for extract and concat */
+    unsigned width;
+    /** Variable index, or term operation of OP_BV_VALUE */
+    unsigned aux;
+    /** Extension size, width of the concat rhs, or low bit of extract */
+    unsigned ext;
+  };
+
+  /** A register */
+  struct reg {
+    /** Is it a word register */
+    bool is_word;
+    /** Index of the register */
+    unsigned index;
+    /** Bit-vector width if a word (0 for Booleans) */
+    unsigned width;
+    reg(): is_word(false), index(0), width(0) {}
+    reg(bool is_word, unsigned index, unsigned width)
+    : is_word(is_word), index(index), width(width) {}
+  };
+
+  class compiler;
+  friend class compiler;
+
+  /** The term manager */
+  term_manager& d_tm;
+
+  /** The program */
+  std::vector<instruction> d_program;
+
+  /** The arguments of the instructions */
+  std::vector<unsigned> d_arguments;
+
+  /** The variables to load from the model (already renamed) */
+  std::vector<term_ref> d_variables;
+
+  /** The register with the result */
+  reg d_result;
+
+  /** Word registers of one model, with constants set */
+  std::vector<word> d_word_constants;
+
+  /** Value registers of one model, with constants set */
+  std::vector<value> d_value_constants;
+
+  /** Number of models the register file is allocated for */
+  mutable size_t d_lanes;
+
+  /** The word registers, d_word_constants.size() for each model */
+  mutable std::vector<word> d_words;
+
+  /** The value registers, d_value_constants.size() for each model */
+  mutable std::vector<value> d_values;
+
+  /** Maximal number of models evaluated at once */
+  static const size_t s_max_lanes = 64;
+
+  /** Compile t into the program */
+  void compile(term_ref t, const term_manager::substitution_map& var_renaming);
+
+  /** Make sure there are registers for n models */
+  void ensure_lanes(size_t n) const;
+
+  /** Run the program on the models */
+  void run(const model* const* models, size_t n) const;
+
+  /** Run the instruction on the lane k */
+  void execute(const instruction& ins, size_t k, const model& m) const;
+
+  /** Get the result of the lane k */
+  value get_result(size_t k) const;
+};
+
+}
+}
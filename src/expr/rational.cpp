@@ -23,44 +23,203 @@
 
 #include "expr/term_manager.h"
 
+#include <limits>
 #include <cassert>
+#include <sstream>
 #include <iostream>
 
 namespace sally {
 namespace expr {
 
+/** GMP integer from a 128-bit one */
+static mpz_class to_mpz(__int128 x) {
+  bool negative = x < 0;
+  unsigned __int128 u = negative ? -(unsigned __int128) x : (unsigned __int128) x;
+  mpz_class result((unsigned long) (uint64_t) (u >> 64));
+  result <<= 64;
+  result += (unsigned long) (uint64_t) u;
+  return negative ? mpz_class(-result) : result;
+}
+
+/** Greatest common divisor */
+static unsigned __int128 gcd(unsigned __int128 a, unsigned __int128 b) {
+  while (b != 0) {
+    if ((a >> 64) == 0 && (b >> 64) == 0) {
+      // Machine word division from here on
+      uint64_t x = a, y = b;
+      while (y != 0) {
+        uint64_t t = x % y;
+        x = y;
+        y = t;
+      }
+      return x;
+    }
+    unsigned __int128 t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+void rational::set_small(int64_t n, int64_t d) {
+  assert(d > 0);
+  delete d_gmp_rat;
+  d_gmp_rat = 0;
+  d_num = n;
+  d_den = d;
+}
+
+void rational::set_gmp(mpq_class q) {
+  q.canonicalize();
+  if (mpz_fits_slong_p(q.get_num_mpz_t()) && mpz_fits_slong_p(q.get_den_mpz_t())) {
+    set_small(q.get_num().get_si(), q.get_den().get_si());
+  } else if (d_gmp_rat) {
+    d_gmp_rat->swap(q);
+  } else {
+    d_gmp_rat = new mpq_class(std::move(q));
+  }
+}
+
+void rational::set_reduced(__int128 n, __int128 d) {
+  assert(d != 0);
+  if (d < 0) {
+    n = -n;
+    d = -d;
+  }
+  unsigned __int128 g = gcd(n < 0 ? -(unsigned __int128) n : (unsigned __int128) n, d);
+  if (g > 1) {
+    n /= (__int128) g;
+    d /= (__int128) g;
+  }
+  if (n >= std::numeric_limits<int64_t>::min() && n <= std::numeric_limits<int64_t>::max() && d <= std::numeric_limits<int64_t>::max()) {
+    set_small((int64_t) n, (int64_t) d);
+  } else {
+    set_gmp(mpq_class(to_mpz(n), to_mpz(d)));
+  }
+}
+
+rational::rational(const integer& p, const integer& q)
+: d_num(0), d_den(1), d_gmp_rat(0)
+{
+  if (q.sgn() != 0 && mpz_fits_slong_p(p.mpz().get_mpz_t()) && mpz_fits_slong_p(q.mpz().get_mpz_t())) {
+    set_reduced(p.get_signed(), q.get_signed());
+  } else {
+    set_gmp(mpq_class(p.mpz(), q.mpz()));
+  }
+}
+
+rational::rational(long p, unsigned long q)
+: d_num(0), d_den(1), d_gmp_rat(0)
+{
+  if (q != 0 && q <= (unsigned long) std::numeric_limits<int64_t>::max()) {
+    set_reduced(p, q);
+  } else {
+    set_gmp(mpq_class(p, q));
+  }
+}
+
+rational::rational(std::string integer_part, std::string fractional_part)
+: d_num(0), d_den(1), d_gmp_rat(0)
+{
+  set_gmp(mpq_class(integer(integer_part + fractional_part, 10).mpz(), integer(10).pow(fractional_part.size()).mpz()));
+}
+
+rational& rational::operator = (const rational& q) {
+  if (this != &q) {
+    if (q.is_small()) {
+      set_small(q.d_num, q.d_den);
+    } else if (d_gmp_rat) {
+      *d_gmp_rat = *q.d_gmp_rat;
+    } else {
+      d_gmp_rat = new mpq_class(*q.d_gmp_rat);
+    }
+  }
+  return *this;
+}
+
+rational& rational::operator = (rational&& q) {
+  d_num = q.d_num;
+  d_den = q.d_den;
+  std::swap(d_gmp_rat, q.d_gmp_rat);
+  return *this;
+}
+
+mpq_class rational::mpq() const {
+  if (is_small()) {
+    mpq_class result;
+    mpq_set_si(result.get_mpq_t(), d_num, d_den);
+    return result;
+  } else {
+    return *d_gmp_rat;
+  }
+}
+
 size_t rational::hash() const {
   utils::sequence_hash hasher;
-  hasher.add(mpz_get_si(d_gmp_rat.get_den_mpz_t()));
-  hasher.add(mpz_get_si(d_gmp_rat.get_num_mpz_t()));
+  if (is_small()) {
+    hasher.add(d_den);
+    hasher.add(d_num);
+  } else {
+    hasher.add(mpz_get_si(d_gmp_rat->get_den_mpz_t()));
+    hasher.add(mpz_get_si(d_gmp_rat->get_num_mpz_t()));
+  }
   return hasher.get();
 }
 
+int rational::cmp(const rational& q) const {
+  if (is_small() && q.is_small()) {
+    __int128 lhs = (__int128) d_num * q.d_den;
+    __int128 rhs = (__int128) q.d_num * d_den;
+    return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+  } else {
+    return mpq_cmp(mpq().get_mpq_t(), q.mpq().get_mpq_t());
+  }
+}
+
+bool rational::operator == (const rational& q) const {
+  // Small representation is canonical
+  if (is_small() || q.is_small()) {
+    return is_small() && q.is_small() && d_num == q.d_num && d_den == q.d_den;
+  }
+  return *d_gmp_rat == *q.d_gmp_rat;
+}
+
 void rational::to_stream(std::ostream& out) const {
+  std::string num, den;
+  if (is_small()) {
+    std::stringstream ss;
+    ss << d_num;
+    num = ss.str();
+    ss.str("");
+    ss << d_den;
+    den = ss.str();
+  } else {
+    num = d_gmp_rat->get_num().get_str(10);
+    den = d_gmp_rat->get_den().get_str(10);
+  }
   output::language lang = output::get_output_language(out);
   switch (lang) {
   case output::MCMT:
   case output::MCMT_TAB:
   case output::HORN:
   {
-    const mpz_class& num = d_gmp_rat.get_num();
-    int sgn = mpz_sgn(num.get_mpz_t());
-    if (sgn == 0) {
+    int sign = sgn();
+    if (sign == 0) {
       out << "0";
     } else {
       bool is_rational = !is_integer();
       if (is_rational) {
         out << "(/ ";
       }
-      if (sgn < 0) {
-        // when printing gmp numerator skip the -, but wrap into (- )
-        out << "(- " << (d_gmp_rat.get_num().get_str().c_str() + 1) << ")";
+      if (sign < 0) {
+        // when printing the numerator skip the -, but wrap into (- )
+        out << "(- " << (num.c_str() + 1) << ")";
       } else {
         // just regular print
-        out << d_gmp_rat.get_num().get_str();
+        out << num;
       }
       if (is_rational) {
-        out << " " << d_gmp_rat.get_den().get_str(10) << ")";
+        out << " " << den << ")";
       }
     }
     break;
@@ -70,13 +229,8 @@ void rational::to_stream(std::ostream& out) const {
     if (sign == 0) {
       out << "0";
     } else if (sign > 0) {
-      if (is_integer()) {
-        // Integer output
-        out << "f'" << d_gmp_rat.get_str(10) << "/1";
-      } else {
-        // Rational output
-        out << "f'" << d_gmp_rat.get_str(10);
-      }
+      // Rational output, integers with /1
+      out << "f'" << num << "/" << den;
     } else {
       out << "-" << negate();
     }
@@ -93,147 +247,218 @@ std::ostream& operator << (std::ostream& out, const rational& q) {
 }
 
 bool rational::is_integer() const {
-  const mpz_class& den = d_gmp_rat.get_den();
-  return den == 1;
+  if (is_small()) {
+    return d_den == 1;
+  }
+  return d_gmp_rat->get_den() == 1;
 }
 
 rational rational::invert() const {
-  return rational(1 / d_gmp_rat);
+  rational result;
+  if (is_small() && d_num != 0) {
+    result.set_reduced(d_den, d_num);
+  } else {
+    result.set_gmp(1 / mpq());
+  }
+  return result;
 }
 
 rational rational::negate() const {
-  return rational(-d_gmp_rat);
+  rational result;
+  if (is_small()) {
+    result.set_reduced(-(__int128) d_num, d_den);
+  } else {
+    result.set_gmp(-*d_gmp_rat);
+  }
+  return result;
 }
 
 rational rational::floor() const {
+  if (is_small()) {
+    int64_t q = d_num / d_den;
+    if (d_num % d_den != 0 && d_num < 0) {
+      q --;
+    }
+    rational result;
+    result.set_small(q, 1);
+    return result;
+  }
   return rational(integer(*this, false), integer(1));
 }
 
 rational rational::ceiling() const {
+  if (is_small()) {
+    int64_t q = d_num / d_den;
+    if (d_num % d_den != 0 && d_num > 0) {
+      q ++;
+    }
+    rational result;
+    result.set_small(q, 1);
+    return result;
+  }
   return rational(integer(*this, true), integer(1));
 }
 
 int rational::sgn() const {
-  return mpq_sgn(d_gmp_rat.get_mpq_t());
+  if (is_small()) {
+    return d_num < 0 ? -1 : (d_num > 0 ? 1 : 0);
+  }
+  return mpq_sgn(d_gmp_rat->get_mpq_t());
 }
 
 integer rational::get_numerator() const {
-  return integer(d_gmp_rat.get_num());
+  if (is_small()) {
+    return integer((long) d_num);
+  }
+  return integer(d_gmp_rat->get_num());
 }
 
 integer rational::get_denominator() const {
-  return integer(d_gmp_rat.get_den());
+  if (is_small()) {
+    return integer((long) d_den);
+  }
+  return integer(d_gmp_rat->get_den());
 }
 
-
 rational& rational::operator = (const integer& z) {
-  d_gmp_rat = z.mpz();
-  d_gmp_rat.canonicalize();
+  if (mpz_fits_slong_p(z.mpz().get_mpz_t())) {
+    set_small(z.get_signed(), 1);
+  } else {
+    set_gmp(mpq_class(z.mpz()));
+  }
   return *this;
 }
 
 rational rational::operator + (const rational& other) const {
-  return rational(d_gmp_rat + other.d_gmp_rat);
+  rational result(*this);
+  result += other;
+  return result;
 }
 
 rational rational::operator + (const integer& other) const {
-  return rational(d_gmp_rat + other.mpz());
+  return *this + rational(other, integer(1));
 }
 
 rational& rational::operator += (const rational& other) {
-  d_gmp_rat += other.d_gmp_rat;
-  d_gmp_rat.canonicalize();
+  if (is_small() && other.is_small()) {
+    int64_t sum;
+    if (d_den == 1 && other.d_den == 1 && !__builtin_add_overflow(d_num, other.d_num, &sum)) {
+      d_num = sum;
+    } else {
+      set_reduced((__int128) d_num * other.d_den + (__int128) other.d_num * d_den, (__int128) d_den * other.d_den);
+    }
+  } else {
+    set_gmp(mpq() + other.mpq());
+  }
   return *this;
 }
 
 rational& rational::operator += (const integer& other) {
-  d_gmp_rat += other.mpz();
-  d_gmp_rat.canonicalize();
-  return *this;
+  return *this += rational(other, integer(1));
 }
 
 rational rational::operator - () const {
-  return rational(-d_gmp_rat);
+  return negate();
 }
 
 rational rational::operator - (const rational& other) const {
-  return rational(d_gmp_rat - other.d_gmp_rat);
+  rational result(*this);
+  result -= other;
+  return result;
 }
 
 rational rational::operator - (const integer& other) const {
-  return rational(d_gmp_rat - other.mpz());
+  return *this - rational(other, integer(1));
 }
 
 rational& rational::operator -= (const rational& other) {
-  d_gmp_rat -= other.d_gmp_rat;
-  d_gmp_rat.canonicalize();
+  if (is_small() && other.is_small()) {
+    int64_t diff;
+    if (d_den == 1 && other.d_den == 1 && !__builtin_sub_overflow(d_num, other.d_num, &diff)) {
+      d_num = diff;
+    } else {
+      set_reduced((__int128) d_num * other.d_den - (__int128) other.d_num * d_den, (__int128) d_den * other.d_den);
+    }
+  } else {
+    set_gmp(mpq() - other.mpq());
+  }
   return *this;
 }
 
 rational& rational::operator -= (const integer& other) {
-  d_gmp_rat -= other.mpz();
-  d_gmp_rat.canonicalize();
-  return *this;
+  return *this -= rational(other, integer(1));
 }
 
 rational rational::operator * (const rational& other) const {
-  return rational(d_gmp_rat * other.d_gmp_rat);
+  rational result(*this);
+  result *= other;
+  return result;
 }
 
 rational rational::operator * (const integer& other) const {
-  return rational(d_gmp_rat * other.mpz());
+  return *this * rational(other, integer(1));
 }
 
 rational& rational::operator *= (const rational& other) {
-  d_gmp_rat *= other.d_gmp_rat;
-  d_gmp_rat.canonicalize();
+  if (is_small() && other.is_small()) {
+    int64_t product;
+    if (d_den == 1 && other.d_den == 1 && !__builtin_mul_overflow(d_num, other.d_num, &product)) {
+      d_num = product;
+    } else {
+      set_reduced((__int128) d_num * other.d_num, (__int128) d_den * other.d_den);
+    }
+  } else {
+    set_gmp(mpq() * other.mpq());
+  }
   return *this;
 }
 
 rational& rational::operator *= (const integer& other) {
-  d_gmp_rat *= other.mpz();
-  d_gmp_rat.canonicalize();
-  return *this;
+  return *this *= rational(other, integer(1));
 }
 
-
 rational rational::operator / (const rational& other) const {
-  return rational(d_gmp_rat / other.d_gmp_rat);
+  rational result(*this);
+  result /= other;
+  return result;
 }
 
 rational rational::operator / (const integer& other) const {
-  return rational(d_gmp_rat / other.mpz());
+  return *this / rational(other, integer(1));
 }
 
 rational& rational::operator /= (const rational& other) {
-  d_gmp_rat /= other.d_gmp_rat;
-  d_gmp_rat.canonicalize();
+  if (is_small() && other.is_small() && other.d_num != 0) {
+    set_reduced((__int128) d_num * other.d_den, (__int128) d_den * other.d_num);
+  } else {
+    set_gmp(mpq() / other.mpq());
+  }
   return *this;
 }
 
 rational& rational::operator /= (const integer& other) {
-  d_gmp_rat /= other.mpz();
-  d_gmp_rat.canonicalize();
-  return *this;
+  return *this /= rational(other, integer(1));
 }
 
 bool rational::operator < (const rational& other) const {
-  return d_gmp_rat < other.d_gmp_rat;
+  return cmp(other) < 0;
 }
 
 bool rational::operator <= (const rational& other) const {
-  return d_gmp_rat <= other.d_gmp_rat;
+  return cmp(other) <= 0;
 }
 
 bool rational::operator > (const rational& other) const {
-  return d_gmp_rat > other.d_gmp_rat;
+  return cmp(other) > 0;
 }
 
 bool rational::operator >= (const rational& other) const {
-  return d_gmp_rat >= other.d_gmp_rat;
+  return cmp(other) >= 0;
 }
 
-rational::rational(const term_manager& tm, term_ref t) {
+rational::rational(const term_manager& tm, term_ref t)
+: d_num(0), d_den(1), d_gmp_rat(0)
+{
   const term& t_term = tm.term_of(t);
   *this = tm.get_rational_constant(t_term);
 }
@@ -245,4 +470,3 @@ rational rational::value_between(const rational& a, const rational& b) {
 
 }
 }
-
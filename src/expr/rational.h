@@ -22,6 +22,7 @@
 #include <gmpxx.h>
 #include <string>
 #include <iosfwd>
+#include <stdint.h>
 
 #include "utils/hash.h"
 #include "expr/integer.h"
@@ -33,50 +34,79 @@ class term_ref;
 class term_manager;
 
 /**
- * Wrapper around the GMP rational.
+ * Rational numbers. Numbers with numerator and denominator that fit into 64
+ * bits are kept inline and computed with machine arithmetic (with 128-bit
+ * intermediate results). When a result doesn't fit it is promoted to a GMP
+ * rational, and it is demoted back as soon as it fits again, so the small
+ * representation is canonical.
  */
 class rational {
-  /** The GMP object */
-  mpq_class d_gmp_rat;
+
+  /** Numerator of the small representation */
+  int64_t d_num;
+  /** Denominator of the small representation (positive, coprime with d_num) */
+  int64_t d_den;
+  /** The GMP object if the number is not small, null otherwise */
+  mpq_class* d_gmp_rat;
+
+  /** Set to the small n/d (canonical) */
+  void set_small(int64_t n, int64_t d);
+  /** Set to the GMP number q (doesn't need to be canonical) */
+  void set_gmp(mpq_class q);
+  /** Set to n/d with d != 0 (doesn't need to be canonical) */
+  void set_reduced(__int128 n, __int128 d);
+
 public:
   /** Default construct a 0 */
-  rational(): d_gmp_rat(0) { d_gmp_rat.canonicalize(); }
+  rational(): d_num(0), d_den(1), d_gmp_rat(0) {}
   /** Copy construct */
-  rational(const rational& q): d_gmp_rat(q.d_gmp_rat) { d_gmp_rat.canonicalize(); }
+  rational(const rational& q)
+  : d_num(q.d_num), d_den(q.d_den), d_gmp_rat(q.d_gmp_rat ? new mpq_class(*q.d_gmp_rat) : 0) {}
+  /** Move construct */
+  rational(rational&& q)
+  : d_num(q.d_num), d_den(q.d_den), d_gmp_rat(q.d_gmp_rat) { q.d_gmp_rat = 0; }
   /** Construct from GMP */
-  rational(const mpq_class& gmp_rat) : d_gmp_rat(gmp_rat) { d_gmp_rat.canonicalize(); }
+  rational(const mpq_class& gmp_rat): d_num(0), d_den(1), d_gmp_rat(0) { set_gmp(gmp_rat); }
   /** Construct from GMP */
-  rational(mpq_t gmp_rat): d_gmp_rat(gmp_rat) { d_gmp_rat.canonicalize(); }
+  rational(mpq_t gmp_rat): d_num(0), d_den(1), d_gmp_rat(0) { set_gmp(mpq_class(gmp_rat)); }
   /** Construct from GMP integer */
-  rational(mpz_t gmp_z): d_gmp_rat(mpz_class(gmp_z)) { d_gmp_rat.canonicalize(); }
+  rational(mpz_t gmp_z): d_num(0), d_den(1), d_gmp_rat(0) { set_gmp(mpq_class(mpz_class(gmp_z))); }
   /** Construct p/q */
-  rational(const integer& p, const integer& q): d_gmp_rat(p.mpz(), q.mpz()) { d_gmp_rat.canonicalize(); }
+  rational(const integer& p, const integer& q);
   /** Construct p/q */
-  rational(long p, unsigned long q) : d_gmp_rat(p, q) { d_gmp_rat.canonicalize(); }
+  rational(long p, unsigned long q);
   /** Construct form float */
-  explicit rational(double q): d_gmp_rat(q) { d_gmp_rat.canonicalize(); }
+  explicit rational(double q): d_num(0), d_den(1), d_gmp_rat(0) { set_gmp(mpq_class(q)); }
   /** Construct from string representation */
-  explicit rational(const char* s): d_gmp_rat(s, 10) { d_gmp_rat.canonicalize(); }
+  explicit rational(const char* s): d_num(0), d_den(1), d_gmp_rat(0) { set_gmp(mpq_class(s, 10)); }
   /** Construct from string representation */
-  explicit rational(std::string s): d_gmp_rat(s, 10) { d_gmp_rat.canonicalize(); }
+  explicit rational(std::string s): d_num(0), d_den(1), d_gmp_rat(0) { set_gmp(mpq_class(s, 10)); }
   /** Construct from string representation "1" "2" = 1.2 = 3/2 */
-  rational(std::string integer_part, std::string fractional_part)
-  : d_gmp_rat(integer(integer_part + fractional_part, 10).mpz(), integer(10).pow(fractional_part.size()).mpz())
-  { d_gmp_rat.canonicalize(); }
+  rational(std::string integer_part, std::string fractional_part);
 
   /** Cosntruct from constant integer or rational term */
   rational(const term_manager& tm, term_ref t);
 
+  ~rational() { delete d_gmp_rat; }
+
+  /** Assignment */
+  rational& operator = (const rational& q);
+  /** Move assignment */
+  rational& operator = (rational&& q);
+
+  /** Is the number in the small representation */
+  bool is_small() const { return d_gmp_rat == 0; }
+
   /** Hash of the rational */
   size_t hash() const;
   /** Compare the two numbers */
-  int cmp(const rational& q) const { return mpq_cmp(d_gmp_rat.get_mpq_t(), q.d_gmp_rat.get_mpq_t()); }
+  int cmp(const rational& q) const;
 
   /** Output to stream */
   void to_stream(std::ostream& out) const;
 
   /** Comparison */
-  bool operator == (const rational& q) const { return this->cmp(q) == 0; }
+  bool operator == (const rational& q) const;
 
   // Arithmetic
 
@@ -137,9 +167,8 @@ public:
   static
   rational value_between(const rational& a, const rational& b);
 
-  const mpq_class& mpq() const {
-    return d_gmp_rat;
-  }
+  /** Get the GMP rational */
+  mpq_class mpq() const;
 };
 
 /** Output operator */
@@ -31,21 +31,6 @@
 namespace sally {
 namespace expr {
 
-/**
- * Term references are compared directly, unless one of them is null. Null is
- * a marker that this is a term constructor, in which case the comparison is
- * done by hand.
- */
-bool term_ref_fat::operator == (const term_ref_fat& other) const {
-  if (this->is_null()) {
-    return cmp(other);
-  }
-  if (other.is_null()) {
-    return other.cmp(*this);
-  }
-  return cmp(other);
-}
-
 void term_ref::to_stream(std::ostream& out) const {
   if (is_null()) {
     out << "null";
@@ -330,23 +315,39 @@ void term::to_stream_smt_with_let(std::ostream& out, term_manager& tm, const exp
   }
 }
 
-#define SMT_REF_OUT(ref) tm.term_of(ref).to_stream_smt_without_let(out, tm, let_cache);
+/** Names from a let cache */
+class let_cache_names : public term_name_table {
+  const term::expr_let_cache& d_let_cache;
+public:
+  let_cache_names(const term::expr_let_cache& let_cache)
+  : d_let_cache(let_cache) {}
+  bool output_name(std::ostream& out, term_ref t) const {
+    term::expr_let_cache::const_iterator find = d_let_cache.find(t);
+    if (find != d_let_cache.end()) {
+      out << find->second;
+      return true;
+    }
+    return false;
+  }
+};
+
+void term::to_stream_smt_without_let(std::ostream& out, term_manager& tm, const expr_let_cache& let_cache, bool use_cache) const {
+  to_stream_smt_without_let(out, tm, let_cache_names(let_cache), use_cache);
+}
+
+#define SMT_REF_OUT(ref) tm.term_of(ref).to_stream_smt_without_let(out, tm, names);
 
 static inline
 bool isalnum_not(char c) { return !isalnum(c); }
 
-void term::to_stream_smt_without_let(std::ostream& out, term_manager& tm, const expr_let_cache& let_cache, bool use_cache) const {
+void term::to_stream_smt_without_let(std::ostream& out, term_manager& tm, const term_name_table& names, bool use_names) const {
 
   // The internals
   const term_manager_internal& tm_internal = *tm.get_internal();
 
-  // See if it's been cached already
-  if (use_cache) {
-    expr_let_cache::const_iterator find = let_cache.find(tm_internal.ref_of(*this));
-    if (find != let_cache.end()) {
-      out << find->second;
-      return;
-    }
+  // See if it has a name
+  if (use_names && names.output_name(out, tm_internal.ref_of(*this))) {
+    return;
   }
 
   switch (d_op) {
@@ -703,20 +704,20 @@ std::string get_nuxmv_operator(expr::term_op op) {
   return "unknown";
 }
 
-#define SMV_REF_OUT(ref) tm.term_of(ref).to_stream_nuxmv_without_let(out, tm, let_cache);
-
 void term::to_stream_nuxmv_without_let(std::ostream& out, term_manager& tm, const expr_let_cache& let_cache, bool use_cache_for_root) const {
+  to_stream_nuxmv_without_let(out, tm, let_cache_names(let_cache), use_cache_for_root);
+}
+
+#define SMV_REF_OUT(ref) tm.term_of(ref).to_stream_nuxmv_without_let(out, tm, names);
+
+void term::to_stream_nuxmv_without_let(std::ostream& out, term_manager& tm, const term_name_table& names, bool use_names_on_root) const {
 
   // The internals
   const term_manager_internal& tm_internal = *tm.get_internal();
 
-  // See if it's been cached already
-  if (use_cache_for_root) {
-    expr_let_cache::const_iterator find = let_cache.find(tm_internal.ref_of(*this));
-    if (find != let_cache.end()) {
-      out << find->second;
-      return;
-    }
+  // See if it has a name
+  if (use_names_on_root && names.output_name(out, tm_internal.ref_of(*this))) {
+    return;
   }
 
   switch (d_op) {
@@ -114,6 +114,17 @@ struct term_ref_strong_hasher {
   }
 };
 
+/**
+ * Names of the subterms that are printed by name instead of structurally
+ * (let bindings, definitions).
+ */
+class term_name_table {
+public:
+  virtual ~term_name_table() {}
+  /** If t has a name output it and return true, otherwise return false */
+  virtual bool output_name(std::ostream& out, term_ref t) const = 0;
+};
+
 /** Terms */
 class term {
 
@@ -122,15 +133,24 @@ class term {
   /** The term kind */
   term_op d_op;
 
+  /**
+   * The type of the term, or for compound types their base type (primitive
+   * types refer to themselves). Null if not computed yet.
+   */
+  term_ref d_type;
+
   /** The hash of the term (independent of reference) */
   size_t d_hash;
 
+  /** The id of the term (consecutive, 0 is reserved for null) */
+  size_t d_id;
+
   /** Default constructor */
-  term(): d_op(OP_LAST), d_hash(0) {}
+  term(): d_op(OP_LAST), d_hash(0), d_id(0) {}
 
   /** Construct the term with all the attributes */
-  term(term_op op, size_t hash)
-  : d_op(op), d_hash(hash) {}
+  term(term_op op, size_t hash, size_t id)
+  : d_op(op), d_hash(hash), d_id(id) {}
 
   friend class term_manager_internal;
 
@@ -147,9 +167,15 @@ public:
   /** Output to the stream using the SMT2 language */
   void to_stream_smt_without_let(std::ostream& out, term_manager& tm, const expr_let_cache& let_cache, bool use_cache_on_root = true) const;
 
+  /** Output to the stream using the SMT2 language, named subterms by name */
+  void to_stream_smt_without_let(std::ostream& out, term_manager& tm, const term_name_table& names, bool use_names_on_root = true) const;
+
   /** Output to the stream using the NUXMV language */
   void to_stream_nuxmv_without_let(std::ostream& out, term_manager& tm, const expr_let_cache& let_cache, bool use_cache_on_root = true) const;
 
+  /** Output to the stream using the NUXMV language, named subterms by name */
+  void to_stream_nuxmv_without_let(std::ostream& out, term_manager& tm, const term_name_table& names, bool use_names_on_root = true) const;
+
   /** Output to the stream using the language set on the stream */
   void to_stream(std::ostream& out) const;
 
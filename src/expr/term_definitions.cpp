@@ -0,0 +1,114 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "expr/term_definitions.h"
+#include "expr/term_manager.h"
+#include "expr/term_traversal.h"
+
+#include <iostream>
+#include <cassert>
+
+namespace sally {
+namespace expr {
+
+/** Defines the terms bottom-up */
+class term_definitions::definition_visitor {
+
+  term_definitions& d_defs;
+  std::vector<term_ref>& d_new;
+
+public:
+
+  definition_visitor(term_definitions& defs, std::vector<term_ref>& definitions)
+  : d_defs(defs), d_new(definitions) {}
+
+  visitor_match_result match(term_ref t) {
+    if (d_defs.is_defined(t) || !d_defs.needs_definition(t)) {
+      return DONT_VISIT_AND_BREAK;
+    }
+    return VISIT_AND_CONTINUE;
+  }
+
+  void visit(term_ref t) {
+    size_t id = d_defs.d_tm.id_of(t);
+    if (id >= d_defs.d_defined.size()) {
+      d_defs.d_defined.resize(std::max(id + 1, 2*d_defs.d_defined.size()), false);
+    }
+    d_defs.d_defined[id] = true;
+    d_defs.d_definitions.push_back(t);
+    d_new.push_back(t);
+  }
+};
+
+term_definitions::term_definitions(term_manager& tm, std::string prefix)
+: d_tm(tm)
+, d_prefix(tm.get_fresh_name_prefix(prefix))
+{}
+
+bool term_definitions::needs_definition(term_ref t) const {
+  const term& t_term = d_tm.term_of(t);
+  switch (t_term.op()) {
+  case VARIABLE:
+  case CONST_BOOL:
+  case CONST_RATIONAL:
+  case CONST_BITVECTOR:
+  case CONST_STRING:
+  case CONST_ENUM:
+    return false;
+  default:
+    // Terms under binders can refer to the bound variables so we don't go
+    // into abstractions at all
+    return t_term.size() > 0 && !d_tm.is_type(t) && !d_tm.get_internal()->is_abstraction(t_term);
+  }
+}
+
+void term_definitions::add(term_ref t, std::vector<term_ref>& definitions) {
+  definition_visitor visitor(*this, definitions);
+  term_traversal traversal(d_tm);
+  traversal.run(visitor, t);
+}
+
+bool term_definitions::is_defined(term_ref t) const {
+  size_t id = d_tm.id_of(t);
+  return id < d_defined.size() && d_defined[id];
+}
+
+bool term_definitions::output_name(std::ostream& out, term_ref t) const {
+  if (!is_defined(t)) {
+    return false;
+  }
+  out << d_prefix << d_tm.id_of(t);
+  return true;
+}
+
+void term_definitions::push() {
+  d_scopes.push_back(d_definitions.size());
+}
+
+void term_definitions::pop() {
+  assert(d_scopes.size() > 0);
+  size_t size = d_scopes.back();
+  d_scopes.pop_back();
+  while (d_definitions.size() > size) {
+    d_defined[d_tm.id_of(d_definitions.back())] = false;
+    d_definitions.pop_back();
+  }
+}
+
+}
+}
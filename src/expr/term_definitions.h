@@ -0,0 +1,96 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "expr/term.h"
+
+#include <vector>
+#include <string>
+#include <iosfwd>
+
+namespace sally {
+namespace expr {
+
+class term_manager;
+
+/**
+ * Definitions of subterms kept across an output stream (define-fun in SMT2,
+ * DEFINE in nuXmv), so that each subterm is printed once no matter how many
+ * times it is used. Every compound subterm gets a definition, except for
+ * types and terms under binders. The name of a definition is a prefix and the
+ * term id, so names need no storage.
+ *
+ * The definitions can be scoped with push() and pop() to follow the scopes
+ * of the output (definitions made after a push are removed by the pop).
+ */
+class term_definitions : public term_name_table {
+
+  /** The term manager */
+  term_manager& d_tm;
+
+  /** Prefix of the names */
+  std::string d_prefix;
+
+  /** Whether the term is defined, by id */
+  std::vector<bool> d_defined;
+
+  /** The defined terms, in order of definition */
+  std::vector<term_ref> d_definitions;
+
+  /** Number of definitions at each push */
+  std::vector<size_t> d_scopes;
+
+  class definition_visitor;
+  friend class definition_visitor;
+
+  /** Should the term get a definition */
+  bool needs_definition(term_ref t) const;
+
+public:
+
+  /**
+   * Construct the definitions with names starting with the prefix (extended
+   * if needed so that no variable name starts with it).
+   */
+  term_definitions(term_manager& tm, std::string prefix);
+
+  /**
+   * Define all the subterms of t that are not defined yet, the new ones are
+   * added to definitions, children before parents.
+   */
+  void add(term_ref t, std::vector<term_ref>& definitions);
+
+  /** Is the term defined */
+  bool is_defined(term_ref t) const;
+
+  /** If t is defined, output its name */
+  bool output_name(std::ostream& out, term_ref t) const;
+
+  /** Number of definitions */
+  size_t size() const { return d_definitions.size(); }
+
+  /** Push a scope */
+  void push();
+
+  /** Pop a scope, removing the definitions made since the push */
+  void pop();
+};
+
+}
+}
@@ -0,0 +1,504 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "expr/term_io.h"
+#include "expr/term_manager_internal.h"
+#include "expr/term_traversal.h"
+#include "expr/bitvector_word.h"
+#include "utils/exception.h"
+
+namespace sally {
+namespace expr {
+
+void write_uint(std::string& out, uint64_t value) {
+  // LEB128: 7 bits at a time, high bit set if more to come
+  while (value >= 0x80) {
+    out.push_back((char) ((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back((char) value);
+}
+
+void write_string(std::string& out, const std::string& s) {
+  write_uint(out, s.size());
+  out.append(s);
+}
+
+void write_integer(std::string& out, const mpz_class& z) {
+  // Sign, then the bytes of the absolute value (least significant first)
+  int sign = sgn(z);
+  size_t size = sign == 0 ? 0 : (mpz_sizeinbase(z.get_mpz_t(), 2) + 7) / 8;
+  write_uint(out, sign < 0 ? 1 : 0);
+  write_uint(out, size);
+  if (size > 0) {
+    std::vector<unsigned char> bytes(size);
+    size_t count = 0;
+    mpz_export(&bytes[0], &count, -1, 1, 0, 0, z.get_mpz_t());
+    out.append((const char*) &bytes[0], count);
+  }
+}
+
+/** Adds the terms in post-order, skipping the terms that have an index already */
+class term_writer_visitor {
+
+  term_writer& d_writer;
+  term_manager_internal& d_tm;
+
+public:
+
+  term_writer_visitor(term_writer& writer, term_manager_internal& tm)
+  : d_writer(writer), d_tm(tm) {}
+
+  visitor_match_result match(term_ref t) {
+    if (d_writer.d_term_index.find(t) != d_writer.d_term_index.end()) {
+      return DONT_VISIT_AND_BREAK;
+    }
+    return VISIT_AND_CONTINUE;
+  }
+
+  void visit(term_ref t_ref);
+};
+
+void term_writer_visitor::visit(term_ref t_ref) {
+
+  // The type goes first (unless it's the term itself, as for primitive types)
+  term_ref type = d_tm.stored_type_of(t_ref);
+  size_t type_index = 0;
+  if (!type.is_null() && type != t_ref) {
+    type_index = d_writer.add_term(type);
+  }
+
+  // Index the term
+  size_t index = d_writer.d_terms.size();
+  d_writer.d_terms.push_back(term_ref_strong(d_writer.d_tm, t_ref));
+  d_writer.d_term_index[t_ref] = index;
+  if (type == t_ref) {
+    type_index = index;
+  }
+
+  // The op and payload
+  std::string& out = d_writer.d_records;
+  const term& t = d_tm.term_of(t_ref);
+  term_op op = t.op();
+  write_uint(out, op);
+  switch (op) {
+  case TYPE_BITVECTOR:
+  case CONST_ENUM:
+  case TERM_TUPLE_READ:
+  case TERM_TUPLE_WRITE:
+    write_uint(out, d_tm.payload_of<size_t>(t));
+    break;
+  case TERM_BV_EXTRACT: {
+    const bitvector_extract& extract = d_tm.payload_of<bitvector_extract>(t);
+    write_uint(out, extract.high);
+    write_uint(out, extract.low);
+    break;
+  }
+  case TERM_BV_SGN_EXTEND:
+    write_uint(out, d_tm.payload_of<bitvector_sgn_extend>(t).size);
+    break;
+  case CONST_BOOL:
+    write_uint(out, d_tm.payload_of<bool>(t));
+    break;
+  case CONST_RATIONAL: {
+    const rational& q = d_tm.payload_of<rational>(t);
+    write_integer(out, q.get_numerator().mpz());
+    write_integer(out, q.get_denominator().mpz());
+    break;
+  }
+  case CONST_BITVECTOR: {
+    const bitvector& bv = d_tm.payload_of<bitvector>(t);
+    write_uint(out, bv.size());
+    if (bv.is_word()) {
+      write_uint(out, bv.get_word());
+    } else {
+      write_integer(out, bv.mpz());
+    }
+    break;
+  }
+  case VARIABLE:
+  case CONST_STRING:
+    write_string(out, d_tm.payload_of<utils::string>(t));
+    break;
+  default:
+    // No payload
+    break;
+  }
+
+  // The children and type
+  write_uint(out, t.size());
+  for (size_t i = 0; i < t.size(); ++ i) {
+    write_uint(out, d_writer.d_term_index.find(t[i])->second);
+  }
+  write_uint(out, type_index);
+
+  d_writer.d_records_count ++;
+}
+
+term_writer::term_writer(term_manager& tm)
+: d_tm(tm)
+, d_records_count(0)
+{
+  // Index 0 is the null term
+  d_terms.push_back(term_ref_strong());
+}
+
+size_t term_writer::add_term(term_ref t) {
+  if (t.is_null()) {
+    return 0;
+  }
+  term_ref_hash_map<size_t>::const_iterator find = d_term_index.find(t);
+  if (find != d_term_index.end()) {
+    return find->second;
+  }
+  term_writer_visitor visitor(*this, *d_tm.get_internal());
+  term_traversal traversal(*d_tm.get_internal());
+  traversal.run(visitor, t);
+  return d_term_index.find(t)->second;
+}
+
+bool term_writer::index_term(term_ref t) {
+  if (d_term_index.find(t) != d_term_index.end()) {
+    return false;
+  }
+  d_term_index[t] = d_terms.size();
+  d_terms.push_back(term_ref_strong(d_tm, t));
+  return true;
+}
+
+void term_writer::write_records(std::string& out) {
+  write_uint(out, d_records_count);
+  out.append(d_records);
+  d_records.clear();
+  d_records_count = 0;
+}
+
+void term_writer::gc_collect(const gc_relocator& gc_reloc) {
+  // The terms are kept alive, so they are all relocated
+  gc_reloc.reloc(d_terms);
+  d_term_index.clear();
+  for (size_t i = 1; i < d_terms.size(); ++ i) {
+    d_term_index[d_terms[i]] = i;
+  }
+}
+
+term_reader::term_reader(term_manager& tm)
+: d_tm(tm)
+, d_pos(0)
+, d_end(0)
+{
+  d_terms.push_back(term_ref_strong());
+}
+
+void term_reader::error(const char* msg) const {
+  throw exception(msg);
+}
+
+void term_reader::set_input(const char* begin, const char* end) {
+  d_pos = begin;
+  d_end = end;
+}
+
+uint64_t term_reader::read_uint() {
+  uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (d_pos == d_end) {
+      error("truncated");
+    }
+    unsigned char byte = *d_pos ++;
+    value |= (uint64_t) (byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return value;
+    }
+  }
+  error("invalid number");
+  return 0;
+}
+
+std::string term_reader::read_string() {
+  uint64_t size = read_uint();
+  if (size > (uint64_t) (d_end - d_pos)) {
+    error("truncated");
+  }
+  std::string s(d_pos, size);
+  d_pos += size;
+  return s;
+}
+
+mpz_class term_reader::read_integer() {
+  bool negative = read_uint();
+  uint64_t size = read_uint();
+  if (size > (uint64_t) (d_end - d_pos)) {
+    error("truncated");
+  }
+  mpz_class z;
+  if (size > 0) {
+    mpz_import(z.get_mpz_t(), size, -1, 1, 0, 0, d_pos);
+    d_pos += size;
+  }
+  if (negative) {
+    z = -z;
+  }
+  return z;
+}
+
+template <term_op op>
+term_ref term_reader::mk_term(const typename term_op_traits<op>::payload_type& payload, term_ref type) {
+  term_manager_internal& tm = *d_tm.get_internal();
+  const term_ref* begin = d_children.empty() ? 0 : &d_children[0];
+  const term_ref* end = begin + d_children.size();
+  if (type.is_null()) {
+    term_ref t = tm.mk_term<op>(payload, begin, end);
+    tm.typecheck(t);
+    return t;
+  }
+  return tm.mk_typed_term<op>(payload, begin, end, type);
+}
+
+void term_reader::read_record() {
+
+  uint64_t op = read_uint();
+  if (op >= OP_LAST) {
+    error("invalid term");
+  }
+
+  // Payload
+  size_t payload_size = 0, payload_low = 0;
+  mpz_class payload_z, payload_den;
+  std::string payload_string;
+  switch (op) {
+  case TYPE_BITVECTOR:
+  case CONST_ENUM:
+  case TERM_TUPLE_READ:
+  case TERM_TUPLE_WRITE:
+  case TERM_BV_SGN_EXTEND:
+  case CONST_BOOL:
+    payload_size = read_uint();
+    break;
+  case TERM_BV_EXTRACT:
+    payload_size = read_uint();
+    payload_low = read_uint();
+    break;
+  case CONST_RATIONAL:
+    payload_z = read_integer();
+    payload_den = read_integer();
+    if (payload_den <= 0) {
+      error("invalid rational");
+    }
+    break;
+  case CONST_BITVECTOR:
+    payload_size = read_uint();
+    if (payload_size == 0) {
+      error("invalid bitvector");
+    }
+    if (payload_size <= 64) {
+      payload_low = read_uint();
+    } else {
+      payload_z = read_integer();
+    }
+    break;
+  case VARIABLE:
+  case CONST_STRING:
+    payload_string = read_string();
+    break;
+  default:
+    break;
+  }
+
+  // Children
+  uint64_t size = read_uint();
+  if (size > (uint64_t) (d_end - d_pos)) {
+    error("truncated");
+  }
+  d_children.clear();
+  for (size_t i = 0; i < size; ++ i) {
+    term_ref child = read_term();
+    if (child.is_null()) {
+      error("invalid term");
+    }
+    d_children.push_back(child);
+  }
+
+  // Type (if it's the term itself, we compute it)
+  uint64_t type_index = read_uint();
+  term_ref type;
+  if (type_index != d_terms.size()) {
+    if (type_index > d_terms.size()) {
+      error("invalid term");
+    }
+    type = d_terms[type_index];
+  }
+
+  term_ref t;
+
+#define TERM_IO_TERM(OP) case OP: t = mk_term<OP>(alloc::empty_type(), type); break;
+
+  switch (op) {
+  case TYPE_BITVECTOR:
+    t = mk_term<TYPE_BITVECTOR>(payload_size, type);
+    break;
+  case CONST_ENUM:
+    t = mk_term<CONST_ENUM>(payload_size, type);
+    break;
+  case TERM_TUPLE_READ:
+    t = mk_term<TERM_TUPLE_READ>(payload_size, type);
+    break;
+  case TERM_TUPLE_WRITE:
+    t = mk_term<TERM_TUPLE_WRITE>(payload_size, type);
+    break;
+  case TERM_BV_EXTRACT:
+    t = mk_term<TERM_BV_EXTRACT>(bitvector_extract(payload_size, payload_low), type);
+    break;
+  case TERM_BV_SGN_EXTEND:
+    t = mk_term<TERM_BV_SGN_EXTEND>(bitvector_sgn_extend(payload_size), type);
+    break;
+  case CONST_BOOL:
+    t = mk_term<CONST_BOOL>(payload_size != 0, type);
+    break;
+  case CONST_RATIONAL:
+    t = mk_term<CONST_RATIONAL>(rational(mpq_class(payload_z, payload_den)), type);
+    break;
+  case CONST_BITVECTOR:
+    if (payload_size <= 64) {
+      t = mk_term<CONST_BITVECTOR>(bitvector::from_word(payload_size, payload_low & bv_word::mask(payload_size)), type);
+    } else {
+      t = mk_term<CONST_BITVECTOR>(bitvector(payload_size, integer(payload_z)), type);
+    }
+    break;
+  case VARIABLE:
+    if (d_children.size() == 1) {
+      // Simple variables as usual, to register the name
+      t = d_tm.mk_variable(payload_string, d_children[0]);
+    } else {
+      t = mk_term<VARIABLE>(utils::string(payload_string), type);
+    }
+    break;
+  case CONST_STRING:
+    t = mk_term<CONST_STRING>(utils::string(payload_string), type);
+    break;
+  TERM_IO_TERM(TYPE_TYPE)
+  TERM_IO_TERM(TYPE_BOOL)
+  TERM_IO_TERM(TYPE_INTEGER)
+  TERM_IO_TERM(TYPE_REAL)
+  TERM_IO_TERM(TYPE_STRING)
+  TERM_IO_TERM(TYPE_STRUCT)
+  TERM_IO_TERM(TYPE_TUPLE)
+  TERM_IO_TERM(TYPE_ENUM)
+  TERM_IO_TERM(TYPE_RECORD)
+  TERM_IO_TERM(TYPE_FUNCTION)
+  TERM_IO_TERM(TYPE_ARRAY)
+  TERM_IO_TERM(TYPE_PREDICATE_SUBTYPE)
+  TERM_IO_TERM(TERM_ITE)
+  TERM_IO_TERM(TERM_EQ)
+  TERM_IO_TERM(TERM_AND)
+  TERM_IO_TERM(TERM_OR)
+  TERM_IO_TERM(TERM_NOT)
+  TERM_IO_TERM(TERM_IMPLIES)
+  TERM_IO_TERM(TERM_XOR)
+  TERM_IO_TERM(TERM_ADD)
+  TERM_IO_TERM(TERM_SUB)
+  TERM_IO_TERM(TERM_MUL)
+  TERM_IO_TERM(TERM_DIV)
+  TERM_IO_TERM(TERM_MOD)
+  TERM_IO_TERM(TERM_LEQ)
+  TERM_IO_TERM(TERM_LT)
+  TERM_IO_TERM(TERM_GEQ)
+  TERM_IO_TERM(TERM_GT)
+  TERM_IO_TERM(TERM_TO_INT)
+  TERM_IO_TERM(TERM_TO_REAL)
+  TERM_IO_TERM(TERM_IS_INT)
+  TERM_IO_TERM(TERM_BV_ADD)
+  TERM_IO_TERM(TERM_BV_SUB)
+  TERM_IO_TERM(TERM_BV_MUL)
+  TERM_IO_TERM(TERM_BV_UDIV)
+  TERM_IO_TERM(TERM_BV_SDIV)
+  TERM_IO_TERM(TERM_BV_UREM)
+  TERM_IO_TERM(TERM_BV_SREM)
+  TERM_IO_TERM(TERM_BV_SMOD)
+  TERM_IO_TERM(TERM_BV_XOR)
+  TERM_IO_TERM(TERM_BV_SHL)
+  TERM_IO_TERM(TERM_BV_LSHR)
+  TERM_IO_TERM(TERM_BV_ASHR)
+  TERM_IO_TERM(TERM_BV_NOT)
+  TERM_IO_TERM(TERM_BV_AND)
+  TERM_IO_TERM(TERM_BV_OR)
+  TERM_IO_TERM(TERM_BV_NAND)
+  TERM_IO_TERM(TERM_BV_NOR)
+  TERM_IO_TERM(TERM_BV_XNOR)
+  TERM_IO_TERM(TERM_BV_CONCAT)
+  TERM_IO_TERM(TERM_BV_ULEQ)
+  TERM_IO_TERM(TERM_BV_SLEQ)
+  TERM_IO_TERM(TERM_BV_ULT)
+  TERM_IO_TERM(TERM_BV_SLT)
+  TERM_IO_TERM(TERM_BV_UGEQ)
+  TERM_IO_TERM(TERM_BV_SGEQ)
+  TERM_IO_TERM(TERM_BV_UGT)
+  TERM_IO_TERM(TERM_BV_SGT)
+  TERM_IO_TERM(TERM_BV_NEG)
+  TERM_IO_TERM(TERM_BV_EXTEND)
+  TERM_IO_TERM(TERM_BV_ROR)
+  TERM_IO_TERM(TERM_BV_ROL)
+  TERM_IO_TERM(TERM_ARRAY_READ)
+  TERM_IO_TERM(TERM_ARRAY_WRITE)
+  TERM_IO_TERM(TERM_ARRAY_LAMBDA)
+  TERM_IO_TERM(TERM_TUPLE_CONSTRUCT)
+  TERM_IO_TERM(TERM_RECORD_CONSTRUCT)
+  TERM_IO_TERM(TERM_RECORD_READ)
+  TERM_IO_TERM(TERM_RECORD_WRITE)
+  TERM_IO_TERM(TERM_LAMBDA)
+  TERM_IO_TERM(TERM_EXISTS)
+  TERM_IO_TERM(TERM_FORALL)
+  TERM_IO_TERM(TERM_FUN_APP)
+  default:
+    error("invalid term");
+  }
+
+#undef TERM_IO_TERM
+
+  d_terms.push_back(term_ref_strong(d_tm, t));
+}
+
+void term_reader::read_records() {
+  uint64_t count = read_uint();
+  if (count > (uint64_t) (d_end - d_pos)) {
+    error("truncated");
+  }
+  d_terms.reserve(d_terms.size() + count);
+  for (size_t i = 0; i < count; ++ i) {
+    read_record();
+  }
+}
+
+term_ref term_reader::read_term() {
+  uint64_t index = read_uint();
+  if (index >= d_terms.size()) {
+    error("invalid term index");
+  }
+  return d_terms[index];
+}
+
+void term_reader::index_term(term_ref t) {
+  d_terms.push_back(term_ref_strong(d_tm, t));
+}
+
+void term_reader::gc_collect(const gc_relocator& gc_reloc) {
+  gc_reloc.reloc(d_terms);
+}
+
+}
+}
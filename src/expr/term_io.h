@@ -0,0 +1,154 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "expr/term_manager.h"
+#include "expr/term_map.h"
+#include "expr/gc_relocator.h"
+
+#include <string>
+#include <vector>
+#include <gmpxx.h>
+
+namespace sally {
+namespace expr {
+
+/** Write an unsigned number (LEB128) */
+void write_uint(std::string& out, uint64_t value);
+
+/** Write a string (size, then the characters) */
+void write_string(std::string& out, const std::string& s);
+
+/** Write a GMP integer (sign, size, then the bytes of the absolute value) */
+void write_integer(std::string& out, const mpz_class& z);
+
+/**
+ * Writes terms in a binary encoding. Each term is a record of its op,
+ * payload, children and type, where the children and the type refer to
+ * earlier terms by index (index 0 is the null term). Terms are added with
+ * all their subterms, each term only once, and the records of the terms
+ * added since the last time are taken with write_records(). Terms can also
+ * be indexed without a record, if the reader will index the same terms in
+ * the same order (e.g. the variables of a state type).
+ */
+class term_writer {
+
+  /** The term manager */
+  term_manager& d_tm;
+
+  /** Records of the terms that were not written yet */
+  std::string d_records;
+
+  /** Number of records */
+  size_t d_records_count;
+
+  /** The terms by index (index 0 is the null term) */
+  std::vector<term_ref_strong> d_terms;
+
+  /** Indices of the terms */
+  term_ref_hash_map<size_t> d_term_index;
+
+  /** Visitor to add terms */
+  friend class term_writer_visitor;
+
+public:
+
+  term_writer(term_manager& tm);
+
+  /** Add the term and all its subterms (and types), returns the index */
+  size_t add_term(term_ref t);
+
+  /** Index the term without a record, returns false if it has an index already */
+  bool index_term(term_ref t);
+
+  /** Write the number of records and the records, and start over */
+  void write_records(std::string& out);
+
+  /** Relocate the terms */
+  void gc_collect(const gc_relocator& gc_reloc);
+};
+
+/**
+ * Reads the terms written by a term writer, from the input given in
+ * set_input(). The terms are kept alive by the reader.
+ */
+class term_reader {
+
+  /** The term manager */
+  term_manager& d_tm;
+
+  /** Current position */
+  const char* d_pos;
+
+  /** End of input */
+  const char* d_end;
+
+  /** The terms by index (index 0 is the null term) */
+  std::vector<term_ref_strong> d_terms;
+
+  /** Children of the current term */
+  std::vector<term_ref> d_children;
+
+  /** Make the term from the children (typed if the type is given) */
+  template <term_op op>
+  term_ref mk_term(const typename term_op_traits<op>::payload_type& payload, term_ref type);
+
+  /** Read a term record and add it to the terms */
+  void read_record();
+
+protected:
+
+  /** Report a malformed input (throws) */
+  virtual void error(const char* msg) const;
+
+public:
+
+  term_reader(term_manager& tm);
+  virtual ~term_reader() {}
+
+  /** Set the input to read from */
+  void set_input(const char* begin, const char* end);
+
+  /** Are we at the end of the input */
+  bool at_end() const { return d_pos == d_end; }
+
+  /** Read an unsigned number */
+  uint64_t read_uint();
+
+  /** Read a string */
+  std::string read_string();
+
+  /** Read a GMP integer */
+  mpz_class read_integer();
+
+  /** Read the records written by the term writer */
+  void read_records();
+
+  /** Read a term index and get the term */
+  term_ref read_term();
+
+  /** Index the term (as the term writer did) */
+  void index_term(term_ref t);
+
+  /** Relocate the terms */
+  void gc_collect(const gc_relocator& gc_reloc);
+};
+
+}
+}
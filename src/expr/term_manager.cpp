@@ -172,6 +172,17 @@ void term_manager::reset_fresh_variables() {
   d_tmp_var_id = 0;
 }
 
+std::string term_manager::get_fresh_name_prefix(std::string prefix) const {
+  for (;;) {
+    // First name not smaller than the prefix is the only candidate
+    std::set<std::string>::const_iterator it = d_variable_names.lower_bound(prefix);
+    if (it == d_variable_names.end() || it->compare(0, prefix.size(), prefix) != 0) {
+      return prefix;
+    }
+    prefix += "_";
+  }
+}
+
 std::string term_manager::get_variable_name(term_ref t_ref) const {
   const term& t = d_tm->term_of(t_ref);
   return get_variable_name(t);
@@ -455,7 +466,7 @@ bitvector_extract term_manager::get_bitvector_extract(const term& t) const {
 }
 
 bitvector_sgn_extend term_manager::get_bitvector_sgn_extend(const term& t) const {
-  assert(t.op() == TERM_BV_SGN_EXTEND);
+  assert(t.op() == TERM_BV_SGN_EXTEND || t.op() == TERM_BV_EXTEND);
   return d_tm->payload_of<bitvector_sgn_extend>(t);
 }
 
@@ -694,6 +705,14 @@ size_t term_manager::id_of(term_ref ref) const {
   return d_tm->id_of(ref);
 }
 
+void term_manager::update_hash_statistics() {
+  d_tm->update_hash_statistics();
+}
+
+void term_manager::memory_usage(utils::memory_report& report) const {
+  d_tm->memory_usage(report);
+}
+
 std::string term_manager::to_string(term_ref ref) const {
   std::stringstream ss;
   ss << set_tm(*const_cast<term_manager*>(this)) << ref;
@@ -777,9 +796,10 @@ void term_manager::get_conjuncts(term_ref f, std::set<term_ref>& out) {
 }
 
 void term_manager::get_conjuncts(term_ref f, std::vector<term_ref>& out) {
-  std::set<term_ref> conjuncts;
-  get_conjuncts(f, conjuncts);
-  std::copy(conjuncts.begin(), conjuncts.end(), std::back_inserter(out));
+  term_buffer conjuncts;
+  collect_conjuncts(f, conjuncts);
+  conjuncts.sort_unique();
+  out.insert(out.end(), conjuncts.begin(), conjuncts.end());
 }
 
 
@@ -807,69 +827,120 @@ void term_manager::get_disjuncts(term_ref f, std::set<term_ref>& out) {
   }
 }
 
-term_ref term_manager::mk_and(const std::vector<term_ref>& conjuncts) {
-  std::set<term_ref> lits;
-  std::vector<term_ref>::const_iterator it;
-  for (it = conjuncts.begin(); it != conjuncts.end(); ++ it) {
-    get_conjuncts(*it, lits);
+void term_manager::collect_conjuncts(term_ref f, term_buffer& out) {
+  const term& f_term = d_tm->term_of(f);
+  switch (f_term.op()) {
+  case TERM_AND: {
+    size_t n = f_term.size();
+    for (size_t i = 0; i < n; ++ i) {
+      collect_conjuncts(d_tm->term_of(f)[i], out);
+    }
+    break;
+  }
+  case TERM_NOT: {
+    term_buffer disjuncts;
+    collect_disjuncts(f_term[0], disjuncts);
+    disjuncts.sort_unique();
+    for (size_t i = 0; i < disjuncts.size(); ++ i) {
+      out.push_back(mk_not(disjuncts[i]));
+    }
+    break;
+  }
+  default:
+    out.push_back(f);
+  }
+}
+
+void term_manager::collect_disjuncts(term_ref f, term_buffer& out) {
+  const term& f_term = d_tm->term_of(f);
+  switch (f_term.op()) {
+  case TERM_OR: {
+    size_t n = f_term.size();
+    for (size_t i = 0; i < n; ++ i) {
+      collect_disjuncts(d_tm->term_of(f)[i], out);
+    }
+    break;
   }
+  case TERM_NOT: {
+    term_buffer conjuncts;
+    collect_conjuncts(f_term[0], conjuncts);
+    conjuncts.sort_unique();
+    for (size_t i = 0; i < conjuncts.size(); ++ i) {
+      out.push_back(mk_not(conjuncts[i]));
+    }
+    break;
+  }
+  default:
+    out.push_back(f);
+  }
+}
+
+term_ref term_manager::mk_and(const term_ref* begin, const term_ref* end) {
+  term_buffer lits;
+  for (const term_ref* it = begin; it != end; ++ it) {
+    collect_conjuncts(*it, lits);
+  }
+  lits.sort_unique();
   if (lits.size() == 0) {
     return mk_boolean_constant(true);
   }
   if (lits.size() == 1) {
-    return *conjuncts.begin();
+    return *begin;
   }
   return d_tm->mk_term<TERM_AND>(lits.begin(), lits.end());
 }
 
+term_ref term_manager::mk_or(const term_ref* begin, const term_ref* end) {
+  term_buffer lits;
+  for (const term_ref* it = begin; it != end; ++ it) {
+    collect_disjuncts(*it, lits);
+  }
+  lits.sort_unique();
+  if (lits.size() == 0) {
+    return mk_boolean_constant(false);
+  }
+  if (lits.size() == 1) {
+    return *begin;
+  }
+  return d_tm->mk_term<TERM_OR>(lits.begin(), lits.end());
+}
+
+term_ref term_manager::mk_and(const std::vector<term_ref>& conjuncts) {
+  return mk_and(conjuncts.data(), conjuncts.data() + conjuncts.size());
+}
+
 term_ref term_manager::mk_and(term_ref f1, term_ref f2) {
-  std::vector<term_ref> conjuncts;
-  conjuncts.push_back(f1);
-  conjuncts.push_back(f2);
-  return mk_and(conjuncts);
+  term_ref conjuncts[2] = { f1, f2 };
+  return mk_and(conjuncts, conjuncts + 2);
 }
 
 term_ref term_manager::mk_or(term_ref f1, term_ref f2) {
-  std::vector<term_ref> disjuncts;
-  disjuncts.push_back(f1);
-  disjuncts.push_back(f2);
-  return mk_or(disjuncts);
+  term_ref disjuncts[2] = { f1, f2 };
+  return mk_or(disjuncts, disjuncts + 2);
 }
 
 term_ref term_manager::mk_or(term_ref f) {
-  std::vector<term_ref> disjuncts;
-  disjuncts.push_back(f);
-  return mk_or(disjuncts);
+  return mk_or(&f, &f + 1);
 }
 
 term_ref term_manager::mk_and(const std::set<term_ref>& conjuncts) {
-  std::set<term_ref> lits;
+  term_buffer lits;
   std::set<term_ref>::const_iterator it;
   for (it = conjuncts.begin(); it != conjuncts.end(); ++ it) {
-    get_conjuncts(*it, lits);
+    collect_conjuncts(*it, lits);
   }
+  lits.sort_unique();
   if (lits.size() == 0) {
     return mk_boolean_constant(true);
   }
   if (lits.size() == 1) {
-    return *lits.begin();
+    return lits[0];
   }
   return d_tm->mk_term<TERM_AND>(lits.begin(), lits.end());
 }
 
 term_ref term_manager::mk_or(const std::vector<term_ref>& disjuncts) {
-  std::set<term_ref> lits;
-  std::vector<term_ref>::const_iterator it;
-  for (it = disjuncts.begin(); it != disjuncts.end(); ++ it) {
-    get_disjuncts(*it, lits);
-  }
-  if (lits.size() == 0) {
-    return mk_boolean_constant(false);
-  }
-  if (lits.size() == 1) {
-    return disjuncts[0];
-  }
-  return d_tm->mk_term<TERM_OR>(lits.begin(), lits.end());
+  return mk_or(disjuncts.data(), disjuncts.data() + disjuncts.size());
 }
 
 bool term_manager::is_type(term_ref t) const {
@@ -19,8 +19,11 @@
 #pragma once
 
 #include "utils/statistics.h"
+#include "utils/memory.h"
 #include "expr/term.h"
+#include "expr/term_map.h"
 #include "utils/name_transformer.h"
+#include "utils/small_vector.h"
 
 #include <set>
 #include <string>
@@ -62,6 +65,15 @@ class term_manager {
   /** Ids of temp variables */
   size_t d_tmp_var_id;
 
+  /** Buffer for collecting children, allocates only for large terms */
+  typedef utils::small_vector<term_ref, 16> term_buffer;
+
+  /** Add the conjuncts of f to the buffer (possibly with duplicates) */
+  void collect_conjuncts(term_ref f, term_buffer& out);
+
+  /** Add the disjuncts of f to the buffer (possibly with duplicates) */
+  void collect_disjuncts(term_ref f, term_buffer& out);
+
 public:
 
   /** Construct them manager */
@@ -180,6 +192,9 @@ public:
   /** Reset the fresh variables counter */
   void reset_fresh_variables();
 
+  /** Extend the prefix until no variable name starts with it */
+  std::string get_fresh_name_prefix(std::string prefix) const;
+
   /** Make a new boolean constant */
   term_ref mk_boolean_constant(bool value);
 
@@ -219,6 +234,12 @@ public:
   /** Make a disjunction. If no children => false. One child => child. */
   term_ref mk_or(const std::vector<term_ref>& disjuncts);
 
+  /** Make a conjunction of the array. If no children => true. One child => child. */
+  term_ref mk_and(const term_ref* begin, const term_ref* end);
+
+  /** Make a disjunction of the array. If no children => false. One child => child. */
+  term_ref mk_or(const term_ref* begin, const term_ref* end);
+
   /** Make a new rational constant */
   term_ref mk_rational_constant(const rational& value);
 
@@ -470,6 +491,12 @@ public:
   /** Get the id of the term */
   size_t id_of(term_ref ref) const;
 
+  /** Update the statistics of the term pool hashing */
+  void update_hash_statistics();
+
+  /** Add the memory of the terms and the term tables to the report */
+  void memory_usage(utils::memory_report& report) const;
+
   /** Get the hash of the term */
   size_t hash_of(term_ref ref) const {
     if (ref.is_null()) return 0;
@@ -504,7 +531,7 @@ public:
   std::string name_normalize(std::string name) const;
 
   /** The substitution map */
-  typedef boost::unordered_map<term_ref, term_ref, term_ref_hasher> substitution_map;
+  typedef term_subst_map substitution_map;
 
   /** Replaces terms from t that appear in the map. */
   term_ref substitute(term_ref t, const substitution_map& subst);
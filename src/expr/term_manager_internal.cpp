@@ -18,7 +18,7 @@
 
 #include "expr/term_manager_internal.h"
 #include "expr/term_manager.h"
-#include "expr/term_visitor.h"
+#include "expr/term_traversal.h"
 #include "expr/type_computation_visitor.h"
 
 #include "utils/exception.h"
@@ -32,7 +32,9 @@ using namespace sally;
 using namespace expr;
 
 term_manager_internal::term_manager_internal(utils::statistics& stats)
-: d_name_transformer(0)
+: d_payload_memory_size(0)
+, d_typed_construction(false)
+, d_name_transformer(0)
 , d_stat_terms(0)
 {
   // The null id
@@ -48,6 +50,12 @@ term_manager_internal::term_manager_internal(utils::statistics& stats)
   d_stat_vars_bool = static_cast<utils::stat_int*>(stats.register_stat("expr::term_manager_internal::bool_vars"));
   d_stat_vars_real = static_cast<utils::stat_int*>(stats.register_stat("expr::term_manager_internal::real_vars"));
   d_stat_vars_int = static_cast<utils::stat_int*>(stats.register_stat("expr::term_manager_internal::int_vars"));
+  d_stat_term_memory = static_cast<utils::stat_int*>(stats.register_stat("expr::term_manager_internal::term_memory"));
+  d_stat_payload_memory = static_cast<utils::stat_int*>(stats.register_stat("expr::term_manager_internal::payload_memory"));
+  d_stat_pool_load_factor = static_cast<utils::stat_double*>(stats.register_stat("expr::term_pool::load_factor"));
+  d_stat_pool_avg_probes = static_cast<utils::stat_double*>(stats.register_stat("expr::term_pool::avg_probes"));
+  d_stat_pool_max_probes = static_cast<utils::stat_int*>(stats.register_stat("expr::term_pool::max_probes"));
+  d_stat_pool_collisions = static_cast<utils::stat_int*>(stats.register_stat("expr::term_pool::collisions"));
 
   // Create the types
   d_typeType = term_ref_strong(*this, mk_term<TYPE_TYPE>(alloc::empty_type()));
@@ -64,26 +72,67 @@ term_manager_internal::~term_manager_internal() {
 }
 
 term_ref term_manager_internal::tcc_of(const term& t) const {
-  term_to_term_map::const_iterator find = d_tcc_map.find(ref_of(t));
-  if (find == d_tcc_map.end()) {
-    return term_ref();
-  } else {
-    return find->second;
-  }
+  // No type-checking conditions are generated, TCC = true
+  return term_ref();
 }
 
 void term_manager_internal::compute_type(term_ref t) {
-  if (d_type_cache.find(t) == d_type_cache.end()) {
-    type_computation_visitor visitor(*this, d_type_cache, d_base_type_cache);
-    term_visit_topological<type_computation_visitor, term_ref, term_ref_hasher> visit_topological(visitor);
-    visit_topological.run(t);
+  if (!has_type(t)) {
+    // Only if typing failed at construction, this will report the error
+    type_computation_visitor visitor(*this);
+    term_traversal traversal(*this);
+    traversal.run(visitor, t);
+  }
+}
+
+void term_manager_internal::compute_type_of_new_term(term_ref t) {
+  if (d_typed_construction) {
+    return;
+  }
+  try {
+    type_computation_visitor visitor(*this);
+    visitor.visit(t);
+  } catch (const exception& e) {
+    TRACE("types") << "compute_type_of_new_term(): " << e.get_message() << std::endl;
+  }
+}
+
+void term_manager_internal::set_type(term_ref t_ref, term_ref type, term_ref base_type) {
+  term& t = d_memory.object_of(t_ref);
+  assert(t.d_type.is_null());
+  if (is_type(t)) {
+    t.d_type = is_primitive_type(t) ? t_ref : base_type;
+  } else {
+    t.d_type = type;
   }
+  assert(!t.d_type.is_null());
 }
 
 void term_manager_internal::typecheck(term_ref t_ref) {
   compute_type(t_ref);
 }
 
+void term_manager_internal::update_hash_statistics() {
+  d_stat_pool_load_factor->set_value(((double) d_pool.size()) / d_pool.capacity());
+  d_stat_pool_avg_probes->set_value(d_pool.average_probes());
+  d_stat_pool_max_probes->set_value(d_pool.max_probes());
+  d_stat_pool_collisions->set_value(d_pool.collisions());
+}
+
+void term_manager_internal::memory_usage(utils::memory_report& report) const {
+  report.add("expr::terms", d_memory.memory_size());
+  for (int op = 0; op < OP_LAST; ++ op) {
+    if (d_payload_memory[op]) {
+      std::stringstream name;
+      name << "expr::payloads::" << (term_op) op;
+      report.add(name.str(), d_payload_memory[op]->memory_size());
+    }
+  }
+  report.add("expr::term_pool", d_pool.memory_size());
+  report.add("expr::term_ids", utils::memory_of(d_term_refcount));
+  report.add("expr::term_marks", d_marks_pool.memory_size());
+}
+
 void term_manager_internal::to_stream(std::ostream& out) const {
   out << "Term memory:" << std::endl;
   out << d_memory << std::endl;
@@ -98,27 +147,32 @@ void term_manager_internal::to_stream(std::ostream& out) const {
   }
 
   out << "Terms:" << std::endl;
-  for (term_ref_hash_set::const_iterator it = d_pool.begin(); it != d_pool.end(); ++ it) {
-    out << "[id: " << it->id() << ", ref_count = " << d_term_refcount[it->id()] << "] : " << *it << std::endl;
+  std::vector<term_ref> terms;
+  d_pool.get_terms(terms);
+  for (size_t i = 0; i < terms.size(); ++ i) {
+    size_t id = id_of(terms[i]);
+    out << "[id: " << id << ", ref_count = " << d_term_refcount[id] << "] : " << terms[i] << std::endl;
   }
 }
 
 term_ref term_manager_internal::type_of(const term& t) {
-  term_ref t_ref = ref_of(t);
-  compute_type(t_ref);
-  term_to_term_map::const_iterator find = d_type_cache.find(t_ref);
-  assert (find != d_type_cache.end());
-  return find->second;
+  if (t.d_type.is_null()) {
+    term_ref t_ref = ref_of(t);
+    compute_type(t_ref);
+    return type_of_if_exists(t_ref);
+  }
+  return type_of_if_exists(t);
 }
 
 term_ref term_manager_internal::type_of_if_exists(const term& t) const {
-  term_ref t_ref = ref_of(t);
-  term_to_term_map::const_iterator find = d_type_cache.find(t_ref);
-  if (find == d_type_cache.end()) {
+  if (t.d_type.is_null()) {
     return term_ref();
-  } else {
-    return find->second;
   }
+  // Types keep the base type, their type is always the type of types
+  if (is_type(t)) {
+    return type_type();
+  }
+  return t.d_type;
 }
 
 term_ref term_manager_internal::base_type_of(const term& t) {
@@ -145,9 +199,7 @@ term_ref term_manager_internal::base_type_of(const term& t) {
     // Otherwise, compute the type, and get the base type
     term_ref t_ref = ref_of(t);
     compute_type(t_ref);
-    term_to_term_map::const_iterator find = d_base_type_cache.find(t_ref);
-    assert (find != d_base_type_cache.end());
-    return find->second;
+    return term_of(t_ref).d_type;
   } else {
     // For terms, just compute the type, and get the base type of the type
     term_ref t_ref = ref_of(t);
@@ -177,14 +229,8 @@ term_ref term_manager_internal::base_type_of_if_exists(const term& t) const {
         return ref_of(t);
       }
     }
-    // Otherwise, compute the type, and get the base type
-    term_ref t_ref = ref_of(t);
-    term_to_term_map::const_iterator find = d_base_type_cache.find(t_ref);
-    if (find != d_base_type_cache.end()) {
-      return find->second;
-    } else {
-      return term_ref();
-    }
+    // Otherwise, get the base type (null if not computed)
+    return t.d_type;
   } else {
     // For terms, just compute the type, and get the base type of the type
     return base_type_of_if_exists(type_of_if_exists(t));
@@ -217,58 +263,76 @@ std::string term_manager_internal::name_normalize(std::string id) const {
   }
 }
 
-// TODO: non-recursive
-term_ref term_manager_internal::substitute(term_ref t, substitution_map& subst) {
+/** Substitutes bottom-up, the map is also the cache */
+class substitution_visitor {
 
-  // Check if already there
-  substitution_map::const_iterator it = subst.find(t);
-  if (it != subst.end()) {
-    return it->second;
-  }
+  term_manager_internal& d_tm;
+  term_manager_internal::substitution_map& d_subst;
+  std::vector<term_ref> d_children;
+
+public:
 
-  bool child_changed = false;
-  std::vector<term_ref> children;
+  substitution_visitor(term_manager_internal& tm, term_manager_internal::substitution_map& subst)
+  : d_tm(tm), d_subst(subst) {}
 
-  for (size_t i = 0; i < term_of(t).size(); ++ i) {
-    // Substitute in the child
-    term_ref child = term_of(t)[i];
-    term_ref child_subst = substitute(child, subst);
-    if (child_subst != child) {
-      child_changed = true;
+  visitor_match_result match(term_ref t) {
+    if (d_subst.count(t)) {
+      return DONT_VISIT_AND_BREAK;
     }
-    children.push_back(child_subst);
+    return VISIT_AND_CONTINUE;
   }
 
-  // Check if anything changed
-  if (!child_changed) {
-    subst[t] = t;
-    return t;
-  }
+  void visit(term_ref t) {
 
-  // Something changed
-  term_ref t_new;
-  term_op op = term_of(t).op();
-  // Need special cases for operators with payload
-  switch (op) {
-  case TERM_BV_EXTRACT: {
-    // Make a copy, in case we resize on construction
-    bitvector_extract extract = payload_of<bitvector_extract>(t);
-    t_new = mk_term<TERM_BV_EXTRACT>(extract, children[0]);
-    break;
-  }
-  case TERM_BV_SGN_EXTEND: {
-    // Make a copy, in case we resize on construction
-    bitvector_sgn_extend extend = payload_of<bitvector_sgn_extend>(t);
-    t_new = mk_term<TERM_BV_SGN_EXTEND>(extend, children[0]);
-    break;
-  }
-  default:
-    t_new = mk_term(op, children.begin(), children.end());
+    bool child_changed = false;
+    d_children.clear();
+
+    const term& t_term = d_tm.term_of(t);
+    for (size_t i = 0; i < t_term.size(); ++ i) {
+      // All children are substituted already
+      term_ref child = t_term[i];
+      term_ref child_subst = d_subst.find(child)->second;
+      if (child_subst != child) {
+        child_changed = true;
+      }
+      d_children.push_back(child_subst);
+    }
+
+    // Check if anything changed
+    if (!child_changed) {
+      d_subst[t] = t;
+      return;
+    }
+
+    // Something changed
+    term_ref t_new;
+    term_op op = t_term.op();
+    // Need special cases for operators with payload
+    switch (op) {
+    case TERM_BV_EXTRACT: {
+      // Make a copy, in case we resize on construction
+      bitvector_extract extract = d_tm.payload_of<bitvector_extract>(t);
+      t_new = d_tm.mk_term<TERM_BV_EXTRACT>(extract, d_children[0]);
+      break;
+    }
+    case TERM_BV_SGN_EXTEND: {
+      // Make a copy, in case we resize on construction
+      bitvector_sgn_extend extend = d_tm.payload_of<bitvector_sgn_extend>(t);
+      t_new = d_tm.mk_term<TERM_BV_SGN_EXTEND>(extend, d_children[0]);
+      break;
+    }
+    default:
+      t_new = d_tm.mk_term(op, d_children.begin(), d_children.end());
+    }
+    d_subst[t] = t_new;
   }
-  subst[t] = t_new;
+};
 
-  // Return the result
-  return t_new;
+term_ref term_manager_internal::substitute(term_ref t, substitution_map& subst) {
+  substitution_visitor visitor(*this, subst);
+  term_traversal traversal(*this);
+  traversal.run(visitor, t);
+  return subst.find(t)->second;
 }
 
 term_ref term_manager_internal::bitvector_type(size_t size) {
@@ -500,19 +564,20 @@ void term_manager_internal::gc(std::map<expr::term_ref, expr::term_ref>& reloc_m
   std::queue<term_ref> queue;
 
   // Terms we've visited already
-  visited_set visited_terms;
+  term_marks_lease visited_terms(d_marks_pool);
 
   // Payloads that we've visited one set per term_op
   visited_set visited_payloads[OP_LAST];
 
-  // Go though all ids and get the terms with refcount > 0
-  tref_id_map::const_iterator terms_it = d_term_ids.begin(), terms_it_end = d_term_ids.end();
-  for (; terms_it != terms_it_end; ++ terms_it) {
-    assert(terms_it->second < d_term_refcount.size());
-    if (d_term_refcount[terms_it->second] > 0) {
-      term_ref t = terms_it->first;
-      queue.push(t);
-      visited_terms.insert(t);
+  // Go though all terms and get the ones with refcount > 0
+  std::vector<term_ref> terms;
+  d_pool.get_terms(terms);
+  for (size_t i = 0; i < terms.size(); ++ i) {
+    size_t id = id_of(terms[i]);
+    assert(id < d_term_refcount.size());
+    if (d_term_refcount[id] > 0) {
+      queue.push(terms[i]);
+      visited_terms->mark(id);
     }
   }
 
@@ -526,9 +591,8 @@ void term_manager_internal::gc(std::map<expr::term_ref, expr::term_ref>& reloc_m
     // Add any unvisited children
     const term& current_term = term_of(current);
     for (size_t i = 0; i < current_term.size(); ++ i) {
-      if (visited_terms.find(current_term[i]) == visited_terms.end()) {
+      if (visited_terms->mark(id_of(current_term[i]))) {
         queue.push(current_term[i]);
-        visited_terms.insert(current_term[i]);
       }
     }
 
@@ -19,9 +19,13 @@
 #pragma once
 
 #include "expr/term.h"
+#include "expr/term_map.h"
+#include "expr/term_pool.h"
+#include "expr/term_marks.h"
 #include "utils/allocator.h"
 #include "utils/name_transformer.h"
 #include "utils/statistics.h"
+#include "utils/memory.h"
 
 #include <boost/unordered_map.hpp>
 #include <boost/unordered_set.hpp>
@@ -34,58 +38,6 @@
 namespace sally {
 namespace expr {
 
-/**
- * References with additional data, mainly for internal term manager use.
- */
-class term_ref_fat : public term_ref {
-
-protected:
-
-  /** Id of the term in the expression manager */
-  size_t d_id;
-
-  /** Hash of the term */
-  size_t d_hash;
-
-  friend class term_manager_internal;
-
-  term_ref_fat(const term_ref& ref, size_t id, size_t hash)
-  : term_ref(ref), d_id(id), d_hash(hash) {}
-
-public:
-
-  /** Construct null reference */
-  term_ref_fat()
-  : term_ref(), d_id(0), d_hash(0) {}
-  /** Construct a copy, while finalizing the other reference if needed */
-  term_ref_fat(const term_ref_fat& other) {
-    *this = other.finalize();
-  }
-
-  virtual ~term_ref_fat() {}
-
-  /** Return the "real" version of self. Default, just self. */
-  virtual term_ref_fat finalize() const {
-    return term_ref_fat(*this, d_id, d_hash);
-  }
-
-  /** The ID of the term. Doesn't change during lifetime */
-  size_t id() const { return d_id; }
-
-  /** Returns the hash of the reference */
-  size_t hash() const { return d_hash; }
-
-  /** By default we compare with references */
-  virtual bool cmp(const term_ref_fat& other) const {
-    assert(index() != 0);
-    assert(other.index() != 0);
-    return index() == other.index();
-  }
-
-  /** Comparison with cmp. If any is null, we use it for this->cmp */
-  bool operator == (const term_ref_fat& ref) const;
-};
-
 /**
  * Term manager controls the terms, allocation and garbage collection. All
  * terms are defined in term_ops.h.
@@ -100,17 +52,12 @@ public:
   /** Payload references */
   typedef base_ref payload_ref;
 
-  struct term_ref_fat_hasher {
-    size_t operator () (const term_ref_fat& ref) const {
-      return ref.hash();
-    }
-  };
-
   /**
-   * A term with all the information in the package.
+   * A description of a term (op, payload and children) that can be compared
+   * to existing terms, or constructed, by the term pool.
    */
   template <term_op op, typename iterator_type>
-  class term_ref_constructor : public term_ref_fat {
+  class term_ref_constructor {
 
     typedef typename term_op_traits<op>::payload_type payload_type;
 
@@ -120,27 +67,29 @@ public:
     iterator_type d_begin;
     /** One past last child */
     iterator_type d_end;
+    /** The hash of the term */
+    size_t d_hash;
 
     term_manager_internal& d_tm;
 
   public:
 
     term_ref_constructor(term_manager_internal& tm, const payload_type& payload, iterator_type begin, iterator_type end)
-    : term_ref_fat(term_ref(), 0, tm.term_hash<op, iterator_type>(payload, begin, end))
-    , d_payload(payload)
+    : d_payload(payload)
     , d_begin(begin)
     , d_end(end)
+    , d_hash(tm.term_hash<op, iterator_type>(payload, begin, end))
     , d_tm(tm)
     {}
 
-    /** Compare to a term op without using the hash. */
-    bool cmp(const term_ref_fat& other_ref) const;
+    /** The hash of the term */
+    size_t hash() const { return d_hash; }
+
+    /** Compare to an existing term with the same hash */
+    bool cmp(term_ref other_ref) const;
 
-    /**
-     * Actually construct the reference. This is remembered and guarded from
-     * calling more than once.
-     */
-    virtual term_ref_fat finalize() const {
+    /** Construct the term */
+    term_ref construct() const {
       return d_tm.mk_term_internal<op, iterator_type>(d_payload, d_begin, d_end, d_hash);
     }
 
@@ -154,40 +103,27 @@ private:
   /** Memory for the payloads, one for each kind of expression */
   alloc::allocator_base* d_payload_memory[OP_LAST];
 
+  /** Total bytes of the payload memories */
+  size_t d_payload_memory_size;
+
+  /** Are the types of new terms set by the caller (see mk_typed_term) */
+  bool d_typed_construction;
+
   /** Generic term constructor */
   template <term_op op, typename iterator_type>
-  term_ref_fat mk_term_internal(const typename term_op_traits<op>::payload_type& payload, iterator_type children_begin, iterator_type children_end, size_t hash);
-
-  /** The underlying hash set */
-  typedef boost::unordered_set<term_ref_fat, term_ref_fat_hasher> term_ref_hash_set;
+  term_ref mk_term_internal(const typename term_op_traits<op>::payload_type& payload, iterator_type children_begin, iterator_type children_end, size_t hash);
 
   /** The pool of existing terms */
-  term_ref_hash_set d_pool;
-
-  typedef boost::unordered_map<term_ref, term_ref, term_ref_hasher> term_to_term_map;
-
-  /** Map from term to their types. It's built on demand. */
-  term_to_term_map d_type_cache;
-
-  /** Map from the to their base types. It's build on demand. */
-  term_to_term_map d_base_type_cache;
-
-  /**
-   * Map from terms to their type-checking conditions. If the entry is empty
-   * then TCC = true.
-   */
-  term_to_term_map d_tcc_map;
+  term_pool d_pool;
 
   /** Compute the hash of the term parts */
   template <term_op op, typename iterator_type>
   size_t term_hash(const typename term_op_traits<op>::payload_type& payload, iterator_type begin, iterator_type end);
 
-  typedef boost::unordered_map<term_ref, size_t, term_ref_hasher> tref_id_map;
-
-  /** Map from term references to their ids */
-  tref_id_map d_term_ids;
+  /** Visited marks for the traversals */
+  mutable term_marks_pool d_marks_pool;
 
-  /** Reference counts */
+  /** Reference counts (by term id) */
   std::vector<size_t> d_term_refcount;
 
   friend class term_ref_strong;
@@ -243,9 +179,26 @@ private:
   utils::stat_int* d_stat_vars_int;
   utils::stat_int* d_stat_vars_real;
 
-  /** Compute the type of t and all subterms */
+  /** Memory of the term and payload arenas (KB) */
+  utils::stat_int* d_stat_term_memory;
+  utils::stat_int* d_stat_payload_memory;
+
+  /** Hash quality of the term pool */
+  utils::stat_double* d_stat_pool_load_factor;
+  utils::stat_double* d_stat_pool_avg_probes;
+  utils::stat_int* d_stat_pool_max_probes;
+  utils::stat_int* d_stat_pool_collisions;
+
+  /** Compute the type of t and all subterms that don't have a type */
   void compute_type(term_ref t);
 
+  /**
+   * Compute the type of a new term from the types of its children. If the
+   * term is not well typed, it is left without a type and the error is
+   * reported when the type is requested.
+   */
+  void compute_type_of_new_term(term_ref t);
+
 public:
 
   /** Construct them manager */
@@ -254,6 +207,12 @@ public:
   /** Destruct the manager, and destruct all payloads that the manager owns */
   ~term_manager_internal();
 
+  /** Update the term pool statistics (load, probe lengths, collisions) */
+  void update_hash_statistics();
+
+  /** Add the memory of the terms, payloads and tables to the report */
+  void memory_usage(utils::memory_report& report) const;
+
   /** Print the term manager information and all the terms to out */
   void to_stream(std::ostream& out) const;
 
@@ -404,11 +363,11 @@ public:
     term_ref children[1] = { child };
     if (op == VARIABLE) {
       if (is_integer_type(child)) {
-        d_stat_vars_int->set_value(d_stat_vars_int->get_value() + 1);
+        d_stat_vars_int->increment();
       } else if (is_real_type(child)) {
-        d_stat_vars_real->set_value(d_stat_vars_real->get_value() + 1);
+        d_stat_vars_real->increment();
       } else if (is_boolean_type(child)) {
-        d_stat_vars_bool->set_value(d_stat_vars_bool->get_value() + 1);
+        d_stat_vars_bool->increment();
       }
     }
     return mk_term<op, term_ref*>(payload, children, children + 1);
@@ -418,6 +377,14 @@ public:
   template <typename iterator>
   term_ref mk_term(term_op op, iterator begin, iterator end);
 
+  /**
+   * Make a term whose type is known (for types, the base type), e.g. when
+   * loading terms that were type-checked before. If the term is new, the type
+   * is set directly instead of being computed from the children.
+   */
+  template <term_op op, typename iterator_type>
+  term_ref mk_typed_term(const typename term_op_traits<op>::payload_type& payload, iterator_type children_begin, iterator_type children_end, term_ref type);
+
   /** Get a reference for the term */
   term_ref ref_of(const term& term) const {
     return d_memory.ref_of(term);
@@ -495,6 +462,19 @@ public:
     return base_type_of_if_exists(term_of(t));
   }
 
+  /** Does the term have its type computed */
+  bool has_type(term_ref t) const {
+    return !term_of(t).d_type.is_null();
+  }
+
+  /** Set the type of the term (and base type if a type) */
+  void set_type(term_ref t, term_ref type, term_ref base_type);
+
+  /** Get the type as kept in the term (the base type for types), null if not computed */
+  term_ref stored_type_of(term_ref t) const {
+    return term_of(t).d_type;
+  }
+
   /** Are the types compatible (potentially, looking at base types */
   bool compatible(term_ref t1, term_ref t2);
 
@@ -509,8 +489,17 @@ public:
   /** Get the id of the term */
   size_t id_of(term_ref ref) const {
     if (ref.is_null()) return 0;
-    assert(d_term_ids.find(ref) != d_term_ids.end());
-    return d_term_ids.find(ref)->second;
+    return term_of(ref).d_id;
+  }
+
+  /** Number of term ids given out so far (all ids are smaller) */
+  size_t id_count() const {
+    return d_term_refcount.size();
+  }
+
+  /** Get the marks pool for traversals */
+  term_marks_pool& get_marks_pool() const {
+    return d_marks_pool;
   }
 
   /** Get the hash of the term */
@@ -566,7 +555,7 @@ public:
   term_ref get_default_value(term_ref type);
 
   /** Map of substitutions */
-  typedef boost::unordered_map<term_ref, term_ref, term_ref_hasher> substitution_map;
+  typedef term_subst_map substitution_map;
 
   /** Return t with subst applied */
   term_ref substitute(term_ref t, substitution_map& subst);
@@ -655,7 +644,7 @@ size_t term_manager_internal::term_hash(const typename term_op_traits<op>::paylo
 }
 
 template <term_op op, typename iterator_type>
-term_ref_fat term_manager_internal::mk_term_internal(const typename term_op_traits<op>::payload_type& payload, iterator_type begin, iterator_type end, size_t hash) {
+term_ref term_manager_internal::mk_term_internal(const typename term_op_traits<op>::payload_type& payload, iterator_type begin, iterator_type end, size_t hash) {
 
   typedef typename term_op_traits<op>::payload_type payload_type;
   typedef alloc::allocator<payload_type, alloc::empty_type> payload_allocator;
@@ -669,57 +658,66 @@ term_ref_fat term_manager_internal::mk_term_internal(const typename term_op_trai
     }
     // Allocate the payload and copy construct it
     payload_allocator* palloc = ((payload_allocator*) d_payload_memory[op]);
+    size_t palloc_size = palloc->memory_size();
     p_ref = palloc->template allocate<alloc::empty_type*>(payload, 0, 0, 0);
+    d_payload_memory_size += palloc->memory_size() - palloc_size;
+    d_stat_payload_memory->set_value(d_payload_memory_size / 1024);
   }
 
-  // Construct the term
+  // Construct the term with a new id
+  size_t id = new_term_id();
   term_ref t_ref;
   if (alloc::type_traits<payload_type>::is_empty) {
     // No payload, 0 for extras
-    t_ref = d_memory.allocate(term(op, hash), begin, end, 0);
+    t_ref = d_memory.allocate(term(op, hash, id), begin, end, 0);
   } else {
     // Pyaload active, add a child
-    t_ref = d_memory.allocate(term(op, hash), begin, end, 1);
+    t_ref = d_memory.allocate(term(op, hash, id), begin, end, 1);
     *alloc::allocator<term, term_ref>::object_end(d_memory.object_of(t_ref)) = p_ref;
   }
 
-  // Update the statistic
-  d_stat_terms->get_value() = d_memory.size();
+  // Update the statistics
+  d_stat_terms->set_value(d_memory.size());
+  d_stat_term_memory->set_value(d_memory.memory_size() / 1024);
 
-  // Set the id of the term and add to terms
-  size_t id = new_term_id();
-  d_term_ids[t_ref] = id;
+  // Children have their types already, so we can type the term
+  compute_type_of_new_term(t_ref);
 
-  // Get the reference
-  return term_ref_fat(t_ref, id, hash);
+  return t_ref;
 }
 
 template <term_op op, typename iterator_type>
 term_ref term_manager_internal::mk_term(const typename term_op_traits<op>::payload_type& payload, iterator_type begin, iterator_type end) {
-  // Insert and return the actual term_ref
-  term_ref_fat fat_ref = *d_pool.insert(term_ref_constructor<op, iterator_type>(*this, payload, begin, end)).first;
-  return fat_ref;
+  // Find or insert in a single probe of the pool
+  return d_pool.insert(term_ref_constructor<op, iterator_type>(*this, payload, begin, end));
 }
 
-/** Compare to a term op without using the hash. */
 template <term_op op, typename iterator_type>
-bool term_manager_internal::term_ref_constructor<op, iterator_type>::cmp(const term_ref_fat& other_ref) const {
-
-  // If the other reference is null, we're comparing to default => not equal
-  if (other_ref.is_null()) {
-    return false;
+term_ref term_manager_internal::mk_typed_term(const typename term_op_traits<op>::payload_type& payload, iterator_type begin, iterator_type end, term_ref type) {
+  d_typed_construction = true;
+  term_ref result;
+  try {
+    result = mk_term<op, iterator_type>(payload, begin, end);
+  } catch (...) {
+    d_typed_construction = false;
+    throw;
   }
-
-  // Compare hashes first
-  if (hash() != other_ref.hash()) {
-    return false;
+  d_typed_construction = false;
+  if (!has_type(result)) {
+    set_type(result, type, type);
   }
+  return result;
+}
+
+/** Compare to a term op without using the hash. */
+template <term_op op, typename iterator_type>
+bool term_manager_internal::term_ref_constructor<op, iterator_type>::cmp(term_ref other_ref) const {
 
   // The actual term we are comparing with
   const term& other = d_tm.term_of(other_ref);
 
   // Different ops => not equal
-  if (op != d_tm.term_of(other_ref).op()) {
+  if (op != other.op()) {
     return false;
   }
 
@@ -825,9 +823,7 @@ term_ref term_manager_internal::mk_term(term_op op, iterator begin, iterator end
 
 template<typename collection, typename matcher>
 void term_manager_internal::get_subterms(term_ref t, const matcher& m, collection& out) const {
-  typedef boost::unordered_set<term_ref, term_ref_hasher> visited_set;
-
-  visited_set v;
+  term_marks_lease v(d_marks_pool);
   std::queue<subterm_visitor_state> queue;
 
   // If matcher ignores this term, just return
@@ -837,7 +833,7 @@ void term_manager_internal::get_subterms(term_ref t, const matcher& m, collectio
 
   // Start with the term itself, then process
   queue.push(subterm_visitor_state(term_of(t)));
-  v.insert(t);
+  v->mark(id_of(t));
 
   std::insert_iterator<collection> insert(out, out.end());
   while (!queue.empty()) {
@@ -858,11 +854,10 @@ void term_manager_internal::get_subterms(term_ref t, const matcher& m, collectio
     // For abstraction only visit the body, otherwise go into all children
     size_t i = is_abstraction(current.t) ? current.t.size() - 1 : 0;
     for (; i < current.t.size(); ++ i) {
-      if (v.find(current.t[i]) == v.end()) {
-        if (!m.ignore(term_of(current.t[i]))) {
-          queue.push(subterm_visitor_state(term_of(current.t[i]), bound_vars));
-          v.insert(current.t[i]);
-        }
+      const term& child = term_of(current.t[i]);
+      if (!v->is_marked(child.d_id) && !m.ignore(child)) {
+        queue.push(subterm_visitor_state(child, bound_vars));
+        v->mark(child.d_id);
       }
     }
   }
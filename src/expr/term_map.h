@@ -19,8 +19,14 @@
 #pragma once
 
 #include "expr/term.h"
+#include "utils/hash.h"
 
 #include <map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cassert>
+#include <stdint.h>
 #include <boost/unordered_map.hpp>
 #include <functional>
 
@@ -111,5 +117,150 @@ public:
 };
 
 
+/**
+ * Map from terms to terms, used for substitutions. The pairs are kept in a
+ * flat array in insertion order, with an open-addressed index over them
+ * (linear probing, at most half full), so lookups are a probe or two without
+ * any allocation, copies are plain array copies, and iteration is in
+ * insertion order. The API follows the std/boost maps, except that there is
+ * no erase, and that inserting invalidates the iterators and references to
+ * the values.
+ */
+class term_subst_map {
+
+public:
+
+  typedef term_ref key_type;
+  typedef term_ref mapped_type;
+  typedef std::pair<term_ref, term_ref> value_type;
+  typedef std::vector<value_type>::iterator iterator;
+  typedef std::vector<value_type>::const_iterator const_iterator;
+
+private:
+
+  /** The pairs, in insertion order */
+  std::vector<value_type> d_entries;
+
+  /** Index of the pairs (pair index + 1, 0 for empty), size is a power of 2 */
+  std::vector<uint32_t> d_slots;
+
+  /** Smallest non-empty index */
+  static const size_t s_min_slots = 16;
+
+  /** First slot to probe for t */
+  size_t slot_of(term_ref t) const {
+    return utils::hash_mix(t.index()) & (d_slots.size() - 1);
+  }
+
+  /** Index of the pair with key t, or size if not there */
+  size_t lookup(term_ref t) const {
+    if (d_entries.empty()) {
+      return 0;
+    }
+    size_t mask = d_slots.size() - 1;
+    for (size_t i = slot_of(t); d_slots[i]; i = (i + 1) & mask) {
+      size_t entry = d_slots[i] - 1;
+      if (d_entries[entry].first == t) {
+        return entry;
+      }
+    }
+    return d_entries.size();
+  }
+
+  /** Index the last pair, growing the index if needed */
+  void index_last() {
+    if (2*d_entries.size() > d_slots.size()) {
+      assert(d_entries.size() < UINT32_MAX);
+      d_slots.assign(std::max(s_min_slots, 2*d_slots.size()), 0);
+      for (size_t entry = 0; entry < d_entries.size(); ++ entry) {
+        index(entry);
+      }
+    } else {
+      index(d_entries.size() - 1);
+    }
+  }
+
+  /** Add the pair to the index (the key is not there) */
+  void index(size_t entry) {
+    size_t mask = d_slots.size() - 1;
+    size_t i = slot_of(d_entries[entry].first);
+    while (d_slots[i]) {
+      i = (i + 1) & mask;
+    }
+    d_slots[i] = entry + 1;
+  }
+
+public:
+
+  term_subst_map() {}
+
+  iterator begin() { return d_entries.begin(); }
+  iterator end() { return d_entries.end(); }
+  const_iterator begin() const { return d_entries.begin(); }
+  const_iterator end() const { return d_entries.end(); }
+
+  size_t size() const { return d_entries.size(); }
+  bool empty() const { return d_entries.empty(); }
+
+  /** Bytes of memory used by the map */
+  size_t memory_size() const {
+    return d_entries.capacity()*sizeof(value_type) + d_slots.capacity()*sizeof(uint32_t);
+  }
+
+  iterator find(term_ref t) {
+    return d_entries.begin() + lookup(t);
+  }
+
+  const_iterator find(term_ref t) const {
+    return d_entries.begin() + lookup(t);
+  }
+
+  size_t count(term_ref t) const {
+    return lookup(t) < d_entries.size() ? 1 : 0;
+  }
+
+  /** Insert the pair, unless the key is already there */
+  std::pair<iterator, bool> insert(const value_type& p) {
+    size_t entry = lookup(p.first);
+    if (entry < d_entries.size()) {
+      return std::make_pair(d_entries.begin() + entry, false);
+    }
+    d_entries.push_back(p);
+    index_last();
+    return std::make_pair(d_entries.end() - 1, true);
+  }
+
+  /** Value of t, inserting a null value if not there */
+  term_ref& operator [] (term_ref t) {
+    return insert(value_type(t, term_ref())).first->second;
+  }
+
+  void clear() {
+    d_entries.clear();
+    d_slots.clear();
+  }
+
+  void swap(term_subst_map& other) {
+    d_entries.swap(other.d_entries);
+    d_slots.swap(other.d_slots);
+  }
+
+  /** Relocate the terms and remove the pairs with a collected term */
+  template <typename gc_relocator>
+  void reloc(const gc_relocator& gc_reloc) {
+    term_subst_map new_t_map;
+    for (const_iterator it = begin(); it != end(); ++ it) {
+      term_ref key = it->first;
+      term_ref value = it->second;
+      gc_reloc.reloc(key);
+      gc_reloc.reloc(value);
+      if (!key.is_null() && !value.is_null()) {
+        new_t_map[key] = value;
+      }
+    }
+    swap(new_t_map);
+  }
+};
+
 }
 }
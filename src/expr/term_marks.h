@@ -0,0 +1,149 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+namespace sally {
+namespace expr {
+
+/**
+ * Visited marks of terms, stored densely by term id. A term is marked if its
+ * stamp is the current epoch, so clearing all the marks is just starting a
+ * new epoch.
+ */
+class term_marks {
+
+  /** Stamps by term id */
+  std::vector<uint32_t> d_stamps;
+
+  /** Current epoch (never 0) */
+  uint32_t d_epoch;
+
+public:
+
+  term_marks(): d_epoch(1) {}
+
+  /** Bytes of memory used by the marks */
+  size_t memory_size() const {
+    return d_stamps.capacity()*sizeof(uint32_t);
+  }
+
+  /** Unmark all terms */
+  void clear() {
+    if (++ d_epoch == 0) {
+      // Wrapped around, old stamps could look current
+      std::fill(d_stamps.begin(), d_stamps.end(), 0);
+      d_epoch = 1;
+    }
+  }
+
+  /** Is the term with the given id marked */
+  bool is_marked(size_t id) const {
+    return id < d_stamps.size() && d_stamps[id] == d_epoch;
+  }
+
+  /** Mark the term with the given id, returns false if already marked */
+  bool mark(size_t id) {
+    if (id >= d_stamps.size()) {
+      d_stamps.resize(std::max(id + 1, 2*d_stamps.size()), 0);
+    }
+    if (d_stamps[id] == d_epoch) {
+      return false;
+    }
+    d_stamps[id] = d_epoch;
+    return true;
+  }
+};
+
+/**
+ * Term marks kept for reuse, so that the traversals don't allocate the marks
+ * for all the term ids each time. Nested traversals each take their own
+ * marks. Not thread-safe, as the rest of the term manager.
+ */
+class term_marks_pool {
+
+  /** The marks not in use */
+  std::vector<term_marks*> d_free;
+
+  term_marks_pool(const term_marks_pool&);
+  term_marks_pool& operator = (const term_marks_pool&);
+
+public:
+
+  term_marks_pool() {}
+
+  ~term_marks_pool() {
+    for (size_t i = 0; i < d_free.size(); ++ i) {
+      delete d_free[i];
+    }
+  }
+
+  /** Take marks from the pool (all terms unmarked) */
+  term_marks* acquire() {
+    if (d_free.empty()) {
+      return new term_marks();
+    }
+    term_marks* marks = d_free.back();
+    d_free.pop_back();
+    marks->clear();
+    return marks;
+  }
+
+  /** Bytes of memory used by the marks in the pool (not the ones in use) */
+  size_t memory_size() const {
+    size_t size = d_free.capacity()*sizeof(term_marks*);
+    for (size_t i = 0; i < d_free.size(); ++ i) {
+      size += sizeof(term_marks) + d_free[i]->memory_size();
+    }
+    return size;
+  }
+
+  /** Return the marks to the pool */
+  void release(term_marks* marks) {
+    d_free.push_back(marks);
+  }
+};
+
+/** Marks taken from the pool for the lifetime of the object */
+class term_marks_lease {
+
+  term_marks_pool& d_pool;
+  term_marks* d_marks;
+
+  term_marks_lease(const term_marks_lease&);
+  term_marks_lease& operator = (const term_marks_lease&);
+
+public:
+
+  term_marks_lease(term_marks_pool& pool)
+  : d_pool(pool), d_marks(pool.acquire()) {}
+
+  ~term_marks_lease() {
+    d_pool.release(d_marks);
+  }
+
+  term_marks& operator * () const { return *d_marks; }
+  term_marks* operator -> () const { return d_marks; }
+};
+
+}
+}
@@ -0,0 +1,200 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "expr/term.h"
+
+#include <vector>
+#include <cassert>
+#include <stdint.h>
+
+namespace sally {
+namespace expr {
+
+/**
+ * The hash-consing pool of the term manager. It is an open addressing table
+ * (linear probing) of term references with their hashes, so that a lookup of
+ * a term that is not there yet finds the empty slot where the new term goes
+ * in the same probe sequence. Terms are never removed from the pool.
+ *
+ * The construction of a term can insert other terms into the pool.
+ */
+class term_pool {
+
+  /** An entry of the table, empty if ref is null (keeps 32 bits of the hash) */
+  struct entry {
+    term_ref ref;
+    uint32_t hash;
+    entry(): hash(0) {}
+  };
+
+  /** The table, size is a power of 2 */
+  std::vector<entry> d_table;
+
+  /** Number of terms in the table */
+  size_t d_size;
+
+  /** Number of bits of the table size */
+  unsigned d_bits;
+
+  /** Number of lookups */
+  size_t d_lookups;
+
+  /** Total number of occupied slots inspected by lookups */
+  size_t d_probes;
+
+  /** Maximal number of occupied slots inspected by one lookup */
+  size_t d_max_probes;
+
+  /** Number of times we compared to a different term with the same (32 bit) hash */
+  size_t d_collisions;
+
+  /** Slot for the hash (multiplicative, uses the high bits of the product) */
+  size_t slot_of(uint32_t hash) const {
+    return (size_t) (((uint64_t) hash * 0x9e3779b97f4a7c15ULL) >> (64 - d_bits));
+  }
+
+  /** Record the probe length of a lookup */
+  void record_lookup(size_t probes) {
+    d_lookups ++;
+    d_probes += probes;
+    if (probes > d_max_probes) {
+      d_max_probes = probes;
+    }
+  }
+
+  /** Double the size of the table */
+  void grow() {
+    std::vector<entry> old;
+    old.swap(d_table);
+    d_bits ++;
+    d_table.resize(((size_t) 1) << d_bits);
+    size_t mask = d_table.size() - 1;
+    for (size_t i = 0; i < old.size(); ++ i) {
+      if (!old[i].ref.is_null()) {
+        size_t slot = slot_of(old[i].hash);
+        while (!d_table[slot].ref.is_null()) {
+          slot = (slot + 1) & mask;
+        }
+        d_table[slot] = old[i];
+      }
+    }
+  }
+
+public:
+
+  term_pool()
+  : d_table(((size_t) 1) << 10)
+  , d_size(0)
+  , d_bits(10)
+  , d_lookups(0)
+  , d_probes(0)
+  , d_max_probes(0)
+  , d_collisions(0)
+  {}
+
+  /**
+   * Find the term described by the constructor, or create it if not in the
+   * pool. The constructor must provide hash(), cmp(term_ref) that compares
+   * to an existing term with the same hash, and construct() that creates
+   * the term.
+   */
+  template <typename constructor>
+  term_ref insert(const constructor& c) {
+    uint32_t hash = (uint32_t) c.hash();
+    size_t mask = d_table.size() - 1;
+    size_t slot = slot_of(hash);
+    size_t probes = 0;
+    for (;; slot = (slot + 1) & mask, ++ probes) {
+      entry& e = d_table[slot];
+      if (e.ref.is_null()) {
+        break;
+      }
+      if (e.hash == hash) {
+        if (c.cmp(e.ref)) {
+          record_lookup(probes + 1);
+          return e.ref;
+        }
+        d_collisions ++;
+      }
+    }
+    record_lookup(probes);
+    // Not found, slot is empty: construct in place. Constructing the term
+    // can add other terms (e.g. its type), in which case we probe again.
+    size_t size = d_size;
+    term_ref ref = c.construct();
+    if (size != d_size) {
+      mask = d_table.size() - 1;
+      slot = slot_of(hash);
+      while (!d_table[slot].ref.is_null()) {
+        slot = (slot + 1) & mask;
+      }
+    }
+    d_table[slot].ref = ref;
+    d_table[slot].hash = hash;
+    d_size ++;
+    // Keep the load under 1/2, linear probing clusters quickly above that
+    if (2*d_size > d_table.size()) {
+      grow();
+    }
+    return ref;
+  }
+
+  /** Number of terms in the pool */
+  size_t size() const {
+    return d_size;
+  }
+
+  /** Number of slots in the table */
+  size_t capacity() const {
+    return d_table.size();
+  }
+
+  /** Bytes of memory used by the table */
+  size_t memory_size() const {
+    return d_table.capacity()*sizeof(entry);
+  }
+
+  /** Average number of occupied slots inspected per lookup */
+  double average_probes() const {
+    return d_lookups ? ((double) d_probes) / d_lookups : 0;
+  }
+
+  /** Maximal number of occupied slots inspected by one lookup */
+  size_t max_probes() const {
+    return d_max_probes;
+  }
+
+  /** Number of comparisons to different terms with the same hash */
+  size_t collisions() const {
+    return d_collisions;
+  }
+
+  /** Get all the terms in the pool */
+  void get_terms(std::vector<term_ref>& out) const {
+    for (size_t i = 0; i < d_table.size(); ++ i) {
+      if (!d_table[i].ref.is_null()) {
+        out.push_back(d_table[i].ref);
+      }
+    }
+  }
+};
+
+}
+}
@@ -0,0 +1,699 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "expr/term_rewriter.h"
+#include "expr/gc_relocator.h"
+#include "expr/model.h"
+#include "utils/exception.h"
+#include "utils/trace.h"
+
+#include <set>
+#include <sstream>
+#include <cassert>
+
+namespace sally {
+namespace expr {
+
+term_rewriter::term_rewriter(term_manager& tm, unsigned rules)
+: d_tm(tm)
+, d_rules(rules)
+{}
+
+unsigned term_rewriter::parse_rules(std::string rules) {
+  unsigned result = 0;
+  std::stringstream ss(rules);
+  std::string rule;
+  while (std::getline(ss, rule, ',')) {
+    if (rule == "bool") {
+      result |= REWRITE_BOOL;
+    } else if (rule == "arith") {
+      result |= REWRITE_ARITH;
+    } else if (rule == "bv") {
+      result |= REWRITE_BV;
+    } else if (rule == "all") {
+      result |= REWRITE_ALL;
+    } else {
+      throw exception("Unknown rewrite rule set '" + rule + "' (expected bool, arith, bv, or all).");
+    }
+  }
+  return result;
+}
+
+void term_rewriter::clear() {
+  d_cache.clear();
+}
+
+void term_rewriter::gc_collect(const gc_relocator& gc_reloc) {
+  gc_reloc.reloc(d_cache);
+}
+
+bool term_rewriter::rewrite_children(const term& t) const {
+  term_op op = t.op();
+  switch (op) {
+  case TERM_ITE:
+  case TERM_EQ:
+  case TERM_AND:
+  case TERM_OR:
+  case TERM_NOT:
+  case TERM_IMPLIES:
+  case TERM_XOR:
+    return true;
+  case TERM_BV_EXTEND:
+  case TERM_BV_ROR:
+  case TERM_BV_ROL:
+    return false;
+  default:
+    return (TERM_ADD <= op && op <= TERM_IS_INT) || (TERM_BV_ADD <= op && op <= TERM_BV_NEG);
+  }
+}
+
+term_ref term_rewriter::rewrite(term_ref t) {
+
+  // Post-order, with an explicit stack (terms can be deep)
+  std::vector<term_ref> stack(1, t);
+  std::vector<term_ref> children;
+  while (!stack.empty()) {
+    term_ref current = stack.back();
+    if (d_cache.find(current) != d_cache.end()) {
+      stack.pop_back();
+      continue;
+    }
+
+    const term& current_term = d_tm.term_of(current);
+    bool descend = rewrite_children(current_term);
+
+    // Add the children that are not done yet
+    bool ready = true;
+    if (descend) {
+      for (size_t i = 0; i < current_term.size(); ++ i) {
+        if (d_cache.find(current_term[i]) == d_cache.end()) {
+          stack.push_back(current_term[i]);
+          ready = false;
+        }
+      }
+    }
+    if (!ready) {
+      continue;
+    }
+
+    // All children are rewritten
+    stack.pop_back();
+    term_ref result = current;
+    if (descend) {
+      children.clear();
+      for (size_t i = 0; i < current_term.size(); ++ i) {
+        children.push_back(d_cache[current_term[i]]);
+      }
+      result = rewrite_node(current, children);
+    }
+    TRACE("expr::rewriter") << current << " -> " << result << std::endl;
+    d_cache[current] = result;
+  }
+
+  return d_cache[t];
+}
+
+void term_rewriter::rewrite(std::vector<term_ref>& terms) {
+  for (size_t i = 0; i < terms.size(); ++ i) {
+    terms[i] = rewrite(terms[i]);
+  }
+}
+
+term_ref term_rewriter::rewrite_node(term_ref t, const std::vector<term_ref>& children) {
+  term_op op = d_tm.term_of(t).op();
+  term_ref result;
+  if (d_rules & REWRITE_BOOL) {
+    result = rewrite_bool(op, children);
+  }
+  if (result.is_null() && (d_rules & REWRITE_ARITH)) {
+    result = rewrite_arith(op, children);
+  }
+  if (result.is_null() && (d_rules & REWRITE_BV)) {
+    result = rewrite_bv(t, op, children);
+  }
+  if (result.is_null()) {
+    result = mk_term(t, op, children);
+  }
+  return result;
+}
+
+term_ref term_rewriter::mk_term(term_ref t, term_op op, const std::vector<term_ref>& children) {
+  if (t.is_null()) {
+    return d_tm.mk_term(op, children);
+  }
+  // Check if anything changed
+  const term& t_term = d_tm.term_of(t);
+  bool changed = false;
+  for (size_t i = 0; !changed && i < children.size(); ++ i) {
+    changed = t_term[i] != children[i];
+  }
+  if (!changed) {
+    return t;
+  }
+  // Need special cases for operators with payload
+  switch (op) {
+  case TERM_BV_EXTRACT:
+    return d_tm.mk_bitvector_extract(children[0], d_tm.get_bitvector_extract(t_term));
+  case TERM_BV_SGN_EXTEND:
+    return d_tm.mk_bitvector_sgn_extend(children[0], d_tm.get_bitvector_sgn_extend(t_term));
+  default:
+    return d_tm.mk_term(op, children);
+  }
+}
+
+bool term_rewriter::is_constant(term_ref t) const {
+  switch (d_tm.term_of(t).op()) {
+  case CONST_BOOL:
+  case CONST_RATIONAL:
+  case CONST_BITVECTOR:
+  case CONST_ENUM:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool term_rewriter::is_arithmetic(term_ref t) const {
+  return d_tm.base_type_of(t) == d_tm.real_type();
+}
+
+bool term_rewriter::is_bitvector_constant(term_ref t, bool value) const {
+  const term& t_term = d_tm.term_of(t);
+  if (t_term.op() != CONST_BITVECTOR) {
+    return false;
+  }
+  bitvector bv = d_tm.get_bitvector_constant(t_term);
+  return value ? bv == bitvector::one(bv.size()) : bv == bitvector(bv.size());
+}
+
+term_ref term_rewriter::fold_constant(term_ref t, term_op op, const std::vector<term_ref>& children) {
+  for (size_t i = 0; i < children.size(); ++ i) {
+    if (!is_constant(children[i])) {
+      return term_ref();
+    }
+  }
+  term_ref t_new = mk_term(t, op, children);
+  model empty(d_tm, false);
+  return empty.get_term_value(t_new).to_term(d_tm);
+}
+
+term_ref term_rewriter::rewrite_bool(term_op op, const std::vector<term_ref>& children) {
+
+  term_ref true_term = d_tm.mk_boolean_constant(true);
+  term_ref false_term = d_tm.mk_boolean_constant(false);
+
+  switch (op) {
+  case TERM_NOT:
+    if (children[0] == true_term) return false_term;
+    if (children[0] == false_term) return true_term;
+    return d_tm.mk_not(children[0]);
+  case TERM_AND:
+  case TERM_OR: {
+    // Neutral and absorbing element
+    term_ref neutral = op == TERM_AND ? true_term : false_term;
+    term_ref absorbing = op == TERM_AND ? false_term : true_term;
+    // Flatten and remove duplicates
+    std::set<term_ref> lits;
+    for (size_t i = 0; i < children.size(); ++ i) {
+      const term& child_term = d_tm.term_of(children[i]);
+      if (child_term.op() == op) {
+        lits.insert(child_term.begin(), child_term.end());
+      } else {
+        lits.insert(children[i]);
+      }
+    }
+    lits.erase(neutral);
+    if (lits.count(absorbing)) {
+      return absorbing;
+    }
+    // x and (not x)
+    for (std::set<term_ref>::const_iterator it = lits.begin(); it != lits.end(); ++ it) {
+      const term& lit_term = d_tm.term_of(*it);
+      if (lit_term.op() == TERM_NOT && lits.count(lit_term[0])) {
+        return absorbing;
+      }
+    }
+    if (lits.size() == 0) {
+      return neutral;
+    }
+    if (lits.size() == 1) {
+      return *lits.begin();
+    }
+    return d_tm.mk_term(op, std::vector<term_ref>(lits.begin(), lits.end()));
+  }
+  case TERM_IMPLIES:
+    if (children[0] == true_term) return children[1];
+    if (children[0] == false_term) return true_term;
+    if (children[1] == true_term) return true_term;
+    if (children[1] == false_term) return d_tm.mk_not(children[0]);
+    if (children[0] == children[1]) return true_term;
+    return term_ref();
+  case TERM_XOR:
+    if (children.size() != 2) return term_ref();
+    if (children[0] == children[1]) return false_term;
+    if (children[0] == false_term) return children[1];
+    if (children[1] == false_term) return children[0];
+    if (children[0] == true_term) return d_tm.mk_not(children[1]);
+    if (children[1] == true_term) return d_tm.mk_not(children[0]);
+    return term_ref();
+  case TERM_EQ:
+    if (children[0] == children[1]) return true_term;
+    // Constants are unique
+    if (is_constant(children[0]) && is_constant(children[1])) return false_term;
+    if (children[0] == true_term) return children[1];
+    if (children[1] == true_term) return children[0];
+    if (children[0] == false_term) return d_tm.mk_not(children[1]);
+    if (children[1] == false_term) return d_tm.mk_not(children[0]);
+    return term_ref();
+  case TERM_ITE:
+    if (children[0] == true_term) return children[1];
+    if (children[0] == false_term) return children[2];
+    if (children[1] == children[2]) return children[1];
+    if (children[1] == true_term && children[2] == false_term) return children[0];
+    if (children[1] == false_term && children[2] == true_term) return d_tm.mk_not(children[0]);
+    return term_ref();
+  default:
+    return term_ref();
+  }
+}
+
+void term_rewriter::add_to_polynomial(term_ref t, const rational& scale, polynomial& p) {
+  const term& t_term = d_tm.term_of(t);
+  term_op op = t_term.op();
+  switch (op) {
+  case CONST_RATIONAL:
+    p.constant += scale * d_tm.get_rational_constant(t_term);
+    return;
+  case TERM_ADD:
+  case TERM_SUB:
+  case TERM_MUL:
+  case TERM_DIV: {
+    std::vector<term_ref> children(t_term.begin(), t_term.end());
+    if (add_to_polynomial(op, children, scale, p)) {
+      return;
+    }
+    break;
+  }
+  default:
+    break;
+  }
+  // An atom
+  rational& c = p.monomials[t];
+  c += scale;
+  if (c.sgn() == 0) {
+    p.monomials.erase(t);
+  }
+}
+
+bool term_rewriter::add_to_polynomial(term_op op, const std::vector<term_ref>& children, const rational& scale, polynomial& p) {
+  switch (op) {
+  case TERM_ADD:
+    for (size_t i = 0; i < children.size(); ++ i) {
+      add_to_polynomial(children[i], scale, p);
+    }
+    return true;
+  case TERM_SUB:
+    if (children.size() == 1) {
+      add_to_polynomial(children[0], -scale, p);
+    } else {
+      add_to_polynomial(children[0], scale, p);
+      add_to_polynomial(children[1], -scale, p);
+    }
+    return true;
+  case TERM_MUL: {
+    // Linear if all but one child are constants
+    rational c = scale;
+    term_ref non_constant;
+    for (size_t i = 0; i < children.size(); ++ i) {
+      const term& child_term = d_tm.term_of(children[i]);
+      if (child_term.op() == CONST_RATIONAL) {
+        c *= d_tm.get_rational_constant(child_term);
+      } else if (non_constant.is_null()) {
+        non_constant = children[i];
+      } else {
+        return false;
+      }
+    }
+    if (non_constant.is_null()) {
+      p.constant += c;
+    } else if (c.sgn() != 0) {
+      add_to_polynomial(non_constant, c, p);
+    }
+    return true;
+  }
+  case TERM_DIV: {
+    // Linear if dividing by a non-zero constant
+    const term& divisor_term = d_tm.term_of(children[1]);
+    if (divisor_term.op() != CONST_RATIONAL) {
+      return false;
+    }
+    rational divisor = d_tm.get_rational_constant(divisor_term);
+    if (divisor.sgn() == 0) {
+      return false;
+    }
+    add_to_polynomial(children[0], scale / divisor, p);
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+term_ref term_rewriter::mk_polynomial(const polynomial& p) {
+  std::vector<term_ref> sum;
+  rational one(1, 1);
+  std::map<term_ref, rational>::const_iterator it = p.monomials.begin();
+  for (; it != p.monomials.end(); ++ it) {
+    if (it->second == one) {
+      sum.push_back(it->first);
+    } else {
+      sum.push_back(d_tm.mk_term(TERM_MUL, d_tm.mk_rational_constant(it->second), it->first));
+    }
+  }
+  if (p.constant.sgn() != 0 || sum.empty()) {
+    sum.push_back(d_tm.mk_rational_constant(p.constant));
+  }
+  if (sum.size() == 1) {
+    return sum[0];
+  }
+  return d_tm.mk_term(TERM_ADD, sum);
+}
+
+term_ref term_rewriter::mk_arith_atom(term_op op, polynomial& p) {
+
+  assert(op == TERM_LEQ || op == TERM_LT || op == TERM_EQ);
+
+  // Constant to the right: p op c
+  rational c = p.constant.negate();
+  p.constant = rational();
+
+  // Constant atoms
+  if (p.monomials.empty()) {
+    int sgn = c.sgn();
+    bool value = op == TERM_LEQ ? sgn >= 0 : (op == TERM_LT ? sgn > 0 : sgn == 0);
+    return d_tm.mk_boolean_constant(value);
+  }
+
+  // Integer polynomials have integer atoms and coefficients
+  bool is_int = true;
+  std::map<term_ref, rational>::iterator it = p.monomials.begin();
+  for (; is_int && it != p.monomials.end(); ++ it) {
+    is_int = it->second.is_integer() && d_tm.is_integer_type(d_tm.type_of(it->first));
+  }
+
+  // Scale by a positive factor, for equalities also make the leading coefficient positive
+  rational scale;
+  if (is_int) {
+    mpz_class gcd;
+    for (it = p.monomials.begin(); it != p.monomials.end(); ++ it) {
+      mpz_class coeff = it->second.get_numerator().mpz();
+      mpz_gcd(gcd.get_mpz_t(), gcd.get_mpz_t(), coeff.get_mpz_t());
+    }
+    scale = rational(integer(1L), integer(gcd));
+  } else {
+    scale = p.monomials.begin()->second.sgn() > 0 ? p.monomials.begin()->second.invert() : p.monomials.begin()->second.invert().negate();
+  }
+  if (op == TERM_EQ && p.monomials.begin()->second.sgn() < 0) {
+    scale = scale.negate();
+  }
+  for (it = p.monomials.begin(); it != p.monomials.end(); ++ it) {
+    it->second *= scale;
+  }
+  c *= scale;
+
+  // Integer tightening
+  if (is_int) {
+    switch (op) {
+    case TERM_LEQ:
+      c = c.floor();
+      break;
+    case TERM_LT:
+      c = c.ceiling() - rational(1, 1);
+      op = TERM_LEQ;
+      break;
+    case TERM_EQ:
+      if (!c.is_integer()) {
+        return d_tm.mk_boolean_constant(false);
+      }
+      break;
+    default:
+      assert(false);
+    }
+  }
+
+  // Positive monomials to the left, negative ones to the right
+  polynomial lhs, rhs;
+  rhs.constant = c;
+  for (it = p.monomials.begin(); it != p.monomials.end(); ++ it) {
+    if (it->second.sgn() > 0) {
+      lhs.monomials[it->first] = it->second;
+    } else {
+      rhs.monomials[it->first] = it->second.negate();
+    }
+  }
+  if (lhs.monomials.empty()) {
+    // -p op c becomes p op' -c
+    rhs.constant = rational();
+    term_op op_reversed = op == TERM_LEQ ? TERM_GEQ : (op == TERM_LT ? TERM_GT : TERM_EQ);
+    return d_tm.mk_term(op_reversed, mk_polynomial(rhs), d_tm.mk_rational_constant(c.negate()));
+  }
+  return d_tm.mk_term(op, mk_polynomial(lhs), mk_polynomial(rhs));
+}
+
+term_ref term_rewriter::rewrite_arith(term_op op, const std::vector<term_ref>& children) {
+  switch (op) {
+  case TERM_ADD:
+  case TERM_SUB:
+  case TERM_MUL:
+  case TERM_DIV: {
+    polynomial p;
+    if (add_to_polynomial(op, children, rational(1, 1), p)) {
+      return mk_polynomial(p);
+    }
+    return term_ref();
+  }
+  case TERM_LEQ:
+  case TERM_LT:
+  case TERM_GEQ:
+  case TERM_GT:
+  case TERM_EQ: {
+    if (op == TERM_EQ && !is_arithmetic(children[0])) {
+      return term_ref();
+    }
+    // lhs - rhs op 0, or rhs - lhs for >, >=
+    bool flip = op == TERM_GEQ || op == TERM_GT;
+    polynomial p;
+    add_to_polynomial(children[flip ? 1 : 0], rational(1, 1), p);
+    add_to_polynomial(children[flip ? 0 : 1], rational(-1, 1), p);
+    if (op == TERM_GEQ) op = TERM_LEQ;
+    if (op == TERM_GT) op = TERM_LT;
+    return mk_arith_atom(op, p);
+  }
+  case TERM_TO_REAL:
+    if (d_tm.term_of(children[0]).op() == CONST_RATIONAL) {
+      return children[0];
+    }
+    return term_ref();
+  case TERM_TO_INT:
+  case TERM_IS_INT:
+    if (d_tm.term_of(children[0]).op() == CONST_RATIONAL) {
+      return fold_constant(term_ref(), op, children);
+    }
+    return term_ref();
+  default:
+    return term_ref();
+  }
+}
+
+term_ref term_rewriter::mk_extract(term_ref t, size_t high, size_t low) {
+
+  assert(low <= high);
+
+  const term& t_term = d_tm.term_of(t);
+  size_t size = d_tm.get_bitvector_size(t);
+
+  // Whole term
+  if (low == 0 && high + 1 == size) {
+    return t;
+  }
+
+  switch (t_term.op()) {
+  case CONST_BITVECTOR:
+    return d_tm.mk_bitvector_constant(d_tm.get_bitvector_constant(t_term).extract(low, high));
+  case TERM_BV_EXTRACT: {
+    // Extract of extract
+    bitvector_extract inner = d_tm.get_bitvector_extract(t_term);
+    return mk_extract(t_term[0], inner.low + high, inner.low + low);
+  }
+  case TERM_BV_CONCAT: {
+    // Find the child with the bits, children are from the most significant
+    std::vector<term_ref> children(t_term.begin(), t_term.end());
+    size_t child_low = size;
+    for (size_t i = 0; i < children.size(); ++ i) {
+      size_t child_size = d_tm.get_bitvector_size(children[i]);
+      child_low -= child_size;
+      if (child_low <= low && high < child_low + child_size) {
+        return mk_extract(children[i], high - child_low, low - child_low);
+      }
+    }
+    break;
+  }
+  default:
+    break;
+  }
+
+  return d_tm.mk_bitvector_extract(t, bitvector_extract(high, low));
+}
+
+term_ref term_rewriter::rewrite_bv(term_ref t, term_op op, const std::vector<term_ref>& children) {
+
+  if (op < TERM_BV_ADD || op > TERM_BV_NEG) {
+    return term_ref();
+  }
+
+  // Constant folding
+  term_ref folded = fold_constant(t, op, children);
+  if (!folded.is_null()) {
+    return folded;
+  }
+
+  size_t size = d_tm.get_bitvector_size(children[0]);
+  term_ref zero = d_tm.mk_bitvector_constant(bitvector(size));
+
+  switch (op) {
+  case TERM_BV_ADD:
+  case TERM_BV_OR:
+  case TERM_BV_AND:
+  case TERM_BV_MUL: {
+    // Absorbing element
+    if (op == TERM_BV_MUL || op == TERM_BV_AND || op == TERM_BV_OR) {
+      for (size_t i = 0; i < children.size(); ++ i) {
+        if (is_bitvector_constant(children[i], op == TERM_BV_OR)) {
+          return children[i];
+        }
+      }
+    }
+    // Remove neutral elements (and duplicates for and/or)
+    std::vector<term_ref> filtered;
+    std::set<term_ref> seen;
+    for (size_t i = 0; i < children.size(); ++ i) {
+      bool neutral;
+      if (op == TERM_BV_MUL) {
+        neutral = d_tm.term_of(children[i]).op() == CONST_BITVECTOR && d_tm.get_bitvector_constant(d_tm.term_of(children[i])) == bitvector(size, 1);
+      } else {
+        neutral = is_bitvector_constant(children[i], op == TERM_BV_AND);
+      }
+      if (op == TERM_BV_AND || op == TERM_BV_OR) {
+        neutral = neutral || !seen.insert(children[i]).second;
+      }
+      if (!neutral) {
+        filtered.push_back(children[i]);
+      }
+    }
+    if (filtered.size() == children.size()) {
+      return term_ref();
+    }
+    if (filtered.empty()) {
+      return op == TERM_BV_AND ? d_tm.mk_bitvector_constant(bitvector::one(size)) :
+             op == TERM_BV_MUL ? d_tm.mk_bitvector_constant(bitvector(size, 1)) : zero;
+    }
+    if (filtered.size() == 1) {
+      return filtered[0];
+    }
+    return d_tm.mk_term(op, filtered);
+  }
+  case TERM_BV_XOR:
+    if (children.size() != 2) return term_ref();
+    if (children[0] == children[1]) return zero;
+    if (children[0] == zero) return children[1];
+    if (children[1] == zero) return children[0];
+    return term_ref();
+  case TERM_BV_SUB:
+    if (children.size() != 2) return term_ref();
+    if (children[0] == children[1]) return zero;
+    if (children[1] == zero) return children[0];
+    return term_ref();
+  case TERM_BV_SHL:
+  case TERM_BV_LSHR:
+  case TERM_BV_ASHR:
+    if (children[1] == zero) return children[0];
+    if (children[0] == zero) return zero;
+    return term_ref();
+  case TERM_BV_NOT:
+  case TERM_BV_NEG:
+    // Double negation
+    if (d_tm.term_of(children[0]).op() == op) {
+      return d_tm.term_of(children[0])[0];
+    }
+    return term_ref();
+  case TERM_BV_EXTRACT: {
+    bitvector_extract extract = d_tm.get_bitvector_extract(d_tm.term_of(t));
+    return mk_extract(children[0], extract.high, extract.low);
+  }
+  case TERM_BV_CONCAT: {
+    // Merge adjacent constants and adjacent extracts of the same term
+    std::vector<term_ref> merged;
+    for (size_t i = 0; i < children.size(); ++ i) {
+      term_ref current = children[i];
+      if (!merged.empty()) {
+        const term& last_term = d_tm.term_of(merged.back());
+        const term& current_term = d_tm.term_of(current);
+        if (last_term.op() == CONST_BITVECTOR && current_term.op() == CONST_BITVECTOR) {
+          bitvector bv = d_tm.get_bitvector_constant(last_term).concat(d_tm.get_bitvector_constant(current_term));
+          merged.back() = d_tm.mk_bitvector_constant(bv);
+          continue;
+        }
+        if (last_term.op() == TERM_BV_EXTRACT && current_term.op() == TERM_BV_EXTRACT && last_term[0] == current_term[0]) {
+          bitvector_extract last_extract = d_tm.get_bitvector_extract(last_term);
+          bitvector_extract current_extract = d_tm.get_bitvector_extract(current_term);
+          if (last_extract.low == current_extract.high + 1) {
+            term_ref base = last_term[0];
+            merged.back() = mk_extract(base, last_extract.high, current_extract.low);
+            continue;
+          }
+        }
+      }
+      merged.push_back(current);
+    }
+    if (merged.size() == children.size()) {
+      return term_ref();
+    }
+    if (merged.size() == 1) {
+      return merged[0];
+    }
+    return d_tm.mk_term(TERM_BV_CONCAT, merged);
+  }
+  case TERM_BV_ULEQ:
+  case TERM_BV_SLEQ:
+  case TERM_BV_UGEQ:
+  case TERM_BV_SGEQ:
+    if (children[0] == children[1]) return d_tm.mk_boolean_constant(true);
+    return term_ref();
+  case TERM_BV_ULT:
+  case TERM_BV_SLT:
+  case TERM_BV_UGT:
+  case TERM_BV_SGT:
+    if (children[0] == children[1]) return d_tm.mk_boolean_constant(false);
+    return term_ref();
+  default:
+    return term_ref();
+  }
+}
+
+}
+}
@@ -0,0 +1,151 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "expr/term_manager.h"
+#include "expr/rational.h"
+
+#include <map>
+#include <vector>
+#include <string>
+
+namespace sally {
+namespace expr {
+
+class gc_relocator;
+
+/**
+ * Bottom-up simplification of terms. Each term is rewritten once, after its
+ * children, and the results are cached by term so that shared subterms are
+ * only processed once. The rules are grouped into theory rule sets that can
+ * be enabled separately:
+ *
+ * - Boolean: constant propagation, double negation, flattening and
+ *   deduplication of and/or, complementary literals, ite simplification;
+ * - arithmetic: linear terms are put into a polynomial normal form (sum of
+ *   coefficient * atom ordered by term, constant last), and comparisons into
+ *   lhs <= rhs, lhs < rhs, lhs = rhs with positive coefficients on both sides
+ *   (real comparisons are scaled so that the first atom has coefficient 1,
+ *   integer ones are divided by the gcd of the coefficients and tightened);
+ * - bit-vectors: constant folding, neutral and absorbing elements, extract
+ *   over extract/concat and fusion of adjacent extracts in concat.
+ *
+ * The rewriting is not reentrant. The cache keeps term references, so it
+ * must either be cleared or relocated on garbage collection.
+ */
+class term_rewriter {
+
+public:
+
+  /** The rule sets */
+  enum rule_set {
+    REWRITE_BOOL = 1,
+    REWRITE_ARITH = 2,
+    REWRITE_BV = 4,
+    REWRITE_ALL = REWRITE_BOOL | REWRITE_ARITH | REWRITE_BV
+  };
+
+  /** Construct the rewriter with the rule sets */
+  term_rewriter(term_manager& tm, unsigned rules = REWRITE_ALL);
+
+  /** Rewrite the term */
+  term_ref rewrite(term_ref t);
+
+  /** Rewrite all the terms in place */
+  void rewrite(std::vector<term_ref>& terms);
+
+  /** Clear the cache */
+  void clear();
+
+  /** Relocate the cache */
+  void gc_collect(const gc_relocator& gc_reloc);
+
+  /** Get the rule sets from a comma separated list (bool, arith, bv, all) */
+  static unsigned parse_rules(std::string rules);
+
+private:
+
+  /** A linear polynomial sum c*x + constant */
+  struct polynomial {
+    /** The atoms with their (non-zero) coefficients, ordered by term */
+    std::map<term_ref, rational> monomials;
+    /** The constant */
+    rational constant;
+  };
+
+  /** The term manager */
+  term_manager& d_tm;
+
+  /** Enabled rule sets */
+  unsigned d_rules;
+
+  /** Cache of rewritten terms */
+  term_manager::substitution_map d_cache;
+
+  /** Should we rewrite the children of the term */
+  bool rewrite_children(const term& t) const;
+
+  /** Rewrite the term, given the rewritten children */
+  term_ref rewrite_node(term_ref t, const std::vector<term_ref>& children);
+
+  /** Make the term like t but with different children */
+  term_ref mk_term(term_ref t, term_op op, const std::vector<term_ref>& children);
+
+  /** Boolean rules (returns null if none applies) */
+  term_ref rewrite_bool(term_op op, const std::vector<term_ref>& children);
+
+  /** Arithmetic rules (returns null if none applies) */
+  term_ref rewrite_arith(term_op op, const std::vector<term_ref>& children);
+
+  /** Bit-vector rules (returns null if none applies) */
+  term_ref rewrite_bv(term_ref t, term_op op, const std::vector<term_ref>& children);
+
+  /** Fold the term with all constant children to a constant (null if not possible) */
+  term_ref fold_constant(term_ref t, term_op op, const std::vector<term_ref>& children);
+
+  /** Extract the bits [low, high] of t, simplifying the extract */
+  term_ref mk_extract(term_ref t, size_t high, size_t low);
+
+  /** Add scale*t to the polynomial */
+  void add_to_polynomial(term_ref t, const rational& scale, polynomial& p);
+
+  /** Add scale*op(children) to the polynomial, returns false if not linear */
+  bool add_to_polynomial(term_op op, const std::vector<term_ref>& children, const rational& scale, polynomial& p);
+
+  /** Make the term of the polynomial */
+  term_ref mk_polynomial(const polynomial& p);
+
+  /**
+   * Make the normalized atom p op 0 where op is one of <=, <, =. The result is
+   * lhs op rhs, with positive coefficients on both sides.
+   */
+  term_ref mk_arith_atom(term_op op, polynomial& p);
+
+  /** Is the term a constant */
+  bool is_constant(term_ref t) const;
+
+  /** Is the term an arithmetic term */
+  bool is_arithmetic(term_ref t) const;
+
+  /** Is t a bit-vector constant with all bits equal to value */
+  bool is_bitvector_constant(term_ref t, bool value) const;
+};
+
+}
+}
@@ -0,0 +1,158 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "expr/term_manager.h"
+#include "expr/term_manager_internal.h"
+#include "expr/term_marks.h"
+#include "expr/term_visitor.h"
+
+#include <vector>
+#include <stdint.h>
+
+namespace sally {
+namespace expr {
+
+/**
+ * Post-order traversal of term DAGs, each term is visited once after all its
+ * children. The visitor provides
+ *
+ *   visitor_match_result match(term_ref t);
+ *   void visit(term_ref t);
+ *
+ * where match() decides whether to visit the term and whether to go into its
+ * children (see visitor_match_result). The children are read directly from
+ * the term, and the visited terms are marked in a dense array by term id
+ * (taken from the term manager pool and cleared in O(1) for each run). The
+ * traversal is iterative, keeps its stack between runs, and the visitor can
+ * create new terms while visiting.
+ *
+ * When running on several roots, shared subterms are visited only once.
+ */
+class term_traversal {
+
+  /** Entry of the DFS stack */
+  struct entry {
+    term_ref t;
+    /** Next child to process */
+    uint32_t child;
+    /** Should we go into the children */
+    bool descend;
+    /** Should we visit the term */
+    bool visit;
+    entry(term_ref t, visitor_match_result match)
+    : t(t)
+    , child(0)
+    , descend(match == VISIT_AND_CONTINUE || match == DONT_VISIT_AND_CONTINUE)
+    , visit(match == VISIT_AND_CONTINUE || match == VISIT_AND_BREAK)
+    {}
+  };
+
+  /** The term manager */
+  const term_manager_internal& d_tm;
+
+  /** The marks */
+  term_marks_lease d_marks;
+
+  /** The DFS stack */
+  std::vector<entry> d_stack;
+
+  term_traversal(const term_traversal&);
+  term_traversal& operator = (const term_traversal&);
+
+  /** Add the term to the stack, unless already reached */
+  template <typename visitor>
+  void push(visitor& v, term_ref t) {
+    if (d_marks->mark(d_tm.id_of(t))) {
+      d_stack.push_back(entry(t, v.match(t)));
+    }
+  }
+
+  /** Traverse from t, calling done(t, visit) in post-order */
+  template <typename visitor, typename callback>
+  void dfs(visitor& v, term_ref t, callback& done) {
+    push(v, t);
+    while (!d_stack.empty()) {
+      entry& current = d_stack.back();
+      TRACE("term::visitor") << "current: " << current.t << std::endl;
+      if (current.descend) {
+        // Terms can move if the visitor creates new ones, so get it each time
+        const term& current_term = d_tm.term_of(current.t);
+        if (current.child < current_term.size()) {
+          term_ref child = current_term[current.child ++];
+          push(v, child);
+          continue;
+        }
+      }
+      // All children done
+      term_ref done_t = current.t;
+      bool done_visit = current.visit;
+      d_stack.pop_back();
+      done(done_t, done_visit);
+    }
+  }
+
+  /** Post-order callback visiting the terms */
+  template <typename visitor>
+  struct visit_callback {
+    visitor& v;
+    visit_callback(visitor& v): v(v) {}
+    void operator () (term_ref t, bool visit) {
+      if (visit) {
+        v.visit(t);
+      }
+    }
+  };
+
+public:
+
+  term_traversal(const term_manager& tm)
+  : d_tm(*tm.get_internal())
+  , d_marks(d_tm.get_marks_pool())
+  {}
+
+  term_traversal(const term_manager_internal& tm)
+  : d_tm(tm)
+  , d_marks(d_tm.get_marks_pool())
+  {}
+
+  /** Run the visitor on the term */
+  template <typename visitor>
+  void run(visitor& v, term_ref t) {
+    run(v, &t, &t + 1);
+  }
+
+  /** Run the visitor on all the terms, visiting shared subterms once */
+  template <typename visitor, typename iterator>
+  void run(visitor& v, iterator begin, iterator end) {
+    d_marks->clear();
+    visit_callback<visitor> done(v);
+    for (; begin != end; ++ begin) {
+      dfs(v, *begin, done);
+    }
+  }
+
+  /** Was the term reached in the last run */
+  bool is_reached(term_ref t) const {
+    return d_marks->is_marked(d_tm.id_of(t));
+  }
+};
+
+}
+}
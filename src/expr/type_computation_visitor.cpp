@@ -31,7 +31,7 @@ namespace expr {
 void type_computation_visitor::error(term_ref t_ref, std::string message) const {
   std::stringstream ss;
   term_manager* tm = output::get_term_manager(std::cerr);
-  if (tm->get_internal() == &d_tm) {
+  if (tm != 0 && tm->get_internal() == &d_tm) {
     output::set_term_manager(ss, tm);
   }
   ss << "Can't typecheck " << t_ref;
@@ -65,22 +65,13 @@ bool type_computation_visitor::compatible(term_ref t1, term_ref t2) const {
   return base_type_of(t1) == base_type_of(t2);
 }
 
-type_computation_visitor::type_computation_visitor(term_manager_internal& tm, term_to_term_map& type_cache, term_to_term_map& base_type_cache)
+type_computation_visitor::type_computation_visitor(term_manager_internal& tm)
 : d_tm(tm)
-, d_type_cache(type_cache)
-, d_base_type_cache(base_type_cache)
 , d_ok(true)
 {}
 
-void type_computation_visitor::get_children(term_ref t, std::vector<term_ref>& children) {
-  const term& t_term = d_tm.term_of(t);
-  for (size_t i = 0; i < t_term.size(); ++ i) {
-    children.push_back(t_term[i]);
-  }
-}
-
 visitor_match_result type_computation_visitor::match(term_ref t) {
-  if (d_type_cache.find(t) == d_type_cache.end()) {
+  if (!d_tm.has_type(t)) {
     // Visit the children if needed and then the node
     return VISIT_AND_CONTINUE;
   } else {
@@ -115,7 +106,8 @@ void type_computation_visitor::visit(term_ref t_ref) {
   case TYPE_REAL:
   case TYPE_STRING:
     d_ok = t.size() == 0;
-    if (d_ok) t_type = d_tm.type_type();
+    // The type of types is created first, so it's its own type
+    if (d_ok) t_type = op == TYPE_TYPE ? t_ref : d_tm.type_type();
     else error_message << "unexpected children of " << op;
     break;
   case VARIABLE:
@@ -1031,11 +1023,7 @@ void type_computation_visitor::visit(term_ref t_ref) {
   if (!d_ok) {
     error(t_ref, error_message.str());
   } else {
-    assert(d_type_cache.find(t_ref) == d_type_cache.end());
-    d_type_cache[t_ref] = t_type;
-    if (d_tm.is_type(t_ref) && !d_tm.is_primitive_type(t_ref)) {
-      d_base_type_cache[t_ref] = t_base_type;
-    }
+    d_tm.set_type(t_ref, t_type, t_base_type);
   }
 }
 
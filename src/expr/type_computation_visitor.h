@@ -18,7 +18,6 @@
 
 #pragma once
 
-#include <boost/unordered_map.hpp>
 #include <vector>
 
 #include "expr/term.h"
@@ -31,17 +30,9 @@ class term_manager_internal;
 
 class type_computation_visitor {
 
-  typedef boost::unordered_map<term_ref, term_ref, term_ref_hasher> term_to_term_map;
-
-  /** The term manager */
+  /** The term manager (types are stored in the terms) */
   term_manager_internal& d_tm;
 
-  /** Cache of the term manager: term/type -> type */
-  term_to_term_map& d_type_cache;
-
-  /** Cache of the term manager: non-primitive type -> type */
-  term_to_term_map& d_base_type_cache;
-
   /** Set to false whenever type computation fails */
   bool d_ok;
 
@@ -53,15 +44,7 @@ class type_computation_visitor {
 
 public:
 
-  type_computation_visitor(term_manager_internal& tm, term_to_term_map& type_cache, term_to_term_map& base_type_cache);
-
-  // Non-null terms are good
-  bool is_good_term(expr::term_ref t) const {
-    return !t.is_null();
-  }
-
-  /** Get the children of the term t that are relevant for the type computation */
-  void get_children(term_ref t, std::vector<term_ref>& children);
+  type_computation_visitor(term_manager_internal& tm);
 
   /** We visit only nodes that don't have types yet and are relevant for type computation */
   visitor_match_result match(term_ref t);
@@ -20,6 +20,8 @@
 #include "expr/term_manager.h"
 #include "utils/exception.h"
 
+#include <new>
+#include <utility>
 #include <iostream>
 #include <cassert>
 
@@ -39,40 +41,51 @@ value::value(bool b)
 }
 
 value::value(const value& v)
-: d_type(v.d_type)
-, d_b(v.d_b)
-, d_bv(v.d_bv)
-, d_q(v.d_q)
-, d_a(v.d_a)
-, d_ev(v.d_ev)
+: d_type(VALUE_NONE)
+, d_b(false)
+{
+  construct(v);
+}
+
+value::value(value&& v)
+: d_type(VALUE_NONE)
+, d_b(false)
 {
+  construct(std::move(v));
 }
 
 value::value(const rational& q)
 : d_type(VALUE_RATIONAL)
-, d_b(false)
 , d_q(q)
 {
 }
 
+value::value(rational&& q)
+: d_type(VALUE_RATIONAL)
+, d_q(std::move(q))
+{
+}
+
 value::value(const algebraic_number& a)
 : d_type(VALUE_ALGEBRAIC)
-, d_b(false)
 , d_a(a)
 {
 }
 
-
 value::value(const bitvector& bv)
 : d_type(VALUE_BITVECTOR)
-, d_b(false)
 , d_bv(bv)
 {
 }
 
+value::value(bitvector&& bv)
+: d_type(VALUE_BITVECTOR)
+, d_bv(std::move(bv))
+{
+}
+
 value::value(const enum_value& ev)
 : d_type(VALUE_ENUM)
-, d_b(false)
 , d_ev(ev)
 {}
 
@@ -88,15 +101,15 @@ value::value(const term_manager& tm, term_ref t)
     d_type = VALUE_BOOL;
     break;
   case CONST_BITVECTOR:
-    d_bv = tm.get_bitvector_constant(t_term);
+    new (&d_bv) bitvector(tm.get_bitvector_constant(t_term));
     d_type = VALUE_BITVECTOR;
     break;
   case CONST_RATIONAL:
-    d_q = tm.get_rational_constant(t_term);
+    new (&d_q) rational(tm.get_rational_constant(t_term));
     d_type = VALUE_RATIONAL;
     break;
   case CONST_ENUM:
-    d_ev = tm.get_enum_constant(t_term);
+    new (&d_ev) enum_value(tm.get_enum_constant(t_term));
     d_type = VALUE_ENUM;
     break;
   default:
@@ -104,14 +117,95 @@ value::value(const term_manager& tm, term_ref t)
   }
 }
 
+value::~value() {
+  destruct();
+}
+
+void value::construct(const value& v) {
+  assert(d_type == VALUE_NONE);
+  switch (v.d_type) {
+  case VALUE_NONE:
+    break;
+  case VALUE_BOOL:
+    d_b = v.d_b;
+    break;
+  case VALUE_BITVECTOR:
+    new (&d_bv) bitvector(v.d_bv);
+    break;
+  case VALUE_RATIONAL:
+    new (&d_q) rational(v.d_q);
+    break;
+  case VALUE_ALGEBRAIC:
+    new (&d_a) algebraic_number(v.d_a);
+    break;
+  case VALUE_ENUM:
+    new (&d_ev) enum_value(v.d_ev);
+    break;
+  }
+  d_type = v.d_type;
+}
+
+void value::construct(value&& v) {
+  assert(d_type == VALUE_NONE);
+  switch (v.d_type) {
+  case VALUE_BITVECTOR:
+    new (&d_bv) bitvector(std::move(v.d_bv));
+    break;
+  case VALUE_RATIONAL:
+    new (&d_q) rational(std::move(v.d_q));
+    break;
+  default:
+    construct(static_cast<const value&>(v));
+    return;
+  }
+  d_type = v.d_type;
+}
+
+void value::destruct() {
+  switch (d_type) {
+  case VALUE_NONE:
+  case VALUE_BOOL:
+    break;
+  case VALUE_BITVECTOR:
+    d_bv.~bitvector();
+    break;
+  case VALUE_RATIONAL:
+    d_q.~rational();
+    break;
+  case VALUE_ALGEBRAIC:
+    d_a.~algebraic_number();
+    break;
+  case VALUE_ENUM:
+    d_ev.~enum_value();
+    break;
+  }
+  d_type = VALUE_NONE;
+}
+
 value& value::operator = (const value& v) {
   if (this != &v) {
-    d_type = v.d_type;
-    d_b = v.d_b;
-    d_bv = v.d_bv;
-    d_q = v.d_q;
-    d_a = v.d_a;
-    d_ev = v.d_ev;
+    if (d_type == v.d_type && d_type == VALUE_BITVECTOR) {
+      d_bv = v.d_bv;
+    } else if (d_type == v.d_type && d_type == VALUE_RATIONAL) {
+      d_q = v.d_q;
+    } else {
+      destruct();
+      construct(v);
+    }
+  }
+  return *this;
+}
+
+value& value::operator = (value&& v) {
+  if (this != &v) {
+    if (d_type == v.d_type && d_type == VALUE_BITVECTOR) {
+      d_bv = std::move(v.d_bv);
+    } else if (d_type == v.d_type && d_type == VALUE_RATIONAL) {
+      d_q = std::move(v.d_q);
+    } else {
+      destruct();
+      construct(std::move(v));
+    }
   }
   return *this;
 }
@@ -187,28 +281,40 @@ void value::to_stream(std::ostream& out) const {
   }
 }
 
+// The members are a union, so only the member of the type can be read
+
 bool value::get_bool() const {
-  assert(is_bool());
+  if (!is_bool()) {
+    throw exception("value is not a Boolean");
+  }
   return d_b;
 }
 
 const bitvector& value::get_bitvector() const {
-  assert(is_bitvector());
+  if (!is_bitvector()) {
+    throw exception("value is not a bit-vector");
+  }
   return d_bv;
 }
 
 const rational& value::get_rational() const {
-  assert(is_rational());
+  if (!is_rational()) {
+    throw exception("value is not a rational");
+  }
   return d_q;
 }
 
 const algebraic_number& value::get_algebraic() const {
-  assert(is_algebraic());
+  if (!is_algebraic()) {
+    throw exception("value is not an algebraic number");
+  }
   return d_a;
 }
 
 const enum_value& value::get_enum_value() const {
-  assert(is_enum_value());
+  if (!is_enum_value()) {
+    throw exception("value is not an enum value");
+  }
   return d_ev;
 }
 
@@ -251,16 +357,16 @@ public:
     if (x.value_type() == y.value_type()) {
       x_to_use = &x;
       y_to_use = &y;
+    } else if (x.is_rational() && y.is_algebraic()) {
+      tmp = value(algebraic_number(x.get_rational()));
+      x_to_use = &tmp;
+      y_to_use = &y;
+    } else if (x.is_algebraic() && y.is_rational()) {
+      tmp = value(algebraic_number(y.get_rational()));
+      x_to_use = &x;
+      y_to_use = &tmp;
     } else {
-      if (x.value_type() == value::VALUE_RATIONAL) {
-        tmp = value(algebraic_number(x.get_rational()));
-        x_to_use = &tmp;
-        y_to_use = &y;
-      } else {
-        tmp = value(algebraic_number(y.get_rational()));
-        x_to_use = &x;
-        y_to_use = &tmp;
-      }
+      throw exception("can't combine values of different types");
     }
   }
 
@@ -301,9 +407,9 @@ value& value::operator += (const value& other) {
 value value::operator - () const {
   switch (value_type()) {
   case VALUE_RATIONAL:
-    return value(get_rational().invert());
+    return value(get_rational().negate());
   case VALUE_ALGEBRAIC:
-    return value(get_algebraic().invert());
+    return value(get_algebraic().negate());
   default:
     assert(false);
   }
@@ -31,6 +31,10 @@ namespace expr {
 class term_manager;
 class term_ref;
 
+/**
+ * A value of one of the types, stored as a tagged union so that only the
+ * active member is constructed.
+ */
 class value {
 
 public:
@@ -48,24 +52,40 @@ private:
 
   type d_type;
 
-  bool d_b;
-  bitvector d_bv;
-  rational d_q;
-  algebraic_number d_a;
-  enum_value d_ev;
+  union {
+    bool d_b;
+    bitvector d_bv;
+    rational d_q;
+    algebraic_number d_a;
+    enum_value d_ev;
+  };
+
+  /** Construct the active member as a copy of v's (assumes none active) */
+  void construct(const value& v);
+
+  /** Construct the active member by moving v's (assumes none active) */
+  void construct(value&& v);
+
+  /** Destruct the active member */
+  void destruct();
 
 public:
 
   value();
   value(const value& v);
+  value(value&& v);
   value(bool b);
   value(const rational& q);
+  value(rational&& q);
   value(const algebraic_number& a);
   value(const bitvector& bv);
+  value(bitvector&& bv);
   value(const enum_value& ev);
   value(const term_manager& tm, term_ref t);
+  ~value();
 
   value& operator = (const value& v);
+  value& operator = (value&& v);
 
   bool operator == (const value& v) const;
   bool operator != (const value& v) const;
@@ -243,11 +243,11 @@ aiger_parser::aiger_parser(const system::context& ctx, const char* filename)
 
   // Define initial states
   expr::term_ref initial_state = d_tm.mk_and(initial_state_formulas);
-  system::state_formula* initial_state_formula = new system::state_formula(d_tm, state_type, initial_state);
+  system::state_formula* initial_state_formula = new system::state_formula(d_tm, state_type, rewrite_input(ctx, initial_state));
 
   // Define transition
   expr::term_ref transition = d_tm.mk_and(transition_formulas);
-  system::transition_formula* transition_formula = new system::transition_formula(d_tm, state_type, transition);
+  system::transition_formula* transition_formula = new system::transition_formula(d_tm, state_type, rewrite_input(ctx, transition));
 
   // Define system
   system::transition_system* aiger_system = new system::transition_system(state_type, initial_state_formula, transition_formula);
@@ -259,7 +259,7 @@ aiger_parser::aiger_parser(const system::context& ctx, const char* filename)
   for (size_t i = 0; i < a->num_outputs; ++ i) {
     expr::term_ref bad_i = aiger_to_term(a->outputs[i].lit);
     expr::term_ref p_i = d_tm.mk_term(expr::TERM_NOT, bad_i);
-    system::state_formula *p = new system::state_formula(d_tm, state_type, p_i);
+    system::state_formula *p = new system::state_formula(d_tm, state_type, rewrite_input(ctx, p_i));
     queries.push_back(p);
   }
   cmd::command* query = new cmd::query(ctx, "system", queries);
@@ -20,33 +20,102 @@
 
 #include "parser/parser.h"
 #include "expr/gc_participant.h"
+#include "utils/mapped_file.h"
 
 #include <iostream>
+#include <limits>
+#include <algorithm>
 #include <antlr3.h>
 
 namespace sally {
 namespace parser {
 
+/**
+ * Find the end of a batch of top-level s-expressions starting at begin: whole
+ * s-expressions are added until the batch is at least min_size bytes. Comments
+ * (';' to the end of line), strings ("...") and quoted symbols (|...|) are
+ * skipped over, so their parentheses don't count.
+ */
+inline
+const char* next_sexpr_batch(const char* begin, const char* end, size_t min_size) {
+  const char* p = begin;
+  size_t depth = 0;
+  while (p != end) {
+    char c = *p ++;
+    switch (c) {
+    case ';':
+      while (p != end && *p != '\n') { ++ p; }
+      break;
+    case '"':
+      while (p != end && *p != '"') { ++ p; }
+      if (p != end) { ++ p; }
+      break;
+    case '|':
+      while (p != end && *p != '|') { ++ p; }
+      if (p != end) { ++ p; }
+      break;
+    case '(':
+      ++ depth;
+      break;
+    case ')':
+      if (depth > 0 && -- depth == 0 && (size_t)(p - begin) >= min_size) {
+        return p;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  return end;
+}
+
+/**
+ * Traits of the languages. Besides the lexer and parser, the traits say
+ * whether the input can be streamed: if so, the top-level commands are
+ * independent s-expressions and the input is parsed in batches of commands.
+ */
 template<input_language lang>
 struct antlr_parser_traits {};
 
+/**
+ * ANTLR parser over a memory-mapped file. The ANTLR input reads the mapped
+ * file in place (no copy). For streamed languages the file is parsed in
+ * batches of top-level commands, each with its own lexer, token stream and
+ * parser, so the tokens of a batch are released once the batch is parsed and
+ * the memory of parsing is bounded by the largest batch instead of the file.
+ * The parser state (symbol tables) is kept across batches.
+ */
 template <input_language lang>
 class antlr_parser : public internal_parser_interface, public expr::gc_participant {
 
-  /** The input */
+  typedef antlr_parser_traits<lang> traits;
+
+  /** The file */
+  utils::mapped_file d_file;
+
+  /** Start of the next batch */
+  const char* d_next;
+
+  /** Line of the start of the next batch */
+  size_t d_next_line;
+
+  /** The input of the current batch (0 if none) */
   pANTLR3_INPUT_STREAM d_input;
 
   /** The lexer */
-  typename antlr_parser_traits<lang>::pLangLexer d_lexer;
+  typename traits::pLangLexer d_lexer;
 
   /** The token stream */
   pANTLR3_COMMON_TOKEN_STREAM d_token_stream;
 
   /** The parser */
-  typename antlr_parser_traits<lang>::pLangParser d_parser;
+  typename traits::pLangParser d_parser;
 
   /** The state of the solver */
-  typename antlr_parser_traits<lang>::langState d_state;
+  typename traits::langState d_state;
+
+  /** Minimal size of a batch (for streamed languages) */
+  static const size_t s_batch_size = 1 << 20;
 
   static
   void sally_parser_reportError(pANTLR3_BASE_RECOGNIZER recognizer);
@@ -54,23 +123,34 @@ class antlr_parser : public internal_parser_interface, public expr::gc_participa
   static
   void sally_lexer_reportError(pANTLR3_BASE_RECOGNIZER recognizer);
 
-public:
+  /** Set up the parsing of the next batch, returns false if at the end */
+  bool next_batch() {
+    const char* end = d_file.end();
+    if (d_next == end && d_input != 0) {
+      return false;
+    }
 
-  antlr_parser(const system::context& ctx, const char* file_to_parse)
-  : gc_participant(ctx.tm())
-  , d_state(ctx)
-  {
-    // Create the input stream for the file
-    d_input = antlr3FileStreamNew((pANTLR3_UINT8) file_to_parse, ANTLR3_ENC_8BIT);
+    // The batch: everything if not streaming
+    const char* begin = d_next;
+    const char* batch_end = traits::streaming ? next_sexpr_batch(begin, end, s_batch_size) : end;
+    if ((size_t)(batch_end - begin) > (size_t) std::numeric_limits<ANTLR3_UINT32>::max()) {
+      throw parser_exception("input too large", d_file.get_filename(), d_next_line);
+    }
+    free_batch();
+
+    // Create the input stream over the batch
+    static const char empty[] = "";
+    d_input = antlr3StringStreamNew((pANTLR3_UINT8) (begin == end ? empty : begin), ANTLR3_ENC_8BIT, batch_end - begin, (pANTLR3_UINT8) d_file.get_filename().c_str());
     if (d_input == 0) {
-      throw parser_exception(std::string("can't open ") + file_to_parse);
+      throw parser_exception(std::string("can't open ") + d_file.get_filename());
     }
 
     // Create a lexer
-    d_lexer = antlr_parser_traits<lang>::newLexer(d_input);
+    d_lexer = traits::newLexer(d_input);
     if (d_lexer == 0) {
       throw parser_exception("can't create the lexer");
     }
+    d_input->setLine(d_input, d_next_line);
 
     // Report the error
     d_lexer->pLexer->rec->reportError = sally_lexer_reportError;
@@ -82,7 +162,7 @@ public:
     }
 
     // Create the parser
-    d_parser = antlr_parser_traits<lang>::newParser(d_token_stream);
+    d_parser = traits::newParser(d_token_stream);
     if (d_parser == 0) {
       throw parser_exception("can't create the parser");
     }
@@ -96,17 +176,49 @@ public:
 
     // Add error reporting
     d_parser->pParser->rec->reportError = sally_parser_reportError;
+
+    // Move on
+    d_next_line += std::count(begin, batch_end, '\n');
+    d_next = batch_end;
+
+    return true;
+  }
+
+  /** Free the ANTLR objects of the current batch (the tokens too) */
+  void free_batch() {
+    if (d_parser) { d_parser->free(d_parser); d_parser = 0; }
+    if (d_token_stream) { d_token_stream->free(d_token_stream); d_token_stream = 0; }
+    if (d_lexer) { d_lexer->free(d_lexer); d_lexer = 0; }
+    if (d_input) { d_input->free(d_input); d_input = 0; }
+  }
+
+public:
+
+  antlr_parser(const system::context& ctx, const char* file_to_parse)
+  : gc_participant(ctx.tm())
+  , d_file(file_to_parse)
+  , d_next(d_file.begin())
+  , d_next_line(1)
+  , d_input(0)
+  , d_lexer(0)
+  , d_token_stream(0)
+  , d_parser(0)
+  , d_state(ctx)
+  {
+    next_batch();
   }
 
   ~antlr_parser() {
-    d_parser->free(d_parser);
-    d_token_stream->free(d_token_stream);
-    d_lexer->free(d_lexer);
-    d_input->free(d_input);
+    free_batch();
   }
 
   cmd::command* parse_command() {
-    return d_parser->command(d_parser);
+    for (;;) {
+      cmd::command* cmd = d_parser->command(d_parser);
+      if (cmd != 0 || !next_batch()) {
+        return cmd;
+      }
+    }
   }
 
   /** Returns true if the parser is in error state */
@@ -116,7 +228,7 @@ public:
 
   /** Returns the name of the file being parser */
   std::string get_filename() const {
-    return (const char*) d_lexer->pLexer->rec->state->tokSource->fileName->chars;
+    return d_file.get_filename();
   }
 
   pANTLR3_COMMON_TOKEN get_current_parser_token() const {
@@ -18,38 +18,293 @@
 
 #include "parser/btor/btor.h"
 #include "parser/btor/btor_state.h"
+#include "parser/line_reader.h"
 
-#include "parser/btor/btorLexer.h"
-#include "parser/btor/btorParser.h"
+#include "expr/gc_participant.h"
+#include "utils/mapped_file.h"
+
+#include <algorithm>
 
 namespace sally {
 namespace parser {
 
-template<>
-struct antlr_parser_traits<INPUT_BTOR> {
+/** Kinds of BTOR lines */
+enum btor_kind {
+  BTOR_VAR,
+  BTOR_CONSTD,
+  BTOR_CONST,
+  BTOR_BINARY,
+  BTOR_SLICE,
+  BTOR_COND,
+  BTOR_NEXT,
+  BTOR_ROOT
+};
+
+/**
+ * A parsed BTOR line. The arguments are the subterms, except for slice (term,
+ * high, low) and next (variable, term). The text is the name of a variable or
+ * the digits of a constant, pointing into the input.
+ */
+struct btor_line {
+  size_t lineno;
+  uint64_t id;
+  btor_kind kind;
+  expr::term_op op;
+  uint64_t size;
+  int64_t args[3];
+  line_token text;
+};
+
+/** Parses the lines into btor_line records, no state so it can run in parallel */
+struct btor_line_parser {
 
-  typedef pbtorLexer pLangLexer;
-  typedef pbtorParser pLangParser;
+  static void error(const char* msg, const line_token& token) {
+    throw parser_exception(std::string(msg) + ": '" + token.str() + "'");
+  }
+
+  static void expect(line_tokenizer& tokens, line_token& token) {
+    if (!tokens.next(token)) {
+      throw parser_exception("Unexpected end of line");
+    }
+  }
 
-  typedef btor_state langState;
+  static uint64_t get_uint(line_tokenizer& tokens) {
+    line_token token;
+    expect(tokens, token);
+    uint64_t value;
+    if (!token.to_uint(value)) {
+      error("Expected a number", token);
+    }
+    return value;
+  }
 
-  static
-  pLangLexer newLexer(pANTLR3_INPUT_STREAM instream) {
-    return btorLexerNew(instream);
+  static int64_t get_int(line_tokenizer& tokens) {
+    line_token token;
+    expect(tokens, token);
+    int64_t value;
+    if (!token.to_int(value)) {
+      error("Expected a number", token);
+    }
+    return value;
   }
 
-  static
-  pLangParser newParser(pANTLR3_COMMON_TOKEN_STREAM instream) {
-    return btorParserNew(instream);
+  /** Binary operators */
+  static bool get_binary_op(const line_token& token, expr::term_op& op) {
+    static const struct { const char* name; expr::term_op op; } ops[] = {
+      { "xor", expr::TERM_BV_XOR },
+      { "sra", expr::TERM_BV_ASHR },
+      { "sll", expr::TERM_BV_SHL },
+      { "concat", expr::TERM_BV_CONCAT },
+      { "eq", expr::TERM_EQ },
+      { "and", expr::TERM_BV_AND },
+      { "or", expr::TERM_BV_OR },
+      { "add", expr::TERM_BV_ADD },
+      { "sub", expr::TERM_BV_SUB },
+      { "mul", expr::TERM_BV_MUL },
+      { "sdiv", expr::TERM_BV_SDIV },
+      { "srem", expr::TERM_BV_SREM },
+      { "ulte", expr::TERM_BV_ULEQ },
+    };
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); ++ i) {
+      if (token == ops[i].name) {
+        op = ops[i].op;
+        return true;
+      }
+    }
+    return false;
   }
 
+  void operator () (const char* begin, const char* end, size_t lineno, std::vector<btor_line>& out) const {
+
+    line_tokenizer tokens(begin, end);
+    line_token token;
+    if (!tokens.next(token)) {
+      // Empty line or comment
+      return;
+    }
+
+    btor_line line;
+    line.lineno = lineno;
+    line.op = expr::OP_LAST;
+    line.args[0] = line.args[1] = line.args[2] = 0;
+    if (!token.to_uint(line.id)) {
+      error("Expected a number", token);
+    }
+
+    line_token kind;
+    expect(tokens, kind);
+    line.size = get_uint(tokens);
+
+    if (kind == "var") {
+      line.kind = BTOR_VAR;
+      tokens.next(line.text);
+    } else if (kind == "constd") {
+      line.kind = BTOR_CONSTD;
+      expect(tokens, line.text);
+    } else if (kind == "const") {
+      line.kind = BTOR_CONST;
+      expect(tokens, line.text);
+    } else if (kind == "slice") {
+      line.kind = BTOR_SLICE;
+      line.args[0] = get_int(tokens);
+      line.args[1] = get_uint(tokens);
+      line.args[2] = get_uint(tokens);
+    } else if (kind == "cond") {
+      line.kind = BTOR_COND;
+      line.args[0] = get_int(tokens);
+      line.args[1] = get_int(tokens);
+      line.args[2] = get_int(tokens);
+    } else if (kind == "next") {
+      line.kind = BTOR_NEXT;
+      line.args[0] = get_uint(tokens);
+      line.args[1] = get_int(tokens);
+    } else if (kind == "root") {
+      line.kind = BTOR_ROOT;
+      line.args[0] = get_int(tokens);
+    } else if (get_binary_op(kind, line.op)) {
+      line.kind = BTOR_BINARY;
+      line.args[0] = get_int(tokens);
+      line.args[1] = get_int(tokens);
+    } else {
+      error("Unknown BTOR operator", kind);
+    }
+
+    if (tokens.next(token)) {
+      error("Unexpected token", token);
+    }
+
+    out.push_back(line);
+  }
 };
 
-internal_parser_interface* new_btor_parser(const system::context& ctx, const char* filename) {
-  return new antlr_parser<INPUT_BTOR>(ctx, filename);
-}
+/** Reads the whole file line by line into the BTOR state */
+class btor_parser : public internal_parser_interface, public expr::gc_participant {
+
+  /** The state */
+  btor_state d_state;
+
+  /** File we're parsing */
+  std::string d_filename;
+
+  /** Line we're parsing */
+  int d_lineno;
+
+  /** Have we returned the command */
+  bool d_done;
+
+  /** Number of threads for reading the lines */
+  size_t d_workers;
+
+  /** Add the line to the state */
+  void add_line(const btor_line& line);
+
+public:
 
+  btor_parser(const system::context& ctx, const char* filename)
+  : gc_participant(ctx.tm())
+  , d_state(ctx)
+  , d_filename(filename)
+  , d_lineno(0)
+  , d_done(false)
+  , d_workers(1)
+  {
+    if (ctx.get_options().has_option("parse-threads")) {
+      d_workers = ctx.get_options().get_unsigned("parse-threads");
+    }
+  }
+
+  cmd::command* parse_command();
+
+  int get_current_parser_line() const {
+    return d_lineno;
+  }
+
+  int get_current_parser_position() const {
+    return -1;
+  }
+
+  std::string get_filename() const {
+    return d_filename;
+  }
+
+  void gc_collect(const expr::gc_relocator& gc_reloc) {
+    d_state.gc_collect(gc_reloc);
+  }
+};
+
+void btor_parser::add_line(const btor_line& line) {
+  const int64_t* args = line.args;
+  switch (line.kind) {
+  case BTOR_VAR:
+    d_state.add_variable(line.id, line.size, line.text.str());
+    break;
+  case BTOR_CONSTD:
+  case BTOR_CONST: {
+    expr::bitvector bv;
+    if (line.text.empty() || *line.text.begin == '-' || !parse_bitvector(line.text, line.kind == BTOR_CONST ? 2 : 10, line.size, bv)) {
+      throw parser_exception("Invalid constant: " + line.text.str());
+    }
+    d_state.add_constant(line.id, line.size, bv);
+    break;
+  }
+  case BTOR_BINARY:
+    d_state.add_term(line.id, line.op, line.size, d_state.get_term(args[0]), d_state.get_term(args[1]));
+    break;
+  case BTOR_SLICE:
+    d_state.add_slice(line.id, line.size, d_state.get_term(args[0]), args[1], args[2]);
+    break;
+  case BTOR_COND:
+    d_state.add_ite(line.id, line.size, d_state.get_term(args[0]), d_state.get_term(args[1]), d_state.get_term(args[2]));
+    break;
+  case BTOR_NEXT:
+    d_state.add_next_variable(line.id, line.size, args[0], d_state.get_term(args[1]));
+    break;
+  case BTOR_ROOT:
+    d_state.add_root(line.id, line.size, d_state.get_term(args[0]));
+    break;
+  }
 }
+
+cmd::command* btor_parser::parse_command() {
+
+  // Everything is one command
+  if (d_done) {
+    return 0;
+  }
+  d_done = true;
+
+  // First pass: split the lines into records (in parallel if asked), the
+  // records point into the input so it's kept until the end
+  utils::mapped_file input(d_filename);
+  std::vector<btor_line> lines;
+  parse_lines(input.begin(), input.end(), d_filename, btor_line_parser(), lines, d_workers);
+
+  // Second pass: make the terms in order
+  uint64_t max_id = 0;
+  for (size_t i = 0; i < lines.size(); ++ i) {
+    max_id = std::max(max_id, lines[i].id);
+  }
+  d_state.reserve(max_id);
+  for (size_t i = 0; i < lines.size(); ++ i) {
+    d_lineno = lines[i].lineno;
+    try {
+      add_line(lines[i]);
+    } catch (const parser_exception& e) {
+      if (e.has_line_info()) {
+        throw;
+      }
+      throw parser_exception(e.get_message(), d_filename, d_lineno);
+    } catch (const exception& e) {
+      throw parser_exception(e.get_message(), d_filename, d_lineno);
+    }
+  }
+
+  return d_state.finalize();
 }
 
+internal_parser_interface* new_btor_parser(const system::context& ctx, const char* filename) {
+  return new btor_parser(ctx, filename);
+}
 
+}
+}
@@ -19,7 +19,7 @@
 #pragma once
 
 #include "system/context.h"
-#include "parser/antlr_parser.h"
+#include "parser/parser.h"
 
 namespace sally {
 namespace parser {
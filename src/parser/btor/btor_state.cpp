@@ -31,7 +31,6 @@
 #include "command/sequence.h"
 
 #include <cassert>
-#include <sstream>
 
 using namespace sally;
 using namespace parser;
@@ -46,22 +45,10 @@ btor_state::btor_state(const system::context& context)
   d_zero = expr::term_ref_strong(tm(), tm().mk_bitvector_constant(bitvector(1, 0)));
 }
 
-string btor_state::token_text(pANTLR3_COMMON_TOKEN token) {
-  ANTLR3_MARKER start = token->getStartIndex(token);
-  size_t size = token->getStopIndex(token) - start + 1;
-  return string((const char*) start, size);
-}
-
-int btor_state::token_as_int(pANTLR3_COMMON_TOKEN token) {
-  int value;
-  std::stringstream ss;
-  ss << token_text(token);
-  ss >> value;
-  return value;
-}
-
-integer btor_state::token_as_integer(pANTLR3_COMMON_TOKEN token, size_t base) {
-  return integer(token_text(token), base);
+void btor_state::reserve(size_t max_index) {
+  if (max_index >= d_terms.size()) {
+    d_terms.resize(max_index + 1);
+  }
 }
 
 void btor_state::set_term(size_t index, term_ref term, size_t size) {
@@ -82,7 +69,7 @@ void btor_state::set_term(size_t index, term_ref term, size_t size) {
   d_terms[index] = term;
 }
 
-expr::term_ref btor_state::get_term(int index) const {
+expr::term_ref btor_state::get_term(int64_t index) const {
   size_t i = index >= 0 ? index : -index;
   if (i >= d_terms.size() || d_terms[i].is_null()) {
     throw exception("Index not declared yet");
@@ -100,8 +87,8 @@ expr::term_ref btor_state::get_term(int index) const {
 }
 
 expr::term_ref btor_state::get_next(size_t index) const {
-  var_to_var_map::const_iterator find = d_variables_next.find(index);
-  return get_term(find->second);
+  assert(is_register(index));
+  return get_term(d_variables_next[index]);
 }
 
 
@@ -113,8 +100,10 @@ void btor_state::add_variable(size_t id, size_t size, std::string name) {
 }
 
 void btor_state::add_next_variable(size_t id, size_t size, size_t var_id, term_ref value) {
-  var_to_var_map::const_iterator find = d_variables_next.find(var_id);
-  if (find != d_variables_next.end()) {
+  if (var_id >= d_variables_next.size()) {
+    d_variables_next.resize(std::max(var_id + 1, d_terms.size()), 0);
+  }
+  if (d_variables_next[var_id]) {
     throw exception("Next already defined for this variable.");
   }
   if (tm().get_bitvector_type_size(tm().type_of(value)) != size) {
@@ -194,7 +183,7 @@ void btor_state::add_root(size_t id, size_t size, term_ref term) {
 }
 
 bool btor_state::is_register(size_t index) const {
-  return d_variables_next.find(index) != d_variables_next.end();
+  return index < d_variables_next.size() && d_variables_next[index] != 0;
 }
 
 cmd::command* btor_state::finalize() const {
@@ -239,7 +228,7 @@ cmd::command* btor_state::finalize() const {
     }
   }
   term_ref init = tm().mk_and(init_children);
-  system::state_formula* init_formula = new system::state_formula(tm(), state_type, init);
+  system::state_formula* init_formula = new system::state_formula(tm(), state_type, rewrite_input(ctx(), init));
 
   // Define the transition relation
   std::vector<term_ref> transition_children;
@@ -254,7 +243,7 @@ cmd::command* btor_state::finalize() const {
   }
   term_ref transition = tm().mk_and(transition_children);
   transition = tm().substitute_and_cache(transition, btor_to_state_var);
-  system::transition_formula* transition_formula = new system::transition_formula(tm(), state_type, transition);
+  system::transition_formula* transition_formula = new system::transition_formula(tm(), state_type, rewrite_input(ctx(), transition));
 
   // Define the transition system
   system::transition_system* transition_system = new system::transition_system(state_type, init_formula, transition_formula);
@@ -269,7 +258,7 @@ cmd::command* btor_state::finalize() const {
     bad_children.push_back(bad);
   }
   term_ref property = tm().mk_and(bad_children);
-  system::state_formula* property_formula = new system::state_formula(tm(), state_type, property);
+  system::state_formula* property_formula = new system::state_formula(tm(), state_type, rewrite_input(ctx(), property));
   cmd::command* query = new cmd::query(ctx(), "T", property_formula);
 
   // Make the final command
@@ -18,10 +18,9 @@
 
 #pragma once
 
-#include <map>
 #include <vector>
 #include <iosfwd>
-#include <antlr3.h>
+#include <stdint.h>
 
 #include "system/context.h"
 #include "command/command.h"
@@ -41,10 +40,8 @@ class btor_state {
   // List of variables indices
   std::vector<size_t> d_variables;
 
-  typedef std::map<size_t, size_t> var_to_var_map;
-
-  // Map from variables to their next versions
-  var_to_var_map d_variables_next;
+  // Next nodes of the variables, by variable index (0 if none)
+  std::vector<size_t> d_variables_next;
 
   // List of root nodes
   std::vector<expr::term_ref_strong> d_roots;
@@ -75,20 +72,11 @@ public:
   /** Returns the context for the parser */
   const system::context& ctx() const { return d_context; }
 
-  /** Get the string of a token begin parsed */
-  static
-  std::string token_text(pANTLR3_COMMON_TOKEN token);
-
-  /** Get the int value of a token begin parsed */
-  static
-  int token_as_int(pANTLR3_COMMON_TOKEN token);
-
-  /** Get the integer value of a token begin parsed */
-  static
-  expr::integer token_as_integer(pANTLR3_COMMON_TOKEN token, size_t base);
+  /** Make room for the nodes up to the given index */
+  void reserve(size_t max_index);
 
   /** Get the term at index (negated if negative) */
-  expr::term_ref get_term(int index) const;
+  expr::term_ref get_term(int64_t index) const;
 
   /** Add a variable */
   void add_variable(size_t id, size_t size, std::string name);
@@ -23,57 +23,311 @@
 #include "command/query.h"
 #include "command/sequence.h"
 
+#include "utils/mapped_file.h"
+
 #include <cassert>
+#include <algorithm>
 
 #include "parser/btor2/btor2.h"
+#include "parser/line_reader.h"
+
+namespace sally {
+namespace parser {
 
-#ifdef WITH_BTOR2TOOLS
+/** The BTOR2 tags */
+enum btor2_tag {
+  BTOR2_TAG_add, BTOR2_TAG_and, BTOR2_TAG_bad, BTOR2_TAG_concat, BTOR2_TAG_const,
+  BTOR2_TAG_constd, BTOR2_TAG_consth, BTOR2_TAG_constraint, BTOR2_TAG_dec,
+  BTOR2_TAG_eq, BTOR2_TAG_fair, BTOR2_TAG_iff, BTOR2_TAG_implies, BTOR2_TAG_inc,
+  BTOR2_TAG_init, BTOR2_TAG_input, BTOR2_TAG_ite, BTOR2_TAG_justice,
+  BTOR2_TAG_mul, BTOR2_TAG_nand, BTOR2_TAG_neg, BTOR2_TAG_neq, BTOR2_TAG_next,
+  BTOR2_TAG_nor, BTOR2_TAG_not, BTOR2_TAG_one, BTOR2_TAG_ones, BTOR2_TAG_or,
+  BTOR2_TAG_output, BTOR2_TAG_read, BTOR2_TAG_redand, BTOR2_TAG_redor,
+  BTOR2_TAG_redxor, BTOR2_TAG_rol, BTOR2_TAG_ror, BTOR2_TAG_saddo,
+  BTOR2_TAG_sdiv, BTOR2_TAG_sdivo, BTOR2_TAG_sext, BTOR2_TAG_sgt,
+  BTOR2_TAG_sgte, BTOR2_TAG_slice, BTOR2_TAG_sll, BTOR2_TAG_slt,
+  BTOR2_TAG_slte, BTOR2_TAG_smod, BTOR2_TAG_smulo, BTOR2_TAG_sort,
+  BTOR2_TAG_sra, BTOR2_TAG_srem, BTOR2_TAG_srl, BTOR2_TAG_ssubo,
+  BTOR2_TAG_state, BTOR2_TAG_sub, BTOR2_TAG_uaddo, BTOR2_TAG_udiv,
+  BTOR2_TAG_uext, BTOR2_TAG_ugt, BTOR2_TAG_ugte, BTOR2_TAG_ult,
+  BTOR2_TAG_ulte, BTOR2_TAG_umulo, BTOR2_TAG_urem, BTOR2_TAG_usubo,
+  BTOR2_TAG_write, BTOR2_TAG_xnor, BTOR2_TAG_xor, BTOR2_TAG_zero
+};
 
-extern "C"
-{
-#include "btor2parser/btor2parser.h"
+/** The shape of the line after the tag */
+enum btor2_shape {
+  /** bitvec <width> | array <index sort> <element sort> */
+  BTOR2_SHAPE_sort,
+  /** <sort> */
+  BTOR2_SHAPE_nullary,
+  /** <sort> <constant> */
+  BTOR2_SHAPE_constant,
+  /** <sort> <arg> */
+  BTOR2_SHAPE_unary,
+  /** <sort> <arg> <arg> */
+  BTOR2_SHAPE_binary,
+  /** <sort> <arg> <arg> <arg> */
+  BTOR2_SHAPE_ternary,
+  /** <sort> <arg> <width> */
+  BTOR2_SHAPE_extend,
+  /** <sort> <arg> <upper> <lower> */
+  BTOR2_SHAPE_slice,
+  /** <arg> */
+  BTOR2_SHAPE_root,
+  /** <n> <arg>... */
+  BTOR2_SHAPE_justice
+};
+
+struct btor2_tag_info {
+  const char* name;
+  btor2_tag tag;
+  btor2_shape shape;
+  expr::term_op op;
+};
+
+/** All tags, sorted by name */
+static const btor2_tag_info btor2_tags[] = {
+  { "add", BTOR2_TAG_add, BTOR2_SHAPE_binary, expr::TERM_BV_ADD },
+  { "and", BTOR2_TAG_and, BTOR2_SHAPE_binary, expr::TERM_BV_AND },
+  { "bad", BTOR2_TAG_bad, BTOR2_SHAPE_root, expr::OP_LAST },
+  { "concat", BTOR2_TAG_concat, BTOR2_SHAPE_binary, expr::TERM_BV_CONCAT },
+  { "const", BTOR2_TAG_const, BTOR2_SHAPE_constant, expr::OP_LAST },
+  { "constd", BTOR2_TAG_constd, BTOR2_SHAPE_constant, expr::OP_LAST },
+  { "consth", BTOR2_TAG_consth, BTOR2_SHAPE_constant, expr::OP_LAST },
+  { "constraint", BTOR2_TAG_constraint, BTOR2_SHAPE_root, expr::OP_LAST },
+  { "dec", BTOR2_TAG_dec, BTOR2_SHAPE_unary, expr::OP_LAST },
+  { "eq", BTOR2_TAG_eq, BTOR2_SHAPE_binary, expr::TERM_EQ },
+  { "fair", BTOR2_TAG_fair, BTOR2_SHAPE_root, expr::OP_LAST },
+  { "iff", BTOR2_TAG_iff, BTOR2_SHAPE_binary, expr::TERM_EQ },
+  { "implies", BTOR2_TAG_implies, BTOR2_SHAPE_binary, expr::TERM_IMPLIES },
+  { "inc", BTOR2_TAG_inc, BTOR2_SHAPE_unary, expr::OP_LAST },
+  { "init", BTOR2_TAG_init, BTOR2_SHAPE_binary, expr::OP_LAST },
+  { "input", BTOR2_TAG_input, BTOR2_SHAPE_nullary, expr::OP_LAST },
+  { "ite", BTOR2_TAG_ite, BTOR2_SHAPE_ternary, expr::TERM_ITE },
+  { "justice", BTOR2_TAG_justice, BTOR2_SHAPE_justice, expr::OP_LAST },
+  { "mul", BTOR2_TAG_mul, BTOR2_SHAPE_binary, expr::TERM_BV_MUL },
+  { "nand", BTOR2_TAG_nand, BTOR2_SHAPE_binary, expr::TERM_BV_NAND },
+  { "neg", BTOR2_TAG_neg, BTOR2_SHAPE_unary, expr::TERM_BV_NEG },
+  { "neq", BTOR2_TAG_neq, BTOR2_SHAPE_binary, expr::OP_LAST },
+  { "next", BTOR2_TAG_next, BTOR2_SHAPE_binary, expr::OP_LAST },
+  { "nor", BTOR2_TAG_nor, BTOR2_SHAPE_binary, expr::TERM_BV_NOR },
+  { "not", BTOR2_TAG_not, BTOR2_SHAPE_unary, expr::TERM_BV_NOT },
+  { "one", BTOR2_TAG_one, BTOR2_SHAPE_nullary, expr::OP_LAST },
+  { "ones", BTOR2_TAG_ones, BTOR2_SHAPE_nullary, expr::OP_LAST },
+  { "or", BTOR2_TAG_or, BTOR2_SHAPE_binary, expr::TERM_BV_OR },
+  { "output", BTOR2_TAG_output, BTOR2_SHAPE_root, expr::OP_LAST },
+  { "read", BTOR2_TAG_read, BTOR2_SHAPE_binary, expr::TERM_ARRAY_READ },
+  { "redand", BTOR2_TAG_redand, BTOR2_SHAPE_unary, expr::OP_LAST },
+  { "redor", BTOR2_TAG_redor, BTOR2_SHAPE_unary, expr::OP_LAST },
+  { "redxor", BTOR2_TAG_redxor, BTOR2_SHAPE_unary, expr::OP_LAST },
+  { "rol", BTOR2_TAG_rol, BTOR2_SHAPE_binary, expr::OP_LAST },
+  { "ror", BTOR2_TAG_ror, BTOR2_SHAPE_binary, expr::OP_LAST },
+  { "saddo", BTOR2_TAG_saddo, BTOR2_SHAPE_binary, expr::OP_LAST },
+  { "sdiv", BTOR2_TAG_sdiv, BTOR2_SHAPE_binary, expr::TERM_BV_SDIV },
+  { "sdivo", BTOR2_TAG_sdivo, BTOR2_SHAPE_binary, expr::OP_LAST },
+  { "sext", BTOR2_TAG_sext, BTOR2_SHAPE_extend, expr::TERM_BV_SGN_EXTEND },
+  { "sgt", BTOR2_TAG_sgt, BTOR2_SHAPE_binary, expr::TERM_BV_SGT },
+  { "sgte", BTOR2_TAG_sgte, BTOR2_SHAPE_binary, expr::TERM_BV_SGEQ },
+  { "slice", BTOR2_TAG_slice, BTOR2_SHAPE_slice, expr::TERM_BV_EXTRACT },
+  { "sll", BTOR2_TAG_sll, BTOR2_SHAPE_binary, expr::TERM_BV_SHL },
+  { "slt", BTOR2_TAG_slt, BTOR2_SHAPE_binary, expr::TERM_BV_SLT },
+  { "slte", BTOR2_TAG_slte, BTOR2_SHAPE_binary, expr::TERM_BV_SLEQ },
+  { "smod", BTOR2_TAG_smod, BTOR2_SHAPE_binary, expr::TERM_BV_SMOD },
+  { "smulo", BTOR2_TAG_smulo, BTOR2_SHAPE_binary, expr::OP_LAST },
+  { "sort", BTOR2_TAG_sort, BTOR2_SHAPE_sort, expr::OP_LAST },
+  { "sra", BTOR2_TAG_sra, BTOR2_SHAPE_binary, expr::TERM_BV_ASHR },
+  { "srem", BTOR2_TAG_srem, BTOR2_SHAPE_binary, expr::TERM_BV_SREM },
+  { "srl", BTOR2_TAG_srl, BTOR2_SHAPE_binary, expr::TERM_BV_LSHR },
+  { "ssubo", BTOR2_TAG_ssubo, BTOR2_SHAPE_binary, expr::OP_LAST },
+  { "state", BTOR2_TAG_state, BTOR2_SHAPE_nullary, expr::OP_LAST },
+  { "sub", BTOR2_TAG_sub, BTOR2_SHAPE_binary, expr::TERM_BV_SUB },
+  { "uaddo", BTOR2_TAG_uaddo, BTOR2_SHAPE_binary, expr::OP_LAST },
+  { "udiv", BTOR2_TAG_udiv, BTOR2_SHAPE_binary, expr::TERM_BV_UDIV },
+  { "uext", BTOR2_TAG_uext, BTOR2_SHAPE_extend, expr::OP_LAST },
+  { "ugt", BTOR2_TAG_ugt, BTOR2_SHAPE_binary, expr::TERM_BV_UGT },
+  { "ugte", BTOR2_TAG_ugte, BTOR2_SHAPE_binary, expr::TERM_BV_UGEQ },
+  { "ult", BTOR2_TAG_ult, BTOR2_SHAPE_binary, expr::TERM_BV_ULT },
+  { "ulte", BTOR2_TAG_ulte, BTOR2_SHAPE_binary, expr::TERM_BV_ULEQ },
+  { "umulo", BTOR2_TAG_umulo, BTOR2_SHAPE_binary, expr::OP_LAST },
+  { "urem", BTOR2_TAG_urem, BTOR2_SHAPE_binary, expr::TERM_BV_UREM },
+  { "usubo", BTOR2_TAG_usubo, BTOR2_SHAPE_binary, expr::OP_LAST },
+  { "write", BTOR2_TAG_write, BTOR2_SHAPE_ternary, expr::TERM_ARRAY_WRITE },
+  { "xnor", BTOR2_TAG_xnor, BTOR2_SHAPE_binary, expr::TERM_BV_XNOR },
+  { "xor", BTOR2_TAG_xor, BTOR2_SHAPE_binary, expr::TERM_BV_XOR },
+  { "zero", BTOR2_TAG_zero, BTOR2_SHAPE_nullary, expr::OP_LAST },
+};
+
+static const size_t btor2_tags_size = sizeof(btor2_tags) / sizeof(btor2_tag_info);
+
+/** Find the tag info by name (binary search), 0 if not a tag */
+static const btor2_tag_info* find_btor2_tag(const line_token& name) {
+  size_t lo = 0, hi = btor2_tags_size;
+  size_t n = name.size();
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    const char* mid_name = btor2_tags[mid].name;
+    int cmp = strncmp(mid_name, name.begin, n);
+    if (cmp == 0 && mid_name[n] != 0) {
+      cmp = 1;
+    }
+    if (cmp == 0) {
+      return btor2_tags + mid;
+    } else if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return 0;
 }
 
-namespace sally {
-namespace parser {
+/**
+ * A parsed BTOR2 line. The constant and the symbol point into the input. For
+ * sorts, the arguments are the width, or the index and element sorts.
+ */
+struct btor2_line {
+  size_t lineno;
+  uint64_t id;
+  const btor2_tag_info* info;
+  uint64_t sort;
+  int64_t args[3];
+  line_token constant;
+  line_token symbol;
+  bool is_array;
+};
+
+/** Parses the lines into btor2_line records, no state so it can run in parallel */
+struct btor2_line_parser {
+
+  static void error(const char* msg, const line_token& token) {
+    throw parser_exception(std::string(msg) + ": '" + token.str() + "'");
+  }
+
+  static void expect(line_tokenizer& tokens, line_token& token, const char* what) {
+    if (!tokens.next(token)) {
+      throw parser_exception(std::string("Expected ") + what);
+    }
+  }
+
+  static uint64_t get_id(line_tokenizer& tokens, const char* what) {
+    line_token token;
+    expect(tokens, token, what);
+    uint64_t value;
+    if (!token.to_uint(value) || value == 0) {
+      error("Expected a positive id", token);
+    }
+    return value;
+  }
+
+  static int64_t get_arg(line_tokenizer& tokens) {
+    line_token token;
+    expect(tokens, token, "an argument");
+    int64_t value;
+    if (!token.to_int(value) || value == 0) {
+      error("Expected a non-zero id", token);
+    }
+    return value;
+  }
+
+  static int64_t get_number(line_tokenizer& tokens) {
+    line_token token;
+    expect(tokens, token, "a number");
+    uint64_t value;
+    if (!token.to_uint(value) || value > (uint64_t) INT64_MAX) {
+      error("Expected a number", token);
+    }
+    return value;
+  }
+
+  void operator () (const char* begin, const char* end, size_t lineno, std::vector<btor2_line>& out) const {
+
+    line_tokenizer tokens(begin, end);
+    line_token token;
+    if (!tokens.next(token)) {
+      // Empty line or comment
+      return;
+    }
+
+    btor2_line line;
+    line.lineno = lineno;
+    line.sort = 0;
+    line.args[0] = line.args[1] = line.args[2] = 0;
+    line.is_array = false;
+
+    if (!token.to_uint(line.id) || line.id == 0) {
+      error("Expected a positive id", token);
+    }
+    expect(tokens, token, "a tag");
+    line.info = find_btor2_tag(token);
+    if (line.info == 0) {
+      error("Unknown btor2 tag", token);
+    }
+
+    switch (line.info->shape) {
+    case BTOR2_SHAPE_sort:
+      expect(tokens, token, "a sort");
+      if (token == "bitvec") {
+        line.args[0] = get_number(tokens);
+        if (line.args[0] == 0) {
+          throw parser_exception("Bitvector width must be positive");
+        }
+      } else if (token == "array") {
+        line.is_array = true;
+        line.args[0] = get_id(tokens, "a sort");
+        line.args[1] = get_id(tokens, "a sort");
+      } else {
+        error("Unknown sort", token);
+      }
+      break;
+    case BTOR2_SHAPE_nullary:
+      line.sort = get_id(tokens, "a sort");
+      break;
+    case BTOR2_SHAPE_constant:
+      line.sort = get_id(tokens, "a sort");
+      expect(tokens, line.constant, "a constant");
+      break;
+    case BTOR2_SHAPE_unary:
+      line.sort = get_id(tokens, "a sort");
+      line.args[0] = get_arg(tokens);
+      break;
+    case BTOR2_SHAPE_binary:
+      line.sort = get_id(tokens, "a sort");
+      line.args[0] = get_arg(tokens);
+      line.args[1] = get_arg(tokens);
+      break;
+    case BTOR2_SHAPE_ternary:
+      line.sort = get_id(tokens, "a sort");
+      line.args[0] = get_arg(tokens);
+      line.args[1] = get_arg(tokens);
+      line.args[2] = get_arg(tokens);
+      break;
+    case BTOR2_SHAPE_extend:
+      line.sort = get_id(tokens, "a sort");
+      line.args[0] = get_arg(tokens);
+      line.args[1] = get_number(tokens);
+      break;
+    case BTOR2_SHAPE_slice:
+      line.sort = get_id(tokens, "a sort");
+      line.args[0] = get_arg(tokens);
+      line.args[1] = get_number(tokens);
+      line.args[2] = get_number(tokens);
+      break;
+    case BTOR2_SHAPE_root:
+      line.args[0] = get_arg(tokens);
+      break;
+    case BTOR2_SHAPE_justice:
+      // Not supported, the rest is not checked
+      out.push_back(line);
+      return;
+    }
 
-std::unordered_map<Btor2Tag, expr::term_op> btor2_tag_to_term_op = {
-  {BTOR2_TAG_add, expr::TERM_BV_ADD},
-  {BTOR2_TAG_and, expr::TERM_BV_AND},
-  {BTOR2_TAG_concat, expr::TERM_BV_CONCAT},
-  {BTOR2_TAG_eq, expr::TERM_EQ},
-  {BTOR2_TAG_iff, expr::TERM_EQ},
-  {BTOR2_TAG_implies, expr::TERM_IMPLIES},
-  {BTOR2_TAG_ite, expr::TERM_ITE},
-  {BTOR2_TAG_mul, expr::TERM_BV_MUL},
-  {BTOR2_TAG_nand, expr::TERM_BV_NAND},
-  {BTOR2_TAG_neg, expr::TERM_BV_NEG},
-  {BTOR2_TAG_nor, expr::TERM_BV_NOR},
-  {BTOR2_TAG_not, expr::TERM_BV_NOT},
-  {BTOR2_TAG_or, expr::TERM_BV_OR},
-  {BTOR2_TAG_read, expr::TERM_ARRAY_READ},
-  {BTOR2_TAG_sdiv, expr::TERM_BV_SDIV},
-  {BTOR2_TAG_sext, expr::TERM_BV_SGN_EXTEND},
-  {BTOR2_TAG_sgt, expr::TERM_BV_SGT},
-  {BTOR2_TAG_sgte, expr::TERM_BV_SGEQ},
-  {BTOR2_TAG_slice, expr::TERM_BV_EXTRACT},
-  {BTOR2_TAG_sll, expr::TERM_BV_SHL},
-  {BTOR2_TAG_slt, expr::TERM_BV_SLT},
-  {BTOR2_TAG_slte, expr::TERM_BV_SLEQ},
-  {BTOR2_TAG_smod, expr::TERM_BV_SMOD},
-  {BTOR2_TAG_sra, expr::TERM_BV_ASHR},
-  {BTOR2_TAG_srem, expr::TERM_BV_SREM},
-  {BTOR2_TAG_srl, expr::TERM_BV_LSHR},
-  {BTOR2_TAG_sub, expr::TERM_BV_SUB},
-  {BTOR2_TAG_udiv, expr::TERM_BV_UDIV},
-  {BTOR2_TAG_ugt, expr::TERM_BV_UGT},
-  {BTOR2_TAG_ugte, expr::TERM_BV_UGEQ},
-  {BTOR2_TAG_ult, expr::TERM_BV_ULT},
-  {BTOR2_TAG_ulte, expr::TERM_BV_ULEQ},
-  {BTOR2_TAG_urem, expr::TERM_BV_UREM},
-  {BTOR2_TAG_write, expr::TERM_ARRAY_WRITE},
-  {BTOR2_TAG_xnor, expr::TERM_BV_XNOR},
-  {BTOR2_TAG_xor, expr::TERM_BV_XOR},
+    // Optional symbol
+    if (tokens.next(line.symbol) && tokens.next(token)) {
+      error("Unexpected token", token);
+    }
+
+    out.push_back(line);
+  }
 };
 
 class btor2_parser : public internal_parser_interface {
@@ -101,13 +355,9 @@ class btor2_parser : public internal_parser_interface {
   // so we can just use the state variables for both.
   std::vector<size_t> state_vars;
 
-  typedef std::map<size_t, size_t> var_to_var_map;
-
-  // Map from variables to their init versions
-  var_to_var_map init;
-
-  // Map from variables to their next versions
-  var_to_var_map next;
+  // Init and next nodes of the variables, by variable index (0 if none)
+  std::vector<size_t> init;
+  std::vector<size_t> next;
 
   // List of root nodes
   std::vector<expr::term_ref_strong> bad;
@@ -125,23 +375,26 @@ class btor2_parser : public internal_parser_interface {
   /** Add a bitvector type */
   void add_bv_type(size_t id, size_t size);
 
-  /** Add an array type */
-  void add_array_type(size_t id, size_t index, size_t element);
-
   /** Get the sort at index */
   expr::term_ref get_type(size_t index) const;
 
-  /** Get the term at index (negated if negative) */
-  expr::term_ref get_term(int index) const;
+  /** Get the node at index, which must be defined */
+  expr::term_ref get_node(size_t index) const;
 
   /** Get the term at index (negated if negative), casting to bitvector if necessary */
-  expr::term_ref get_term_bitvector(int index) const;
+  expr::term_ref get_term_bitvector(int64_t index) const;
 
   /** Get the term at index (negated if negative), casting to boolean if necessary */
-  expr::term_ref get_term_boolean(int index) const;
+  expr::term_ref get_term_boolean(int64_t index) const;
+
+  /** Get the width of the term at index */
+  size_t get_term_width(int64_t index) const;
 
-  /** Get the term at index (negated if negative) with a specific width */
-  size_t get_term_width(int index) const;
+  /** Get the width of the bitvector sort at index */
+  size_t get_sort_width(size_t index) const;
+
+  /** Make a bitvector constant of the given width from the text in base */
+  expr::term_ref mk_constant(const line_token& text, size_t base, size_t width) const;
 
   /** Add a state variable */
   void add_state_var(size_t id, size_t type_id, std::string name);
@@ -161,6 +414,9 @@ class btor2_parser : public internal_parser_interface {
   /** Add a ternary term */
   void add_ternary_term(size_t id, expr::term_op op, size_t type_id, expr::term_ref t1, expr::term_ref t2, expr::term_ref t3);
 
+  /** Make the term of the line */
+  void add_line(const btor2_line& line);
+
   /** Build the transition system from the parsed terms */
   void build_transition_system();
 
@@ -191,33 +447,24 @@ void btor2_parser::add_bv_type(size_t id, size_t size) {
   nodes[id] = tm.bitvector_type(size);
 }
 
-void btor2_parser::add_array_type(size_t id, size_t index, size_t element) {
-  // Ensure size
-  if (id >= nodes.size()) {
-    nodes.resize((id * 2) + 1);
-  }
-  // Remember
-  nodes[id] = tm.array_type(get_type(index), get_type(element));
-}
-
 expr::term_ref btor2_parser::get_type(size_t index) const {
-  return nodes[index];
+  expr::term_ref type = get_node(index);
+  if (!tm.is_type(type)) {
+    throw parser_exception("Not a sort: " + std::to_string(index));
+  }
+  return type;
 }
 
-expr::term_ref btor2_parser::get_term(int index) const {
-  size_t i = index >= 0 ? index : -index;
-  expr::term_ref result = nodes[i];
-  // If the id is negative, negate the term
-  if (index >= 0) {
-    return result;
-  } else {
-    return tm.mk_term(expr::TERM_BV_NOT, result);
+expr::term_ref btor2_parser::get_node(size_t index) const {
+  if (index >= nodes.size() || nodes[index].is_null()) {
+    throw parser_exception("Index not declared yet: " + std::to_string(index));
   }
+  return nodes[index];
 }
 
-expr::term_ref btor2_parser::get_term_bitvector(int index) const {
+expr::term_ref btor2_parser::get_term_bitvector(int64_t index) const {
   size_t i = index >= 0 ? index : -index;
-  expr::term_ref result = nodes[i];
+  expr::term_ref result = get_node(i);
 
   // If the term is a boolean, convert it to a bitvector
   expr::term_ref type = tm.type_of(result);
@@ -233,9 +480,9 @@ expr::term_ref btor2_parser::get_term_bitvector(int index) const {
   }
 }
 
-expr::term_ref btor2_parser::get_term_boolean(int index) const {
+expr::term_ref btor2_parser::get_term_boolean(int64_t index) const {
   size_t i = index >= 0 ? index : -index;
-  expr::term_ref result = nodes[i];
+  expr::term_ref result = get_node(i);
 
   // If the term is a bit-vector, convert it to a boolean
   expr::term_ref type = tm.type_of(result);
@@ -251,7 +498,7 @@ expr::term_ref btor2_parser::get_term_boolean(int index) const {
   }
 }
 
-size_t btor2_parser::get_term_width(int index) const {
+size_t btor2_parser::get_term_width(int64_t index) const {
   expr::term_ref term = get_term_bitvector(index);
   if (tm.is_bitvector_type(tm.type_of(term))) {
     return tm.get_bitvector_size(term);
@@ -260,6 +507,22 @@ size_t btor2_parser::get_term_width(int index) const {
   }
 }
 
+size_t btor2_parser::get_sort_width(size_t index) const {
+  expr::term_ref type = get_type(index);
+  if (!tm.is_bitvector_type(type)) {
+    throw parser_exception("Sort is not a bitvector: " + std::to_string(index));
+  }
+  return tm.get_bitvector_type_size(type);
+}
+
+expr::term_ref btor2_parser::mk_constant(const line_token& text, size_t base, size_t width) const {
+  expr::bitvector bv;
+  if (!parse_bitvector(text, base, width, bv)) {
+    throw parser_exception("Invalid constant: " + text.str());
+  }
+  return tm.mk_bitvector_constant(bv);
+}
+
 void btor2_parser::add_state_var(size_t id, size_t type_id, std::string name) {
   expr::term_ref type = get_type(type_id);
   expr::term_ref term = tm.mk_variable(name, type);
@@ -268,8 +531,10 @@ void btor2_parser::add_state_var(size_t id, size_t type_id, std::string name) {
 }
 
 void btor2_parser::set_init(size_t id, size_t type_id, size_t var_id, expr::term_ref value) {
-  var_to_var_map::const_iterator find = init.find(var_id);
-  if (find != init.end()) {
+  if (var_id >= init.size()) {
+    init.resize(std::max(var_id + 1, nodes.size()), 0);
+  }
+  if (init[var_id]) {
     throw parser_exception("Init already defined for this variable.", filename, lineno);
   }
   expr::term_ref type = get_type(type_id);
@@ -278,6 +543,9 @@ void btor2_parser::set_init(size_t id, size_t type_id, size_t var_id, expr::term
 }
 
 void btor2_parser::set_next(size_t id, size_t type_id, size_t var_id, expr::term_ref value) {
+  if (var_id >= next.size()) {
+    next.resize(std::max(var_id + 1, nodes.size()), 0);
+  }
   expr::term_ref type = get_type(type_id);
   next[var_id] = id;
   set_term(id, value, type);
@@ -338,29 +606,29 @@ void btor2_parser::build_transition_system() {
   std::vector<expr::term_ref> init_children;
   for (size_t i = 0; i < state_vars.size(); ++ i) {
     expr::term_ref state_var = sally_current_vars[i];
-    var_to_var_map::const_iterator find = init.find(state_vars[i]);
-    if (find == init.end()) { continue; } 
-    expr::term_ref init_value = get_term_bitvector(find->second);
+    size_t var_id = state_vars[i];
+    if (var_id >= init.size() || !init[var_id]) { continue; }
+    expr::term_ref init_value = get_term_bitvector(init[var_id]);
     expr::term_ref eq = tm.mk_term(expr::TERM_EQ, state_var, init_value);
     init_children.push_back(eq);
   }
   expr::term_ref init = tm.mk_and(init_children);
   init = tm.substitute_and_cache(init, btor_to_state_var);
-  system::state_formula* init_formula = new system::state_formula(tm, state_type, init);
+  system::state_formula* init_formula = new system::state_formula(tm, state_type, rewrite_input(ctx, init));
 
   // Define the transition relation
   std::vector<expr::term_ref> transition_children;
   for (size_t i = 0; i < state_vars.size(); ++ i) {
     expr::term_ref next_var = sally_next_vars[i];
-    var_to_var_map::const_iterator find = next.find(state_vars[i]);
-    if (find == next.end()) { continue; } 
-    expr::term_ref next_value = get_term_bitvector(find->second);
+    size_t var_id = state_vars[i];
+    if (var_id >= next.size() || !next[var_id]) { continue; }
+    expr::term_ref next_value = get_term_bitvector(next[var_id]);
     expr::term_ref eq = tm.mk_term(expr::TERM_EQ, next_var, next_value);
     transition_children.push_back(eq);
   }
   expr::term_ref transition = tm.mk_and(transition_children);
   transition = tm.substitute_and_cache(transition, btor_to_state_var);
-  system::transition_formula* transition_formula = new system::transition_formula(tm, state_type, transition);
+  system::transition_formula* transition_formula = new system::transition_formula(tm, state_type, rewrite_input(ctx, transition));
 
   // Define the transition system
   system::transition_system* transition_system = new system::transition_system(state_type, init_formula, transition_formula);
@@ -377,7 +645,7 @@ void btor2_parser::build_transition_system() {
   }
   expr::term_ref invariant = tm.mk_and(constraint_children);
   invariant = tm.substitute_and_cache(invariant, btor_to_state_var);
-  system::state_formula* invariant_formula = new system::state_formula(tm, state_type, invariant);
+  system::state_formula* invariant_formula = new system::state_formula(tm, state_type, rewrite_input(ctx, invariant));
   transition_system->add_invariant(invariant_formula);
 
   // Query
@@ -391,7 +659,7 @@ void btor2_parser::build_transition_system() {
   }
   expr::term_ref property = tm.mk_or(bad_children);
   property = tm.mk_term(expr::TERM_NOT, property);
-  system::state_formula* property_formula = new system::state_formula(tm, state_type, property);
+  system::state_formula* property_formula = new system::state_formula(tm, state_type, rewrite_input(ctx, property));
   cmd::command* query = new cmd::query(ctx, "Sys", property_formula);
 
   // Make the final command
@@ -403,6 +671,226 @@ void btor2_parser::build_transition_system() {
   command = full_command;
 }
 
+
+void btor2_parser::add_line(const btor2_line& line) {
+  size_t id = line.id;
+  size_t sort = line.sort;
+  const int64_t* args = line.args;
+  switch (line.info->tag)
+  {
+  case BTOR2_TAG_bad: {
+    expr::term_ref term = get_term_bitvector(args[0]);
+    expr::term_ref type = tm.type_of(term);
+    bad.push_back(expr::term_ref_strong(tm, term));
+    set_term(id, term, type);
+    break;
+  }
+  case BTOR2_TAG_constraint: {
+    expr::term_ref term = get_term_bitvector(args[0]);
+    expr::term_ref type = tm.type_of(term);
+    constraints.push_back(expr::term_ref_strong(tm, term));
+    set_term(id, term, type);
+    break;
+  }
+  case BTOR2_TAG_input:
+    add_state_var(id, sort, line.symbol.empty() ? "input_" + std::to_string(id) : line.symbol.str());
+    break;
+  case BTOR2_TAG_state:
+    add_state_var(id, sort, line.symbol.empty() ? "state_" + std::to_string(id) : line.symbol.str());
+    break;
+  case BTOR2_TAG_init:
+  case BTOR2_TAG_next: {
+    if (args[0] < 0 || tm.term_of(get_node(args[0])).op() != expr::VARIABLE) {
+      throw parser_exception("Expected a state variable: " + std::to_string(args[0]));
+    }
+    expr::term_ref value = get_term_bitvector(args[1]);
+    if (line.info->tag == BTOR2_TAG_init) {
+      set_init(id, sort, args[0], value);
+    } else {
+      set_next(id, sort, args[0], value);
+    }
+    break;
+  }
+  case BTOR2_TAG_output:
+    break;
+  case BTOR2_TAG_sort:
+    if (!line.is_array) {
+      add_bv_type(id, args[0]);
+    } else {
+      throw parser_exception("Sally does not support const arrays: " + std::string(line.info->name), filename, lineno);
+    }
+    break;
+  case BTOR2_TAG_one:{
+    size_t width = get_sort_width(sort);
+    expr::term_ref term = tm.mk_bitvector_constant(expr::bitvector(width, 1));
+    set_term(id, term, get_type(sort));
+    break;
+  }
+  case BTOR2_TAG_ones: {
+    size_t width = get_sort_width(sort);
+    expr::term_ref term = tm.mk_bitvector_constant(expr::bitvector::one(width));
+    set_term(id, term, get_type(sort));
+    break;
+  }
+  case BTOR2_TAG_zero: {
+    size_t width = get_sort_width(sort);
+    expr::term_ref term = tm.mk_bitvector_constant(expr::bitvector(width, 0));
+    set_term(id, term, get_type(sort));
+    break;
+  }
+  case BTOR2_TAG_const:
+    set_term(id, mk_constant(line.constant, 2, get_sort_width(sort)), get_type(sort));
+    break;
+  case BTOR2_TAG_constd:
+    set_term(id, mk_constant(line.constant, 10, get_sort_width(sort)), get_type(sort));
+    break;
+  case BTOR2_TAG_consth:
+    set_term(id, mk_constant(line.constant, 16, get_sort_width(sort)), get_type(sort));
+    break;
+  case BTOR2_TAG_neq: {
+    expr::term_ref eq = tm.mk_term(expr::TERM_EQ, get_term_bitvector(args[0]), get_term_bitvector(args[1]));
+    add_unary_term(id, expr::TERM_NOT, sort, eq);
+    break;
+  }
+  case BTOR2_TAG_iff:
+  case BTOR2_TAG_implies: {
+    add_binary_term(id, line.info->op, sort,
+                    get_term_boolean(args[0]), get_term_boolean(args[1]));
+    break;
+  }
+  case BTOR2_TAG_eq:
+  case BTOR2_TAG_sgt:
+  case BTOR2_TAG_sgte:
+  case BTOR2_TAG_slt:
+  case BTOR2_TAG_slte:
+  case BTOR2_TAG_ugt:
+  case BTOR2_TAG_ugte:
+  case BTOR2_TAG_ult:
+  case BTOR2_TAG_ulte:
+  case BTOR2_TAG_and:
+  case BTOR2_TAG_add:
+  case BTOR2_TAG_concat:
+  case BTOR2_TAG_mul:
+  case BTOR2_TAG_nand:
+  case BTOR2_TAG_nor:
+  case BTOR2_TAG_or:
+  case BTOR2_TAG_read:
+  case BTOR2_TAG_sdiv:
+  case BTOR2_TAG_sll:
+  case BTOR2_TAG_smod:
+  case BTOR2_TAG_sra:
+  case BTOR2_TAG_srem:
+  case BTOR2_TAG_srl:
+  case BTOR2_TAG_sub:
+  case BTOR2_TAG_udiv:
+  case BTOR2_TAG_urem:
+  case BTOR2_TAG_xnor:
+  case BTOR2_TAG_xor:
+    add_binary_term(id, line.info->op, sort,
+                    get_term_bitvector(args[0]), get_term_bitvector(args[1]));
+    break;
+  case BTOR2_TAG_sext: {
+    expr::term_ref type = get_type(sort);
+    expr::term_ref term;
+    size_t amt = args[1];
+    if (amt == 0) {
+      term = get_term_bitvector(args[0]);
+    } else {
+      expr::bitvector_sgn_extend ext(amt);
+      term = tm.mk_bitvector_sgn_extend(get_term_bitvector(args[0]), ext);
+    }
+    set_term(id, term, type);
+    break;
+  }
+  case BTOR2_TAG_uext: {
+    expr::term_ref type = get_type(sort);
+    expr::term_ref term;
+    size_t amt = args[1];
+    if (amt == 0) {
+      term = get_term_bitvector(args[0]);
+    } else {
+      expr::term_ref zero_term = tm.mk_bitvector_constant(expr::bitvector(amt, 0));
+      term = tm.mk_term(expr::TERM_BV_CONCAT, zero_term, get_term_bitvector(args[0]));
+    }
+    set_term(id, term, type);
+    break;
+  }
+  case BTOR2_TAG_rol:
+  case BTOR2_TAG_ror:
+  case BTOR2_TAG_saddo:
+  case BTOR2_TAG_smulo:
+  case BTOR2_TAG_ssubo:
+  case BTOR2_TAG_sdivo:
+  case BTOR2_TAG_uaddo:
+  case BTOR2_TAG_umulo:
+  case BTOR2_TAG_usubo:
+  case BTOR2_TAG_fair:
+  case BTOR2_TAG_justice:
+    throw parser_exception("Unsupported btor2 tag: " + std::string(line.info->name), filename, lineno);
+  case BTOR2_TAG_inc: {
+    size_t width = get_term_width(args[0]);
+    expr::term_ref one_term = tm.mk_bitvector_constant(expr::bitvector(width, 1));
+    add_binary_term(id, expr::TERM_BV_ADD, sort,
+                    get_term_bitvector(args[0]), one_term);
+    break;
+  }
+  case BTOR2_TAG_dec: {
+    size_t width = get_term_width(args[0]);
+    expr::term_ref one_term = tm.mk_bitvector_constant(expr::bitvector(width, 1));
+    add_binary_term(id, expr::TERM_BV_SUB, sort,
+                    get_term_bitvector(args[0]), one_term);
+    break;
+  }
+  case BTOR2_TAG_redand: {
+    size_t arg_width = get_term_width(args[0]);
+    expr::term_ref ones_term = tm.mk_bitvector_constant(expr::bitvector::one(arg_width));
+    add_binary_term(id, expr::TERM_EQ, sort, get_term_bitvector(args[0]), ones_term);
+    break;
+  }
+  case BTOR2_TAG_redor: {
+    size_t arg_width = get_term_width(args[0]);
+    expr::term_ref zeros_term = tm.mk_bitvector_constant(expr::bitvector(arg_width, 0));
+    expr::term_ref eq = tm.mk_term(expr::TERM_EQ, get_term_bitvector(args[0]), zeros_term);
+    add_unary_term(id, expr::TERM_NOT, sort, eq);
+    break;
+  }
+  case BTOR2_TAG_redxor: {
+    // Xor of all the bits of the argument
+    size_t arg_width = get_term_width(args[0]);
+    expr::term_ref arg = get_term_bitvector(args[0]);
+    expr::term_ref term = tm.mk_bitvector_extract(arg, expr::bitvector_extract(arg_width - 1, arg_width - 1));
+    for (size_t i = 0; i + 1 < arg_width; ++ i) {
+      expr::term_ref next_term = tm.mk_bitvector_extract(arg, expr::bitvector_extract(i, i));
+      term = tm.mk_term(expr::TERM_BV_XOR, term, next_term);
+    }
+    set_term(id, term, get_type(sort));
+    break;
+  }
+  case BTOR2_TAG_neg:
+  case BTOR2_TAG_not:
+    add_unary_term(id, line.info->op, sort, get_term_bitvector(args[0]));
+    break;
+  case BTOR2_TAG_slice: {
+    expr::term_ref type = get_type(sort);
+    expr::term_ref term = tm.mk_bitvector_extract(get_term_bitvector(args[0]), expr::bitvector_extract(args[1], args[2]));
+    set_term(id, term, type);
+    break;
+  }
+  case BTOR2_TAG_ite: {
+    // cast first arg to bools and then add_ternary_term
+    expr::term_ref t1 = get_term_bitvector(args[0]);
+    expr::term_ref t1_bool = tm.mk_term(expr::TERM_EQ, t1, one);
+    add_ternary_term(id, line.info->op, sort,
+                    t1_bool, get_term_bitvector(args[1]), get_term_bitvector(args[2]));
+    break;
+  }
+  case BTOR2_TAG_write:
+    add_ternary_term(id, line.info->op, sort,
+                    get_term_bitvector(args[0]), get_term_bitvector(args[1]), get_term_bitvector(args[2]));
+    break;
+  }
+}
+
 btor2_parser::btor2_parser(const system::context& ctx, const char* filename)
 : tm(ctx.tm())
 , ctx(ctx)
@@ -413,261 +901,37 @@ btor2_parser::btor2_parser(const system::context& ctx, const char* filename)
   one = expr::term_ref_strong(tm, tm.mk_bitvector_constant(expr::bitvector(1, 1)));
   zero = expr::term_ref_strong(tm, tm.mk_bitvector_constant(expr::bitvector(1, 0)));
 
-  Btor2Parser* parser;
-  Btor2LineIterator it;
-  Btor2Line* line;
-
-  FILE *input_file = fopen(filename, "r");
-  if (!input_file) {
-    throw parser_exception("Error opening file: " + std::string(filename), filename, lineno);
-  }
-
-  parser = btor2parser_new();
-  if (!parser) {
-    throw parser_exception("Error creating btor2 parser", filename, lineno);
+  // First pass: split the lines into records (in parallel if asked)
+  size_t workers = 1;
+  if (ctx.get_options().has_option("parse-threads")) {
+    workers = ctx.get_options().get_unsigned("parse-threads");
   }
-  if (!btor2parser_read_lines(parser, input_file)) {
-    const char *err = btor2parser_error(parser);
-    throw parser_exception("Error reading btor2 file: " + std::string(err), filename, lineno);
+  utils::mapped_file input(filename);
+  std::vector<btor2_line> lines;
+  parse_lines(input.begin(), input.end(), this->filename, btor2_line_parser(), lines, workers);
+
+  // All the nodes are known now
+  size_t max_id = 0;
+  for (size_t i = 0; i < lines.size(); ++ i) {
+    max_id = std::max<size_t>(max_id, lines[i].id);
   }
-
-  std::string symbol;
-  it = btor2parser_iter_init(parser);
-  while ((line = btor2parser_iter_next(&it))) {
-    lineno = line->lineno;
-    switch (line->tag)
-    {
-    case BTOR2_TAG_bad: {
-      expr::term_ref term = get_term_bitvector(line->args[0]);
-      expr::term_ref type = tm.type_of(term);
-      bad.push_back(expr::term_ref_strong(tm, term));
-      set_term(line->id, term, type);
-      break;
-    }
-    case BTOR2_TAG_constraint: {
-      expr::term_ref term = get_term_bitvector(line->args[0]);
-      expr::term_ref type = tm.type_of(term);
-      constraints.push_back(expr::term_ref_strong(tm, term));
-      set_term(line->id, term, type);
-      break;
-    }
-    case BTOR2_TAG_input:
-      if (line->symbol == NULL) {
-        symbol = "input_" + std::to_string(line->id);
-      } else {
-        symbol = line->symbol;
-      }
-      add_state_var(line->id, line->sort.id, symbol);
-      break;
-    case BTOR2_TAG_state:
-      if (line->symbol == NULL) {
-        symbol = "state_" + std::to_string(line->id);
-      } else {
-        symbol = line->symbol;
-      }
-      add_state_var(line->id, line->sort.id, symbol);
-      break;
-    case BTOR2_TAG_init:
-      set_init(line->id, line->sort.id, line->args[0], get_term_bitvector(line->args[1]));
-      break;
-    case BTOR2_TAG_next:
-      set_next(line->id, line->sort.id, line->args[0], get_term_bitvector(line->args[1]));
-      break;
-    case BTOR2_TAG_output:
-      break;
-    case BTOR2_TAG_sort:
-      if (line->sort.tag == BTOR2_TAG_SORT_bitvec) {
-        add_bv_type(line->id, line->sort.bitvec.width);
-      } else {
-        throw parser_exception("Sally does not support const arrays: " + std::string(line->name), filename, lineno);
-      }
-      break;
-    case BTOR2_TAG_one:{
-      expr::term_ref type = get_type(line->sort.id);
-      size_t width = tm.get_bitvector_type_size(type);
-      expr::term_ref term = tm.mk_bitvector_constant(expr::bitvector(width, 1));
-      set_term(line->id, term, type);
-      break;
-    }
-    case BTOR2_TAG_ones: {
-      expr::term_ref type = get_type(line->sort.id);
-      size_t width = tm.get_bitvector_type_size(type);
-      expr::term_ref term = tm.mk_bitvector_constant(expr::bitvector::one(width));
-      set_term(line->id, term, type);
-      break;
-    }
-    case BTOR2_TAG_zero: {
-      expr::term_ref type = get_type(line->sort.id);
-      size_t width = tm.get_bitvector_type_size(type);
-      expr::term_ref term = tm.mk_bitvector_constant(expr::bitvector(width, 0));
-      set_term(line->id, term, type);
-      break;
-    }
-    case BTOR2_TAG_const: {
-      expr::term_ref type = get_type(line->sort.id);
-      expr::term_ref term = tm.mk_bitvector_constant(expr::bitvector(line->constant, 2, line->sort.bitvec.width));
-      set_term(line->id, term, type);
-      break;
-    }
-    case BTOR2_TAG_constd: {
-      expr::term_ref type = get_type(line->sort.id);
-      expr::term_ref term = tm.mk_bitvector_constant(expr::bitvector(line->constant, 10, line->sort.bitvec.width));
-      set_term(line->id, term, type);
-      break;
-    }
-    case BTOR2_TAG_consth: {
-      expr::term_ref type = get_type(line->sort.id);
-      expr::term_ref term = tm.mk_bitvector_constant(expr::bitvector(line->constant, 16, line->sort.bitvec.width));
-      set_term(line->id, term, type);
-      break;
-    }
-    case BTOR2_TAG_neq: {
-      expr::term_ref eq = tm.mk_term(expr::TERM_EQ, get_term_bitvector(line->args[0]), get_term_bitvector(line->args[1]));
-      add_unary_term(line->id, expr::TERM_NOT, line->sort.id, eq);
-      break;
-    }
-    case BTOR2_TAG_iff:
-    case BTOR2_TAG_implies: {
-      add_binary_term(line->id, btor2_tag_to_term_op[line->tag], line->sort.id, 
-                      get_term_boolean(line->args[0]), get_term_boolean(line->args[1]));
-      break;
-    }
-    case BTOR2_TAG_eq:      
-    case BTOR2_TAG_sgt:
-    case BTOR2_TAG_sgte:
-    case BTOR2_TAG_slt:
-    case BTOR2_TAG_slte:
-    case BTOR2_TAG_ugt:
-    case BTOR2_TAG_ugte:
-    case BTOR2_TAG_ult:
-    case BTOR2_TAG_ulte:
-    case BTOR2_TAG_and:
-    case BTOR2_TAG_add:
-    case BTOR2_TAG_concat:
-    case BTOR2_TAG_mul:
-    case BTOR2_TAG_nand:
-    case BTOR2_TAG_nor:
-    case BTOR2_TAG_or:
-    case BTOR2_TAG_read:
-    case BTOR2_TAG_sdiv:
-    case BTOR2_TAG_sll:
-    case BTOR2_TAG_smod:
-    case BTOR2_TAG_sra:
-    case BTOR2_TAG_srem:
-    case BTOR2_TAG_srl:
-    case BTOR2_TAG_sub:
-    case BTOR2_TAG_udiv:
-    case BTOR2_TAG_urem:
-    case BTOR2_TAG_xnor:
-    case BTOR2_TAG_xor:
-      add_binary_term(line->id, btor2_tag_to_term_op[line->tag], line->sort.id, 
-                      get_term_bitvector(line->args[0]), get_term_bitvector(line->args[1]));
-      break;
-    case BTOR2_TAG_sext: {
-      expr::term_ref type = get_type(line->sort.id);
-      expr::term_ref term;
-      size_t amt = line->args[1];
-      if (amt == 0) {
-        term = get_term_bitvector(line->args[0]);
-      } else {
-        expr::bitvector_sgn_extend ext(amt);
-        term = tm.mk_bitvector_sgn_extend(get_term_bitvector(line->args[0]), ext);
+  nodes.resize(max_id + 1);
+
+  // Second pass: make the terms (ids are defined before use, so in order)
+  for (size_t i = 0; i < lines.size(); ++ i) {
+    const btor2_line& line = lines[i];
+    lineno = line.lineno;
+    try {
+      add_line(line);
+    } catch (const parser_exception& e) {
+      if (e.has_line_info()) {
+        throw;
       }
-      set_term(line->id, term, type);
-      break;
-    }
-    case BTOR2_TAG_uext: {
-      expr::term_ref type = get_type(line->sort.id);
-      expr::term_ref term;
-      size_t amt = line->args[1];
-      if (amt == 0) {
-        term = get_term_bitvector(line->args[0]);
-      } else {
-        expr::term_ref zero_term = tm.mk_bitvector_constant(expr::bitvector(amt, 0));
-        term = tm.mk_term(expr::TERM_BV_CONCAT, zero_term, get_term_bitvector(line->args[0]));
-      }
-      set_term(line->id, term, type);
-      break;
-    }
-    case BTOR2_TAG_rol: 
-    case BTOR2_TAG_ror:
-    case BTOR2_TAG_saddo:
-    case BTOR2_TAG_smulo:
-    case BTOR2_TAG_ssubo:
-    case BTOR2_TAG_sdivo:
-    case BTOR2_TAG_uaddo:
-    case BTOR2_TAG_umulo:
-    case BTOR2_TAG_usubo:
-      throw parser_exception("Unsupported btor2 tag: " + std::string(line->name), filename, lineno);
-    case BTOR2_TAG_inc: {
-      size_t width = get_term_width(line->args[0]);
-      expr::term_ref one_term = tm.mk_bitvector_constant(expr::bitvector(width, 1));
-      add_binary_term(line->id, expr::TERM_BV_ADD, line->sort.id, 
-                      get_term_bitvector(line->args[0]), one_term);
-      break;
-    }
-    case BTOR2_TAG_dec: {
-      size_t width = get_term_width(line->args[0]);
-      expr::term_ref one_term = tm.mk_bitvector_constant(expr::bitvector(width, 1));
-      add_binary_term(line->id, expr::TERM_BV_SUB, line->sort.id, 
-                      get_term_bitvector(line->args[0]), one_term);
-      break;
-    }
-    case BTOR2_TAG_redand: {
-      size_t arg_width = get_term_width(line->args[0]);
-      expr::term_ref ones_term = tm.mk_bitvector_constant(expr::bitvector(arg_width, (1 << arg_width) - 1));
-      add_binary_term(line->id, expr::TERM_EQ, line->sort.id, get_term_bitvector(line->args[0]), ones_term);
-      break;
-    }
-    case BTOR2_TAG_redor: {
-      size_t arg_width = get_term_width(line->args[0]);
-      expr::term_ref zeros_term = tm.mk_bitvector_constant(expr::bitvector(arg_width, 0));
-      expr::term_ref eq = tm.mk_term(expr::TERM_EQ, get_term_bitvector(line->args[0]), zeros_term);
-      add_unary_term(line->id, expr::TERM_NOT, line->sort.id, eq);
-      break;
-    }
-    case BTOR2_TAG_redxor: {
-      expr::term_ref term = tm.mk_bitvector_extract(get_term_bitvector(line->args[0]), expr::bitvector_extract(line->sort.bitvec.width - 1, line->sort.bitvec.width - 1));
-      for (size_t i = 0; i < line->sort.bitvec.width - 1; ++ i) {
-        expr::term_ref next_term = tm.mk_bitvector_extract(get_term_bitvector(line->args[0]), expr::bitvector_extract(i, i));
-        term = tm.mk_term(expr::TERM_BV_XOR, term, next_term);
-      }
-      set_term(line->id, term, get_type(line->sort.id));
-      break;
-    }
-    case BTOR2_TAG_neg:
-    case BTOR2_TAG_not:
-      add_unary_term(line->id, btor2_tag_to_term_op[line->tag], line->sort.id, get_term_bitvector(line->args[0]));
-      break;
-    case BTOR2_TAG_slice: {
-      expr::term_ref type = get_type(line->sort.id);
-      expr::term_ref term = tm.mk_bitvector_extract(get_term_bitvector(line->args[0]), expr::bitvector_extract(line->args[1], line->args[2]));
-      set_term(line->id, term, type);
-      break;
-    }
-    case BTOR2_TAG_ite: {
-      // cast first arg to bools and then add_ternary_term
-      expr::term_ref t1 = get_term_bitvector(line->args[0]);
-      expr::term_ref t1_bool = tm.mk_term(expr::TERM_EQ, t1, one);
-      add_ternary_term(line->id, btor2_tag_to_term_op[line->tag], line->sort.id, 
-                      t1_bool, get_term_bitvector(line->args[1]), get_term_bitvector(line->args[2]));
-      break;
-    }
-    case BTOR2_TAG_write:
-      add_ternary_term(line->id, btor2_tag_to_term_op[line->tag], line->sort.id, 
-                      get_term_bitvector(line->args[0]), get_term_bitvector(line->args[1]), get_term_bitvector(line->args[2]));
-      break;
-    case BTOR2_TAG_fair:
-      throw parser_exception("Unsupported btor2 tag: fair", filename, lineno);
-    case BTOR2_TAG_justice:
-      throw parser_exception("Unsupported btor2 tag: justice", filename, lineno);
-    default:
-      throw parser_exception("Unsupported btor2 tag: " + std::to_string(line->tag), filename, lineno);
+      throw parser_exception(e.get_message(), this->filename, lineno);
     }
   }
 
   build_transition_system();
-  btor2parser_delete(parser);
 }
 
 btor2_parser::~btor2_parser()
@@ -681,11 +945,11 @@ cmd::command* btor2_parser::parse_command() {
 }
 
 int btor2_parser::get_current_parser_line() const {
-  return 0;
+  return lineno;
 }
 
 int btor2_parser::get_current_parser_position() const {
-  return 0;
+  return -1;
 }
 
 std::string btor2_parser::get_filename() const {
@@ -698,5 +962,3 @@ internal_parser_interface* new_btor2_parser(const system::context& ctx, const ch
 
 }
 }
-
-#endif
\ No newline at end of file
@@ -19,14 +19,12 @@
 #pragma once
 
 #include "system/context.h"
-#include "parser/antlr_parser.h"
+#include "parser/parser.h"
 
 namespace sally {
 namespace parser {
 
-#ifdef WITH_BTOR2TOOLS
 internal_parser_interface* new_btor2_parser(const system::context& ctx, const char* filename);
-#endif
 
 }
 }
@@ -0,0 +1,313 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "parser/parser.h"
+#include "expr/bitvector.h"
+#include "expr/bitvector_word.h"
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <stdint.h>
+#include <boost/thread.hpp>
+
+namespace sally {
+namespace parser {
+
+/** A token of a line, pointing into the input (not '\0' terminated) */
+struct line_token {
+
+  const char* begin;
+  const char* end;
+
+  line_token(): begin(0), end(0) {}
+
+  size_t size() const { return end - begin; }
+  bool empty() const { return begin == end; }
+  std::string str() const { return std::string(begin, end); }
+
+  /** Is the token equal to the '\0' terminated string */
+  bool operator == (const char* s) const {
+    size_t n = size();
+    return strncmp(begin, s, n) == 0 && s[n] == 0;
+  }
+
+  /** Parse as a non-negative decimal, false if not a number or too large */
+  bool to_uint(uint64_t& value) const {
+    if (empty() || size() > 19) {
+      return false;
+    }
+    uint64_t result = 0;
+    for (const char* p = begin; p != end; ++ p) {
+      unsigned digit = (unsigned char) *p - '0';
+      if (digit > 9) {
+        return false;
+      }
+      result = result*10 + digit;
+    }
+    value = result;
+    return true;
+  }
+
+  /** Parse as a decimal with an optional '-', false if not a number */
+  bool to_int(int64_t& value) const {
+    line_token digits = *this;
+    bool negative = !empty() && *begin == '-';
+    if (negative) {
+      ++ digits.begin;
+    }
+    uint64_t abs;
+    if (!digits.to_uint(abs) || abs > (uint64_t) INT64_MAX) {
+      return false;
+    }
+    value = negative ? -(int64_t) abs : (int64_t) abs;
+    return true;
+  }
+};
+
+/** Error for a constant that doesn't fit in the width (the line is added by the reader) */
+inline
+parser_exception bitvector_overflow(const line_token& text, size_t width) {
+  return parser_exception("Constant " + text.str() + " doesn't fit in " + std::to_string(width) + " bits");
+}
+
+/**
+ * Parse the token as a bitvector constant of the given width, in base 2, 10
+ * or 16 (decimals can be negative, giving the two's complement). Returns
+ * false if the token is not a number in the base, and throws if the number
+ * doesn't fit in the width (unsigned, or signed if negative).
+ */
+inline
+bool parse_bitvector(const line_token& text, size_t base, size_t width, expr::bitvector& bv) {
+  line_token digits = text;
+  bool negative = base == 10 && !digits.empty() && *digits.begin == '-';
+  if (negative) {
+    ++ digits.begin;
+  }
+  if (digits.empty() || width == 0) {
+    return false;
+  }
+
+  // Machine word fast path
+  size_t bits_per_digit = base == 2 ? 1 : (base == 16 ? 4 : 0);
+  if (width <= 64 && (base == 10 ? digits.size() <= 19 : digits.size()*bits_per_digit <= 64)) {
+    uint64_t value = 0;
+    for (const char* p = digits.begin; p != digits.end; ++ p) {
+      char c = *p;
+      unsigned digit = base;
+      if (c >= '0' && c <= '9') {
+        digit = c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        digit = c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        digit = c - 'A' + 10;
+      }
+      if (digit >= base) {
+        return false;
+      }
+      value = value * base + digit;
+    }
+    if (negative ? value > (uint64_t(1) << (width - 1)) : width < 64 && (value >> width) != 0) {
+      throw bitvector_overflow(text, width);
+    }
+    if (negative) {
+      value = -value;
+    }
+    bv = expr::bitvector::from_word(width, value & expr::bv_word::mask(width));
+    return true;
+  }
+
+  // General case
+  mpz_class z;
+  if (z.set_str(digits.str(), base) != 0 || z < 0) {
+    return false;
+  }
+  mpz_class max = negative ? mpz_class(mpz_class(1) << (width - 1)) : mpz_class((mpz_class(1) << width) - 1);
+  if (z > max) {
+    throw bitvector_overflow(text, width);
+  }
+  if (negative) {
+    // Two's complement
+    mpz_class modulus = mpz_class(1) << width;
+    z = (modulus - z % modulus) % modulus;
+  }
+  bv = expr::bitvector(width, expr::integer(z));
+  return true;
+}
+
+/**
+ * Splits a line into whitespace separated tokens. A ';' starts a comment that
+ * runs to the end of the line.
+ */
+class line_tokenizer {
+
+  const char* d_pos;
+  const char* d_end;
+
+  static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+  }
+
+public:
+
+  line_tokenizer(const char* begin, const char* end)
+  : d_pos(begin), d_end(end) {}
+
+  /** Get the next token, returns false at the end of the line */
+  bool next(line_token& token) {
+    while (d_pos != d_end && is_space(*d_pos)) {
+      ++ d_pos;
+    }
+    if (d_pos == d_end || *d_pos == ';') {
+      d_pos = d_end;
+      return false;
+    }
+    token.begin = d_pos;
+    while (d_pos != d_end && !is_space(*d_pos) && *d_pos != ';') {
+      ++ d_pos;
+    }
+    token.end = d_pos;
+    return true;
+  }
+
+  /** Are there no more tokens */
+  bool done() {
+    line_token token;
+    const char* pos = d_pos;
+    bool more = next(token);
+    d_pos = pos;
+    return !more;
+  }
+};
+
+/**
+ * Parses all the lines of the input into records. The line parser is called
+ * as
+ *
+ *   parse(const char* begin, const char* end, size_t lineno, std::vector<record>& out)
+ *
+ * for each line (without the '\n'), and can add any number of records to out
+ * (the records are kept in input order). Records have a lineno member, which
+ * is set to the line number in the file. With more than one worker, the input
+ * is split into chunks at line boundaries and the chunks are parsed in
+ * parallel, so the line parser must not touch any shared state. Errors are
+ * reported as parser exceptions with the line of the first error in the file.
+ */
+template <typename record, typename line_parser>
+void parse_lines(const char* begin, const char* end, const std::string& filename,
+    line_parser parse, std::vector<record>& records, size_t workers = 1)
+{
+  /** Parses the lines of a chunk, with line numbers local to the chunk */
+  struct chunk {
+    const char* begin;
+    const char* end;
+    line_parser* parse;
+    std::vector<record> records;
+    size_t lines;
+    bool failed;
+    size_t error_line;
+    std::string error;
+
+    chunk(const char* begin, const char* end, line_parser* parse)
+    : begin(begin), end(end), parse(parse), lines(0), failed(false), error_line(0) {}
+
+    void operator () () {
+      const char* line = begin;
+      try {
+        while (line != end) {
+          const char* eol = (const char*) memchr(line, '\n', end - line);
+          const char* line_end = eol ? eol : end;
+          (*parse)(line, line_end, ++ lines, records);
+          line = eol ? eol + 1 : end;
+        }
+      } catch (const sally::exception& e) {
+        failed = true;
+        error_line = lines;
+        error = e.get_message();
+      }
+    }
+  };
+
+  // Split at the line boundaries (small inputs are not worth the threads)
+  static const size_t min_chunk_size = 1 << 20;
+  size_t size = end - begin;
+  if (workers < 1) {
+    workers = 1;
+  }
+  if (workers > 1 && size / workers < min_chunk_size) {
+    workers = std::max<size_t>(1, size / min_chunk_size);
+  }
+  std::vector<chunk> chunks;
+  chunks.reserve(workers);
+  const char* chunk_begin = begin;
+  for (size_t i = 1; i <= workers && chunk_begin != end; ++ i) {
+    const char* chunk_end = i == workers ? end : begin + size / workers * i;
+    if (chunk_end < chunk_begin) {
+      chunk_end = chunk_begin;
+    }
+    const char* eol = (const char*) memchr(chunk_end, '\n', end - chunk_end);
+    chunk_end = eol ? eol + 1 : end;
+    chunks.push_back(chunk(chunk_begin, chunk_end, &parse));
+    chunk_begin = chunk_end;
+  }
+
+  // Parse the chunks
+  if (chunks.size() == 1) {
+    chunks[0]();
+  } else if (chunks.size() > 1) {
+    boost::thread_group threads;
+    for (size_t i = 0; i < chunks.size(); ++ i) {
+      threads.create_thread(boost::ref(chunks[i]));
+    }
+    threads.join_all();
+  }
+
+  // Move to file line numbers, reporting the first error
+  size_t lines = 0;
+  for (size_t i = 0; i < chunks.size(); ++ i) {
+    if (chunks[i].failed) {
+      throw parser_exception(chunks[i].error, filename, lines + chunks[i].error_line);
+    }
+    if (lines > 0) {
+      std::vector<record>& chunk_records = chunks[i].records;
+      for (size_t j = 0; j < chunk_records.size(); ++ j) {
+        chunk_records[j].lineno += lines;
+      }
+    }
+    lines += chunks[i].lines;
+  }
+
+  // Collect the records
+  if (chunks.size() == 1) {
+    records.swap(chunks[0].records);
+  } else {
+    size_t total = 0;
+    for (size_t i = 0; i < chunks.size(); ++ i) {
+      total += chunks[i].records.size();
+    }
+    records.reserve(total);
+    for (size_t i = 0; i < chunks.size(); ++ i) {
+      records.insert(records.end(), chunks[i].records.begin(), chunks[i].records.end());
+    }
+  }
+}
+
+}
+}
@@ -33,6 +33,9 @@ struct antlr_parser_traits<INPUT_MCMT> {
 
   typedef mcmt_state langState;
 
+  /** Commands are independent s-expressions */
+  static const bool streaming = true;
+
   static
   pmcmtLexer newLexer(pANTLR3_INPUT_STREAM instream) {
     return mcmtLexerNew(instream);
@@ -35,6 +35,7 @@ options {
   #include "command/generalize.h"
   #include "command/checksat.h"
   #include "command/sequence.h"
+  #include "parser/parser.h"
   #include "parser/mcmt/mcmt_state.h"
   using namespace sally;
 }
@@ -333,7 +334,7 @@ state_formula[const system::state_type* state_type] returns [system::state_formu
     // Undeclare the variables and return the formula
     {
         STATE->pop_scope();
-        $sf = new system::state_formula(STATE->tm(), state_type, sf_term);
+        $sf = new system::state_formula(STATE->tm(), state_type, parser::rewrite_input(STATE->ctx(), sf_term));
     }
   ;
 
@@ -364,7 +365,7 @@ input_formula[const system::state_type* state_type] returns [system::transition_
     // Undeclare the variables and return the formula
     {
       STATE->pop_scope();
-      $tf = new system::transition_formula(STATE->tm(), state_type, tf_term);
+      $tf = new system::transition_formula(STATE->tm(), state_type, parser::rewrite_input(STATE->ctx(), tf_term));
     }
   ;
 
@@ -381,7 +382,7 @@ state_transition_formula[const system::state_type* state_type] returns [system::
     // Undeclare the variables and make the transition
     {
         STATE->pop_scope();
-        $tf = new system::transition_formula(STATE->tm(), state_type, tf_term);
+        $tf = new system::transition_formula(STATE->tm(), state_type, parser::rewrite_input(STATE->ctx(), tf_term));
     }
   ;
 
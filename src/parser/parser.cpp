@@ -22,13 +22,14 @@
 #include "mcmt/mcmt.h"
 #include "smt2/smt2.h"
 #include "btor/btor.h"
-#ifdef WITH_BTOR2TOOLS
 #include "btor2/btor2.h"
-#endif
 #include "sal/sal.h"
 #include "aiger/aiger.h"
+#include "snapshot/snapshot.h"
 
 #include "expr/term_manager.h"
+#include "expr/term_rewriter.h"
+#include "system/context.h"
 
 #include <iostream>
 #include <string>
@@ -112,11 +113,7 @@ parser::parser(const system::context& ctx, input_language lang, const char* file
     d_internal = new_btor_parser(ctx, filename);
     break;
   case INPUT_BTOR2:
-#ifdef WITH_BTOR2TOOLS
-      d_internal = new_btor2_parser(ctx, filename);
-#else
-      throw parser_exception("Btor2Tools is not installed, cannot parse btor2 files");
-#endif
+    d_internal = new_btor2_parser(ctx, filename);
     break;
   case INPUT_SAL:
     d_internal = new_sal_parser(ctx, filename);
@@ -124,6 +121,9 @@ parser::parser(const system::context& ctx, input_language lang, const char* file
   case INPUT_AIGER:
     d_internal = new_aiger_parser(ctx, filename);
     break;
+  case INPUT_SNAPSHOT:
+    d_internal = new_snapshot_parser(ctx, filename);
+    break;
   default:
     assert(false);
   }
@@ -141,7 +141,7 @@ cmd::command* parser::parse_command() {
       // Add line information
       throw parser_exception(e.get_message(), d_internal->get_filename(), d_internal->get_current_parser_line(), d_internal->get_current_parser_position());
     } else {
-      throw e;
+      throw;
     }
   } catch (const sally::exception& e) {
     throw parser_exception(e.get_message(), d_internal->get_filename(), d_internal->get_current_parser_line(), d_internal->get_current_parser_position());
@@ -170,9 +170,21 @@ input_language parser::guess_language(std::string filename) {
     if (extension == "aig") {
       return INPUT_AIGER;
     }
+    if (extension == "snap") {
+      return INPUT_SNAPSHOT;
+    }
     return INPUT_MCMT;
   }
 }
 
+expr::term_ref rewrite_input(const system::context& ctx, expr::term_ref f) {
+  const options& opts = ctx.get_options();
+  if (!opts.has_option("rewrite")) {
+    return f;
+  }
+  expr::term_rewriter rewriter(ctx.tm(), expr::term_rewriter::parse_rules(opts.get_string("rewrite")));
+  return rewriter.rewrite(f);
+}
+
 }
 }
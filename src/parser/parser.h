@@ -20,6 +20,7 @@
 
 #include "utils/exception.h"
 #include "command/command.h"
+#include "expr/term.h"
 
 namespace sally {
 
@@ -77,7 +78,8 @@ enum input_language {
   INPUT_BTOR,
   INPUT_BTOR2,
   INPUT_SAL,
-  INPUT_AIGER
+  INPUT_AIGER,
+  INPUT_SNAPSHOT
 };
 
 /** Internal parser interface. */
@@ -117,5 +119,11 @@ public:
   input_language guess_language(std::string filename);
 };
 
+/**
+ * Rewrite a parsed formula with the rule sets selected by the --rewrite
+ * option (returns the formula unchanged if the option is not set).
+ */
+expr::term_ref rewrite_input(const system::context& ctx, expr::term_ref f);
+
 }
 }
@@ -33,6 +33,9 @@ struct antlr_parser_traits<INPUT_SAL> {
 
   typedef sal_state langState;
 
+  /** One context */
+  static const bool streaming = false;
+
   static
   psalLexer newLexer(pANTLR3_INPUT_STREAM instream) {
     return salLexerNew(instream);
@@ -33,6 +33,9 @@ struct antlr_parser_traits<INPUT_SMT2> {
 
   typedef smt2_state langState;
 
+  /** All the commands make one system */
+  static const bool streaming = false;
+
   static
   psmt2Lexer newLexer(pANTLR3_INPUT_STREAM instream) {
     return smt2LexerNew(instream);
@@ -166,7 +166,7 @@ cmd::command* smt2_state::mk_smt2_system() {
   // Make the inital state formula
   expr::term_ref initial_states = tm().mk_and(d_assertions);
   initial_states = tm().substitute(initial_states, subst);
-  system::state_formula* init_f = new system::state_formula(tm(), state_type, initial_states);
+  system::state_formula* init_f = new system::state_formula(tm(), state_type, rewrite_input(ctx(), initial_states));
 
   // Make the transition
   system::transition_formula* transition_f = new system::transition_formula(tm(), state_type, tm().mk_boolean_constant(false));
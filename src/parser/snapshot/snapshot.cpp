@@ -0,0 +1,466 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "parser/snapshot/snapshot.h"
+
+#include "command/assume.h"
+#include "command/declare_state_type.h"
+#include "command/define_states.h"
+#include "command/define_transition.h"
+#include "command/define_transition_system.h"
+#include "command/query.h"
+#include "command/sequence.h"
+
+#include "expr/gc_relocator.h"
+#include "utils/mapped_file.h"
+
+#include <cstring>
+
+namespace sally {
+namespace parser {
+
+using expr::write_uint;
+using expr::write_string;
+
+/** The magic at the start of the snapshot */
+static const char snapshot_magic[8] = { 'S', 'A', 'L', 'L', 'Y', 'S', 'N', 'P' };
+
+/** The version of the format, change when the format or the term ops change */
+static const uint64_t snapshot_version = 1;
+
+/** The variable classes of state types, in the order they are indexed */
+static const system::state_type::var_class snapshot_var_classes[3] = {
+  system::state_type::STATE_CURRENT,
+  system::state_type::STATE_INPUT,
+  system::state_type::STATE_NEXT
+};
+
+snapshot_writer::snapshot_writer(const system::context& ctx, std::string filename)
+: gc_participant(ctx.tm())
+, d_ctx(ctx)
+, d_out(filename.c_str(), std::ios::binary)
+, d_filename(filename)
+, d_terms(ctx.tm())
+{
+  if (!d_out) {
+    throw exception("can't open snapshot ") << filename;
+  }
+  d_out.write(snapshot_magic, sizeof(snapshot_magic));
+  std::string header;
+  write_uint(header, snapshot_version);
+  d_out.write(header.data(), header.size());
+}
+
+void snapshot_writer::write_term(expr::term_ref t) {
+  write_uint(d_buffer, d_terms.add_term(t));
+}
+
+void snapshot_writer::index_term(expr::term_ref t) {
+  if (!d_terms.index_term(t)) {
+    throw exception("snapshot: state type variable ") << t << " used before its state type";
+  }
+}
+
+void snapshot_writer::write_state_type(const system::state_type* st) {
+  std::map<const system::state_type*, size_t>::const_iterator find = d_state_type_index.find(st);
+  if (find == d_state_type_index.end()) {
+    throw exception("snapshot: state type not declared in the snapshot");
+  }
+  write_uint(d_buffer, find->second);
+}
+
+void snapshot_writer::write_formula(const system::state_formula* f) {
+  write_state_type(f->get_state_type());
+  write_term(f->get_formula());
+}
+
+void snapshot_writer::write_formula(const system::transition_formula* f) {
+  write_state_type(f->get_state_type());
+  write_term(f->get_formula());
+}
+
+void snapshot_writer::write_command(const cmd::command& cmd) {
+
+  write_uint(d_buffer, cmd.get_type());
+
+  // Sequences just have the commands
+  if (cmd.get_type() == cmd::SEQUENCE) {
+    const cmd::sequence& seq = static_cast<const cmd::sequence&>(cmd);
+    write_uint(d_buffer, seq.size());
+    for (size_t i = 0; i < seq.size(); ++ i) {
+      write_command(*seq[i]);
+    }
+    return;
+  }
+
+  // Other commands have their terms first, so we write the fields aside
+  std::string command_buffer;
+  command_buffer.swap(d_buffer);
+
+  switch (cmd.get_type()) {
+  case cmd::DECLARE_STATE_TYPE: {
+    const cmd::declare_state_type& declare = static_cast<const cmd::declare_state_type&>(cmd);
+    const system::state_type* st = declare.get_state_type();
+    write_string(d_buffer, declare.get_id());
+    write_term(st->get_state_type_var());
+    write_term(st->get_input_type_var());
+    // The variables are made by the state type, so we just index them
+    for (size_t i = 0; i < 3; ++ i) {
+      expr::term_ref vars_struct = st->get_vars_struct(snapshot_var_classes[i]);
+      if (vars_struct.is_null()) {
+        write_uint(d_buffer, 0);
+        continue;
+      }
+      const std::vector<expr::term_ref>& vars = st->get_variables(snapshot_var_classes[i]);
+      write_uint(d_buffer, vars.size() + 1);
+      index_term(vars_struct);
+      for (size_t j = 0; j < vars.size(); ++ j) {
+        index_term(vars[j]);
+      }
+    }
+    size_t st_index = d_state_type_index.size();
+    d_state_type_index[st] = st_index;
+    break;
+  }
+  case cmd::DEFINE_STATES: {
+    const cmd::define_states& define = static_cast<const cmd::define_states&>(cmd);
+    write_string(d_buffer, define.get_id());
+    write_formula(define.get_state_formula());
+    break;
+  }
+  case cmd::DEFINE_TRANSITION: {
+    const cmd::define_transition& define = static_cast<const cmd::define_transition&>(cmd);
+    write_string(d_buffer, define.get_id());
+    write_formula(define.get_formula());
+    break;
+  }
+  case cmd::DEFINE_TRANSITION_SYSTEM: {
+    const cmd::define_transition_system& define = static_cast<const cmd::define_transition_system&>(cmd);
+    const system::transition_system* T = define.get_system();
+    write_string(d_buffer, define.get_id());
+    write_state_type(T->get_state_type());
+    write_formula(T->get_initial_states_formula());
+    write_formula(T->get_transition_relation_formula());
+    // The invariant is a chain (and (and true I1) I2) ..., we keep the parts
+    std::vector<expr::term_ref> invariants;
+    expr::term_ref inv = T->get_invariant_formula()->get_formula();
+    expr::term_manager& tm = d_ctx.tm();
+    while (tm.term_of(inv).op() == expr::TERM_AND && tm.term_of(inv).size() == 2) {
+      invariants.push_back(tm.term_of(inv)[1]);
+      inv = tm.term_of(inv)[0];
+    }
+    if (inv != tm.mk_boolean_constant(true)) {
+      invariants.push_back(inv);
+    }
+    write_uint(d_buffer, invariants.size());
+    for (size_t i = invariants.size(); i > 0; -- i) {
+      write_term(invariants[i-1]);
+    }
+    const std::vector<system::state_formula*>& state_assumptions = T->get_state_assumptions();
+    write_uint(d_buffer, state_assumptions.size());
+    for (size_t i = 0; i < state_assumptions.size(); ++ i) {
+      write_formula(state_assumptions[i]);
+    }
+    const std::vector<system::transition_formula*>& transition_assumptions = T->get_transition_assumptions();
+    write_uint(d_buffer, transition_assumptions.size());
+    for (size_t i = 0; i < transition_assumptions.size(); ++ i) {
+      write_formula(transition_assumptions[i]);
+    }
+    break;
+  }
+  case cmd::ASSUME: {
+    const cmd::assume& assume = static_cast<const cmd::assume&>(cmd);
+    write_string(d_buffer, assume.get_system_id());
+    if (assume.get_assumption()) {
+      write_uint(d_buffer, 0);
+      write_formula(assume.get_assumption());
+    } else {
+      write_uint(d_buffer, 1);
+      write_formula(assume.get_transition_assumption());
+    }
+    break;
+  }
+  case cmd::QUERY: {
+    const cmd::query& query = static_cast<const cmd::query&>(cmd);
+    write_string(d_buffer, query.get_system_id());
+    const std::vector<system::state_formula*>& queries = query.get_queries();
+    write_uint(d_buffer, queries.size());
+    for (size_t i = 0; i < queries.size(); ++ i) {
+      write_formula(queries[i]);
+    }
+    break;
+  }
+  default:
+    throw exception("snapshot: can't save command ") << cmd.get_command_type_string();
+  }
+
+  // Terms, then the fields
+  command_buffer.swap(d_buffer);
+  d_terms.write_records(d_buffer);
+  d_buffer.append(command_buffer);
+}
+
+void snapshot_writer::add(const cmd::command& cmd) {
+  d_buffer.clear();
+  write_command(cmd);
+  d_out.write(d_buffer.data(), d_buffer.size());
+  d_out.flush();
+  if (!d_out) {
+    throw exception("can't write snapshot ") << d_filename;
+  }
+}
+
+void snapshot_writer::gc_collect(const expr::gc_relocator& gc_reloc) {
+  d_terms.gc_collect(gc_reloc);
+}
+
+/** Reads the terms of a snapshot, reporting errors as parse errors */
+class snapshot_term_reader : public expr::term_reader {
+protected:
+  void error(const char* msg) const {
+    throw parser_exception(std::string("snapshot: ") + msg);
+  }
+public:
+  snapshot_term_reader(expr::term_manager& tm)
+  : term_reader(tm) {}
+};
+
+/** Loads the commands from a snapshot, one top-level command at a time */
+class snapshot_parser : public internal_parser_interface, public expr::gc_participant {
+
+  /** The context */
+  const system::context& d_ctx;
+
+  /** The term manager */
+  expr::term_manager& d_tm;
+
+  /** The snapshot */
+  utils::mapped_file d_file;
+
+  /** The terms, and the reader of the fields */
+  snapshot_term_reader d_reader;
+
+  /** Number of top-level commands read */
+  int d_commands;
+
+  /** The state types by index */
+  std::vector<const system::state_type*> d_state_types;
+
+  void error(const char* msg) const {
+    throw parser_exception(std::string("snapshot: ") + msg);
+  }
+
+  /** Read a state type index and get the state type */
+  const system::state_type* get_state_type();
+
+  /** Read a state formula */
+  system::state_formula* get_state_formula();
+
+  /** Read a transition formula */
+  system::transition_formula* get_transition_formula();
+
+  /** Read a command */
+  cmd::command* read_command();
+
+public:
+
+  snapshot_parser(const system::context& ctx, const char* filename);
+
+  cmd::command* parse_command();
+
+  int get_current_parser_line() const {
+    return d_commands;
+  }
+
+  int get_current_parser_position() const {
+    return -1;
+  }
+
+  std::string get_filename() const {
+    return d_file.get_filename();
+  }
+
+  void gc_collect(const expr::gc_relocator& gc_reloc) {
+    d_reader.gc_collect(gc_reloc);
+  }
+};
+
+snapshot_parser::snapshot_parser(const system::context& ctx, const char* filename)
+: gc_participant(ctx.tm())
+, d_ctx(ctx)
+, d_tm(ctx.tm())
+, d_file(filename)
+, d_reader(ctx.tm())
+, d_commands(0)
+{
+  if (d_file.size() < sizeof(snapshot_magic) || memcmp(d_file.begin(), snapshot_magic, sizeof(snapshot_magic)) != 0) {
+    error("not a snapshot");
+  }
+  d_reader.set_input(d_file.begin() + sizeof(snapshot_magic), d_file.end());
+  if (d_reader.read_uint() != snapshot_version) {
+    error("unsupported version");
+  }
+}
+
+const system::state_type* snapshot_parser::get_state_type() {
+  uint64_t index = d_reader.read_uint();
+  if (index >= d_state_types.size()) {
+    error("invalid state type index");
+  }
+  return d_state_types[index];
+}
+
+system::state_formula* snapshot_parser::get_state_formula() {
+  const system::state_type* st = get_state_type();
+  expr::term_ref f = d_reader.read_term();
+  return new system::state_formula(d_tm, st, f);
+}
+
+system::transition_formula* snapshot_parser::get_transition_formula() {
+  const system::state_type* st = get_state_type();
+  expr::term_ref f = d_reader.read_term();
+  return new system::transition_formula(d_tm, st, f);
+}
+
+cmd::command* snapshot_parser::read_command() {
+
+  uint64_t type = d_reader.read_uint();
+
+  if (type == cmd::SEQUENCE) {
+    cmd::sequence* seq = new cmd::sequence();
+    try {
+      uint64_t size = d_reader.read_uint();
+      for (size_t i = 0; i < size; ++ i) {
+        seq->push_back(read_command());
+      }
+    } catch (...) {
+      delete seq;
+      throw;
+    }
+    return seq;
+  }
+
+  d_reader.read_records();
+
+  switch (type) {
+  case cmd::DECLARE_STATE_TYPE: {
+    std::string id = d_reader.read_string();
+    expr::term_ref state_type_var = d_reader.read_term();
+    expr::term_ref input_type_var = d_reader.read_term();
+    system::state_type* st = new system::state_type(id, d_tm, state_type_var, input_type_var);
+    cmd::command* declare = new cmd::declare_state_type(id, st);
+    // Index the variables that the state type made
+    for (size_t i = 0; i < 3; ++ i) {
+      uint64_t count = d_reader.read_uint();
+      expr::term_ref vars_struct = st->get_vars_struct(snapshot_var_classes[i]);
+      const std::vector<expr::term_ref>& vars = st->get_variables(snapshot_var_classes[i]);
+      if (count != (vars_struct.is_null() ? 0 : vars.size() + 1)) {
+        delete declare;
+        error("state type variables don't match");
+      }
+      if (count > 0) {
+        d_reader.index_term(vars_struct);
+        for (size_t j = 0; j < vars.size(); ++ j) {
+          d_reader.index_term(vars[j]);
+        }
+      }
+    }
+    d_state_types.push_back(st);
+    return declare;
+  }
+  case cmd::DEFINE_STATES: {
+    std::string id = d_reader.read_string();
+    return new cmd::define_states(id, get_state_formula());
+  }
+  case cmd::DEFINE_TRANSITION: {
+    std::string id = d_reader.read_string();
+    return new cmd::define_transition(id, get_transition_formula());
+  }
+  case cmd::DEFINE_TRANSITION_SYSTEM: {
+    std::string id = d_reader.read_string();
+    const system::state_type* st = get_state_type();
+    system::state_formula* I = get_state_formula();
+    system::transition_formula* T = get_transition_formula();
+    system::transition_system* system = new system::transition_system(st, I, T);
+    cmd::command* define = new cmd::define_transition_system(id, system);
+    try {
+      uint64_t invariants = d_reader.read_uint();
+      for (size_t i = 0; i < invariants; ++ i) {
+        system::state_formula* inv = new system::state_formula(d_tm, st, d_reader.read_term());
+        system->add_invariant(inv);
+        delete inv;
+      }
+      uint64_t state_assumptions = d_reader.read_uint();
+      for (size_t i = 0; i < state_assumptions; ++ i) {
+        system->add_assumption(get_state_formula());
+      }
+      uint64_t transition_assumptions = d_reader.read_uint();
+      for (size_t i = 0; i < transition_assumptions; ++ i) {
+        system->add_assumption(get_transition_formula());
+      }
+    } catch (...) {
+      delete define;
+      throw;
+    }
+    return define;
+  }
+  case cmd::ASSUME: {
+    std::string id = d_reader.read_string();
+    if (d_reader.read_uint() == 0) {
+      return new cmd::assume(d_ctx, id, get_state_formula());
+    } else {
+      return new cmd::assume(d_ctx, id, get_transition_formula());
+    }
+  }
+  case cmd::QUERY: {
+    std::string id = d_reader.read_string();
+    uint64_t size = d_reader.read_uint();
+    std::vector<system::state_formula*> queries;
+    try {
+      for (size_t i = 0; i < size; ++ i) {
+        queries.push_back(get_state_formula());
+      }
+    } catch (...) {
+      for (size_t i = 0; i < queries.size(); ++ i) {
+        delete queries[i];
+      }
+      throw;
+    }
+    return new cmd::query(d_ctx, id, queries);
+  }
+  default:
+    error("invalid command");
+  }
+
+  return 0;
+}
+
+cmd::command* snapshot_parser::parse_command() {
+  if (d_reader.at_end()) {
+    return 0;
+  }
+  d_commands ++;
+  return read_command();
+}
+
+internal_parser_interface* new_snapshot_parser(const system::context& ctx, const char* filename) {
+  return new snapshot_parser(ctx, filename);
+}
+
+}
+}
@@ -0,0 +1,103 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "system/context.h"
+#include "parser/parser.h"
+#include "expr/gc_participant.h"
+#include "expr/term_io.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace sally {
+namespace parser {
+
+/**
+ * Writes the commands as they come out of a parser into a binary snapshot,
+ * that can be loaded back (as input language INPUT_SNAPSHOT) without
+ * parsing and type-checking the source again. The snapshot is a sequence of
+ * commands, each preceded by the terms it needs that are not in the snapshot
+ * yet. Terms are given by op, payload, children and type, all referring to
+ * earlier terms by index. The variables of a state type are not written, but
+ * indexed when the state type is declared, so that the loader maps them to
+ * the variables of the state type it creates.
+ *
+ * Commands must be added before they are run (running gives away the
+ * formulas to the context). Only the commands that come out of the parsers
+ * for systems are supported (state types, states, transitions, systems,
+ * assumptions and queries, in sequences).
+ */
+class snapshot_writer : public expr::gc_participant {
+
+  /** The context */
+  const system::context& d_ctx;
+
+  /** The output */
+  std::ofstream d_out;
+
+  /** The name of the output file */
+  std::string d_filename;
+
+  /** Buffer for the current command */
+  std::string d_buffer;
+
+  /** The terms (with the records of the terms of the current command) */
+  expr::term_writer d_terms;
+
+  /** Indices of the state types, in order of declaration */
+  std::map<const system::state_type*, size_t> d_state_type_index;
+
+  /** Write a term (with terms) */
+  void write_term(expr::term_ref t);
+
+  /** Index the term without writing it (to be recreated by the loader) */
+  void index_term(expr::term_ref t);
+
+  /** Write the state type index */
+  void write_state_type(const system::state_type* st);
+
+  /** Write a state formula (with terms) */
+  void write_formula(const system::state_formula* f);
+
+  /** Write a transition formula (with terms) */
+  void write_formula(const system::transition_formula* f);
+
+  /** Write the command to the buffer */
+  void write_command(const cmd::command& cmd);
+
+public:
+
+  /** Start a snapshot in the file */
+  snapshot_writer(const system::context& ctx, std::string filename);
+
+  /** Add the command (before it runs) */
+  void add(const cmd::command& cmd);
+
+  /** GC */
+  void gc_collect(const expr::gc_relocator& gc_reloc);
+};
+
+/** Make a parser that loads the commands of a snapshot */
+internal_parser_interface* new_snapshot_parser(const system::context& ctx, const char* filename);
+
+}
+}
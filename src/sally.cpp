@@ -26,10 +26,12 @@
 #include "utils/output.h"
 #include "system/context.h"
 #include "parser/parser.h"
+#include "parser/snapshot/snapshot.h"
 #include "engine/factory.h"
 #include "smt/factory.h"
 #include "utils/trace.h"
 #include "utils/statistics.h"
+#include "utils/memory.h"
 
 using namespace std;
 using namespace boost::program_options;
@@ -40,7 +42,8 @@ using namespace sally;
 void parse_options(int argc, char* argv[], variables_map& variables, utils::statistics& stats);
 
 /** Prints statistics to the given output and given time slice */
-void live_stats(const utils::statistics* stats, std::string file, unsigned time);
+void live_stats(const utils::statistics* stats, utils::memory_stats* memory, std::string file, unsigned time, utils::stats_format format);
+void memory_report(const expr::term_manager& tm, const engine* e, std::string file);
 
 int main(int argc, char* argv[]) {
 
@@ -88,6 +91,7 @@ int main(int argc, char* argv[]) {
     stat_solver->set_value(opts.get_string("solver"));
     stat_result->set_value("unknown");
     stat_time->start();
+    utils::memory_stats stat_memory(stats);
 
     // Create the term manager
     expr::term_manager tm(stats);
@@ -105,6 +109,21 @@ int main(int argc, char* argv[]) {
       smt::factory::enable_smt2_output(opts.get_string("smt2-output"));
     }
 
+    // Enable query caching if enabled
+    if (opts.has_option("solver-cache")) {
+      smt::factory::enable_query_cache(opts.has_option("solver-cache-file") ? opts.get_string("solver-cache-file") : "");
+    }
+
+    // Profile the solver queries if asked
+    if (opts.has_option("solver-profile") || opts.has_option("solver-slow-queries")) {
+      smt::factory::enable_profile();
+    }
+
+    // Generalize with the built-in projection if asked
+    if (opts.has_option("solver-mbp")) {
+      smt::factory::enable_mbp();
+    }
+
     // Create the engine
     engine* engine_to_use = 0;
     if (opts.has_option("engine")) {
@@ -116,7 +135,14 @@ int main(int argc, char* argv[]) {
     if (opts.has_option("live-stats")) {
       std::string stats_out = opts.get_string("live-stats");
       unsigned time = boost_opts.at("live-stats-time").as<unsigned>();
-      stats_worker = new boost::thread(live_stats, &stats, stats_out, time);
+      utils::stats_format format = utils::statistics::format_from_string(opts.get_string("live-stats-format"));
+      stats_worker = new boost::thread(live_stats, &stats, &stat_memory, stats_out, time, format);
+    }
+
+    // Save the parsed commands if asked
+    parser::snapshot_writer* snapshot = 0;
+    if (opts.has_option("save-snapshot")) {
+      snapshot = new parser::snapshot_writer(ctx, opts.get_string("save-snapshot"));
     }
 
     // Go through all the files and run them
@@ -132,9 +158,20 @@ int main(int argc, char* argv[]) {
       for (cmd::command* cmd = p.parse_command(); cmd != 0; delete cmd, cmd = p.parse_command()) {
 
         MSG(2) << "Got command " << *cmd << endl;
+
+        // Save it before it runs
+        if (snapshot) {
+          snapshot->add(*cmd);
+        }
+
         // Run the command
         cmd->run(&ctx, engine_to_use);
 
+        if (boost_opts.count("stats") > 0 || boost_opts.count("stats-format") > 0) {
+          tm.update_hash_statistics();
+          stat_memory.update();
+        }
+
         if (boost_opts.count("stats") > 0) {
           std::cout << "Stats after " << cmd->get_command_type_string() << std::endl;
           stats.to_stream(" - ", std::cout);
@@ -145,9 +182,16 @@ int main(int argc, char* argv[]) {
           std::string format = boost_opts.at("stats-format").as<string>();
           std::cout << stats.format(format) << std::endl;
         }
+
+        if (cmd->get_type() == cmd::QUERY && opts.has_option("memory-report")) {
+          memory_report(tm, engine_to_use, opts.get_string("memory-report"));
+        }
       }
     }
 
+    // Close the snapshot
+    delete snapshot;
+
     // Delete the engine
     if (engine_to_use != 0) {
       delete engine_to_use;
@@ -216,20 +260,37 @@ void parse_options(int argc, char* argv[], variables_map& variables, utils::stat
       ("debug,d", value<vector<string> >(), "Any tags to trace (only for debug builds).")
 #endif
       ("show-trace", "Show the counterexample trace if found.")
+      ("trace-format", value<string>()->default_value("full"), "Format of the counterexample traces: full (all values, in the output language), delta (only the values that changed), btor2 (BTOR2 witness), or binary.")
+      ("trace-file", value<string>(), "Write the counterexample traces to the given file instead of the standard output.")
       ("show-invariant", "Show the invariant if property is proved.")
       ("parse-only", "Just parse, don't solve.")
+      ("parse-threads", value<unsigned>()->default_value(1), "Number of threads for reading the lines of BTOR and BTOR2 files.")
+      ("save-snapshot", value<string>(), "Save the parsed commands to the given binary snapshot, to be loaded back quickly as a .snap input (use with --parse-only to just convert).")
       ("engine", value<string>(), get_engines_list().c_str())
+      ("checkpoint", value<string>(), "Periodically save the state of the engine (bmc, kind, pdkind) to the given file, to be continued with --resume.")
+      ("checkpoint-interval", value<double>()->default_value(60), "Time (in seconds) between the checkpoints (0 to save at every bound or frame).")
+      ("resume", value<string>(), "Continue the query from the given checkpoint (must be made by the same engine on the same input).")
       ("solver", value<string>()->default_value(smt::factory::get_default_solver_id()), get_solver_list().c_str())
       ("solver-logic", value<string>(), "Optional smt2 logic to set to the solver (e.g. QF_LRA, QF_LIA, ...).")
       ("output-language", value<string>()->default_value("mcmt"), get_output_languages_list().c_str())
       ("lsal-extensions", "Use lsal extensions to the MCMT language")
       ("no-input-namespace", "Don't use input namespace in the the MCMT language")
+      ("rewrite", value<string>()->implicit_value("all"), "Simplify the input formulas with the given rule sets (comma separated list of bool, arith, bv, all).")
       ("stats", "Show statistics after every command")
       ("stats-format", value<string>(), "Show statistics in the given format after every query. See --stats-help for more information.")
       ("stats-help", "Show help for statistics formatting.")
       ("live-stats", value<string>(), "Output live statistic to the given file (- for stdout).")
       ("live-stats-time", value<unsigned>()->default_value(100), "Time period for statistics output (in miliseconds)")
+      ("live-stats-format", value<string>()->default_value("table"), "Format of the live statistics: table, csv, or json (one object per line).")
+      ("memory-report", value<string>()->implicit_value("-"), "Report the memory of each subsystem after every query to the given file (- for stdout).")
       ("smt2-output", value<string>(), "Generate smt2 logs of solver queries with given prefix.")
+      ("solver-profile", "Keep histograms of the solver check times per solver and query site (see --stats).")
+      ("solver-slow-queries", value<string>(), "Write the solver queries slower than --solver-slow-threshold as smt2 files with the given prefix.")
+      ("solver-slow-threshold", value<double>()->default_value(1.0), "Time (in seconds) above which a solver query is slow.")
+      ("solver-cache", "Cache the results of solver queries.")
+      ("solver-cache-file", value<string>(), "Keep the cached solver results in the given file, to be reused across runs.")
+      ("solver-cache-size", value<unsigned>()->default_value(10000), "Maximal number of cached queries per solver (0 for no limit).")
+      ("solver-mbp", "Generalize with the built-in model-based projection.")
       ("no-lets", "Don't use let expressions in printouts.");
       ;
 
@@ -271,7 +332,7 @@ void parse_options(int argc, char* argv[], variables_map& variables, utils::stat
   }
 }
 
-void live_stats(const utils::statistics* stats, std::string file, unsigned time) {
+void live_stats(const utils::statistics* stats, utils::memory_stats* memory, std::string file, unsigned time, utils::stats_format format) {
 
   ostream* out = 0;
   ofstream* of_out = 0;
@@ -282,19 +343,36 @@ void live_stats(const utils::statistics* stats, std::string file, unsigned time)
     out = of_out = new ofstream(file.c_str());
   }
 
-  // Output headers
-  stats->headers_to_stream(*out);
-  *out << std::endl;
-
+  // Output stats, with the headers first
+  bool header = true;
   try {
-    // Output stats
-    for (;;) {
+    for (;; header = false) {
       boost::this_thread::sleep(boost::posix_time::milliseconds(time));
-      *out << *stats << endl;
+      memory->update();
+      stats->snapshot_to_stream(*out, format, header);
     }
-  } catch (boost::thread_interrupted&) {}
+  } catch (boost::thread_interrupted&) {
+    // The final values
+    memory->update();
+    stats->snapshot_to_stream(*out, format, header);
+  }
 
   if (of_out) {
     delete of_out;
   }
 }
+
+void memory_report(const expr::term_manager& tm, const engine* e, std::string file) {
+  utils::memory_report report;
+  tm.memory_usage(report);
+  if (e) {
+    e->memory_usage(report);
+  }
+  if (file == "-") {
+    cout << report;
+  } else {
+    // Append, so that we get a report for every query
+    ofstream out(file.c_str(), ios_base::app);
+    out << report;
+  }
+}
@@ -0,0 +1,647 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "smt/bitblast/bit_blaster.h"
+#include "expr/term_traversal.h"
+#include "utils/exception.h"
+#include "utils/hash.h"
+#include "utils/trace.h"
+
+#include <sstream>
+#include <cassert>
+
+namespace sally {
+namespace smt {
+
+using sat::lit;
+
+size_t bit_blaster::gate_hasher::operator () (const gate& g) const {
+  utils::sequence_hash hasher;
+  hasher.add((size_t) g.op);
+  hasher.add(g.a);
+  hasher.add(g.b);
+  hasher.add(g.c);
+  return hasher.get();
+}
+
+bit_blaster::bit_blaster(expr::term_manager& tm, sat::sat_solver& sat)
+: d_tm(tm)
+, d_sat(sat)
+{
+  d_true = lit(d_sat.new_var(), false);
+  d_false = ~d_true;
+  d_sat.add_clause(d_true);
+}
+
+const bit_blaster::bits& bit_blaster::get_bits(expr::term_ref t) const {
+  term_cache::const_iterator find = d_cache.find(t);
+  assert(find != d_cache.end());
+  return find->second;
+}
+
+void bit_blaster::mk_fresh(size_t size, bits& out) {
+  out.clear();
+  for (size_t i = 0; i < size; ++ i) {
+    out.push_back(lit(d_sat.new_var(), false));
+  }
+}
+
+void bit_blaster::mk_constant(const expr::bitvector& bv, bits& out) {
+  out.clear();
+  for (size_t i = 0; i < bv.size(); ++ i) {
+    out.push_back(bv.get_bit(i) ? d_true : d_false);
+  }
+}
+
+lit bit_blaster::mk_and(lit a, lit b) {
+  if (a == d_false || b == d_false || a == ~b) return d_false;
+  if (a == d_true || a == b) return b;
+  if (b == d_true) return a;
+  if (b < a) std::swap(a, b);
+  gate g(GATE_AND, a, b);
+  gate_cache::const_iterator find = d_gates.find(g);
+  if (find != d_gates.end()) {
+    return find->second;
+  }
+  lit o(d_sat.new_var(), false);
+  d_sat.add_clause(~o, a);
+  d_sat.add_clause(~o, b);
+  d_sat.add_clause(o, ~a, ~b);
+  d_gates[g] = o;
+  return o;
+}
+
+lit bit_blaster::mk_or(lit a, lit b) {
+  return ~mk_and(~a, ~b);
+}
+
+lit bit_blaster::mk_xor(lit a, lit b) {
+  if (a == d_false) return b;
+  if (a == d_true) return ~b;
+  if (b == d_false) return a;
+  if (b == d_true) return ~a;
+  if (a == b) return d_false;
+  if (a == ~b) return d_true;
+  // Normalize to positive inputs
+  bool negate = a.is_negative() != b.is_negative();
+  a = lit(a.get_var(), false);
+  b = lit(b.get_var(), false);
+  if (b < a) std::swap(a, b);
+  gate g(GATE_XOR, a, b);
+  gate_cache::const_iterator find = d_gates.find(g);
+  if (find != d_gates.end()) {
+    return find->second ^ negate;
+  }
+  lit o(d_sat.new_var(), false);
+  d_sat.add_clause(~o, a, b);
+  d_sat.add_clause(~o, ~a, ~b);
+  d_sat.add_clause(o, ~a, b);
+  d_sat.add_clause(o, a, ~b);
+  d_gates[g] = o;
+  return o ^ negate;
+}
+
+lit bit_blaster::mk_ite(lit c, lit t, lit e) {
+  if (c == d_true || t == e) return t;
+  if (c == d_false) return e;
+  if (t == d_true || t == c) return mk_or(c, e);
+  if (t == d_false || t == ~c) return mk_and(~c, e);
+  if (e == d_true || e == ~c) return mk_or(~c, t);
+  if (e == d_false || e == c) return mk_and(c, t);
+  if (t == ~e) return mk_xor(c, e);
+  // Normalize to positive condition
+  if (c.is_negative()) {
+    c = ~c;
+    std::swap(t, e);
+  }
+  gate g(GATE_ITE, c, t, e);
+  gate_cache::const_iterator find = d_gates.find(g);
+  if (find != d_gates.end()) {
+    return find->second;
+  }
+  lit o(d_sat.new_var(), false);
+  d_sat.add_clause(~c, ~t, o);
+  d_sat.add_clause(~c, t, ~o);
+  d_sat.add_clause(c, ~e, o);
+  d_sat.add_clause(c, e, ~o);
+  // Redundant, but help propagation
+  d_sat.add_clause(~t, ~e, o);
+  d_sat.add_clause(t, e, ~o);
+  d_gates[g] = o;
+  return o;
+}
+
+lit bit_blaster::mk_and(const bits& a) {
+  lit result = d_true;
+  for (size_t i = 0; i < a.size(); ++ i) {
+    result = mk_and(result, a[i]);
+  }
+  return result;
+}
+
+lit bit_blaster::mk_or(const bits& a) {
+  lit result = d_false;
+  for (size_t i = 0; i < a.size(); ++ i) {
+    result = mk_or(result, a[i]);
+  }
+  return result;
+}
+
+void bit_blaster::mk_not(const bits& a, bits& out) {
+  out.resize(a.size());
+  for (size_t i = 0; i < a.size(); ++ i) {
+    out[i] = ~a[i];
+  }
+}
+
+void bit_blaster::mk_ite(lit c, const bits& t, const bits& e, bits& out) {
+  assert(t.size() == e.size());
+  out.resize(t.size());
+  for (size_t i = 0; i < t.size(); ++ i) {
+    out[i] = mk_ite(c, t[i], e[i]);
+  }
+}
+
+lit bit_blaster::mk_eq(const bits& a, const bits& b) {
+  assert(a.size() == b.size());
+  lit result = d_true;
+  for (size_t i = 0; i < a.size(); ++ i) {
+    result = mk_and(result, ~mk_xor(a[i], b[i]));
+  }
+  return result;
+}
+
+void bit_blaster::mk_add(const bits& a, const bits& b, lit cin, bits& out, lit* cout) {
+  assert(a.size() == b.size());
+  out.resize(a.size());
+  lit carry = cin;
+  for (size_t i = 0; i < a.size(); ++ i) {
+    lit a_xor_b = mk_xor(a[i], b[i]);
+    out[i] = mk_xor(a_xor_b, carry);
+    carry = mk_or(mk_and(a[i], b[i]), mk_and(carry, a_xor_b));
+  }
+  if (cout) {
+    *cout = carry;
+  }
+}
+
+void bit_blaster::mk_neg(const bits& a, bits& out) {
+  bits not_a, zero(a.size(), d_false);
+  mk_not(a, not_a);
+  mk_add(not_a, zero, d_true, out, 0);
+}
+
+void bit_blaster::mk_mul(const bits& a, const bits& b, bits& out) {
+  assert(a.size() == b.size());
+  size_t n = a.size();
+  bits result(n, d_false), lhs, rhs, sum;
+  for (size_t i = 0; i < n; ++ i) {
+    if (b[i] == d_false) {
+      continue;
+    }
+    // Add (a << i) & b_i to the result (bits above i only)
+    lhs.assign(result.begin() + i, result.end());
+    rhs.resize(n - i);
+    for (size_t j = 0; j < n - i; ++ j) {
+      rhs[j] = mk_and(a[j], b[i]);
+    }
+    mk_add(lhs, rhs, d_false, sum, 0);
+    std::copy(sum.begin(), sum.end(), result.begin() + i);
+  }
+  out.swap(result);
+}
+
+void bit_blaster::mk_udiv_urem(const bits& a, const bits& b, bits* q, bits* r) {
+  assert(a.size() == b.size());
+  size_t n = a.size();
+
+  // Restoring division with an n+1 bit remainder. If b = 0 we subtract 0
+  // at each step, so q = 1...1 and r = a, as in expr::bitvector.
+  bits rem(n, d_false), quot(n), shifted(n + 1), not_b(n + 1), diff;
+  mk_not(b, not_b);
+  not_b.resize(n + 1);
+  not_b[n] = d_true;
+  for (size_t k = n; k > 0; -- k) {
+    size_t i = k - 1;
+    // shifted = (rem << 1) | a_i
+    shifted[0] = a[i];
+    std::copy(rem.begin(), rem.end(), shifted.begin() + 1);
+    // diff = shifted - b, geq = no borrow
+    lit geq;
+    mk_add(shifted, not_b, d_true, diff, &geq);
+    quot[i] = geq;
+    for (size_t j = 0; j < n; ++ j) {
+      rem[j] = mk_ite(geq, diff[j], shifted[j]);
+    }
+  }
+
+  if (q) q->swap(quot);
+  if (r) r->swap(rem);
+}
+
+void bit_blaster::mk_sdiv(const bits& a, const bits& b, bits& out) {
+  size_t n = a.size();
+  lit msb_a = a[n-1], msb_b = b[n-1];
+  bits neg_a, neg_b, abs_a, abs_b, q, neg_q;
+  mk_neg(a, neg_a);
+  mk_neg(b, neg_b);
+  mk_ite(msb_a, neg_a, a, abs_a);
+  mk_ite(msb_b, neg_b, b, abs_b);
+  mk_udiv_urem(abs_a, abs_b, &q, 0);
+  mk_neg(q, neg_q);
+  mk_ite(mk_xor(msb_a, msb_b), neg_q, q, out);
+}
+
+void bit_blaster::mk_srem(const bits& a, const bits& b, bits& out) {
+  size_t n = a.size();
+  lit msb_a = a[n-1], msb_b = b[n-1];
+  bits neg_a, neg_b, abs_a, abs_b, r, neg_r;
+  mk_neg(a, neg_a);
+  mk_neg(b, neg_b);
+  mk_ite(msb_a, neg_a, a, abs_a);
+  mk_ite(msb_b, neg_b, b, abs_b);
+  mk_udiv_urem(abs_a, abs_b, 0, &r);
+  mk_neg(r, neg_r);
+  mk_ite(msb_a, neg_r, r, out);
+}
+
+void bit_blaster::mk_smod(const bits& a, const bits& b, bits& out) {
+  size_t n = a.size();
+  lit msb_a = a[n-1], msb_b = b[n-1];
+  bits neg_a, neg_b, abs_a, abs_b, u, neg_u, neg_u_plus_b, u_plus_b, zero(n, d_false);
+  mk_neg(a, neg_a);
+  mk_neg(b, neg_b);
+  mk_ite(msb_a, neg_a, a, abs_a);
+  mk_ite(msb_b, neg_b, b, abs_b);
+  mk_udiv_urem(abs_a, abs_b, 0, &u);
+  mk_neg(u, neg_u);
+  mk_add(neg_u, b, d_false, neg_u_plus_b, 0);
+  mk_add(u, b, d_false, u_plus_b, 0);
+  // u = 0 or both positive => u
+  // a negative, b positive => -u + b
+  // a positive, b negative => u + b
+  // both negative => -u
+  bits a_neg_case, a_pos_case, signed_case;
+  mk_ite(msb_b, neg_u, neg_u_plus_b, a_neg_case);
+  mk_ite(msb_b, u_plus_b, u, a_pos_case);
+  mk_ite(msb_a, a_neg_case, a_pos_case, signed_case);
+  mk_ite(mk_eq(u, zero), u, signed_case, out);
+}
+
+void bit_blaster::mk_shift(shift_type type, const bits& a, const bits& s, bits& out) {
+  assert(a.size() == s.size());
+  size_t n = a.size();
+  lit fill = type == SHIFT_RIGHT_ARITHMETIC ? a[n-1] : d_false;
+
+  // Barrel shifter on the low bits of s
+  bits current(a), next(n);
+  size_t stage = 0;
+  for (; ((size_t) 1 << stage) < n; ++ stage) {
+    size_t amount = (size_t) 1 << stage;
+    for (size_t j = 0; j < n; ++ j) {
+      lit shifted;
+      if (type == SHIFT_LEFT) {
+        shifted = j >= amount ? current[j - amount] : fill;
+      } else {
+        shifted = j + amount < n ? current[j + amount] : fill;
+      }
+      next[j] = mk_ite(s[stage], shifted, current[j]);
+    }
+    current.swap(next);
+  }
+
+  // If any of the high bits of s is set, we shift everything out
+  bits high(s.begin() + stage, s.end());
+  lit overflow = mk_or(high);
+  out.resize(n);
+  for (size_t j = 0; j < n; ++ j) {
+    out[j] = mk_ite(overflow, fill, current[j]);
+  }
+}
+
+lit bit_blaster::mk_ult(const bits& a, const bits& b) {
+  assert(a.size() == b.size());
+  // From the least significant bit: if the bits differ, b decides
+  lit lt = d_false;
+  for (size_t i = 0; i < a.size(); ++ i) {
+    lt = mk_ite(mk_xor(a[i], b[i]), b[i], lt);
+  }
+  return lt;
+}
+
+lit bit_blaster::mk_slt(const bits& a, const bits& b) {
+  // Flip the sign bits and compare unsigned
+  bits a_flip(a), b_flip(b);
+  a_flip.back() = ~a_flip.back();
+  b_flip.back() = ~b_flip.back();
+  return mk_ult(a_flip, b_flip);
+}
+
+/** Visitor that translates the terms bottom-up */
+class bit_blaster_visitor {
+
+  expr::term_manager& d_tm;
+  bit_blaster& d_bb;
+
+public:
+
+  bit_blaster_visitor(expr::term_manager& tm, bit_blaster& bb)
+  : d_tm(tm), d_bb(bb) {}
+
+  // Visit the terms that are not translated yet, but don't go into variables
+  expr::visitor_match_result match(expr::term_ref t) {
+    if (d_bb.is_cached(t)) {
+      return expr::DONT_VISIT_AND_BREAK;
+    }
+    if (d_tm.term_of(t).op() == expr::VARIABLE) {
+      return expr::VISIT_AND_BREAK;
+    }
+    return expr::VISIT_AND_CONTINUE;
+  }
+
+  void visit(expr::term_ref t) {
+    d_bb.visit(t);
+  }
+};
+
+lit bit_blaster::blast_formula(expr::term_ref f) {
+  const bits& f_bits = blast(f);
+  assert(f_bits.size() == 1);
+  return f_bits[0];
+}
+
+const bit_blaster::bits& bit_blaster::blast(expr::term_ref t) {
+  if (!is_cached(t)) {
+    bit_blaster_visitor visitor(d_tm, *this);
+    expr::term_traversal traversal(d_tm);
+    traversal.run(visitor, t);
+  }
+  return get_bits(t);
+}
+
+void bit_blaster::visit(expr::term_ref t) {
+
+  const expr::term& t_term = d_tm.term_of(t);
+  expr::term_op op = t_term.op();
+  size_t t_size = t_term.size();
+
+  bits result;
+
+  switch (op) {
+  case expr::VARIABLE: {
+    expr::term_ref type = d_tm.base_type_of(t);
+    if (d_tm.is_boolean_type(type)) {
+      mk_fresh(1, result);
+    } else if (d_tm.is_bitvector_type(type)) {
+      mk_fresh(d_tm.get_bitvector_type_size(type), result);
+    } else {
+      std::stringstream ss;
+      ss << expr::set_tm(d_tm) << "bitblast: variable " << t << " is not Boolean or bit-vector";
+      throw exception(ss.str());
+    }
+    d_variables.push_back(t);
+    break;
+  }
+  case expr::CONST_BOOL:
+    result.push_back(d_tm.get_boolean_constant(t_term) ? d_true : d_false);
+    break;
+  case expr::CONST_BITVECTOR:
+    mk_constant(d_tm.get_bitvector_constant(t_term), result);
+    break;
+  case expr::TERM_ITE:
+    mk_ite(get_bits(t_term[0])[0], get_bits(t_term[1]), get_bits(t_term[2]), result);
+    break;
+  case expr::TERM_EQ:
+    result.push_back(mk_eq(get_bits(t_term[0]), get_bits(t_term[1])));
+    break;
+  case expr::TERM_AND: {
+    lit r = d_true;
+    for (size_t i = 0; i < t_size; ++ i) {
+      r = mk_and(r, get_bits(t_term[i])[0]);
+    }
+    result.push_back(r);
+    break;
+  }
+  case expr::TERM_OR: {
+    lit r = d_false;
+    for (size_t i = 0; i < t_size; ++ i) {
+      r = mk_or(r, get_bits(t_term[i])[0]);
+    }
+    result.push_back(r);
+    break;
+  }
+  case expr::TERM_NOT:
+    result.push_back(~get_bits(t_term[0])[0]);
+    break;
+  case expr::TERM_IMPLIES:
+    result.push_back(mk_or(~get_bits(t_term[0])[0], get_bits(t_term[1])[0]));
+    break;
+  case expr::TERM_XOR: {
+    lit r = d_false;
+    for (size_t i = 0; i < t_size; ++ i) {
+      r = mk_xor(r, get_bits(t_term[i])[0]);
+    }
+    result.push_back(r);
+    break;
+  }
+  case expr::TERM_BV_ADD: {
+    result = get_bits(t_term[0]);
+    bits sum;
+    for (size_t i = 1; i < t_size; ++ i) {
+      mk_add(result, get_bits(t_term[i]), d_false, sum, 0);
+      result.swap(sum);
+    }
+    break;
+  }
+  case expr::TERM_BV_SUB:
+    if (t_size == 1) {
+      mk_neg(get_bits(t_term[0]), result);
+    } else {
+      bits not_b;
+      mk_not(get_bits(t_term[1]), not_b);
+      mk_add(get_bits(t_term[0]), not_b, d_true, result, 0);
+    }
+    break;
+  case expr::TERM_BV_NEG:
+    mk_neg(get_bits(t_term[0]), result);
+    break;
+  case expr::TERM_BV_MUL: {
+    result = get_bits(t_term[0]);
+    bits product;
+    for (size_t i = 1; i < t_size; ++ i) {
+      mk_mul(result, get_bits(t_term[i]), product);
+      result.swap(product);
+    }
+    break;
+  }
+  case expr::TERM_BV_UDIV:
+    mk_udiv_urem(get_bits(t_term[0]), get_bits(t_term[1]), &result, 0);
+    break;
+  case expr::TERM_BV_UREM:
+    mk_udiv_urem(get_bits(t_term[0]), get_bits(t_term[1]), 0, &result);
+    break;
+  case expr::TERM_BV_SDIV:
+    mk_sdiv(get_bits(t_term[0]), get_bits(t_term[1]), result);
+    break;
+  case expr::TERM_BV_SREM:
+    mk_srem(get_bits(t_term[0]), get_bits(t_term[1]), result);
+    break;
+  case expr::TERM_BV_SMOD:
+    mk_smod(get_bits(t_term[0]), get_bits(t_term[1]), result);
+    break;
+  case expr::TERM_BV_SHL:
+    mk_shift(SHIFT_LEFT, get_bits(t_term[0]), get_bits(t_term[1]), result);
+    break;
+  case expr::TERM_BV_LSHR:
+    mk_shift(SHIFT_RIGHT_LOGICAL, get_bits(t_term[0]), get_bits(t_term[1]), result);
+    break;
+  case expr::TERM_BV_ASHR:
+    mk_shift(SHIFT_RIGHT_ARITHMETIC, get_bits(t_term[0]), get_bits(t_term[1]), result);
+    break;
+  case expr::TERM_BV_NOT:
+    mk_not(get_bits(t_term[0]), result);
+    break;
+  case expr::TERM_BV_AND:
+  case expr::TERM_BV_OR:
+  case expr::TERM_BV_XOR:
+  case expr::TERM_BV_NAND:
+  case expr::TERM_BV_NOR:
+  case expr::TERM_BV_XNOR: {
+    result = get_bits(t_term[0]);
+    for (size_t i = 1; i < t_size; ++ i) {
+      const bits& child = get_bits(t_term[i]);
+      for (size_t j = 0; j < result.size(); ++ j) {
+        switch (op) {
+        case expr::TERM_BV_AND:
+        case expr::TERM_BV_NAND:
+          result[j] = mk_and(result[j], child[j]);
+          break;
+        case expr::TERM_BV_OR:
+        case expr::TERM_BV_NOR:
+          result[j] = mk_or(result[j], child[j]);
+          break;
+        default:
+          result[j] = mk_xor(result[j], child[j]);
+        }
+      }
+    }
+    if (op == expr::TERM_BV_NAND || op == expr::TERM_BV_NOR || op == expr::TERM_BV_XNOR) {
+      bits negated;
+      mk_not(result, negated);
+      result.swap(negated);
+    }
+    break;
+  }
+  case expr::TERM_BV_CONCAT:
+    // First child is the most significant
+    for (size_t i = t_size; i > 0; -- i) {
+      const bits& child = get_bits(t_term[i-1]);
+      result.insert(result.end(), child.begin(), child.end());
+    }
+    break;
+  case expr::TERM_BV_EXTRACT: {
+    expr::bitvector_extract extract = d_tm.get_bitvector_extract(t_term);
+    const bits& child = get_bits(t_term[0]);
+    result.assign(child.begin() + extract.low, child.begin() + extract.high + 1);
+    break;
+  }
+  case expr::TERM_BV_SGN_EXTEND:
+  case expr::TERM_BV_EXTEND: {
+    expr::bitvector_sgn_extend extend = d_tm.get_bitvector_sgn_extend(t_term);
+    result = get_bits(t_term[0]);
+    lit fill = op == expr::TERM_BV_SGN_EXTEND ? result.back() : d_false;
+    result.insert(result.end(), extend.size, fill);
+    break;
+  }
+  case expr::TERM_BV_ULEQ:
+    result.push_back(~mk_ult(get_bits(t_term[1]), get_bits(t_term[0])));
+    break;
+  case expr::TERM_BV_ULT:
+    result.push_back(mk_ult(get_bits(t_term[0]), get_bits(t_term[1])));
+    break;
+  case expr::TERM_BV_UGEQ:
+    result.push_back(~mk_ult(get_bits(t_term[0]), get_bits(t_term[1])));
+    break;
+  case expr::TERM_BV_UGT:
+    result.push_back(mk_ult(get_bits(t_term[1]), get_bits(t_term[0])));
+    break;
+  case expr::TERM_BV_SLEQ:
+    result.push_back(~mk_slt(get_bits(t_term[1]), get_bits(t_term[0])));
+    break;
+  case expr::TERM_BV_SLT:
+    result.push_back(mk_slt(get_bits(t_term[0]), get_bits(t_term[1])));
+    break;
+  case expr::TERM_BV_SGEQ:
+    result.push_back(~mk_slt(get_bits(t_term[0]), get_bits(t_term[1])));
+    break;
+  case expr::TERM_BV_SGT:
+    result.push_back(mk_slt(get_bits(t_term[1]), get_bits(t_term[0])));
+    break;
+  default: {
+    std::stringstream ss;
+    ss << expr::set_tm(d_tm) << "bitblast: unsupported term " << t;
+    throw exception(ss.str());
+  }
+  }
+
+  TRACE("bitblast") << "bitblast: " << t << " -> " << result.size() << " bits" << std::endl;
+
+  d_cache[t].swap(result);
+}
+
+expr::value bit_blaster::get_value(expr::term_ref var) const {
+  const bits& var_bits = get_bits(var);
+  if (d_tm.is_boolean_type(d_tm.base_type_of(var))) {
+    return expr::value(d_sat.model_value(var_bits[0]) == sat::L_TRUE);
+  } else {
+    expr::bitvector bv(var_bits.size());
+    for (size_t i = 0; i < var_bits.size(); ++ i) {
+      if (d_sat.model_value(var_bits[i]) == sat::L_TRUE) {
+        bv.set_bit(i, true);
+      }
+    }
+    return expr::value(bv);
+  }
+}
+
+void bit_blaster::gc_collect(const expr::gc_relocator& gc_reloc) {
+  // The clauses stay, we just forget about the collected terms
+  term_cache cache;
+  for (term_cache::iterator it = d_cache.begin(); it != d_cache.end(); ++ it) {
+    expr::term_ref t = it->first;
+    if (gc_reloc.reloc(t)) {
+      cache[t].swap(it->second);
+    }
+  }
+  d_cache.swap(cache);
+  gc_reloc.reloc(d_variables);
+}
+
+size_t bit_blaster::memory_size() const {
+  // Hash nodes have the pair and two pointers
+  size_t size = d_cache.bucket_count()*sizeof(void*) + d_gates.bucket_count()*sizeof(void*);
+  size += d_gates.size()*(sizeof(gate_cache::value_type) + 2*sizeof(void*));
+  term_cache::const_iterator it = d_cache.begin();
+  for (; it != d_cache.end(); ++ it) {
+    size += sizeof(term_cache::value_type) + 2*sizeof(void*) + utils::memory_of(it->second);
+  }
+  return size + utils::memory_of(d_variables);
+}
+
+}
+}
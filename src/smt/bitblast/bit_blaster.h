@@ -0,0 +1,187 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "smt/bitblast/sat_solver.h"
+#include "expr/term_manager.h"
+#include "expr/gc_relocator.h"
+#include "expr/value.h"
+
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+namespace sally {
+namespace smt {
+
+/**
+ * Translation of Boolean and bit-vector terms into clauses of a SAT solver.
+ * Each term is translated to a vector of literals (least significant bit
+ * first, Booleans have one bit) with a Tseitin encoding that fully defines
+ * the gate outputs. Since the definitions are equivalences, any formula can
+ * be asserted by assuming its literal, and retracted by not assuming it.
+ *
+ * The gates are folded on constants and hashed structurally, so the same
+ * gate is never encoded twice. The semantics of the operations follow
+ * expr::bitvector (e.g. x/0 = 1...1 and x%0 = x).
+ */
+class bit_blaster {
+
+public:
+
+  /** Bits of a term */
+  typedef std::vector<sat::lit> bits;
+
+  bit_blaster(expr::term_manager& tm, sat::sat_solver& sat);
+
+  /** Get the literal of a Boolean term */
+  sat::lit blast_formula(expr::term_ref f);
+
+  /** Get the bits of a term */
+  const bits& blast(expr::term_ref t);
+
+  /** The variables translated so far */
+  const std::vector<expr::term_ref>& get_variables() const { return d_variables; }
+
+  /** Get the value of a translated variable in the current SAT model */
+  expr::value get_value(expr::term_ref var) const;
+
+  /** Relocate the cache, removing the collected terms */
+  void gc_collect(const expr::gc_relocator& gc_reloc);
+
+  /** Bytes of memory used by the term and gate caches */
+  size_t memory_size() const;
+
+  /** The true literal */
+  sat::lit get_true() const { return d_true; }
+
+  /** Number of gates created */
+  size_t gates() const { return d_gates.size(); }
+
+  /** Translate the term once the children are translated (called by visitor) */
+  void visit(expr::term_ref t);
+
+  /** Is the term already translated */
+  bool is_cached(expr::term_ref t) const { return d_cache.find(t) != d_cache.end(); }
+
+private:
+
+  /** Term manager */
+  expr::term_manager& d_tm;
+
+  /** The SAT solver */
+  sat::sat_solver& d_sat;
+
+  /** True literal */
+  sat::lit d_true;
+
+  /** False literal */
+  sat::lit d_false;
+
+  typedef boost::unordered_map<expr::term_ref, bits, expr::term_ref_hasher> term_cache;
+
+  /** Cache of translated terms */
+  term_cache d_cache;
+
+  /** Translated variables */
+  std::vector<expr::term_ref> d_variables;
+
+  enum gate_op {
+    GATE_AND,
+    GATE_XOR,
+    GATE_ITE
+  };
+
+  /** Key for structural hashing of gates */
+  struct gate {
+    gate_op op;
+    uint32_t a, b, c;
+    gate(gate_op op, sat::lit a, sat::lit b, sat::lit c = sat::lit())
+    : op(op), a(a.index()), b(b.index()), c(c.index()) {}
+    bool operator == (const gate& other) const {
+      return op == other.op && a == other.a && b == other.b && c == other.c;
+    }
+  };
+
+  struct gate_hasher {
+    size_t operator () (const gate& g) const;
+  };
+
+  typedef boost::unordered_map<gate, sat::lit, gate_hasher> gate_cache;
+
+  /** Existing gates */
+  gate_cache d_gates;
+
+  /** Get the bits of a child that has already been translated */
+  const bits& get_bits(expr::term_ref t) const;
+
+  /** Make fresh bits */
+  void mk_fresh(size_t size, bits& out);
+
+  /** Make constant bits */
+  void mk_constant(const expr::bitvector& bv, bits& out);
+
+  /** Boolean gates */
+  sat::lit mk_and(sat::lit a, sat::lit b);
+  sat::lit mk_or(sat::lit a, sat::lit b);
+  sat::lit mk_xor(sat::lit a, sat::lit b);
+  sat::lit mk_ite(sat::lit c, sat::lit t, sat::lit e);
+  sat::lit mk_and(const bits& a);
+  sat::lit mk_or(const bits& a);
+
+  /** Bitwise operations */
+  void mk_not(const bits& a, bits& out);
+  void mk_ite(sat::lit c, const bits& t, const bits& e, bits& out);
+
+  /** Equality */
+  sat::lit mk_eq(const bits& a, const bits& b);
+
+  /** Addition with carry in (and out if not null) */
+  void mk_add(const bits& a, const bits& b, sat::lit cin, bits& out, sat::lit* cout);
+
+  /** Negation */
+  void mk_neg(const bits& a, bits& out);
+
+  /** Multiplication */
+  void mk_mul(const bits& a, const bits& b, bits& out);
+
+  /** Unsigned division and remainder */
+  void mk_udiv_urem(const bits& a, const bits& b, bits* q, bits* r);
+
+  /** Signed division, remainder and modulo */
+  void mk_sdiv(const bits& a, const bits& b, bits& out);
+  void mk_srem(const bits& a, const bits& b, bits& out);
+  void mk_smod(const bits& a, const bits& b, bits& out);
+
+  /** Shifts */
+  enum shift_type {
+    SHIFT_LEFT,
+    SHIFT_RIGHT_LOGICAL,
+    SHIFT_RIGHT_ARITHMETIC
+  };
+  void mk_shift(shift_type type, const bits& a, const bits& s, bits& out);
+
+  /** Unsigned less than */
+  sat::lit mk_ult(const bits& a, const bits& b);
+
+  /** Signed less than */
+  sat::lit mk_slt(const bits& a, const bits& b);
+};
+
+}
+}
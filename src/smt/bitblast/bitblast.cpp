@@ -0,0 +1,197 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "smt/bitblast/bitblast.h"
+#include "utils/trace.h"
+
+#include <set>
+#include <sstream>
+#include <cassert>
+
+namespace sally {
+namespace smt {
+
+bitblast::bitblast(expr::term_manager& tm, const options& opts, utils::statistics& stats)
+: solver("bitblast", tm, opts, stats)
+, d_bb(tm, d_sat)
+, d_last_result(UNKNOWN)
+{
+  d_stats.checks = static_cast<utils::stat_int*>(stats.register_stat("smt::bitblast::checks"));
+  d_stats.sat_vars = static_cast<utils::stat_int*>(stats.register_stat("smt::bitblast::sat_vars"));
+  d_stats.sat_clauses = static_cast<utils::stat_int*>(stats.register_stat("smt::bitblast::sat_clauses"));
+  d_stats.conflicts = static_cast<utils::stat_int*>(stats.register_stat("smt::bitblast::conflicts"));
+  d_stats.decisions = static_cast<utils::stat_int*>(stats.register_stat("smt::bitblast::decisions"));
+}
+
+bitblast::~bitblast() {
+}
+
+bool bitblast::supports(feature f) const {
+  switch (f) {
+  case UNSAT_CORE:
+  case CONCURRENT_CHECK:
+    return true;
+  default:
+    return false;
+  }
+}
+
+void bitblast::add(expr::term_ref f, formula_class f_class) {
+  TRACE("bitblast") << "bitblast: adding " << f << std::endl;
+  d_assertions.push_back(f);
+  d_assumptions.push_back(d_bb.blast_formula(f));
+}
+
+solver::result bitblast::check() {
+
+  TRACE("bitblast") << "bitblast: check()" << std::endl;
+
+  size_t vars = d_sat.num_vars();
+  size_t clauses = d_sat.num_clauses();
+  sat::sat_solver::stats before = d_sat.get_stats();
+
+  switch (d_sat.solve(d_assumptions)) {
+  case sat::sat_solver::SAT:
+    d_last_result = SAT;
+    break;
+  case sat::sat_solver::UNSAT:
+    d_last_result = UNSAT;
+    break;
+  default:
+    d_last_result = UNKNOWN;
+  }
+
+  const sat::sat_solver::stats& after = d_sat.get_stats();
+  d_stats.checks->increment();
+  d_stats.sat_vars->add(d_sat.num_vars() - vars);
+  d_stats.sat_clauses->add(d_sat.num_clauses() - clauses);
+  d_stats.conflicts->add(after.conflicts - before.conflicts);
+  d_stats.decisions->add(after.decisions - before.decisions);
+
+  TRACE("bitblast") << "bitblast: " << d_last_result << " (" << d_sat.num_vars() << " vars, " << d_sat.num_clauses() << " clauses)" << std::endl;
+
+  return d_last_result;
+}
+
+void bitblast::check_model() {
+  assert(d_last_result == SAT);
+  expr::model::ref m = get_model();
+  for (size_t i = 0; i < d_assertions.size(); ++ i) {
+    if (!m->is_true(d_assertions[i])) {
+      std::stringstream ss;
+      ss << expr::set_tm(d_tm) << "bitblast: model does not satisfy " << d_assertions[i];
+      throw exception(ss.str());
+    }
+  }
+}
+
+expr::model::ref bitblast::get_model() const {
+  assert(d_last_result == SAT);
+
+  expr::model::ref m = new expr::model(d_tm, false);
+
+  // Values of the translated variables
+  const std::vector<expr::term_ref>& variables = d_bb.get_variables();
+  for (size_t i = 0; i < variables.size(); ++ i) {
+    m->set_variable_value(variables[i], d_bb.get_value(variables[i]));
+  }
+
+  // Variables not in the assertions get the default value
+  const std::set<expr::term_ref>* classes[3] = { &d_A_variables, &d_B_variables, &d_T_variables };
+  for (size_t k = 0; k < 3; ++ k) {
+    std::set<expr::term_ref>::const_iterator it = classes[k]->begin();
+    for (; it != classes[k]->end(); ++ it) {
+      if (!m->has_value(*it)) {
+        expr::term_ref type = d_tm.base_type_of(*it);
+        if (d_tm.is_boolean_type(type)) {
+          m->set_variable_value(*it, expr::value(false));
+        } else if (d_tm.is_bitvector_type(type)) {
+          m->set_variable_value(*it, expr::value(expr::bitvector(d_tm.get_bitvector_type_size(type))));
+        }
+      }
+    }
+  }
+
+  return m;
+}
+
+void bitblast::push() {
+  TRACE("bitblast") << "bitblast: push()" << std::endl;
+  d_assertions_size.push_back(d_assertions.size());
+}
+
+void bitblast::pop() {
+  TRACE("bitblast") << "bitblast: pop()" << std::endl;
+  // The definitions stay in the SAT solver, we just don't assume them
+  size_t size = d_assertions_size.back();
+  d_assertions_size.pop_back();
+  d_assertions.resize(size);
+  d_assumptions.resize(size);
+}
+
+void bitblast::get_unsat_core(std::vector<expr::term_ref>& out) {
+  assert(d_last_result == UNSAT);
+
+  const std::vector<sat::lit>& failed = d_sat.get_failed_assumptions();
+  if (failed.empty()) {
+    // Unsat without assumptions, everything is in
+    out.insert(out.end(), d_assertions.begin(), d_assertions.end());
+    return;
+  }
+
+  std::set<sat::lit> failed_set(failed.begin(), failed.end());
+  std::set<expr::term_ref> added;
+  for (size_t i = 0; i < d_assertions.size(); ++ i) {
+    if (failed_set.count(d_assumptions[i]) && !added.count(d_assertions[i])) {
+      added.insert(d_assertions[i]);
+      out.push_back(d_assertions[i]);
+    }
+  }
+}
+
+void bitblast::set_hint(expr::model::ref m) {
+  const std::vector<expr::term_ref>& variables = d_bb.get_variables();
+  for (size_t i = 0; i < variables.size(); ++ i) {
+    expr::term_ref x = variables[i];
+    if (!m->has_value(x)) {
+      continue;
+    }
+    const bit_blaster::bits& x_bits = d_bb.blast(x);
+    expr::value v = m->get_variable_value(x);
+    for (size_t j = 0; j < x_bits.size(); ++ j) {
+      bool bit = v.is_bool() ? v.get_bool() : v.get_bitvector().get_bit(j);
+      d_sat.set_phase(x_bits[j].get_var(), bit != x_bits[j].is_negative());
+    }
+  }
+}
+
+void bitblast::gc_collect(const expr::gc_relocator& gc_reloc) {
+  solver::gc_collect(gc_reloc);
+  for (size_t i = 0; i < d_assertions.size(); ++ i) {
+    gc_reloc.reloc(d_assertions[i]);
+  }
+  d_bb.gc_collect(gc_reloc);
+}
+
+void bitblast::memory_usage(utils::memory_report& report) const {
+  report.add("smt::bitblast::sat", d_sat.memory_size());
+  report.add("smt::bitblast::cache", d_bb.memory_size());
+}
+
+}
+}
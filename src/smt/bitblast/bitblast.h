@@ -0,0 +1,111 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "smt/solver.h"
+#include "smt/bitblast/sat_solver.h"
+#include "smt/bitblast/bit_blaster.h"
+
+#include <vector>
+
+namespace sally {
+namespace smt {
+
+/**
+ * A built-in solver for Boolean and bit-vector problems. Formulas are
+ * bit-blasted into an incremental CDCL SAT solver. Each assertion is
+ * represented by the literal of its definition and is passed to the SAT
+ * solver as an assumption, so push/pop only needs to drop literals and the
+ * unsat core is the set of failed assumptions. Formulas are bit-blasted when
+ * added, so check() only runs the SAT solver of the instance and instances
+ * can be checked concurrently.
+ */
+class bitblast : public solver {
+
+  /** The SAT solver */
+  sat::sat_solver d_sat;
+
+  /** The bit-blaster */
+  bit_blaster d_bb;
+
+  /** The assertions */
+  std::vector<expr::term_ref> d_assertions;
+
+  /** Literals of the assertions (the assumptions) */
+  std::vector<sat::lit> d_assumptions;
+
+  /** Assertion sizes per push */
+  std::vector<size_t> d_assertions_size;
+
+  /** Result of the last check */
+  result d_last_result;
+
+  struct stats {
+    utils::stat_int* checks;
+    utils::stat_int* sat_vars;
+    utils::stat_int* sat_clauses;
+    utils::stat_int* conflicts;
+    utils::stat_int* decisions;
+  } d_stats;
+
+public:
+
+  /** Constructor */
+  bitblast(expr::term_manager& tm, const options& opts, utils::statistics& stats);
+
+  /** Destructor */
+  ~bitblast();
+
+  /** Features */
+  bool supports(feature f) const;
+
+  /** Add an assertion f to the solver */
+  void add(expr::term_ref f, formula_class f_class);
+
+  /** Check the assertions for satisfiability */
+  result check();
+
+  /** Check the model against the assertions */
+  void check_model();
+
+  /** Get the model */
+  expr::model::ref get_model() const;
+
+  /** Push the solving context */
+  void push();
+
+  /** Pop the solving context */
+  void pop();
+
+  /** Get the assertions used to derive unsat */
+  void get_unsat_core(std::vector<expr::term_ref>& out);
+
+  /** Use the values of the model as the preferred phases */
+  void set_hint(expr::model::ref m);
+
+  /** Collect terms */
+  void gc_collect(const expr::gc_relocator& gc_reloc);
+
+  /** The SAT solver and the bit-blaster caches */
+  void memory_usage(utils::memory_report& report) const;
+
+};
+
+}
+}
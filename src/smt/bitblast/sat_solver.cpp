@@ -0,0 +1,753 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "smt/bitblast/sat_solver.h"
+
+#include <cmath>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+namespace sally {
+namespace smt {
+namespace sat {
+
+/** Decay of variable activities */
+static const double VAR_DECAY = 0.95;
+
+/** Decay of clause activities */
+static const double CLAUSE_DECAY = 0.999;
+
+/** Conflicts in the first restart */
+static const double RESTART_FIRST = 100;
+
+const sat_solver::cref sat_solver::CREF_NULL;
+
+sat_solver::stats::stats()
+: decisions(0)
+, propagations(0)
+, conflicts(0)
+, restarts(0)
+, learnt_literals(0)
+, deleted_clauses(0)
+{}
+
+sat_solver::sat_solver()
+: d_arena_wasted(0)
+, d_var_inc(1)
+, d_clause_inc(1)
+, d_qhead(0)
+, d_ok(true)
+, d_simplify_trail(0)
+, d_max_learnts(0)
+{}
+
+var sat_solver::new_var() {
+  var v = d_assign.size();
+  d_assign.push_back(L_UNDEF);
+  d_level.push_back(0);
+  d_reason.push_back(CREF_NULL);
+  d_phase.push_back(0);
+  d_seen.push_back(0);
+  d_activity.push_back(0);
+  d_heap_index.push_back(-1);
+  d_watches.push_back(std::vector<watch>());
+  d_watches.push_back(std::vector<watch>());
+  heap_insert(v);
+  return v;
+}
+
+lbool sat_solver::model_value(lit l) const {
+  lbool v = model_value(l.get_var());
+  if (v == L_UNDEF) {
+    return L_UNDEF;
+  }
+  return (lbool) (v ^ (uint8_t) l.is_negative());
+}
+
+float sat_solver::clause_activity(cref c) const {
+  uint32_t bits = d_arena[c+2].index();
+  float a;
+  std::memcpy(&a, &bits, sizeof(float));
+  return a;
+}
+
+void sat_solver::clause_set_activity(cref c, float a) {
+  uint32_t bits;
+  std::memcpy(&bits, &a, sizeof(float));
+  d_arena[c+2] = lit::from_index(bits);
+}
+
+sat_solver::cref sat_solver::alloc_clause(const std::vector<lit>& lits, bool learnt) {
+  cref c = d_arena.size();
+  d_arena.push_back(lit::from_index(lits.size()));
+  d_arena.push_back(lit::from_index(learnt ? FLAG_LEARNT : 0));
+  d_arena.push_back(lit::from_index(0));
+  clause_set_activity(c, 0);
+  d_arena.insert(d_arena.end(), lits.begin(), lits.end());
+  return c;
+}
+
+void sat_solver::attach_clause(cref c) {
+  assert(clause_size(c) >= 2);
+  lit* lits = clause_lits(c);
+  d_watches[lits[0].index()].push_back(watch(c, lits[1]));
+  d_watches[lits[1].index()].push_back(watch(c, lits[0]));
+}
+
+void sat_solver::remove_clause(cref c) {
+  assert(!clause_deleted(c));
+  d_arena[c+1] = lit::from_index(d_arena[c+1].index() | FLAG_DELETED);
+  d_arena_wasted += clause_size(c) + HEADER_SIZE;
+  d_stats.deleted_clauses ++;
+}
+
+void sat_solver::clean_watches() {
+  for (size_t l = 0; l < d_watches.size(); ++ l) {
+    std::vector<watch>& ws = d_watches[l];
+    size_t j = 0;
+    for (size_t i = 0; i < ws.size(); ++ i) {
+      if (!clause_deleted(ws[i].c)) {
+        ws[j++] = ws[i];
+      }
+    }
+    ws.resize(j);
+  }
+}
+
+bool sat_solver::is_locked(cref c) {
+  lit first = clause_lits(c)[0];
+  return value(first) == L_TRUE && d_reason[first.get_var()] == c;
+}
+
+void sat_solver::collect_garbage() {
+  // Only at level 0, where no reasons are needed
+  assert(decision_level() == 0);
+  std::vector<lit> arena;
+  arena.reserve(d_arena.size() - d_arena_wasted);
+  std::vector<cref>* lists[2] = { &d_clauses, &d_learnts };
+  for (size_t k = 0; k < 2; ++ k) {
+    std::vector<cref>& list = *lists[k];
+    for (size_t i = 0; i < list.size(); ++ i) {
+      cref c = list[i];
+      cref c_new = arena.size();
+      arena.insert(arena.end(), d_arena.begin() + c, d_arena.begin() + c + HEADER_SIZE + clause_size(c));
+      // Keep the forwarding address in the old activity
+      d_arena[c+2] = lit::from_index(c_new);
+      list[i] = c_new;
+    }
+  }
+  for (size_t l = 0; l < d_watches.size(); ++ l) {
+    std::vector<watch>& ws = d_watches[l];
+    for (size_t i = 0; i < ws.size(); ++ i) {
+      ws[i].c = d_arena[ws[i].c + 2].index();
+    }
+  }
+  d_arena.swap(arena);
+  d_arena_wasted = 0;
+}
+
+void sat_solver::enqueue(lit l, cref reason) {
+  var v = l.get_var();
+  assert(d_assign[v] == L_UNDEF);
+  d_assign[v] = l.is_negative() ? L_FALSE : L_TRUE;
+  d_level[v] = decision_level();
+  d_reason[v] = reason;
+  d_trail.push_back(l);
+}
+
+bool sat_solver::add_clause(lit a) {
+  std::vector<lit> clause(1, a);
+  return add_clause(clause);
+}
+
+bool sat_solver::add_clause(lit a, lit b) {
+  std::vector<lit> clause;
+  clause.push_back(a);
+  clause.push_back(b);
+  return add_clause(clause);
+}
+
+bool sat_solver::add_clause(lit a, lit b, lit c) {
+  std::vector<lit> clause;
+  clause.push_back(a);
+  clause.push_back(b);
+  clause.push_back(c);
+  return add_clause(clause);
+}
+
+bool sat_solver::add_clause(const std::vector<lit>& clause) {
+  assert(decision_level() == 0);
+
+  if (!d_ok) {
+    return false;
+  }
+
+  // Sort, remove duplicates, false literals, and check for true ones
+  d_learnt_tmp = clause;
+  std::sort(d_learnt_tmp.begin(), d_learnt_tmp.end());
+  size_t j = 0;
+  lit prev;
+  for (size_t i = 0; i < d_learnt_tmp.size(); ++ i) {
+    lit l = d_learnt_tmp[i];
+    assert(l.get_var() < num_vars());
+    if (value(l) == L_TRUE || l == ~prev) {
+      return true;
+    }
+    if (value(l) != L_FALSE && l != prev) {
+      d_learnt_tmp[j++] = prev = l;
+    }
+  }
+  d_learnt_tmp.resize(j);
+
+  switch (d_learnt_tmp.size()) {
+  case 0:
+    d_ok = false;
+    break;
+  case 1:
+    enqueue(d_learnt_tmp[0], CREF_NULL);
+    d_ok = propagate() == CREF_NULL;
+    break;
+  default: {
+    cref c = alloc_clause(d_learnt_tmp, false);
+    d_clauses.push_back(c);
+    attach_clause(c);
+  }
+  }
+
+  return d_ok;
+}
+
+sat_solver::cref sat_solver::propagate() {
+  cref conflict = CREF_NULL;
+  while (d_qhead < d_trail.size()) {
+    lit false_lit = ~d_trail[d_qhead++];
+    d_stats.propagations ++;
+    std::vector<watch>& ws = d_watches[false_lit.index()];
+    size_t i = 0, j = 0, n = ws.size();
+    while (i < n) {
+      // Skip if the blocker is true
+      lit blocker = ws[i].blocker;
+      if (value(blocker) == L_TRUE) {
+        ws[j++] = ws[i++];
+        continue;
+      }
+      // Make sure the false literal is at position 1
+      cref c = ws[i].c;
+      lit* lits = clause_lits(c);
+      if (lits[0] == false_lit) {
+        lits[0] = lits[1];
+        lits[1] = false_lit;
+      }
+      i ++;
+      // If the other watch is true, we're done
+      lit first = lits[0];
+      watch w(c, first);
+      if (first != blocker && value(first) == L_TRUE) {
+        ws[j++] = w;
+        continue;
+      }
+      // Look for a new watch
+      uint32_t size = clause_size(c);
+      bool found = false;
+      for (uint32_t k = 2; k < size; ++ k) {
+        if (value(lits[k]) != L_FALSE) {
+          lits[1] = lits[k];
+          lits[k] = false_lit;
+          d_watches[lits[1].index()].push_back(w);
+          found = true;
+          break;
+        }
+      }
+      if (found) {
+        continue;
+      }
+      // Unit or conflict
+      ws[j++] = w;
+      if (value(first) == L_FALSE) {
+        conflict = c;
+        d_qhead = d_trail.size();
+        while (i < n) {
+          ws[j++] = ws[i++];
+        }
+      } else {
+        enqueue(first, c);
+      }
+    }
+    ws.resize(j);
+  }
+  return conflict;
+}
+
+bool sat_solver::is_redundant(lit l) {
+  cref r = d_reason[l.get_var()];
+  if (r == CREF_NULL) {
+    return false;
+  }
+  // Local minimization: all the antecedents are already in the clause
+  lit* lits = clause_lits(r);
+  uint32_t size = clause_size(r);
+  for (uint32_t k = 1; k < size; ++ k) {
+    var v = lits[k].get_var();
+    if (!d_seen[v] && d_level[v] > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t sat_solver::analyze(cref conflict) {
+
+  int path_count = 0;
+  lit p;
+  d_learnt_tmp.clear();
+  d_learnt_tmp.push_back(lit());
+  size_t index = d_trail.size();
+
+  do {
+    assert(conflict != CREF_NULL);
+    if (clause_learnt(conflict)) {
+      clause_bump(conflict);
+    }
+    lit* lits = clause_lits(conflict);
+    uint32_t size = clause_size(conflict);
+    for (uint32_t k = p.is_null() ? 0 : 1; k < size; ++ k) {
+      lit q = lits[k];
+      var v = q.get_var();
+      if (!d_seen[v] && d_level[v] > 0) {
+        var_bump(v);
+        d_seen[v] = 1;
+        if (d_level[v] >= decision_level()) {
+          path_count ++;
+        } else {
+          d_learnt_tmp.push_back(q);
+        }
+      }
+    }
+    // Next literal to look at
+    while (!d_seen[d_trail[-- index].get_var()]);
+    p = d_trail[index];
+    conflict = d_reason[p.get_var()];
+    d_seen[p.get_var()] = 0;
+    path_count --;
+  } while (path_count > 0);
+  d_learnt_tmp[0] = ~p;
+
+  // Minimize
+  d_to_clear.clear();
+  for (size_t k = 1; k < d_learnt_tmp.size(); ++ k) {
+    d_to_clear.push_back(d_learnt_tmp[k].get_var());
+  }
+  size_t j = 1;
+  for (size_t k = 1; k < d_learnt_tmp.size(); ++ k) {
+    if (!is_redundant(d_learnt_tmp[k])) {
+      d_learnt_tmp[j++] = d_learnt_tmp[k];
+    }
+  }
+  d_learnt_tmp.resize(j);
+  for (size_t k = 0; k < d_to_clear.size(); ++ k) {
+    d_seen[d_to_clear[k]] = 0;
+  }
+  d_stats.learnt_literals += d_learnt_tmp.size();
+
+  // Find the backtrack level, and put the literal of that level at position 1
+  if (d_learnt_tmp.size() == 1) {
+    return 0;
+  }
+  size_t max_k = 1;
+  for (size_t k = 2; k < d_learnt_tmp.size(); ++ k) {
+    if (d_level[d_learnt_tmp[k].get_var()] > d_level[d_learnt_tmp[max_k].get_var()]) {
+      max_k = k;
+    }
+  }
+  std::swap(d_learnt_tmp[1], d_learnt_tmp[max_k]);
+  return d_level[d_learnt_tmp[1].get_var()];
+}
+
+void sat_solver::analyze_final(lit p) {
+  d_failed.clear();
+  d_failed.push_back(p);
+  if (decision_level() == 0) {
+    return;
+  }
+  d_seen[p.get_var()] = 1;
+  for (size_t i = d_trail.size(); i > d_trail_lim[0]; -- i) {
+    var v = d_trail[i-1].get_var();
+    if (d_seen[v]) {
+      cref r = d_reason[v];
+      if (r == CREF_NULL) {
+        // Decisions below the assumption levels are assumptions
+        assert(d_level[v] > 0);
+        d_failed.push_back(d_trail[i-1]);
+      } else {
+        lit* lits = clause_lits(r);
+        uint32_t size = clause_size(r);
+        for (uint32_t k = 1; k < size; ++ k) {
+          if (d_level[lits[k].get_var()] > 0) {
+            d_seen[lits[k].get_var()] = 1;
+          }
+        }
+      }
+      d_seen[v] = 0;
+    }
+  }
+  d_seen[p.get_var()] = 0;
+}
+
+void sat_solver::cancel_until(uint32_t level) {
+  if (decision_level() <= level) {
+    return;
+  }
+  size_t trail_size = d_trail_lim[level];
+  for (size_t i = d_trail.size(); i > trail_size; -- i) {
+    lit l = d_trail[i-1];
+    var v = l.get_var();
+    d_assign[v] = L_UNDEF;
+    d_reason[v] = CREF_NULL;
+    d_phase[v] = !l.is_negative();
+    if (d_heap_index[v] < 0) {
+      heap_insert(v);
+    }
+  }
+  d_trail.resize(trail_size);
+  d_trail_lim.resize(level);
+  d_qhead = trail_size;
+}
+
+lit sat_solver::pick_branch_lit() {
+  while (!d_heap.empty()) {
+    var v = heap_pop();
+    if (value(v) == L_UNDEF) {
+      return lit(v, !d_phase[v]);
+    }
+  }
+  return lit();
+}
+
+void sat_solver::simplify(std::vector<cref>& clauses) {
+  size_t j = 0;
+  for (size_t i = 0; i < clauses.size(); ++ i) {
+    cref c = clauses[i];
+    lit* lits = clause_lits(c);
+    uint32_t size = clause_size(c);
+    bool satisfied = false;
+    for (uint32_t k = 0; !satisfied && k < size; ++ k) {
+      satisfied = value(lits[k]) == L_TRUE;
+    }
+    if (satisfied) {
+      remove_clause(c);
+      continue;
+    }
+    // Watches are not false after propagation, so only look at the rest
+    uint32_t new_size = 2;
+    for (uint32_t k = 2; k < size; ++ k) {
+      if (value(lits[k]) != L_FALSE) {
+        lits[new_size++] = lits[k];
+      }
+    }
+    d_arena[c] = lit::from_index(new_size);
+    d_arena_wasted += size - new_size;
+    clauses[j++] = c;
+  }
+  clauses.resize(j);
+}
+
+void sat_solver::simplify() {
+  assert(decision_level() == 0);
+  if (!d_ok || d_trail.size() == d_simplify_trail) {
+    return;
+  }
+  if (propagate() != CREF_NULL) {
+    d_ok = false;
+    return;
+  }
+  // Level 0 reasons are never looked at
+  for (size_t i = 0; i < d_trail.size(); ++ i) {
+    d_reason[d_trail[i].get_var()] = CREF_NULL;
+  }
+  simplify(d_clauses);
+  simplify(d_learnts);
+  clean_watches();
+  d_simplify_trail = d_trail.size();
+  if (d_arena_wasted > d_arena.size() / 2) {
+    collect_garbage();
+  }
+}
+
+/** Order of learnt clauses for reduction: binary last, then by activity */
+struct reduce_db_cmp {
+  const std::vector<lit>& arena;
+  reduce_db_cmp(const std::vector<lit>& arena): arena(arena) {}
+  float activity(uint32_t c) const {
+    uint32_t bits = arena[c+2].index();
+    float a;
+    std::memcpy(&a, &bits, sizeof(float));
+    return a;
+  }
+  bool operator () (uint32_t c1, uint32_t c2) const {
+    uint32_t s1 = arena[c1].index(), s2 = arena[c2].index();
+    if ((s1 > 2) != (s2 > 2)) {
+      return s1 > 2;
+    }
+    return activity(c1) < activity(c2);
+  }
+};
+
+void sat_solver::reduce_db() {
+  std::sort(d_learnts.begin(), d_learnts.end(), reduce_db_cmp(d_arena));
+  size_t j = 0, half = d_learnts.size() / 2;
+  for (size_t i = 0; i < d_learnts.size(); ++ i) {
+    cref c = d_learnts[i];
+    if (i < half && clause_size(c) > 2 && !is_locked(c)) {
+      remove_clause(c);
+    } else {
+      d_learnts[j++] = c;
+    }
+  }
+  d_learnts.resize(j);
+  clean_watches();
+}
+
+sat_solver::result sat_solver::search(int64_t max_conflicts, const std::vector<lit>& assumptions) {
+
+  int64_t conflicts = 0;
+
+  for (;;) {
+    cref conflict = propagate();
+    if (conflict != CREF_NULL) {
+      conflicts ++;
+      d_stats.conflicts ++;
+      if (decision_level() == 0) {
+        d_ok = false;
+        return UNSAT;
+      }
+      uint32_t level = analyze(conflict);
+      cancel_until(level);
+      if (d_learnt_tmp.size() == 1) {
+        enqueue(d_learnt_tmp[0], CREF_NULL);
+      } else {
+        cref c = alloc_clause(d_learnt_tmp, true);
+        d_learnts.push_back(c);
+        attach_clause(c);
+        clause_bump(c);
+        enqueue(d_learnt_tmp[0], c);
+      }
+      var_decay();
+      clause_decay();
+    } else {
+      // Restart
+      if (conflicts >= max_conflicts) {
+        cancel_until(0);
+        d_stats.restarts ++;
+        return UNKNOWN;
+      }
+
+      if (decision_level() == 0) {
+        simplify();
+        if (!d_ok) {
+          return UNSAT;
+        }
+      }
+
+      if (d_learnts.size() >= d_trail.size() + d_max_learnts) {
+        reduce_db();
+      }
+
+      // Decide the assumptions first
+      lit next;
+      while (decision_level() < assumptions.size()) {
+        lit p = assumptions[decision_level()];
+        if (value(p) == L_TRUE) {
+          // Dummy decision level
+          d_trail_lim.push_back(d_trail.size());
+        } else if (value(p) == L_FALSE) {
+          analyze_final(p);
+          return UNSAT;
+        } else {
+          next = p;
+          break;
+        }
+      }
+
+      // Regular decision
+      if (next.is_null()) {
+        next = pick_branch_lit();
+        if (next.is_null()) {
+          return SAT;
+        }
+        d_stats.decisions ++;
+      }
+
+      d_trail_lim.push_back(d_trail.size());
+      enqueue(next, CREF_NULL);
+    }
+  }
+
+  return UNKNOWN;
+}
+
+/** The Luby sequence (y^seq, where seq is the x-th element of 0 0 1 0 0 1 2 ...) */
+static
+double luby(double y, int x) {
+  int size, seq;
+  for (size = 1, seq = 0; size < x + 1; seq ++, size = 2 * size + 1);
+  while (size - 1 != x) {
+    size = (size - 1) >> 1;
+    seq --;
+    x = x % size;
+  }
+  return std::pow(y, seq);
+}
+
+/** Bytes allocated by a vector */
+template <typename T>
+static size_t vector_size(const std::vector<T>& v) {
+  return v.capacity()*sizeof(T);
+}
+
+size_t sat_solver::memory_size() const {
+  size_t size = vector_size(d_arena) + vector_size(d_clauses) + vector_size(d_learnts);
+  size += vector_size(d_watches);
+  for (size_t i = 0; i < d_watches.size(); ++ i) {
+    size += vector_size(d_watches[i]);
+  }
+  size += vector_size(d_assign) + vector_size(d_level) + vector_size(d_reason);
+  size += vector_size(d_phase) + vector_size(d_seen) + vector_size(d_activity);
+  size += vector_size(d_heap) + vector_size(d_heap_index);
+  size += vector_size(d_trail) + vector_size(d_trail_lim) + vector_size(d_model);
+  return size;
+}
+
+sat_solver::result sat_solver::solve(const std::vector<lit>& assumptions) {
+
+  d_model.clear();
+  d_failed.clear();
+
+  if (!d_ok) {
+    return UNSAT;
+  }
+
+  double min_learnts = std::max((double) d_clauses.size() / 3, 2000.0);
+  if (d_max_learnts < min_learnts) {
+    d_max_learnts = min_learnts;
+  }
+
+  result r = UNKNOWN;
+  for (int restarts = 0; r == UNKNOWN; ++ restarts) {
+    r = search((int64_t) (luby(2, restarts) * RESTART_FIRST), assumptions);
+    d_max_learnts *= 1.02;
+  }
+
+  if (r == SAT) {
+    d_model = d_assign;
+  }
+
+  cancel_until(0);
+  return r;
+}
+
+void sat_solver::var_bump(var v) {
+  if ((d_activity[v] += d_var_inc) > 1e100) {
+    for (size_t i = 0; i < d_activity.size(); ++ i) {
+      d_activity[i] *= 1e-100;
+    }
+    d_var_inc *= 1e-100;
+  }
+  if (d_heap_index[v] >= 0) {
+    heap_up(d_heap_index[v]);
+  }
+}
+
+void sat_solver::var_decay() {
+  d_var_inc /= VAR_DECAY;
+}
+
+void sat_solver::clause_bump(cref c) {
+  float a = clause_activity(c) + d_clause_inc;
+  clause_set_activity(c, a);
+  if (a > 1e20) {
+    for (size_t i = 0; i < d_learnts.size(); ++ i) {
+      clause_set_activity(d_learnts[i], clause_activity(d_learnts[i]) * 1e-20);
+    }
+    d_clause_inc *= 1e-20;
+  }
+}
+
+void sat_solver::clause_decay() {
+  d_clause_inc /= CLAUSE_DECAY;
+}
+
+void sat_solver::heap_up(size_t i) {
+  var v = d_heap[i];
+  while (i > 0) {
+    size_t parent = (i - 1) >> 1;
+    if (!heap_lt(v, d_heap[parent])) {
+      break;
+    }
+    d_heap[i] = d_heap[parent];
+    d_heap_index[d_heap[i]] = i;
+    i = parent;
+  }
+  d_heap[i] = v;
+  d_heap_index[v] = i;
+}
+
+void sat_solver::heap_down(size_t i) {
+  var v = d_heap[i];
+  size_t n = d_heap.size();
+  for (;;) {
+    size_t child = 2 * i + 1;
+    if (child >= n) {
+      break;
+    }
+    if (child + 1 < n && heap_lt(d_heap[child + 1], d_heap[child])) {
+      child ++;
+    }
+    if (!heap_lt(d_heap[child], v)) {
+      break;
+    }
+    d_heap[i] = d_heap[child];
+    d_heap_index[d_heap[i]] = i;
+    i = child;
+  }
+  d_heap[i] = v;
+  d_heap_index[v] = i;
+}
+
+void sat_solver::heap_insert(var v) {
+  d_heap.push_back(v);
+  d_heap_index[v] = d_heap.size() - 1;
+  heap_up(d_heap.size() - 1);
+}
+
+var sat_solver::heap_pop() {
+  var v = d_heap[0];
+  d_heap_index[v] = -1;
+  var last = d_heap.back();
+  d_heap.pop_back();
+  if (!d_heap.empty()) {
+    d_heap[0] = last;
+    d_heap_index[last] = 0;
+    heap_down(0);
+  }
+  return v;
+}
+
+}
+}
+}
@@ -0,0 +1,321 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+namespace sally {
+namespace smt {
+namespace sat {
+
+/** A variable is just an index */
+typedef uint32_t var;
+
+/** A literal is 2*var + sign (sign = 1 for negative) */
+class lit {
+  uint32_t d_x;
+public:
+  lit(): d_x(UINT32_MAX) {}
+  lit(var v, bool negative): d_x(2*v + (negative ? 1 : 0)) {}
+  static lit from_index(uint32_t x) { lit l; l.d_x = x; return l; }
+  var get_var() const { return d_x >> 1; }
+  bool is_negative() const { return d_x & 1; }
+  uint32_t index() const { return d_x; }
+  bool is_null() const { return d_x == UINT32_MAX; }
+  lit operator ~ () const { return from_index(d_x ^ 1); }
+  lit operator ^ (bool negate) const { return from_index(d_x ^ (negate ? 1 : 0)); }
+  bool operator == (const lit& other) const { return d_x == other.d_x; }
+  bool operator != (const lit& other) const { return d_x != other.d_x; }
+  bool operator < (const lit& other) const { return d_x < other.d_x; }
+};
+
+/** Values of variables and literals */
+enum lbool {
+  L_FALSE = 0,
+  L_TRUE = 1,
+  L_UNDEF = 2
+};
+
+/**
+ * An incremental CDCL SAT solver in the style of MiniSat: two watched
+ * literals with blockers, first-UIP learning with local clause minimization,
+ * VSIDS with phase saving, Luby restarts and activity-based deletion of
+ * learnt clauses. Clauses are stored contiguously in a single arena.
+ *
+ * Solving is done under assumptions. If the problem is unsatisfiable under
+ * the assumptions, the subset of assumptions used in the refutation is
+ * available through get_failed_assumptions(). Clauses can only be added
+ * between calls to solve(), and they stay for good.
+ */
+class sat_solver {
+
+public:
+
+  /** Result of solve */
+  enum result {
+    SAT,
+    UNSAT,
+    UNKNOWN
+  };
+
+  /** Search statistics */
+  struct stats {
+    uint64_t decisions;
+    uint64_t propagations;
+    uint64_t conflicts;
+    uint64_t restarts;
+    uint64_t learnt_literals;
+    uint64_t deleted_clauses;
+    stats();
+  };
+
+  sat_solver();
+
+  /** Make a new variable */
+  var new_var();
+
+  /** Number of variables */
+  size_t num_vars() const { return d_assign.size(); }
+
+  /** Number of problem clauses */
+  size_t num_clauses() const { return d_clauses.size(); }
+
+  /** Number of learnt clauses */
+  size_t num_learnts() const { return d_learnts.size(); }
+
+  /** Add a clause (returns false if the solver became inconsistent) */
+  bool add_clause(const std::vector<lit>& clause);
+
+  /** Add a unit clause */
+  bool add_clause(lit a);
+
+  /** Add a binary clause */
+  bool add_clause(lit a, lit b);
+
+  /** Add a ternary clause */
+  bool add_clause(lit a, lit b, lit c);
+
+  /** Is the solver (trivially) inconsistent without assumptions */
+  bool is_consistent() const { return d_ok; }
+
+  /** Solve under the given assumptions */
+  result solve(const std::vector<lit>& assumptions);
+
+  /** Value of the variable in the last model */
+  lbool model_value(var v) const { return v < d_model.size() ? (lbool) d_model[v] : L_UNDEF; }
+
+  /** Value of the literal in the last model */
+  lbool model_value(lit l) const;
+
+  /** Assumptions responsible for the last unsat result (empty if unsat without assumptions) */
+  const std::vector<lit>& get_failed_assumptions() const { return d_failed; }
+
+  /** Set the preferred polarity of the variable */
+  void set_phase(var v, bool value) { d_phase[v] = value; }
+
+  /** Get the statistics */
+  const stats& get_stats() const { return d_stats; }
+
+  /** Bytes of memory used by the clauses, watches and variable data */
+  size_t memory_size() const;
+
+private:
+
+  /** Reference to a clause in the arena */
+  typedef uint32_t cref;
+
+  /** Null clause reference */
+  static const cref CREF_NULL = UINT32_MAX;
+
+  /** Header words of a clause: size, flags, activity */
+  static const uint32_t HEADER_SIZE = 3;
+
+  /** Clause flags */
+  static const uint32_t FLAG_LEARNT = 1;
+  static const uint32_t FLAG_DELETED = 2;
+
+  /** The clause arena (header words are stored as literal indices) */
+  std::vector<lit> d_arena;
+
+  /** Number of arena words in deleted clauses */
+  size_t d_arena_wasted;
+
+  /** Problem clauses */
+  std::vector<cref> d_clauses;
+
+  /** Learnt clauses */
+  std::vector<cref> d_learnts;
+
+  /** A watch: the clause and a literal of the clause (if true, skip) */
+  struct watch {
+    cref c;
+    lit blocker;
+    watch(): c(CREF_NULL) {}
+    watch(cref c, lit blocker): c(c), blocker(blocker) {}
+  };
+
+  /** Watch lists, indexed by literals */
+  std::vector< std::vector<watch> > d_watches;
+
+  /** Current assignment, indexed by variables */
+  std::vector<uint8_t> d_assign;
+
+  /** Decision level of assigned variables */
+  std::vector<uint32_t> d_level;
+
+  /** Reason of assigned variables */
+  std::vector<cref> d_reason;
+
+  /** Saved phases */
+  std::vector<uint8_t> d_phase;
+
+  /** Marks for conflict analysis */
+  std::vector<uint8_t> d_seen;
+
+  /** VSIDS activities */
+  std::vector<double> d_activity;
+
+  /** Variable activity increment */
+  double d_var_inc;
+
+  /** Clause activity increment */
+  double d_clause_inc;
+
+  /** Binary heap of variables ordered by activity */
+  std::vector<var> d_heap;
+
+  /** Position of variables in the heap (-1 if not in the heap) */
+  std::vector<int32_t> d_heap_index;
+
+  /** The trail */
+  std::vector<lit> d_trail;
+
+  /** Trail size at the start of each decision level */
+  std::vector<size_t> d_trail_lim;
+
+  /** Propagation head */
+  size_t d_qhead;
+
+  /** The model of the last SAT result */
+  std::vector<uint8_t> d_model;
+
+  /** Failed assumptions of the last UNSAT result */
+  std::vector<lit> d_failed;
+
+  /** Consistency at level 0 */
+  bool d_ok;
+
+  /** Size of the level 0 trail at last simplification */
+  size_t d_simplify_trail;
+
+  /** Maximal number of learnt clauses before reduction */
+  double d_max_learnts;
+
+  /** Statistics */
+  stats d_stats;
+
+  /** Temporaries */
+  std::vector<lit> d_learnt_tmp;
+  std::vector<var> d_to_clear;
+
+  lbool value(var v) const { return (lbool) d_assign[v]; }
+  lbool value(lit l) const {
+    uint8_t v = d_assign[l.get_var()];
+    return v == L_UNDEF ? L_UNDEF : (lbool) (v ^ (uint8_t) l.is_negative());
+  }
+  uint32_t decision_level() const { return d_trail_lim.size(); }
+
+  /** Clause access */
+  uint32_t clause_size(cref c) const { return d_arena[c].index(); }
+  lit* clause_lits(cref c) { return &d_arena[c + HEADER_SIZE]; }
+  bool clause_learnt(cref c) const { return d_arena[c+1].index() & FLAG_LEARNT; }
+  bool clause_deleted(cref c) const { return d_arena[c+1].index() & FLAG_DELETED; }
+  float clause_activity(cref c) const;
+  void clause_set_activity(cref c, float a);
+
+  /** Allocate a clause in the arena */
+  cref alloc_clause(const std::vector<lit>& lits, bool learnt);
+
+  /** Attach the watches of a clause */
+  void attach_clause(cref c);
+
+  /** Mark a clause deleted (watches are removed with clean_watches) */
+  void remove_clause(cref c);
+
+  /** Remove the watches of deleted clauses */
+  void clean_watches();
+
+  /** Is the clause the reason for its first literal */
+  bool is_locked(cref c);
+
+  /** Compact the arena if too much is wasted */
+  void collect_garbage();
+
+  /** Assign the literal */
+  void enqueue(lit l, cref reason);
+
+  /** Boolean propagation, returns conflicting clause or CREF_NULL */
+  cref propagate();
+
+  /** Analyze the conflict, learnt clause in d_learnt_tmp, returns backtrack level */
+  uint32_t analyze(cref conflict);
+
+  /** Can the literal be removed from the learnt clause */
+  bool is_redundant(lit l);
+
+  /** Compute the failed assumptions given a false assumption */
+  void analyze_final(lit p);
+
+  /** Backtrack to the given level */
+  void cancel_until(uint32_t level);
+
+  /** Pick the next decision literal (null if all assigned) */
+  lit pick_branch_lit();
+
+  /** Remove satisfied clauses and false literals at level 0 */
+  void simplify();
+
+  /** Simplify the clauses in the list */
+  void simplify(std::vector<cref>& clauses);
+
+  /** Delete half of the learnt clauses */
+  void reduce_db();
+
+  /** Search for a given number of conflicts */
+  result search(int64_t conflicts, const std::vector<lit>& assumptions);
+
+  /** Activities */
+  void var_bump(var v);
+  void var_decay();
+  void clause_bump(cref c);
+  void clause_decay();
+
+  /** Heap operations */
+  bool heap_lt(var a, var b) const { return d_activity[a] > d_activity[b]; }
+  void heap_up(size_t i);
+  void heap_down(size_t i);
+  void heap_insert(var v);
+  var heap_pop();
+};
+
+}
+}
+}
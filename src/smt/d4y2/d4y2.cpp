@@ -135,6 +135,11 @@ void d4y2::gc() {
   d_dreal4->gc();
 }
 
+void d4y2::memory_usage(utils::memory_report& report) const {
+  d_yices2->memory_usage(report);
+  d_dreal4->memory_usage(report);
+}
+
 void d4y2::gc_collect(const expr::gc_relocator& gc_reloc) {
   solver::gc_collect(gc_reloc);
 }
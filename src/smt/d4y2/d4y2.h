@@ -84,6 +84,9 @@ public:
 
   /** Collect garbage */
   void gc();
+
+  /** Memory of both solvers */
+  void memory_usage(utils::memory_report& report) const;
 };
 
 }
@@ -106,6 +106,10 @@ void delayed_wrapper::gc_collect(const expr::gc_relocator& gc_reloc) {
   solver::gc_collect(gc_reloc);
 }
 
+void delayed_wrapper::memory_usage(utils::memory_report& report) const {
+  d_solver->memory_usage(report);
+}
+
 void delayed_wrapper::set_hint(expr::model::ref m) {
   flush();
   d_solver->set_hint(m);
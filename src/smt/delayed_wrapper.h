@@ -53,9 +53,6 @@ class delayed_wrapper : public solver {
   /** The scope we last processed */
   size_t d_scope;
 
-  /** Flush the assertions */
-  void flush();
-
 public:
 
   /** Takes over the solver and will destruct it on destruction */
@@ -64,6 +61,7 @@ public:
 
   bool supports(feature f) const;
   void add(expr::term_ref f, formula_class f_class);
+  void flush();
   result check();
   void check_model();
   expr::model::ref get_model() const;
@@ -75,6 +73,7 @@ public:
   void add_variable(expr::term_ref var, variable_class f_class);
   void set_hint(expr::model::ref m);
   void gc_collect(const expr::gc_relocator& gc_reloc);
+  void memory_usage(utils::memory_report& report) const;
 };
 
 }
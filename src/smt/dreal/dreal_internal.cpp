@@ -24,7 +24,7 @@
 #include "expr/gc_relocator.h"
 #include "expr/term.h"
 #include "expr/term_manager.h"
-#include "expr/term_visitor.h"
+#include "expr/term_traversal.h"
 #include "utils/output.h"
 
 #ifdef WITH_LIBPOLY
@@ -261,25 +261,12 @@ public:
   , d_subexpr_to_vars(subexpr_to_vars)
   {}
 
-  // Non-null terms are good
-  bool is_good_term(expr::term_ref t) const {
-    return !t.is_null();
-  }
-
   bool has_extra_assertions() const { return d_extra_assertions.size() > 0; }
   bool has_extra_variables() const { return d_extra_variables.size() > 0; }
 
   const std::vector<dreal_term>& get_extra_assertions() const { return d_extra_assertions; }
   const std::vector<dreal_term>& get_extra_variables() const { return d_extra_variables; }
 
-  // Get the children of t
-  void get_children(expr::term_ref t, std::vector<expr::term_ref>& children) {
-    const expr::term& t_term = d_tm.term_of(t);
-    for (size_t i = 0; i < t_term.size(); ++ i) {
-      children.push_back(t_term[i]);
-    }
-  }
-
   // We visit all regular nodes
   // the cache yet
   expr::visitor_match_result match(expr::term_ref t) {
@@ -409,9 +396,8 @@ public:
 
 dreal_term dreal_internal::to_dreal_term(expr::term_ref ref) {
   to_dreal_visitor visitor(d_tm, *this, *d_conversion_cache, d_options.has_option("dreal-subexpr-to-vars"));
-  expr::term_visit_topological<to_dreal_visitor, expr::term_ref, expr::term_ref_hasher>
-    topological_visit(visitor);
-  topological_visit.run(ref);
+  expr::term_traversal traversal(d_tm);
+  traversal.run(visitor, ref);
   dreal_term result = d_conversion_cache->get_term_cache(ref);
   assert(!result.is_null_term());
 
@@ -19,6 +19,9 @@
 #include "smt/factory.h"
 #include "utils/module_setup.h"
 #include "smt/smt2_output_wrapper.h"
+#include "smt/query_cache_wrapper.h"
+#include "smt/mbp_wrapper.h"
+#include "smt/profile_wrapper.h"
 
 #include <iostream>
 #include <iomanip>
@@ -43,6 +46,12 @@ bool factory::s_generate_smt = false;
 
 std::string factory::s_smt2_prefix;
 
+bool factory::s_query_cache = false;
+
+bool factory::s_mbp = false;
+
+bool factory::s_profile = false;
+
 void factory::set_default_solver(std::string id) {
   s_default_solver = id;
 }
@@ -61,11 +70,22 @@ solver* factory::mk_solver(std::string id, expr::term_manager& tm, const options
   }
   solver* solver = s_solver_data.get_module_info(id).new_instance(ctx);
   s_total_instances ++;
+  // Profile right at the solver, so that only the solver time is measured
+  if (s_profile) {
+    solver = new profile_wrapper(tm, opts, stats, solver);
+  }
+  // Generalize with the built-in projection instead of the solver
+  if (s_mbp) {
+    solver = new mbp_wrapper(tm, opts, stats, solver);
+  }
   if (s_generate_smt) {
     std::stringstream ss;
     ss << s_smt2_prefix << "." << std::setfill('0') << std::setw(3) << s_total_instances << "." << solver->get_name() << ".smt2";
     solver = new smt2_output_wrapper(tm, opts, stats, solver, ss.str());
   }
+  if (s_query_cache) {
+    solver = new query_cache_wrapper(tm, opts, stats, solver);
+  }
   return solver;
 }
 
@@ -94,6 +114,21 @@ void factory::enable_smt2_output(std::string prefix) {
   s_smt2_prefix = prefix;
 }
 
+void factory::enable_query_cache(std::string filename) {
+  s_query_cache = true;
+  if (filename.size() > 0) {
+    query_cache_wrapper::open_persistent_store(filename);
+  }
+}
+
+void factory::enable_profile() {
+  s_profile = true;
+}
+
+void factory::enable_mbp() {
+  s_mbp = true;
+}
+
 }
 }
 
@@ -44,6 +44,15 @@ class factory {
   /** Prefix of smt2 files */
   static std::string s_smt2_prefix;
 
+  /** Wrap solvers to cache query results */
+  static bool s_query_cache;
+
+  /** Generalize with the built-in projection even if the solver supports it */
+  static bool s_mbp;
+
+  /** Wrap solvers to profile the queries */
+  static bool s_profile;
+
 public:
 
   static
@@ -67,6 +76,18 @@ public:
   static
   void enable_smt2_output(std::string prefix);
 
+  /** Cache query results, and keep them in the file if not empty */
+  static
+  void enable_query_cache(std::string filename);
+
+  /** Profile the queries of all solvers (and dump the slow ones if asked) */
+  static
+  void enable_profile();
+
+  /** Use the built-in model-based projection for all solvers */
+  static
+  void enable_mbp();
+
 };
 
 }
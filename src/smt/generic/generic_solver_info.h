@@ -47,7 +47,7 @@ struct generic_solver_info {
         ("generic-solver-script", value<std::string>(), "The SMT solver script to use (takes SMT2 from stdin).")
         ("generic-solver-logic", value<std::string>(), "The SMT logic to use (e.g. QF_LRA).")
         ("generic-solver-log", value<std::string>(), "Prefix of a file where the SMT2 output will be logged. Given 'output', the files generated will be 'output.1.smt2', ...")
-        ("generic-solver-flatten", "Run the solver in non-incremental mode.")
+        ("generic-solver-flatten", "Don't use push/pop in the solver: new assertions are sent on each check, and the solver is restarted only when a pop removes assertions it already has.")
         ;
   }
 
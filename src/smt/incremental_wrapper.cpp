@@ -26,8 +26,13 @@ namespace smt {
 incremental_wrapper::incremental_wrapper(std::string name, expr::term_manager& tm, const options& opts, utils::statistics& stats, solver_constructor* constructor)
 : solver(name, tm, opts, stats)
 , d_constructor(constructor)
+, d_materialized(0)
+, d_rebuild(false)
 {
   d_solver = d_constructor->mk_solver();
+  d_stats.rebuilds = static_cast<utils::stat_int*>(stats.register_stat("smt::incremental_wrapper::rebuilds"));
+  d_stats.replays = static_cast<utils::stat_int*>(stats.register_stat("smt::incremental_wrapper::replays"));
+  d_stats.assertions = static_cast<utils::stat_int*>(stats.register_stat("smt::incremental_wrapper::assertions"));
 }
 
 incremental_wrapper::~incremental_wrapper() {
@@ -43,21 +48,48 @@ void incremental_wrapper::add(expr::term_ref f, formula_class f_class) {
   d_assertions.push_back(assertion(f, f_class));
 }
 
-solver::result incremental_wrapper::check() {
+void incremental_wrapper::add_variable(expr::term_ref var, variable_class f_class) {
+  solver::add_variable(var, f_class);
+  // Variables are context-independent, so the current solver can take them
+  d_solver->add_variable(var, f_class);
+}
+
+void incremental_wrapper::rebuild() {
 
   delete d_solver;
   d_solver = d_constructor->mk_solver();
+  d_materialized = 0;
+  d_rebuild = false;
 
   // Initialize solver
   d_solver->add_variables(d_A_variables.begin(), d_A_variables.end(), CLASS_A);
   d_solver->add_variables(d_B_variables.begin(), d_B_variables.end(), CLASS_B);
   d_solver->add_variables(d_T_variables.begin(), d_T_variables.end(), CLASS_T);
 
-  // Assert the formulas
-  for (size_t i = 0; i < d_assertions.size(); ++ i) {
-    d_solver->add(d_assertions[i].f, d_assertions[i].f_class);
+  d_stats.rebuilds->increment();
+}
+
+void incremental_wrapper::flush() {
+
+  // Start over only if we popped below what the solver holds
+  if (d_rebuild) {
+    rebuild();
   }
 
+  // Assert the formulas the solver doesn't have yet
+  for (; d_materialized < d_assertions.size(); ++ d_materialized) {
+    d_solver->add(d_assertions[d_materialized].f, d_assertions[d_materialized].f_class);
+    d_stats.assertions->increment();
+  }
+}
+
+solver::result incremental_wrapper::check() {
+
+  if (!d_rebuild) {
+    d_stats.replays->increment();
+  }
+  flush();
+
   // Check and interpolate
   return d_solver->check();
 }
@@ -76,6 +108,10 @@ void incremental_wrapper::pop() {
   while (d_assertions.size() > size) {
     d_assertions.pop_back();
   }
+  // If we removed assertions the solver already has, we need a new one
+  if (d_assertions.size() < d_materialized) {
+    d_rebuild = true;
+  }
 }
 
 void incremental_wrapper::generalize(generalization_type type, std::vector<expr::term_ref>& out) {
@@ -97,6 +133,11 @@ void incremental_wrapper::gc_collect(const expr::gc_relocator& gc_reloc) {
   }
 }
 
+void incremental_wrapper::memory_usage(utils::memory_report& report) const {
+  report.add("smt::incremental_wrapper", utils::memory_of(d_assertions));
+  d_solver->memory_usage(report);
+}
+
 }
 }
 
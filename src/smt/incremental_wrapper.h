@@ -31,8 +31,11 @@ public:
 };
 
 /**
- * A solver that wraps another solver and doesn't use push/pop. Instead the
- * solver is created on each check and all assertions are added.
+ * A solver that wraps another solver and doesn't use push/pop. Instead, the
+ * wrapper keeps the assertion stack and on each check adds to the underlying
+ * solver only the assertions it doesn't hold yet. The underlying solver is
+ * recreated (and all assertions re-added) only when a pop removes assertions
+ * that have already been added to it.
  */
 class incremental_wrapper : public solver {
 
@@ -55,9 +58,27 @@ class incremental_wrapper : public solver {
   /** Solver previously used */
   solver* d_solver;
 
+  /** Number of assertions (a prefix of d_assertions) held by d_solver */
+  size_t d_materialized;
+
+  /** True if a pop removed assertions already held by d_solver */
+  bool d_rebuild;
+
   /** Instance */
   static size_t d_instance;
 
+  struct stats {
+    /** Number of times the underlying solver was recreated */
+    utils::stat_int* rebuilds;
+    /** Number of checks that only added the new assertions */
+    utils::stat_int* replays;
+    /** Number of assertions added to the underlying solvers */
+    utils::stat_int* assertions;
+  } d_stats;
+
+  /** Recreate the solver and add all the variables */
+  void rebuild();
+
 public:
 
   incremental_wrapper(std::string name, expr::term_manager& tm, const options& opts, utils::statistics& stats, solver_constructor* constructor);
@@ -65,6 +86,7 @@ public:
 
   bool supports(feature f) const;
   void add(expr::term_ref f, formula_class f_class);
+  void flush();
   result check();
   expr::model::ref get_model() const;
   void push();
@@ -72,7 +94,9 @@ public:
   void generalize(generalization_type type, std::vector<expr::term_ref>& projection_out);
   void interpolate(std::vector<expr::term_ref>& out);
   void get_unsat_core(std::vector<expr::term_ref>& out);
+  void add_variable(expr::term_ref var, variable_class f_class);
   void gc_collect(const expr::gc_relocator& gc_reloc);
+  void memory_usage(utils::memory_report& report) const;
 };
 
 }
@@ -0,0 +1,751 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "smt/mbp/model_based_projection.h"
+#include "utils/trace.h"
+
+#include <cassert>
+
+namespace sally {
+namespace smt {
+
+using namespace expr;
+
+/** Absolute value of a rational */
+static inline
+rational abs(const rational& q) {
+  return q.sgn() < 0 ? q.negate() : q;
+}
+
+/** Is the rational 1 or -1 */
+static inline
+bool is_unit(const rational& q) {
+  return abs(q) == rational(1, 1);
+}
+
+rational model_based_projection::linear_term::get(term_ref t) const {
+  coeff_map::const_iterator find = coeffs.find(t);
+  return find == coeffs.end() ? rational() : find->second;
+}
+
+void model_based_projection::linear_term::add(const rational& a, const linear_term& p) {
+  coeff_map::const_iterator it = p.coeffs.begin();
+  for (; it != p.coeffs.end(); ++ it) {
+    rational& c = coeffs[it->first];
+    c += a * it->second;
+    if (c.sgn() == 0) {
+      coeffs.erase(it->first);
+    }
+  }
+  constant += a * p.constant;
+}
+
+model_based_projection::model_based_projection(term_manager& tm, utils::statistics& stats)
+: d_tm(tm)
+{
+  d_stats.projections = static_cast<utils::stat_int*>(stats.register_stat("smt::mbp::projections"));
+  d_stats.eliminated = static_cast<utils::stat_int*>(stats.register_stat("smt::mbp::eliminated"));
+  d_stats.substituted = static_cast<utils::stat_int*>(stats.register_stat("smt::mbp::substituted"));
+}
+
+void model_based_projection::project(const std::vector<term_ref>& formulas, const std::set<term_ref>& vars, model::ref m, std::vector<term_ref>& out) {
+
+  TRACE("mbp") << "mbp: projecting " << formulas.size() << " formulas, " << vars.size() << " variables" << std::endl;
+
+  d_stats.projections->increment();
+  d_model = m;
+
+  // Get the implicant
+  for (size_t i = 0; i < formulas.size(); ++ i) {
+    assert(is_true(formulas[i]));
+    add_implicant(formulas[i], true);
+  }
+
+  TRACE("mbp") << "mbp: implicant of size " << d_literals.size() << std::endl;
+
+  // Eliminate the variables
+  std::set<term_ref>::const_iterator it = vars.begin();
+  for (; it != vars.end(); ++ it) {
+    eliminate(*it);
+  }
+
+  for (size_t i = 0; i < d_literals.size(); ++ i) {
+    TRACE("mbp") << "mbp: " << d_literals[i] << std::endl;
+    assert(d_model->is_true(d_literals[i]));
+    out.push_back(d_literals[i]);
+  }
+
+  // Clear the state
+  d_model = 0;
+  d_literals.clear();
+  d_literals_set.clear();
+  d_value_cache.clear();
+  d_implicant_visited[0].clear();
+  d_implicant_visited[1].clear();
+  d_variables.clear();
+}
+
+bool model_based_projection::is_true(term_ref f) {
+
+  bool_cache::const_iterator find = d_value_cache.find(f);
+  if (find != d_value_cache.end()) {
+    return find->second;
+  }
+
+  // Copy the children, the term table can move when adding terms
+  const term& t = d_tm.term_of(f);
+  term_op op = t.op();
+  std::vector<term_ref> children(d_tm.term_begin(t), d_tm.term_end(t));
+  bool result = false;
+  switch (op) {
+  case CONST_BOOL:
+    result = d_tm.get_boolean_constant(d_tm.term_of(f));
+    break;
+  case TERM_AND:
+    result = true;
+    for (size_t i = 0; result && i < children.size(); ++ i) {
+      result = is_true(children[i]);
+    }
+    break;
+  case TERM_OR:
+    result = false;
+    for (size_t i = 0; !result && i < children.size(); ++ i) {
+      result = is_true(children[i]);
+    }
+    break;
+  case TERM_NOT:
+    result = !is_true(children[0]);
+    break;
+  case TERM_IMPLIES:
+    result = !is_true(children[0]) || is_true(children[1]);
+    break;
+  case TERM_XOR:
+    result = false;
+    for (size_t i = 0; i < children.size(); ++ i) {
+      result = result != is_true(children[i]);
+    }
+    break;
+  case TERM_EQ:
+    if (d_tm.is_boolean_type(d_tm.type_of(children[0]))) {
+      result = is_true(children[0]) == is_true(children[1]);
+    } else {
+      result = d_model->is_true(f);
+    }
+    break;
+  case TERM_ITE:
+    result = is_true(children[0]) ? is_true(children[1]) : is_true(children[2]);
+    break;
+  default:
+    result = d_model->is_true(f);
+  }
+
+  d_value_cache[f] = result;
+  return result;
+}
+
+void model_based_projection::add_implicant(term_ref f, bool positive) {
+
+  if (d_implicant_visited[positive].count(f)) {
+    return;
+  }
+  d_implicant_visited[positive].insert(f);
+
+  assert(is_true(f) == positive);
+
+  // Copy the children, the term table can move when adding terms
+  const term& t = d_tm.term_of(f);
+  term_op op = t.op();
+  std::vector<term_ref> children(d_tm.term_begin(t), d_tm.term_end(t));
+  switch (op) {
+  case CONST_BOOL:
+    break;
+  case TERM_NOT:
+    add_implicant(children[0], !positive);
+    break;
+  case TERM_AND:
+  case TERM_OR: {
+    // All children if positive AND (negative OR), otherwise just one
+    bool all = (op == TERM_AND) == positive;
+    if (all) {
+      for (size_t i = 0; i < children.size(); ++ i) {
+        add_implicant(children[i], positive);
+      }
+    } else {
+      // Prefer children that we've already added
+      size_t selected = children.size();
+      for (size_t i = 0; i < children.size(); ++ i) {
+        if (is_true(children[i]) == positive) {
+          if (selected == children.size()) {
+            selected = i;
+          }
+          if (d_implicant_visited[positive].count(children[i])) {
+            selected = i;
+            break;
+          }
+        }
+      }
+      assert(selected < children.size());
+      add_implicant(children[selected], positive);
+    }
+    break;
+  }
+  case TERM_IMPLIES:
+    if (positive) {
+      if (!is_true(children[0])) {
+        add_implicant(children[0], false);
+      } else {
+        add_implicant(children[1], true);
+      }
+    } else {
+      add_implicant(children[0], true);
+      add_implicant(children[1], false);
+    }
+    break;
+  case TERM_XOR:
+    for (size_t i = 0; i < children.size(); ++ i) {
+      add_implicant(children[i], is_true(children[i]));
+    }
+    break;
+  case TERM_EQ:
+    if (d_tm.is_boolean_type(d_tm.type_of(children[0]))) {
+      add_implicant(children[0], is_true(children[0]));
+      add_implicant(children[1], is_true(children[1]));
+    } else {
+      add_literal(positive ? f : d_tm.mk_not(f));
+    }
+    break;
+  case TERM_ITE: {
+    bool c = is_true(children[0]);
+    add_implicant(children[0], c);
+    add_implicant(c ? children[1] : children[2], positive);
+    break;
+  }
+  default:
+    add_literal(positive ? f : d_tm.mk_not(f));
+  }
+}
+
+term_ref model_based_projection::remove_ite(term_ref t) {
+  for (;;) {
+    std::vector<term_ref> subterms;
+    d_tm.get_subterms(t, subterms);
+    term_manager::substitution_map subst;
+    for (size_t i = 0; i < subterms.size(); ++ i) {
+      const term& ite = d_tm.term_of(subterms[i]);
+      if (ite.op() == TERM_ITE) {
+        term_ref c = ite[0], t_true = ite[1], t_false = ite[2];
+        bool c_value = is_true(c);
+        add_implicant(c, c_value);
+        subst[subterms[i]] = c_value ? t_true : t_false;
+      }
+    }
+    if (subst.empty()) {
+      return t;
+    }
+    t = d_tm.substitute(t, subst);
+  }
+}
+
+void model_based_projection::add_literal(term_ref l) {
+  l = remove_ite(l);
+  if (d_literals_set.count(l)) {
+    return;
+  }
+  // Ground literals are true in the model
+  if (d_tm.get_variables_count(l) == 0) {
+    return;
+  }
+  // Trivial equalities
+  const term& t = d_tm.term_of(l);
+  if (t.op() == TERM_EQ && t[0] == t[1]) {
+    return;
+  }
+  d_literals_set.insert(l);
+  d_literals.push_back(l);
+}
+
+bool model_based_projection::contains(term_ref t, term_ref x) {
+  variables_cache::iterator find = d_variables.find(t);
+  if (find == d_variables.end()) {
+    find = d_variables.insert(variables_cache::value_type(t, std::set<term_ref>())).first;
+    d_tm.get_variables(t, find->second);
+  }
+  return find->second.count(x) > 0;
+}
+
+void model_based_projection::linearize(term_ref t_ref, const rational& c, linear_term& out) {
+  const term& t = d_tm.term_of(t_ref);
+  switch (t.op()) {
+  case CONST_RATIONAL:
+    out.constant += c * d_tm.get_rational_constant(t);
+    return;
+  case TERM_ADD:
+    for (size_t i = 0; i < t.size(); ++ i) {
+      linearize(t[i], c, out);
+    }
+    return;
+  case TERM_SUB:
+    if (t.size() == 1) {
+      linearize(t[0], c.negate(), out);
+    } else {
+      linearize(t[0], c, out);
+      for (size_t i = 1; i < t.size(); ++ i) {
+        linearize(t[i], c.negate(), out);
+      }
+    }
+    return;
+  case TERM_MUL: {
+    // Linear if all but one child are constant
+    rational k(1, 1);
+    std::vector<linear_term> non_constant;
+    for (size_t i = 0; i < t.size() && non_constant.size() < 2; ++ i) {
+      linear_term child;
+      linearize(t[i], rational(1, 1), child);
+      if (child.coeffs.empty()) {
+        k *= child.constant;
+      } else {
+        non_constant.push_back(child);
+      }
+    }
+    if (non_constant.empty()) {
+      out.constant += c * k;
+      return;
+    }
+    if (non_constant.size() == 1) {
+      out.add(c * k, non_constant[0]);
+      return;
+    }
+    break;
+  }
+  case TERM_DIV: {
+    const term& d = d_tm.term_of(t[1]);
+    if (d.op() == CONST_RATIONAL && d_tm.get_rational_constant(d).sgn() != 0) {
+      linearize(t[0], c / d_tm.get_rational_constant(d), out);
+      return;
+    }
+    break;
+  }
+  case TERM_TO_REAL:
+    linearize(t[0], c, out);
+    return;
+  default:
+    break;
+  }
+
+  // Non-linear, keep as is
+  rational& coeff = out.coeffs[t_ref];
+  coeff += c;
+  if (coeff.sgn() == 0) {
+    out.coeffs.erase(t_ref);
+  }
+}
+
+value model_based_projection::evaluate(const linear_term& p) {
+  value v(p.constant);
+  linear_term::coeff_map::const_iterator it = p.coeffs.begin();
+  for (; it != p.coeffs.end(); ++ it) {
+    v += value(it->second) * d_model->get_term_value(it->first);
+  }
+  return v;
+}
+
+bool model_based_projection::to_constraint(term_ref l, constraint& out) {
+
+  bool positive = true;
+  const term* atom = &d_tm.term_of(l);
+  if (atom->op() == TERM_NOT) {
+    positive = false;
+    atom = &d_tm.term_of((*atom)[0]);
+  }
+
+  term_op op = atom->op();
+  if (op != TERM_LEQ && op != TERM_LT && op != TERM_GEQ && op != TERM_GT && op != TERM_EQ) {
+    return false;
+  }
+  term_ref lhs = (*atom)[0], rhs = (*atom)[1];
+  if (op == TERM_EQ) {
+    // Base type of integers is real
+    if (d_tm.base_type_of(lhs) != d_tm.real_type()) {
+      return false;
+    }
+  }
+
+  // p = lhs - rhs
+  linear_term p;
+  linearize(lhs, rational(1, 1), p);
+  linearize(rhs, rational(-1, 1), p);
+
+  linear_term p_neg;
+  p_neg.add(rational(-1, 1), p);
+
+  switch (op) {
+  case TERM_LEQ:
+    out.p = positive ? p : p_neg;
+    out.kind = positive ? CONSTRAINT_LEQ : CONSTRAINT_LT;
+    break;
+  case TERM_LT:
+    out.p = positive ? p : p_neg;
+    out.kind = positive ? CONSTRAINT_LT : CONSTRAINT_LEQ;
+    break;
+  case TERM_GEQ:
+    out.p = positive ? p_neg : p;
+    out.kind = positive ? CONSTRAINT_LEQ : CONSTRAINT_LT;
+    break;
+  case TERM_GT:
+    out.p = positive ? p_neg : p;
+    out.kind = positive ? CONSTRAINT_LT : CONSTRAINT_LEQ;
+    break;
+  case TERM_EQ:
+    if (positive) {
+      out.p = p;
+      out.kind = CONSTRAINT_EQ;
+    } else {
+      // Disequality: take the side of the model
+      out.p = evaluate(p) < value(rational()) ? p : p_neg;
+      out.kind = CONSTRAINT_LT;
+    }
+    break;
+  default:
+    assert(false);
+  }
+
+  out.is_int = true;
+  linear_term::coeff_map::const_iterator it = out.p.coeffs.begin();
+  for (; out.is_int && it != out.p.coeffs.end(); ++ it) {
+    out.is_int = d_tm.is_integer_type(d_tm.type_of(it->first));
+  }
+  if (out.is_int) {
+    normalize_int(out);
+  }
+
+  return true;
+}
+
+void model_based_projection::normalize_int(constraint& c) {
+
+  // Make the coefficients integer
+  mpz_class lcm = c.p.constant.get_denominator().mpz();
+  linear_term::coeff_map::iterator it = c.p.coeffs.begin();
+  for (; it != c.p.coeffs.end(); ++ it) {
+    mpz_lcm(lcm.get_mpz_t(), lcm.get_mpz_t(), it->second.get_denominator().mpz().get_mpz_t());
+  }
+  if (lcm != 1) {
+    rational m(integer(lcm), integer(1));
+    for (it = c.p.coeffs.begin(); it != c.p.coeffs.end(); ++ it) {
+      it->second *= m;
+    }
+    c.p.constant *= m;
+  }
+
+  // p < 0 iff p + 1 <= 0
+  if (c.kind == CONSTRAINT_LT) {
+    c.p.constant += rational(1, 1);
+    c.kind = CONSTRAINT_LEQ;
+  }
+
+  // Divide by the gcd of the coefficients
+  mpz_class gcd = 0;
+  for (it = c.p.coeffs.begin(); it != c.p.coeffs.end(); ++ it) {
+    mpz_gcd(gcd.get_mpz_t(), gcd.get_mpz_t(), it->second.get_numerator().mpz().get_mpz_t());
+  }
+  if (gcd > 1) {
+    rational d(integer(gcd), integer(1));
+    for (it = c.p.coeffs.begin(); it != c.p.coeffs.end(); ++ it) {
+      it->second /= d;
+    }
+    c.p.constant /= d;
+    if (c.kind == CONSTRAINT_LEQ) {
+      c.p.constant = c.p.constant.ceiling();
+    }
+  }
+}
+
+term_ref model_based_projection::to_literal(const constraint& c) {
+
+  // Positive coefficients on the left, negative on the right
+  std::vector<term_ref> lhs, rhs;
+  linear_term::coeff_map::const_iterator it = c.p.coeffs.begin();
+  for (; it != c.p.coeffs.end(); ++ it) {
+    std::vector<term_ref>& side = it->second.sgn() > 0 ? lhs : rhs;
+    rational a = abs(it->second);
+    if (a == rational(1, 1)) {
+      side.push_back(it->first);
+    } else {
+      side.push_back(d_tm.mk_term(TERM_MUL, d_tm.mk_rational_constant(a), it->first));
+    }
+  }
+  // The constant goes to the empty side, or to the right
+  if (c.p.constant.sgn() != 0) {
+    if (lhs.empty()) {
+      lhs.push_back(d_tm.mk_rational_constant(c.p.constant));
+    } else {
+      rhs.push_back(d_tm.mk_rational_constant(c.p.constant.negate()));
+    }
+  }
+
+  term_ref sides[2];
+  for (size_t k = 0; k < 2; ++ k) {
+    std::vector<term_ref>& side = k == 0 ? lhs : rhs;
+    if (side.empty()) {
+      sides[k] = d_tm.mk_rational_constant(rational());
+    } else if (side.size() == 1) {
+      sides[k] = side[0];
+    } else {
+      sides[k] = d_tm.mk_term(TERM_ADD, side);
+    }
+  }
+
+  switch (c.kind) {
+  case CONSTRAINT_LT:
+    return d_tm.mk_term(TERM_LT, sides[0], sides[1]);
+  case CONSTRAINT_LEQ:
+    return d_tm.mk_term(TERM_LEQ, sides[0], sides[1]);
+  case CONSTRAINT_EQ:
+    return d_tm.mk_term(TERM_EQ, sides[0], sides[1]);
+  }
+
+  assert(false);
+  return term_ref();
+}
+
+void model_based_projection::replace_literals(term_ref x, const std::vector<term_ref>& literals) {
+  std::vector<term_ref> old_literals;
+  old_literals.swap(d_literals);
+  for (size_t i = 0; i < old_literals.size(); ++ i) {
+    if (contains(old_literals[i], x)) {
+      d_literals_set.erase(old_literals[i]);
+    } else {
+      d_literals.push_back(old_literals[i]);
+    }
+  }
+  for (size_t i = 0; i < literals.size(); ++ i) {
+    assert(!contains(literals[i], x));
+    add_literal(literals[i]);
+  }
+}
+
+void model_based_projection::substitute(term_ref x, term_ref t) {
+  TRACE("mbp") << "mbp: " << x << " -> " << t << std::endl;
+  term_manager::substitution_map subst;
+  subst[x] = t;
+  std::vector<term_ref> literals;
+  for (size_t i = 0; i < d_literals.size(); ++ i) {
+    if (contains(d_literals[i], x)) {
+      literals.push_back(d_tm.substitute(d_literals[i], subst));
+    }
+  }
+  replace_literals(x, literals);
+}
+
+void model_based_projection::eliminate(term_ref x) {
+
+  // Nothing to do if not there
+  bool occurs = false;
+  for (size_t i = 0; !occurs && i < d_literals.size(); ++ i) {
+    occurs = contains(d_literals[i], x);
+  }
+  if (!occurs) {
+    return;
+  }
+
+  TRACE("mbp") << "mbp: eliminating " << x << std::endl;
+
+  term_ref type = d_tm.base_type_of(x);
+  bool eliminated = false;
+  if (type == d_tm.real_type()) {
+    eliminated = eliminate_arithmetic(x);
+  } else if (!d_tm.is_boolean_type(type)) {
+    eliminated = eliminate_equality(x);
+  }
+
+  if (eliminated) {
+    d_stats.eliminated->increment();
+  } else {
+    // Fall back to the model value
+    d_stats.substituted->increment();
+    substitute(x, d_model->get_variable_value(x).to_term(d_tm));
+  }
+}
+
+bool model_based_projection::eliminate_equality(term_ref x) {
+  for (size_t i = 0; i < d_literals.size(); ++ i) {
+    const term& t = d_tm.term_of(d_literals[i]);
+    if (t.op() == TERM_EQ) {
+      for (size_t k = 0; k < 2; ++ k) {
+        if (t[k] == x && !contains(t[1-k], x)) {
+          substitute(x, t[1-k]);
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+bool model_based_projection::eliminate_arithmetic(term_ref x) {
+
+  bool x_is_int = d_tm.is_integer_type(d_tm.type_of(x));
+
+  // Get the constraints, all must be linear in x
+  std::vector<constraint> constraints;
+  for (size_t i = 0; i < d_literals.size(); ++ i) {
+    if (!contains(d_literals[i], x)) {
+      continue;
+    }
+    constraint c;
+    if (!to_constraint(d_literals[i], c)) {
+      return false;
+    }
+    if (c.p.get(x).sgn() == 0) {
+      return false;
+    }
+    linear_term::coeff_map::const_iterator it = c.p.coeffs.begin();
+    for (; it != c.p.coeffs.end(); ++ it) {
+      if (it->first != x && contains(it->first, x)) {
+        return false;
+      }
+    }
+    if (x_is_int && !c.is_int) {
+      return false;
+    }
+    constraints.push_back(c);
+  }
+
+  std::vector<term_ref> literals;
+
+  // Solve an equality (integers only with unit coefficients)
+  bool has_equality = false;
+  for (size_t i = 0; i < constraints.size(); ++ i) {
+    if (constraints[i].kind != CONSTRAINT_EQ) {
+      continue;
+    }
+    has_equality = true;
+    rational a = constraints[i].p.get(x);
+    if (x_is_int && !is_unit(a)) {
+      continue;
+    }
+    for (size_t j = 0; j < constraints.size(); ++ j) {
+      if (j != i) {
+        constraint c = constraints[j];
+        c.p.add(c.p.get(x).negate() / a, constraints[i].p);
+        literals.push_back(to_literal(c));
+      }
+    }
+    replace_literals(x, literals);
+    return true;
+  }
+  if (has_equality) {
+    return false;
+  }
+
+  // Split into lower (negative coefficient) and upper bounds
+  std::vector<size_t> lower, upper;
+  std::vector<value> bound(constraints.size());
+  value x_value = d_model->get_variable_value(x);
+  for (size_t i = 0; i < constraints.size(); ++ i) {
+    const constraint& c = constraints[i];
+    rational a = c.p.get(x);
+    // p = a*x + r, bound is -r/a
+    value r = evaluate(c.p) - value(a) * x_value;
+    bound[i] = -r / value(a);
+    if (a.sgn() < 0) {
+      lower.push_back(i);
+    } else {
+      upper.push_back(i);
+    }
+  }
+
+  // Unbounded on one side, we can drop all
+  if (lower.empty() || upper.empty()) {
+    replace_literals(x, literals);
+    return true;
+  }
+
+  // Greatest lower bound and least upper bound, strict bounds are tighter
+  size_t glb = lower[0], lub = upper[0];
+  for (size_t k = 1; k < lower.size(); ++ k) {
+    size_t i = lower[k];
+    int cmp = bound[i].cmp(bound[glb]);
+    if (cmp > 0 || (cmp == 0 && constraints[i].kind == CONSTRAINT_LT)) {
+      glb = i;
+    }
+  }
+  for (size_t k = 1; k < upper.size(); ++ k) {
+    size_t i = upper[k];
+    int cmp = bound[i].cmp(bound[lub]);
+    if (cmp < 0 || (cmp == 0 && constraints[i].kind == CONSTRAINT_LT)) {
+      lub = i;
+    }
+  }
+
+  if (x_is_int) {
+    // Substitute the closest bound with unit coefficient
+    size_t s;
+    if (is_unit(constraints[glb].p.get(x))) {
+      s = glb;
+    } else if (is_unit(constraints[lub].p.get(x))) {
+      s = lub;
+    } else {
+      return false;
+    }
+    const constraint& c_s = constraints[s];
+    rational a_s = c_s.p.get(x);
+    for (size_t i = 0; i < constraints.size(); ++ i) {
+      if (i != s) {
+        constraint c = constraints[i];
+        c.p.add(c.p.get(x).negate() / a_s, c_s.p);
+        literals.push_back(to_literal(c));
+      }
+    }
+  } else {
+    // Resolve the bound with the others, taking the smaller side
+    size_t s = lower.size() <= upper.size() ? glb : lub;
+    const constraint& c_s = constraints[s];
+    rational a_s = abs(c_s.p.get(x));
+    bool s_strict = c_s.kind == CONSTRAINT_LT;
+    for (size_t i = 0; i < constraints.size(); ++ i) {
+      if (i == s) {
+        continue;
+      }
+      const constraint& c_i = constraints[i];
+      rational a_i = c_i.p.get(x);
+      bool i_strict = c_i.kind == CONSTRAINT_LT;
+      constraint c;
+      c.is_int = false;
+      if (a_i.sgn() == c_s.p.get(x).sgn()) {
+        // Same side: bound i is weaker than bound s
+        c.p.add(a_s, c_i.p);
+        c.p.add(abs(a_i).negate(), c_s.p);
+        c.kind = i_strict && !s_strict ? CONSTRAINT_LT : CONSTRAINT_LEQ;
+      } else {
+        // Opposite sides: bound s is within bound i
+        c.p.add(a_s, c_i.p);
+        c.p.add(abs(a_i), c_s.p);
+        c.kind = i_strict || s_strict ? CONSTRAINT_LT : CONSTRAINT_LEQ;
+      }
+      assert(c.p.get(x).sgn() == 0);
+      literals.push_back(to_literal(c));
+    }
+  }
+
+  replace_literals(x, literals);
+  return true;
+}
+
+}
+}
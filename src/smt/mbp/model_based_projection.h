@@ -0,0 +1,173 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "expr/term_manager.h"
+#include "expr/model.h"
+#include "expr/rational.h"
+#include "utils/statistics.h"
+
+#include <map>
+#include <set>
+#include <vector>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+namespace sally {
+namespace smt {
+
+/**
+ * Model-based projection of formulas over expr terms. Given formulas F(x, y),
+ * variables y and a model M of F, the projection computes a conjunction of
+ * literals G(x) such that
+ *
+ *   M |= G(x)     and     G(x) => \exists y . F(x, y).
+ *
+ * First, an implicant of F is extracted from the Boolean structure using the
+ * values in M (term-level if-then-else is resolved the same way). The
+ * variables are then eliminated from the implicant one at a time:
+ *
+ * - real variables with Loos-Weispfenning elimination, i.e. equalities are
+ *   solved and otherwise the bound closest to M is chosen and resolved
+ *   against the other bounds;
+ * - integer variables Cooper-style, i.e. solving unit equalities and
+ *   otherwise substituting the bound closest to M, when it has a unit
+ *   coefficient;
+ * - bit-vector and other variables by solving equalities x = t.
+ *
+ * When none of the above applies (e.g. non-linear occurrences) the variable
+ * is substituted with its value in M, which is always sound, but weaker.
+ */
+class model_based_projection {
+
+public:
+
+  model_based_projection(expr::term_manager& tm, utils::statistics& stats);
+
+  /** Project the conjunction of formulas onto the variables not in vars */
+  void project(const std::vector<expr::term_ref>& formulas, const std::set<expr::term_ref>& vars, expr::model::ref m, std::vector<expr::term_ref>& out);
+
+private:
+
+  /** The term manager */
+  expr::term_manager& d_tm;
+
+  /** The model we are projecting with */
+  expr::model::ref d_model;
+
+  /** The current literals */
+  std::vector<expr::term_ref> d_literals;
+
+  /** Set of current literals, for duplicates */
+  std::set<expr::term_ref> d_literals_set;
+
+  typedef boost::unordered_map<expr::term_ref, bool, expr::term_ref_hasher> bool_cache;
+
+  /** Values of the Boolean terms in the model */
+  bool_cache d_value_cache;
+
+  typedef boost::unordered_set<expr::term_ref, expr::term_ref_hasher> term_set;
+
+  /** Formulas already processed for the implicant, positive and negative */
+  term_set d_implicant_visited[2];
+
+  typedef boost::unordered_map<expr::term_ref, std::set<expr::term_ref>, expr::term_ref_hasher> variables_cache;
+
+  /** Variables of the terms */
+  variables_cache d_variables;
+
+  /** Linear term sum c_i*t_i + c (t_i are variables or non-linear terms) */
+  struct linear_term {
+    typedef std::map<expr::term_ref, expr::rational> coeff_map;
+    coeff_map coeffs;
+    expr::rational constant;
+    /** Get the coefficient of t */
+    expr::rational get(expr::term_ref t) const;
+    /** Add a*p to this term */
+    void add(const expr::rational& a, const linear_term& p);
+  };
+
+  enum constraint_kind {
+    CONSTRAINT_LT,
+    CONSTRAINT_LEQ,
+    CONSTRAINT_EQ
+  };
+
+  /** Linear constraint p < 0, p <= 0 or p = 0 */
+  struct constraint {
+    linear_term p;
+    constraint_kind kind;
+    /** All the terms are integer (coefficients are then integer too) */
+    bool is_int;
+  };
+
+  struct stats {
+    utils::stat_int* projections;
+    utils::stat_int* eliminated;
+    utils::stat_int* substituted;
+  } d_stats;
+
+  /** Is the formula true in the model */
+  bool is_true(expr::term_ref f);
+
+  /** Add the implicant of f (or not f if negative) to the literals */
+  void add_implicant(expr::term_ref f, bool positive);
+
+  /** Add a literal (if-then-else terms are resolved first) */
+  void add_literal(expr::term_ref l);
+
+  /** Replace the if-then-else terms by the branches true in the model */
+  expr::term_ref remove_ite(expr::term_ref t);
+
+  /** Linearize c*t into out */
+  void linearize(expr::term_ref t, const expr::rational& c, linear_term& out);
+
+  /** Get the constraint of the literal, false if not an arithmetic literal */
+  bool to_constraint(expr::term_ref l, constraint& out);
+
+  /** Normalize the integer constraint: integer coefficients, no strict */
+  void normalize_int(constraint& c);
+
+  /** Make a literal from the constraint */
+  expr::term_ref to_literal(const constraint& c);
+
+  /** Value of the term in the model */
+  expr::value evaluate(const linear_term& p);
+
+  /** Does the term contain the variable */
+  bool contains(expr::term_ref t, expr::term_ref x);
+
+  /** Eliminate the variable from the literals */
+  void eliminate(expr::term_ref x);
+
+  /** Eliminate an arithmetic variable, returns false if not linear */
+  bool eliminate_arithmetic(expr::term_ref x);
+
+  /** Eliminate by solving an equality x = t, returns false if none */
+  bool eliminate_equality(expr::term_ref x);
+
+  /** Substitute x with t in all the literals */
+  void substitute(expr::term_ref x, expr::term_ref t);
+
+  /** Replace the literals containing x with the given ones */
+  void replace_literals(expr::term_ref x, const std::vector<expr::term_ref>& literals);
+};
+
+}
+}
@@ -0,0 +1,152 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "smt/mbp_wrapper.h"
+#include "expr/gc_relocator.h"
+#include "utils/trace.h"
+
+namespace sally {
+namespace smt {
+
+mbp_wrapper::mbp_wrapper(expr::term_manager& tm, const options& opts, utils::statistics& stats, solver* s)
+: solver("mbp_wrapper[" + s->get_name() + "]", tm, opts, stats)
+, d_solver(s)
+, d_mbp(tm, stats)
+{
+}
+
+mbp_wrapper::~mbp_wrapper() {
+  delete d_solver;
+}
+
+bool mbp_wrapper::supports(feature f) const {
+  if (f == GENERALIZATION) {
+    return true;
+  }
+  return d_solver->supports(f);
+}
+
+void mbp_wrapper::add(expr::term_ref f, formula_class f_class) {
+  d_assertions.push_back(f);
+  d_assertion_classes.push_back(f_class);
+  d_solver->add(f, f_class);
+}
+
+void mbp_wrapper::flush() {
+  d_solver->flush();
+}
+
+solver::result mbp_wrapper::check() {
+  return d_solver->check();
+}
+
+solver::result mbp_wrapper::check_relaxed() {
+  return d_solver->check_relaxed();
+}
+
+solver::result mbp_wrapper::check(expr::model::ref m, const std::vector<expr::term_ref>& vars) {
+  return d_solver->check(m, vars);
+}
+
+bool mbp_wrapper::is_consistent() {
+  return d_solver->is_consistent();
+}
+
+void mbp_wrapper::check_model() {
+  d_solver->check_model();
+}
+
+expr::model::ref mbp_wrapper::get_model() const {
+  return d_solver->get_model();
+}
+
+void mbp_wrapper::push() {
+  d_assertions_size.push_back(d_assertions.size());
+  d_solver->push();
+}
+
+void mbp_wrapper::pop() {
+  size_t size = d_assertions_size.back();
+  d_assertions_size.pop_back();
+  d_assertions.resize(size);
+  d_assertion_classes.resize(size);
+  d_solver->pop();
+}
+
+void mbp_wrapper::generalize(generalization_type type, std::vector<expr::term_ref>& out) {
+  generalize(type, d_solver->get_model(), out);
+}
+
+void mbp_wrapper::generalize(generalization_type type, expr::model::ref m, std::vector<expr::term_ref>& out) {
+
+  TRACE("mbp") << "mbp_wrapper: generalizing" << std::endl;
+
+  // When we generalize backward we eliminate from T and B
+  // When we generalize forward we eliminate from A and T
+  formula_class to_keep = type == GENERALIZE_BACKWARD ? CLASS_A : CLASS_B;
+  std::vector<expr::term_ref> assertions;
+  for (size_t i = 0; i < d_assertions.size(); ++ i) {
+    if (d_assertion_classes[i] != to_keep) {
+      assertions.push_back(d_assertions[i]);
+    }
+  }
+
+  std::set<expr::term_ref> vars(d_T_variables);
+  if (type == GENERALIZE_BACKWARD) {
+    vars.insert(d_B_variables.begin(), d_B_variables.end());
+  } else {
+    vars.insert(d_A_variables.begin(), d_A_variables.end());
+  }
+
+  d_mbp.project(assertions, vars, m, out);
+}
+
+void mbp_wrapper::interpolate(std::vector<expr::term_ref>& out) {
+  d_solver->interpolate(out);
+}
+
+void mbp_wrapper::get_unsat_core(std::vector<expr::term_ref>& out) {
+  d_solver->get_unsat_core(out);
+}
+
+void mbp_wrapper::add_variable(expr::term_ref var, variable_class f_class) {
+  solver::add_variable(var, f_class);
+  d_solver->add_variable(var, f_class);
+}
+
+void mbp_wrapper::set_hint(expr::model::ref m) {
+  d_solver->set_hint(m);
+}
+
+void mbp_wrapper::gc() {
+  d_solver->gc();
+}
+
+void mbp_wrapper::gc_collect(const expr::gc_relocator& gc_reloc) {
+  solver::gc_collect(gc_reloc);
+  for (size_t i = 0; i < d_assertions.size(); ++ i) {
+    gc_reloc.reloc(d_assertions[i]);
+  }
+}
+
+void mbp_wrapper::memory_usage(utils::memory_report& report) const {
+  d_solver->memory_usage(report);
+}
+
+}
+}
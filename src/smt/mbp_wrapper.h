@@ -0,0 +1,79 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "smt/solver.h"
+#include "smt/mbp/model_based_projection.h"
+
+namespace sally {
+namespace smt {
+
+/**
+ * A solver that wraps another solver and generalizes with the built-in
+ * model-based projection. Everything else is passed to the solver. The
+ * wrapper keeps track of the assertions, so that any solver that produces
+ * models can be used for generalization.
+ */
+class mbp_wrapper : public solver {
+
+  /** Solver actually used */
+  solver* d_solver;
+
+  /** The assertions */
+  std::vector<expr::term_ref> d_assertions;
+
+  /** Classes of the assertions */
+  std::vector<formula_class> d_assertion_classes;
+
+  /** Assertion sizes per push */
+  std::vector<size_t> d_assertions_size;
+
+  /** The projection */
+  model_based_projection d_mbp;
+
+public:
+
+  /** Takes over the solver and will destruct it on destruction */
+  mbp_wrapper(expr::term_manager& tm, const options& opts, utils::statistics& stats, solver* s);
+  ~mbp_wrapper();
+
+  bool supports(feature f) const;
+  void add(expr::term_ref f, formula_class f_class);
+  void flush();
+  result check();
+  result check_relaxed();
+  result check(expr::model::ref m, const std::vector<expr::term_ref>& vars);
+  bool is_consistent();
+  void check_model();
+  expr::model::ref get_model() const;
+  void push();
+  void pop();
+  void generalize(generalization_type type, std::vector<expr::term_ref>& projection_out);
+  void generalize(generalization_type type, expr::model::ref m, std::vector<expr::term_ref>& projection_out);
+  void interpolate(std::vector<expr::term_ref>& out);
+  void get_unsat_core(std::vector<expr::term_ref>& out);
+  void add_variable(expr::term_ref var, variable_class f_class);
+  void set_hint(expr::model::ref m);
+  void gc();
+  void gc_collect(const expr::gc_relocator& gc_reloc);
+  void memory_usage(utils::memory_report& report) const;
+};
+
+}
+}
@@ -0,0 +1,210 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "smt/profile_wrapper.h"
+#include "expr/gc_relocator.h"
+#include "utils/output.h"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+namespace sally {
+namespace smt {
+
+typedef std::chrono::steady_clock profile_clock;
+
+std::atomic<size_t> profile_wrapper::s_slow_count(0);
+
+profile_wrapper::profile_wrapper(expr::term_manager& tm, const options& opts, utils::statistics& stats, solver* s)
+: solver("profile_wrapper[" + s->get_name() + "]", tm, opts, stats)
+, d_solver(s)
+, d_stats(stats)
+, d_slow_threshold(1)
+{
+  if (opts.has_option("solver-slow-queries")) {
+    d_slow_prefix = opts.get_string("solver-slow-queries");
+  }
+  if (opts.has_option("solver-slow-threshold")) {
+    d_slow_threshold = opts.get_double("solver-slow-threshold");
+  }
+}
+
+profile_wrapper::~profile_wrapper() {
+  delete d_solver;
+}
+
+profile_wrapper::site_stats& profile_wrapper::get_site_stats() {
+  const char* site = query_site::current();
+  std::map<const char*, site_stats>::iterator find = d_site_stats.find(site);
+  if (find != d_site_stats.end()) {
+    return find->second;
+  }
+  std::string prefix = "smt::profile::" + d_solver->get_name() + "::" + site;
+  site_stats& stats = d_site_stats[site];
+  stats.check_time = d_stats.register_histogram(prefix + "::check_time", "Time of the checks (seconds)");
+  stats.assertions = d_stats.register_int(prefix + "::assertions", "Number of assertions");
+  return stats;
+}
+
+void profile_wrapper::record_check(double seconds, result r) {
+  get_site_stats().check_time->record(seconds);
+  if (!d_slow_prefix.empty() && seconds >= d_slow_threshold) {
+    dump_query(seconds, r);
+  }
+}
+
+void profile_wrapper::dump_query(double seconds, result r) {
+  std::stringstream filename;
+  filename << d_slow_prefix << "." << std::setfill('0') << std::setw(4) << s_slow_count ++ << ".smt2";
+  std::ofstream out(filename.str().c_str());
+
+  output::set_output_language(out, output::MCMT);
+  output::set_term_manager(out, &d_tm);
+  output::set_use_lets(out, !d_opts.has_option("no-lets"));
+
+  out << "; " << seconds << " seconds in " << d_solver->get_name() << " at " << query_site::current() << "\n";
+  out << "(set-info :source |sally slow query|)\n";
+  if (r != UNKNOWN) {
+    out << "(set-info :status " << r << ")\n";
+  }
+  if (d_opts.has_option("solver-logic")) {
+    out << "(set-logic " << d_opts.get_string("solver-logic") << ")\n";
+  }
+  const std::set<expr::term_ref>* vars[3] = { &d_A_variables, &d_T_variables, &d_B_variables };
+  for (size_t i = 0; i < 3; ++ i) {
+    std::set<expr::term_ref>::const_iterator it = vars[i]->begin();
+    for (; it != vars[i]->end(); ++ it) {
+      out << "(declare-fun " << *it << " () " << d_tm.type_of(*it) << ")\n";
+    }
+  }
+  for (size_t i = 0; i < d_assertions.size(); ++ i) {
+    out << "(assert " << d_assertions[i].f << ")\n";
+  }
+  out << "(check-sat)\n";
+  out << "(exit)\n";
+}
+
+bool profile_wrapper::supports(feature f) const {
+  // Dumping the slow queries prints the terms
+  if (f == CONCURRENT_CHECK && !d_slow_prefix.empty()) {
+    return false;
+  }
+  return d_solver->supports(f);
+}
+
+void profile_wrapper::add(expr::term_ref f, formula_class f_class) {
+  d_assertions.push_back(assertion(f, f_class));
+  get_site_stats().assertions->increment();
+  d_solver->add(f, f_class);
+}
+
+void profile_wrapper::flush() {
+  d_solver->flush();
+}
+
+solver::result profile_wrapper::check() {
+  profile_clock::time_point start = profile_clock::now();
+  result r = d_solver->check();
+  record_check(std::chrono::duration<double>(profile_clock::now() - start).count(), r);
+  return r;
+}
+
+solver::result profile_wrapper::check_relaxed() {
+  profile_clock::time_point start = profile_clock::now();
+  result r = d_solver->check_relaxed();
+  record_check(std::chrono::duration<double>(profile_clock::now() - start).count(), r);
+  return r;
+}
+
+solver::result profile_wrapper::check(expr::model::ref m, const std::vector<expr::term_ref>& vars) {
+  profile_clock::time_point start = profile_clock::now();
+  result r = d_solver->check(m, vars);
+  record_check(std::chrono::duration<double>(profile_clock::now() - start).count(), r);
+  return r;
+}
+
+bool profile_wrapper::is_consistent() {
+  return d_solver->is_consistent();
+}
+
+void profile_wrapper::check_model() {
+  d_solver->check_model();
+}
+
+expr::model::ref profile_wrapper::get_model() const {
+  return d_solver->get_model();
+}
+
+void profile_wrapper::push() {
+  d_assertions_size.push_back(d_assertions.size());
+  d_solver->push();
+}
+
+void profile_wrapper::pop() {
+  size_t size = d_assertions_size.back();
+  d_assertions_size.pop_back();
+  while (d_assertions.size() > size) {
+    d_assertions.pop_back();
+  }
+  d_solver->pop();
+}
+
+void profile_wrapper::generalize(generalization_type type, std::vector<expr::term_ref>& projection_out) {
+  d_solver->generalize(type, projection_out);
+}
+
+void profile_wrapper::generalize(generalization_type type, expr::model::ref m, std::vector<expr::term_ref>& projection_out) {
+  d_solver->generalize(type, m, projection_out);
+}
+
+void profile_wrapper::interpolate(std::vector<expr::term_ref>& out) {
+  d_solver->interpolate(out);
+}
+
+void profile_wrapper::get_unsat_core(std::vector<expr::term_ref>& out) {
+  d_solver->get_unsat_core(out);
+}
+
+void profile_wrapper::add_variable(expr::term_ref var, variable_class f_class) {
+  solver::add_variable(var, f_class);
+  d_solver->add_variable(var, f_class);
+}
+
+void profile_wrapper::set_hint(expr::model::ref m) {
+  d_solver->set_hint(m);
+}
+
+void profile_wrapper::gc() {
+  d_solver->gc();
+}
+
+void profile_wrapper::gc_collect(const expr::gc_relocator& gc_reloc) {
+  solver::gc_collect(gc_reloc);
+  for (size_t i = 0; i < d_assertions.size(); ++ i) {
+    gc_reloc.reloc(d_assertions[i].f);
+  }
+}
+
+void profile_wrapper::memory_usage(utils::memory_report& report) const {
+  d_solver->memory_usage(report);
+}
+
+}
+}
@@ -0,0 +1,119 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "smt/solver.h"
+
+#include <map>
+#include <atomic>
+
+namespace sally {
+namespace smt {
+
+/**
+ * A solver that wraps another solver and profiles the queries. For each
+ * solver and query site (see query_site) it keeps a histogram of the check
+ * times and the number of assertions, in the statistics
+ *
+ *   smt::profile::<solver>::<site>::check_time
+ *   smt::profile::<solver>::<site>::assertions
+ *
+ * If the option solver-slow-queries is given, the checks that take longer
+ * than solver-slow-threshold seconds are written out as self-contained SMT2
+ * benchmarks (declarations, all the assertions on the stack, and the check),
+ * in files <prefix>.<n>.smt2.
+ */
+class profile_wrapper : public solver {
+
+  /** Solver actually used */
+  solver* d_solver;
+
+  struct assertion {
+    expr::term_ref f;
+    formula_class f_class;
+    assertion(expr::term_ref f, formula_class f_class)
+    : f(f), f_class(f_class) {}
+  };
+
+  /** The assertions */
+  std::vector<assertion> d_assertions;
+
+  /** Assertion sizes per push */
+  std::vector<size_t> d_assertions_size;
+
+  /** Statistics of a site */
+  struct site_stats {
+    utils::stat_histogram* check_time;
+    utils::stat_int* assertions;
+  };
+
+  /** Statistics per site (sites are static strings) */
+  std::map<const char*, site_stats> d_site_stats;
+
+  /** The statistics */
+  utils::statistics& d_stats;
+
+  /** Prefix of the slow query files (empty if not dumping) */
+  std::string d_slow_prefix;
+
+  /** Queries slower than this (seconds) are dumped */
+  double d_slow_threshold;
+
+  /** Number of slow queries dumped (by all solvers) */
+  static std::atomic<size_t> s_slow_count;
+
+  /** Get the statistics of the current site */
+  site_stats& get_site_stats();
+
+  /** Record a check that took the given time */
+  void record_check(double seconds, result r);
+
+  /** Write the current query into a new slow query file */
+  void dump_query(double seconds, result r);
+
+public:
+
+  /** Takes over the solver and will destruct it on destruction */
+  profile_wrapper(expr::term_manager& tm, const options& opts, utils::statistics& stats, solver* s);
+  ~profile_wrapper();
+
+  bool supports(feature f) const;
+  void add(expr::term_ref f, formula_class f_class);
+  void flush();
+  result check();
+  result check_relaxed();
+  result check(expr::model::ref m, const std::vector<expr::term_ref>& vars);
+  bool is_consistent();
+  void check_model();
+  expr::model::ref get_model() const;
+  void push();
+  void pop();
+  void generalize(generalization_type type, std::vector<expr::term_ref>& projection_out);
+  void generalize(generalization_type type, expr::model::ref m, std::vector<expr::term_ref>& projection_out);
+  void interpolate(std::vector<expr::term_ref>& out);
+  void get_unsat_core(std::vector<expr::term_ref>& out);
+  void add_variable(expr::term_ref var, variable_class f_class);
+  void set_hint(expr::model::ref m);
+  void gc();
+  void gc_collect(const expr::gc_relocator& gc_reloc);
+  void memory_usage(utils::memory_report& report) const;
+};
+
+}
+}
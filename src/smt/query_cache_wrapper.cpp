@@ -0,0 +1,472 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "smt/query_cache_wrapper.h"
+#include "expr/gc_relocator.h"
+#include "expr/term_io.h"
+#include "utils/trace.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdint.h>
+
+namespace sally {
+namespace smt {
+
+/** Structural hash of an assertion (stable across runs) */
+static inline
+size_t assertion_hash(const expr::term_manager& tm, expr::term_ref f, solver::formula_class f_class) {
+  return tm.hash_of(f) * 3 + f_class;
+}
+
+query_cache_wrapper::persistent_store query_cache_wrapper::s_persistent;
+
+std::ofstream* query_cache_wrapper::s_persistent_out = 0;
+
+std::mutex query_cache_wrapper::s_persistent_mutex;
+
+/** First line of the persistent store, change when the format or the term ops change */
+static const char* persistent_header = "sally-query-cache 1";
+
+/** Write the bytes in hex */
+static
+void write_hex(std::ostream& out, const std::string& bytes) {
+  static const char digits[] = "0123456789abcdef";
+  for (size_t i = 0; i < bytes.size(); ++ i) {
+    unsigned char c = bytes[i];
+    out << digits[c >> 4] << digits[c & 15];
+  }
+}
+
+/** Read the bytes from hex, returns false if malformed */
+static
+bool read_hex(const std::string& hex, std::string& bytes) {
+  if (hex.size() % 2) {
+    return false;
+  }
+  for (size_t i = 0; i < hex.size(); i += 2) {
+    int value = 0;
+    for (size_t j = i; j < i + 2; ++ j) {
+      char c = hex[j];
+      if (c >= '0' && c <= '9') {
+        value = value * 16 + (c - '0');
+      } else if (c >= 'a' && c <= 'f') {
+        value = value * 16 + (c - 'a' + 10);
+      } else {
+        return false;
+      }
+    }
+    bytes.push_back((char) value);
+  }
+  return true;
+}
+
+query_cache_wrapper::query_cache_wrapper(expr::term_manager& tm, const options& opts, utils::statistics& stats, solver* s)
+: solver("query_cache_wrapper[" + s->get_name() + "]", tm, opts, stats)
+, d_solver(s)
+, d_index(0)
+, d_scope(0)
+, d_last_entry(0)
+, d_solver_checked(false)
+, d_cache_hit(false)
+, d_last_result(UNKNOWN)
+, d_max_size(0)
+{
+  d_assertions_key.push_back(query_key());
+  if (opts.has_option("solver-cache-size")) {
+    d_max_size = opts.get_unsigned("solver-cache-size");
+  }
+  d_stats.hits = static_cast<utils::stat_int*>(stats.register_stat("smt::query_cache::hits"));
+  d_stats.persistent_hits = static_cast<utils::stat_int*>(stats.register_stat("smt::query_cache::persistent_hits"));
+  d_stats.misses = static_cast<utils::stat_int*>(stats.register_stat("smt::query_cache::misses"));
+  d_stats.hit_rate = static_cast<utils::stat_double*>(stats.register_stat("smt::query_cache::hit_rate"));
+}
+
+query_cache_wrapper::~query_cache_wrapper() {
+  delete d_solver;
+}
+
+bool query_cache_wrapper::supports(feature f) const {
+  // The persistent store writes the terms of the queries
+  if (f == CONCURRENT_CHECK && s_persistent_out) {
+    return false;
+  }
+  return d_solver->supports(f);
+}
+
+void query_cache_wrapper::add(expr::term_ref f, formula_class f_class) {
+  d_assertions.push_back(assertion(f, f_class));
+  // Extend the key of the prefix
+  size_t h = assertion_hash(d_tm, f, f_class);
+  const query_key& prev = d_assertions_key.back();
+  d_assertions_key.push_back(query_key(prev.h1 + utils::hash_mix(h + 0x9e3779b97f4a7c15ULL), prev.h2 + utils::hash_mix(h + 0x632be59bd9b4e019ULL)));
+  d_solver_checked = false;
+  d_cache_hit = false;
+  d_last_entry = 0;
+}
+
+void query_cache_wrapper::flush() {
+  for (; d_index < d_assertions.size(); ++ d_index) {
+    while (d_scope < d_assertions_size.size() && d_index == d_assertions_size[d_scope]) {
+      d_scope ++;
+      d_solver->push();
+    }
+    d_solver->add(d_assertions[d_index].f, d_assertions[d_index].f_class);
+  }
+}
+
+query_cache_wrapper::cache_entry* query_cache_wrapper::find_entry() {
+  std::pair<query_cache::iterator, query_cache::iterator> range = d_cache.equal_range(d_assertions_key.back());
+  if (range.first == range.second) {
+    return 0;
+  }
+  // Compare to the actual assertions (hash-consed, so refs are enough)
+  std::vector<assertion> sorted(d_assertions);
+  std::sort(sorted.begin(), sorted.end());
+  for (; range.first != range.second; ++ range.first) {
+    if (range.first->second.assertions == sorted) {
+      return &range.first->second;
+    }
+  }
+  return 0;
+}
+
+void query_cache_wrapper::get_query(std::string& out) const {
+  // Sort by the hash, term ids are not stable across runs
+  std::vector<std::pair<size_t, size_t> > sorted;
+  for (size_t i = 0; i < d_assertions.size(); ++ i) {
+    sorted.push_back(std::make_pair(assertion_hash(d_tm, d_assertions[i].f, d_assertions[i].f_class), i));
+  }
+  std::sort(sorted.begin(), sorted.end());
+  expr::term_writer writer(d_tm);
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < sorted.size(); ++ i) {
+    indices.push_back(writer.add_term(d_assertions[sorted[i].second].f));
+  }
+  writer.write_records(out);
+  expr::write_uint(out, sorted.size());
+  for (size_t i = 0; i < sorted.size(); ++ i) {
+    expr::write_uint(out, d_assertions[sorted[i].second].f_class);
+    expr::write_uint(out, indices[i]);
+  }
+}
+
+const query_cache_wrapper::persistent_entry* query_cache_wrapper::find_persistent_entry(std::string& query) const {
+  std::pair<persistent_store::const_iterator, persistent_store::const_iterator> range = s_persistent.equal_range(d_assertions_key.back());
+  for (; range.first != range.second; ++ range.first) {
+    if (query.empty()) {
+      get_query(query);
+    }
+    if (range.first->second.query == query) {
+      return &range.first->second;
+    }
+  }
+  return 0;
+}
+
+query_cache_wrapper::cache_entry* query_cache_wrapper::add_entry(result r) {
+  if (d_max_size > 0 && d_cache.size() >= d_max_size) {
+    d_cache.clear();
+  }
+  query_cache::iterator it = d_cache.insert(std::make_pair(d_assertions_key.back(), cache_entry()));
+  cache_entry& entry = it->second;
+  entry.assertions = d_assertions;
+  std::sort(entry.assertions.begin(), entry.assertions.end());
+  entry.r = r;
+  entry.model_vars = 0;
+  entry.has_core = false;
+  return &entry;
+}
+
+void query_cache_wrapper::update_hit_rate() {
+  int64_t hits = d_stats.hits->get_value() + d_stats.persistent_hits->get_value();
+  int64_t total = hits + d_stats.misses->get_value();
+  d_stats.hit_rate->set_value(total > 0 ? ((double) hits) / total : 0);
+}
+
+solver::result query_cache_wrapper::check_cached(bool relaxed) {
+
+  // Check the cache of this solver
+  d_last_entry = find_entry();
+  if (d_last_entry) {
+    TRACE("query_cache") << "query_cache: hit " << d_last_entry->r << std::endl;
+    d_stats.hits->increment();
+    update_hit_rate();
+    d_solver_checked = false;
+    d_cache_hit = true;
+    d_last_result = d_last_entry->r;
+    return d_last_result;
+  }
+
+  // Check the persistent store
+  std::string query;
+  {
+    std::lock_guard<std::mutex> lock(s_persistent_mutex);
+    const persistent_entry* persistent = find_persistent_entry(query);
+    if (persistent) {
+      TRACE("query_cache") << "query_cache: persistent hit " << persistent->r << std::endl;
+      d_stats.persistent_hits->increment();
+      update_hit_rate();
+      d_last_entry = add_entry(persistent->r);
+      d_solver_checked = false;
+      d_cache_hit = true;
+      d_last_result = persistent->r;
+      return d_last_result;
+    }
+  }
+
+  // Not cached, run the solver
+  d_stats.misses->increment();
+  update_hit_rate();
+  flush();
+  d_last_result = relaxed ? d_solver->check_relaxed() : d_solver->check();
+  d_solver_checked = true;
+  d_cache_hit = false;
+
+  // Remember the definite answers
+  if (d_last_result != UNKNOWN) {
+    d_last_entry = add_entry(d_last_result);
+    std::lock_guard<std::mutex> lock(s_persistent_mutex);
+    if (s_persistent_out) {
+      const query_key& key = d_assertions_key.back();
+      persistent_entry entry;
+      if (query.empty()) {
+        get_query(query);
+      }
+      entry.query = query;
+      entry.r = d_last_result;
+      s_persistent.insert(std::make_pair(key, entry));
+      *s_persistent_out << key.h1 << " " << key.h2 << " " << d_last_result << " ";
+      write_hex(*s_persistent_out, query);
+      *s_persistent_out << std::endl;
+    }
+  }
+
+  return d_last_result;
+}
+
+solver::result query_cache_wrapper::check() {
+  return check_cached(false);
+}
+
+solver::result query_cache_wrapper::check_relaxed() {
+  return check_cached(true);
+}
+
+solver::result query_cache_wrapper::check(expr::model::ref m, const std::vector<expr::term_ref>& vars) {
+  // Results modulo a model are not cached
+  flush();
+  d_last_result = d_solver->check(m, vars);
+  d_solver_checked = true;
+  d_cache_hit = false;
+  d_last_entry = 0;
+  return d_last_result;
+}
+
+void query_cache_wrapper::ensure_checked() {
+  if (!d_solver_checked) {
+    flush();
+    result r = d_solver->check();
+    d_solver_checked = true;
+    // Only a cached answer has to be confirmed by the solver
+    if (d_cache_hit && r != d_last_result) {
+      throw exception("query_cache_wrapper: cached result does not match the solver (") << d_last_result << " vs " << r << ")";
+    }
+  }
+}
+
+void query_cache_wrapper::check_model() {
+  ensure_checked();
+  d_solver->check_model();
+}
+
+expr::model::ref query_cache_wrapper::get_model() const {
+  query_cache_wrapper* nonconst = const_cast<query_cache_wrapper*>(this);
+  size_t vars = d_A_variables.size() + d_B_variables.size() + d_T_variables.size();
+  // Use the recorded model only if no variables were added since
+  if (d_last_entry && !d_last_entry->model.is_null() && d_last_entry->model_vars == vars) {
+    return d_last_entry->model;
+  }
+  nonconst->ensure_checked();
+  expr::model::ref m = d_solver->get_model();
+  if (d_last_entry) {
+    d_last_entry->model = m;
+    d_last_entry->model_vars = vars;
+  }
+  return m;
+}
+
+void query_cache_wrapper::push() {
+  d_assertions_size.push_back(d_assertions.size());
+  d_solver_checked = false;
+  d_cache_hit = false;
+  d_last_entry = 0;
+}
+
+void query_cache_wrapper::pop() {
+  // Pop the assertions stack
+  size_t size = d_assertions_size.back();
+  d_assertions_size.pop_back();
+  while (d_assertions.size() > size) {
+    d_assertions.pop_back();
+    d_assertions_key.pop_back();
+  }
+  // If we went below next one to process, also update
+  if (d_assertions.size() < d_index) {
+    d_index = d_assertions.size();
+  }
+  // If scope went below currently processed, also update
+  if (d_assertions_size.size() < d_scope) {
+    d_scope = d_assertions_size.size();
+    d_solver->pop();
+  }
+  d_solver_checked = false;
+  d_cache_hit = false;
+  d_last_entry = 0;
+}
+
+void query_cache_wrapper::generalize(generalization_type type, std::vector<expr::term_ref>& out) {
+  ensure_checked();
+  d_solver->generalize(type, out);
+}
+
+void query_cache_wrapper::generalize(generalization_type type, expr::model::ref m, std::vector<expr::term_ref>& out) {
+  // Generalization of a given model doesn't need a check
+  flush();
+  d_solver->generalize(type, m, out);
+}
+
+void query_cache_wrapper::interpolate(std::vector<expr::term_ref>& out) {
+  ensure_checked();
+  d_solver->interpolate(out);
+}
+
+void query_cache_wrapper::get_unsat_core(std::vector<expr::term_ref>& out) {
+  if (d_last_entry && d_last_entry->has_core) {
+    out.insert(out.end(), d_last_entry->core.begin(), d_last_entry->core.end());
+    return;
+  }
+  ensure_checked();
+  std::vector<expr::term_ref> core;
+  d_solver->get_unsat_core(core);
+  if (d_last_entry) {
+    d_last_entry->core = core;
+    d_last_entry->has_core = true;
+  }
+  out.insert(out.end(), core.begin(), core.end());
+}
+
+void query_cache_wrapper::add_variable(expr::term_ref var, variable_class f_class) {
+  solver::add_variable(var, f_class);
+  d_solver->add_variable(var, f_class);
+}
+
+void query_cache_wrapper::set_hint(expr::model::ref m) {
+  flush();
+  d_solver->set_hint(m);
+}
+
+void query_cache_wrapper::gc_collect(const expr::gc_relocator& gc_reloc) {
+  solver::gc_collect(gc_reloc);
+  for (size_t i = 0; i < d_assertions.size(); ++ i) {
+    gc_reloc.reloc(d_assertions[i].f);
+  }
+  // Relocate the cache, removing the queries with collected terms (the keys
+  // are structural, so they don't change)
+  query_cache::iterator it = d_cache.begin();
+  while (it != d_cache.end()) {
+    cache_entry& entry = it->second;
+    bool collected = false;
+    for (size_t i = 0; !collected && i < entry.assertions.size(); ++ i) {
+      collected = !gc_reloc.reloc(entry.assertions[i].f);
+    }
+    if (collected) {
+      it = d_cache.erase(it);
+    } else {
+      std::sort(entry.assertions.begin(), entry.assertions.end());
+      gc_reloc.reloc(entry.core);
+      ++ it;
+    }
+  }
+  d_last_entry = 0;
+}
+
+void query_cache_wrapper::memory_usage(utils::memory_report& report) const {
+  // Each hash node has the entry, the key and two pointers
+  size_t cache = d_cache.bucket_count()*sizeof(void*);
+  query_cache::const_iterator it = d_cache.begin();
+  for (; it != d_cache.end(); ++ it) {
+    const cache_entry& entry = it->second;
+    cache += sizeof(query_cache::value_type) + 2*sizeof(void*);
+    cache += utils::memory_of(entry.assertions) + utils::memory_of(entry.core);
+    if (!entry.model.is_null()) {
+      cache += entry.model->memory_size();
+    }
+  }
+  report.add("smt::query_cache", cache);
+  d_solver->memory_usage(report);
+}
+
+void query_cache_wrapper::open_persistent_store(std::string filename) {
+  std::lock_guard<std::mutex> lock(s_persistent_mutex);
+  // Read the existing results, if the file is in the current format
+  std::ifstream in(filename.c_str());
+  std::string line;
+  bool current = std::getline(in, line) && line == persistent_header;
+  while (current && std::getline(in, line)) {
+    std::istringstream line_in(line);
+    size_t h1, h2;
+    std::string r, hex;
+    if (!(line_in >> h1 >> h2 >> r >> hex)) {
+      continue;
+    }
+    persistent_entry entry;
+    if (r == "sat") {
+      entry.r = SAT;
+    } else if (r == "unsat") {
+      entry.r = UNSAT;
+    } else {
+      continue;
+    }
+    if (read_hex(hex, entry.query)) {
+      s_persistent.insert(std::make_pair(query_key(h1, h2), entry));
+    }
+  }
+  in.close();
+  // Append new results (start over if the file is in another format)
+  if (s_persistent_out) {
+    delete s_persistent_out;
+  }
+  if (current) {
+    s_persistent_out = new std::ofstream(filename.c_str(), std::ios_base::app);
+  } else {
+    s_persistent_out = new std::ofstream(filename.c_str(), std::ios_base::trunc);
+    *s_persistent_out << persistent_header << std::endl;
+  }
+}
+
+void query_cache_wrapper::close_persistent_store() {
+  std::lock_guard<std::mutex> lock(s_persistent_mutex);
+  if (s_persistent_out) {
+    delete s_persistent_out;
+    s_persistent_out = 0;
+  }
+}
+
+}
+}
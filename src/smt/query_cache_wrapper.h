@@ -0,0 +1,229 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "smt/solver.h"
+
+#include <map>
+#include <mutex>
+#include <fstream>
+#include <boost/unordered_map.hpp>
+
+namespace sally {
+namespace smt {
+
+/**
+ * A solver that wraps another solver and remembers the results of previous
+ * checks. The key of a query is the set of asserted formulas, hashed with
+ * the structural term hash. Assertions are passed to the solver only when a
+ * query is not in the cache (as in delayed_wrapper). Models and unsat cores
+ * are recorded when requested. If the solver is asked for something that is
+ * not recorded (e.g. an interpolant after a cache hit) the query is sent to
+ * the solver first.
+ *
+ * Optionally, SAT/UNSAT results are also kept in a file so that they can be
+ * reused between runs. Since term references are not stable across runs,
+ * the persistent store keeps the assertions of each query as written by
+ * expr::term_writer (sorted by their structural hash), and a result is only
+ * reused if they are the same. The store is shared by all the wrappers and
+ * guarded by a lock.
+ */
+class query_cache_wrapper : public solver {
+
+  struct assertion {
+    expr::term_ref f;
+    formula_class f_class;
+    assertion(expr::term_ref f, formula_class f_class)
+    : f(f), f_class(f_class) {}
+    bool operator < (const assertion& other) const {
+      if (f == other.f) return f_class < other.f_class;
+      return f < other.f;
+    }
+    bool operator == (const assertion& other) const {
+      return f == other.f && f_class == other.f_class;
+    }
+  };
+
+  /**
+   * Key of a query: two order-insensitive combinations of the assertion
+   * hashes. Both come from the same hashes, so entries with the same key are
+   * compared to the actual assertions.
+   */
+  struct query_key {
+    size_t h1, h2;
+    query_key(): h1(0), h2(0) {}
+    query_key(size_t h1, size_t h2): h1(h1), h2(h2) {}
+    bool operator < (const query_key& other) const {
+      return h1 == other.h1 ? h2 < other.h2 : h1 < other.h1;
+    }
+    bool operator == (const query_key& other) const {
+      return h1 == other.h1 && h2 == other.h2;
+    }
+  };
+
+  struct query_key_hasher {
+    size_t operator () (const query_key& key) const {
+      return key.h1;
+    }
+  };
+
+  /** A cached query */
+  struct cache_entry {
+    /** The assertions of the query, sorted */
+    std::vector<assertion> assertions;
+    /** The result */
+    result r;
+    /** The model, if SAT and requested */
+    expr::model::ref model;
+    /** Number of variables declared when the model was recorded */
+    size_t model_vars;
+    /** The unsat core, if UNSAT and requested */
+    std::vector<expr::term_ref> core;
+    /** Do we have the core */
+    bool has_core;
+  };
+
+  typedef boost::unordered_multimap<query_key, cache_entry, query_key_hasher> query_cache;
+
+  /** The cache */
+  query_cache d_cache;
+
+  /** Solver actually used */
+  solver* d_solver;
+
+  /** Keep track of assertions */
+  std::vector<assertion> d_assertions;
+
+  /** Key of the assertion prefixes (i-th element is key of the first i assertions) */
+  std::vector<query_key> d_assertions_key;
+
+  /** Assertion sizes per push */
+  std::vector<size_t> d_assertions_size;
+
+  /** The index of the next assertion to send to the solver */
+  size_t d_index;
+
+  /** The scope we last sent to the solver */
+  size_t d_scope;
+
+  /** Entry of the last check (null if last check was not cached) */
+  cache_entry* d_last_entry;
+
+  /** True if the solver has been checked on the current assertions */
+  bool d_solver_checked;
+
+  /** True if the last check was answered by the cache */
+  bool d_cache_hit;
+
+  /** Result of the last check */
+  result d_last_result;
+
+  /** Maximal number of entries to keep (0 for no limit) */
+  size_t d_max_size;
+
+  /** A result from the persistent store */
+  struct persistent_entry {
+    /** The assertions of the query (see get_query()) */
+    std::string query;
+    /** The result */
+    result r;
+  };
+
+  typedef std::multimap<query_key, persistent_entry> persistent_store;
+
+  /** Persistent results from all runs */
+  static persistent_store s_persistent;
+
+  /** Output for new persistent results */
+  static std::ofstream* s_persistent_out;
+
+  /** Lock for the persistent store */
+  static std::mutex s_persistent_mutex;
+
+  struct stats {
+    utils::stat_int* hits;
+    utils::stat_int* persistent_hits;
+    utils::stat_int* misses;
+    utils::stat_double* hit_rate;
+  } d_stats;
+
+  /** Make sure the solver state corresponds to the last check */
+  void ensure_checked();
+
+  /** Look up the current assertions in the cache */
+  cache_entry* find_entry();
+
+  /**
+   * Write the current assertions with their classes, sorted by the
+   * structural hash, as by expr::term_writer. Equal outputs are the same
+   * query, also across runs.
+   */
+  void get_query(std::string& out) const;
+
+  /**
+   * Look up the current assertions in the persistent store (call locked).
+   * The query is written to the given string if needed and not there yet.
+   */
+  const persistent_entry* find_persistent_entry(std::string& query) const;
+
+  /** Add the result of the current assertions to the cache */
+  cache_entry* add_entry(result r);
+
+  /** Update the hit rate */
+  void update_hit_rate();
+
+  /** Check (possibly relaxed) going through the cache */
+  result check_cached(bool relaxed);
+
+public:
+
+  /** Takes over the solver and will destruct it on destruction */
+  query_cache_wrapper(expr::term_manager& tm, const options& opts, utils::statistics& stats, solver* s);
+  ~query_cache_wrapper();
+
+  bool supports(feature f) const;
+  void add(expr::term_ref f, formula_class f_class);
+  void flush();
+  result check();
+  result check_relaxed();
+  result check(expr::model::ref m, const std::vector<expr::term_ref>& vars);
+  void check_model();
+  expr::model::ref get_model() const;
+  void push();
+  void pop();
+  void generalize(generalization_type type, std::vector<expr::term_ref>& projection_out);
+  void generalize(generalization_type type, expr::model::ref m, std::vector<expr::term_ref>& projection_out);
+  void interpolate(std::vector<expr::term_ref>& out);
+  void get_unsat_core(std::vector<expr::term_ref>& out);
+  void add_variable(expr::term_ref var, variable_class f_class);
+  void set_hint(expr::model::ref m);
+  void gc_collect(const expr::gc_relocator& gc_reloc);
+  void memory_usage(utils::memory_report& report) const;
+
+  /** Load the persistent results from the file and append new ones to it */
+  static
+  void open_persistent_store(std::string filename);
+
+  /** Close the persistent store */
+  static
+  void close_persistent_store();
+};
+
+}
+}
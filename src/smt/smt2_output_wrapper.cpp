@@ -26,31 +26,37 @@ namespace smt {
 smt2_output_wrapper::smt2_output_wrapper(expr::term_manager& tm, const options& opts, utils::statistics& stats, solver* solver, std::string filename)
 : smt::solver("smt2_wrapper[" + filename + "]", tm, opts, stats)
 , d_solver(solver)
-, d_output(filename.c_str())
+, d_output_buffer(1 << 20)
+, d_use_definitions(!opts.has_option("no-lets"))
+, d_definitions(tm, "_def")
 , d_total_assertions_count(0)
 , d_vars_added(false)
 {
+  // Buffer must be set before opening
+  d_output.rdbuf()->pubsetbuf(&d_output_buffer[0], d_output_buffer.size());
+  d_output.open(filename.c_str());
+
   // Setup the stream
   output::set_output_language(d_output, output::MCMT);
   output::set_term_manager(d_output, &d_tm);
   output::set_use_lets(d_output, !opts.has_option("no-lets"));
 
   // Models by default
-  d_output << "(set-option :produce-models true)" << std::endl;
+  d_output << "(set-option :produce-models true)\n";
 
   // Unsat cores if supported
   if (solver->supports(solver::UNSAT_CORE)) {
-    d_output << "(set-option :produce-unsat-cores true)" << std::endl;
+    d_output << "(set-option :produce-unsat-cores true)\n";
   }
 
   // Interpolation if supported
   if (solver->supports(solver::INTERPOLATION)) {
-    d_output << "(set-option :produce-interpolants true)" << std::endl;
+    d_output << "(set-option :produce-interpolants true)\n";
   }
 
   // If logic set, set it
   if (opts.has_option("solver-logic") > 0) {
-    d_output << "(set-logic " << opts.get_string("solver-logic") << ")" << std::endl;
+    d_output << "(set-logic " << opts.get_string("solver-logic") << ")\n";
   }
 }
 
@@ -58,6 +64,32 @@ smt2_output_wrapper::~smt2_output_wrapper() {
   delete d_solver;
 }
 
+void smt2_output_wrapper::output_definitions(expr::term_ref f) {
+  if (!d_use_definitions) {
+    return;
+  }
+  std::vector<expr::term_ref> definitions;
+  d_definitions.add(f, definitions);
+  for (size_t i = 0; i < definitions.size(); ++ i) {
+    expr::term_ref t = definitions[i];
+    d_output << "(define-fun ";
+    d_definitions.output_name(d_output, t);
+    d_output << " () ";
+    d_tm.term_of(d_tm.type_of(t)).to_stream_smt_without_let(d_output, d_tm, d_definitions);
+    d_output << " ";
+    d_tm.term_of(t).to_stream_smt_without_let(d_output, d_tm, d_definitions, false);
+    d_output << ")\n";
+  }
+}
+
+void smt2_output_wrapper::output_term(expr::term_ref t) {
+  if (d_use_definitions) {
+    d_tm.term_of(t).to_stream_smt_without_let(d_output, d_tm, d_definitions);
+  } else {
+    d_output << t;
+  }
+}
+
 bool smt2_output_wrapper::supports(feature f) const {
   return d_solver->supports(f);
 }
@@ -70,11 +102,13 @@ void smt2_output_wrapper::add(expr::term_ref f, formula_class f_class) {
 
   bool needs_annotation = d_solver->supports(solver::UNSAT_CORE) || d_solver->supports(solver::INTERPOLATION);
 
+  output_definitions(f);
+
   d_output << "(assert ";
   if (needs_annotation) {
     d_output << "(! ";
   }
-  d_output << f;
+  output_term(f);
   if (d_solver->supports(solver::UNSAT_CORE)) {
     d_output << " :named a" << a.index;
   }
@@ -88,11 +122,15 @@ void smt2_output_wrapper::add(expr::term_ref f, formula_class f_class) {
   if (needs_annotation) {
     d_output << ")";
   }
-  d_output << ")" << std::endl;
+  d_output << ")\n";
 
   d_solver->add(f, f_class);
 }
 
+void smt2_output_wrapper::flush() {
+  d_solver->flush();
+}
+
 solver::result smt2_output_wrapper::check() {
   d_output << "(check-sat)" << std::endl;
   return d_solver->check();
@@ -105,31 +143,33 @@ expr::model::ref smt2_output_wrapper::get_model() const {
   bool space = false;
   for (it = d_A_variables.begin(); it != d_A_variables.end(); ++ it, space = true) {
     if (space) { out_nonconst << " "; }
-    out_nonconst << *it << std::endl;
+    out_nonconst << *it << "\n";
   }
   for (it = d_T_variables.begin(); it != d_T_variables.end(); ++ it, space = true) {
     if (space) { out_nonconst << " "; }
-    out_nonconst << *it << std::endl;
+    out_nonconst << *it << "\n";
   }
   for (it = d_B_variables.begin(); it != d_B_variables.end(); ++ it, space = true) {
     if (space) { out_nonconst << " "; }
-    out_nonconst << *it << std::endl;
+    out_nonconst << *it << "\n";
   }
-  out_nonconst << "))" << std::endl;
+  out_nonconst << "))\n";
 
   return d_solver->get_model();
 }
 
 void smt2_output_wrapper::push() {
-  d_output << "(push 1)" << std::endl;
+  d_output << "(push 1)\n";
   d_solver->push();
+  d_definitions.push();
 
   d_assertions_size.push_back(d_assertions.size());
 }
 
 void smt2_output_wrapper::pop() {
-  d_output << "(pop 1)" << std::endl;
+  d_output << "(pop 1)\n";
   d_solver->pop();
+  d_definitions.pop();
 
   size_t size = d_assertions_size.back();
   d_assertions_size.pop_back();
@@ -147,17 +187,17 @@ void smt2_output_wrapper::generalize(generalization_type type, expr::model::ref
 }
 
 void smt2_output_wrapper::interpolate(std::vector<expr::term_ref>& out) {
-  d_output << "(get-interpolant (A))" << std::endl;
+  d_output << "(get-interpolant (A))\n";
   d_solver->interpolate(out);
 }
 
 void smt2_output_wrapper::get_unsat_core(std::vector<expr::term_ref>& out) {
-  d_output << "(get-unsat-core)" << std::endl;
+  d_output << "(get-unsat-core)\n";
   d_solver->get_unsat_core(out);
 }
 
 void smt2_output_wrapper::add_variable(expr::term_ref var, variable_class f_class) {
-  d_output << "(declare-fun " << var << " () " << d_tm.type_of(var) << ")" << std::endl;
+  d_output << "(declare-fun " << var << " () " << d_tm.type_of(var) << ")\n";
   solver::add_variable(var, f_class);
   d_solver->add_variable(var, f_class);
   d_vars_added = true;
@@ -172,5 +212,9 @@ void smt2_output_wrapper::gc_collect(const expr::gc_relocator& gc_reloc) {
   }
 }
 
+void smt2_output_wrapper::memory_usage(utils::memory_report& report) const {
+  d_solver->memory_usage(report);
+}
+
 }
 }
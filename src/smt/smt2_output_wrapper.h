@@ -19,6 +19,7 @@
 #pragma once
 
 #include "smt/solver.h"
+#include "expr/term_definitions.h"
 
 #include <fstream>
 
@@ -27,15 +28,33 @@ namespace smt {
 
 /**
  * A solver that wraps another solver and outputs the queries to a file.
+ * Unless lets are disabled, the subterms of the assertions are output as
+ * define-fun definitions that are kept (within the push/pop scopes), so each
+ * subterm is output once and the assertions refer to it by name.
  */
 class smt2_output_wrapper : public solver {
 
   /** Solver actually used */
   solver* d_solver;
 
+  /** Buffer of the output (flushed on check) */
+  std::vector<char> d_output_buffer;
+
   /** Output */
   std::ofstream d_output;
 
+  /** Should we output the definitions */
+  bool d_use_definitions;
+
+  /** Subterms defined so far */
+  expr::term_definitions d_definitions;
+
+  /** Output the definitions of the subterms of f that are not defined yet */
+  void output_definitions(expr::term_ref f);
+
+  /** Output the term (by name if defined) */
+  void output_term(expr::term_ref t);
+
   /** Total number of assertions */
   int d_total_assertions_count;
 
@@ -64,6 +83,7 @@ public:
 
   bool supports(feature f) const;
   void add(expr::term_ref f, formula_class f_class);
+  void flush();
   result check();
   expr::model::ref get_model() const;
   void push();
@@ -74,6 +94,7 @@ public:
   void get_unsat_core(std::vector<expr::term_ref>& out);
   void add_variable(expr::term_ref var, variable_class f_class);
   void gc_collect(const expr::gc_relocator& gc_reloc);
+  void memory_usage(utils::memory_report& report) const;
 
 };
 
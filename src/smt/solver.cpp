@@ -25,6 +25,8 @@
 namespace sally {
 namespace smt {
 
+thread_local const char* query_site::s_current = "other";
+
 std::ostream& operator << (std::ostream& out, solver::result result) {
   switch (result) {
   case solver::SAT:
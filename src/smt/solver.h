@@ -25,6 +25,7 @@
 #include "utils/options.h"
 #include "utils/name_transformer.h"
 #include "utils/statistics.h"
+#include "utils/memory.h"
 #include "utils/smart_ptr.h"
 
 namespace sally {
@@ -105,7 +106,9 @@ public:
     GENERALIZATION,
     INTERPOLATION,
     UNSAT_CORE,
-    SMT_MODULO_MODELS
+    SMT_MODULO_MODELS,
+    /** Independent instances can be checked from several threads, after flush() */
+    CONCURRENT_CHECK
   };
 
   /**
@@ -161,6 +164,13 @@ public:
   virtual
   void add(expr::term_ref f, formula_class f_class) = 0;
 
+  /**
+   * Send all the pending assertions to the backend, so that the following
+   * check() does no term work (e.g. for solvers that delay the assertions).
+   */
+  virtual
+  void flush() {}
+
   /** Check for satisfiability */
   virtual
   result check() = 0;
@@ -296,6 +306,13 @@ public:
   virtual
   void gc() {}
 
+  /**
+   * Add the memory of the solver to the report (wrappers add the memory of
+   * the wrapped solvers).
+   */
+  virtual
+  void memory_usage(utils::memory_report& report) const {}
+
   /** Collect base terms */
   void gc_collect(const expr::gc_relocator& gc_reloc);
 };
@@ -331,5 +348,21 @@ public:
 
 std::ostream& operator << (std::ostream& out, solver::formula_class fc);
 
+/**
+ * Marks the solver queries made in its scope as coming from the given site
+ * (e.g. "pdkind::check_inductive"), so that the profiling of the solvers can
+ * tell them apart. Sites nest, the innermost counts. The site is per thread,
+ * queries outside of any site are from "other".
+ */
+class query_site {
+  const char* d_previous;
+  static thread_local const char* s_current;
+public:
+  query_site(const char* name): d_previous(s_current) { s_current = name; }
+  ~query_site() { s_current = d_previous; }
+  /** The current site */
+  static const char* current() { return s_current; }
+};
+
 }
 }
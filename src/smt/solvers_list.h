@@ -31,6 +31,7 @@
 #include "smt/generic/generic_solver_info.h"
 #include "smt/dreal/dreal_info.h"
 #include "smt/d4y2/d4y2_info.h"
+#include "smt/bitblast/bitblast_info.h"
 
 sally::smt::solver_data::solver_data() {
 #ifdef WITH_YICES2
@@ -54,6 +55,7 @@ sally::smt::solver_data::solver_data() {
 #endif // WITH_YICES2
 #endif // WITH_OPENSMT2
   add_module_info<generic_solver_info>();
+  add_module_info<bitblast_info>();
 #ifdef WITH_DREAL
   add_module_info<dreal_info>();
 #endif   
@@ -159,6 +159,11 @@ void y2m5::gc() {
   d_mathsat5->gc();
 }
 
+void y2m5::memory_usage(utils::memory_report& report) const {
+  d_yices2->memory_usage(report);
+  d_mathsat5->memory_usage(report);
+}
+
 void y2m5::gc_collect(const expr::gc_relocator& gc_reloc) {
   solver::gc_collect(gc_reloc);
 }
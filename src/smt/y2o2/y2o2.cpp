@@ -160,6 +160,11 @@ void y2o2::gc() {
   d_opensmt2->gc();
 }
 
+void y2o2::memory_usage(utils::memory_report& report) const {
+  d_yices2->memory_usage(report);
+  d_opensmt2->memory_usage(report);
+}
+
 void y2o2::gc_collect(const expr::gc_relocator& gc_reloc) {
   solver::gc_collect(gc_reloc);
 }
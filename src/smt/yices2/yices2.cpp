@@ -119,6 +119,10 @@ void yices2::gc() {
   d_internal->gc();
 }
 
+void yices2::memory_usage(utils::memory_report& report) const {
+  d_internal->memory_usage(report);
+}
+
 void yices2::gc_collect(const expr::gc_relocator& gc_reloc) {
   solver::gc_collect(gc_reloc);
   d_internal->gc_collect(gc_reloc);
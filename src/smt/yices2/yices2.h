@@ -94,6 +94,9 @@ public:
 
   /** Collect garbage */
   void gc();
+
+  /** The term cache (shared by all instances) */
+  void memory_usage(utils::memory_report& report) const;
 };
 
 }
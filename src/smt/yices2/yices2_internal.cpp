@@ -25,6 +25,7 @@
 #include "utils/trace.h"
 #include "expr/gc_relocator.h"
 #include "expr/term_visitor.h"
+#include "expr/term_traversal.h"
 #include "utils/output.h"
 #include "expr/value.h"
 
@@ -477,19 +478,6 @@ public:
   , d_conversion_cache(cache)
   {}
 
-  // Non-null terms are good
-  bool is_good_term(expr::term_ref t) const {
-    return !t.is_null();
-  }
-
-  // Get the children of t
-  void get_children(expr::term_ref t, std::vector<expr::term_ref>& children) {
-    const expr::term& t_term = d_tm.term_of(t);
-    for (size_t i = 0; i < t_term.size(); ++ i) {
-      children.push_back(t_term[i]);
-    }
-  }
-
   // We visit all regular nodes
   // the cache yet
   expr::visitor_match_result match(expr::term_ref t) {
@@ -620,8 +608,8 @@ public:
 
 term_t yices2_internal::to_yices2_term(expr::term_ref ref) {
   to_yices_visitor visitor(d_tm, *this, *d_conversion_cache);
-  expr::term_visit_topological<to_yices_visitor, expr::term_ref, expr::term_ref_hasher> topological_visit(visitor);
-  topological_visit.run(ref);
+  expr::term_traversal traversal(d_tm);
+  traversal.run(visitor, ref);
   term_t result = d_conversion_cache->get_term_cache(ref);
   assert(result != NULL_TERM);
   return result;
@@ -1702,6 +1690,11 @@ void yices2_internal::gc() {
   d_conversion_cache->gc();
 }
 
+void yices2_internal::memory_usage(utils::memory_report& report) const {
+  // Yices doesn't report its own memory, so just the conversion cache
+  report.set("smt::yices2::term_cache", d_conversion_cache->memory_size());
+}
+
 void yices2_internal::get_assertions(std::set<expr::term_ref>& out) const {
   for (size_t i = 0; i < d_assertions.size(); ++ i) {
     out.insert(d_assertions[i]);
@@ -208,6 +208,9 @@ public:
   /** Collect garbage */
   void gc();
 
+  /** Add the memory of the term cache to the report */
+  void memory_usage(utils::memory_report& report) const;
+
   /** Wrap yices_error_string cleanly */
   static std::string yices_error(void);
   
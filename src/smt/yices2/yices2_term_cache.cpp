@@ -171,6 +171,14 @@ yices2_term_cache* yices2_term_cache::get_cache(expr::term_manager& tm) {
   return cache;
 }
 
+size_t yices2_term_cache::memory_size() const {
+  // Tree nodes have the pair and four words, hash nodes the pair and two
+  size_t to_yices = d_term_to_yices_cache.size()*(sizeof(term_to_yices_cache::value_type) + 4*sizeof(void*));
+  size_t from_yices = d_yices_to_term_cache.bucket_count()*sizeof(void*);
+  from_yices += d_yices_to_term_cache.size()*(sizeof(yices_to_term_cache::value_type) + 2*sizeof(void*));
+  return to_yices + from_yices + utils::memory_of(d_permanent_terms) + utils::memory_of(d_permanent_terms_yices);
+}
+
 void yices2_term_cache::gc() {
   if (!d_cache_is_clean) {
 
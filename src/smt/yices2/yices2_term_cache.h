@@ -111,6 +111,9 @@ public:
 
   /** Collect the cache, leaving only the variables */
   void gc();
+
+  /** Estimate of the bytes used by the cache (map nodes are estimated) */
+  size_t memory_size() const;
 };
 
 }
@@ -90,6 +90,10 @@ void z3::gc() {
   d_internal->gc();
 }
 
+void z3::memory_usage(utils::memory_report& report) const {
+  report.set("smt::z3::native", Z3_get_estimated_alloc_size());
+}
+
 void z3::gc_collect(const expr::gc_relocator& gc_reloc) {
   solver::gc_collect(gc_reloc);
   d_internal->gc_collect(gc_reloc);
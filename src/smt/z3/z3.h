@@ -71,6 +71,9 @@ public:
 
   /** Collect garbage */
   void gc();
+
+  /** Memory reported by z3 (for all instances) */
+  void memory_usage(utils::memory_report& report) const;
 };
 
 }
@@ -39,6 +39,31 @@ size_t trace_helper::size() const {
   return d_state_variables_structs.size();
 }
 
+void trace_helper::memory_usage(utils::memory_report& report) const {
+  size_t variables = utils::memory_of(d_state_variables_structs) + utils::memory_of(d_input_variables_structs);
+  variables += utils::memory_of(d_state_variables) + utils::memory_of(d_input_variables);
+  for (size_t k = 0; k < d_state_variables.size(); ++ k) {
+    variables += utils::memory_of(d_state_variables[k]);
+  }
+  for (size_t k = 0; k < d_input_variables.size(); ++ k) {
+    variables += utils::memory_of(d_input_variables[k]);
+  }
+  report.add("system::trace::variables", variables);
+
+  size_t renaming = utils::memory_of(d_subst_maps_state_to_trace) + utils::memory_of(d_subst_maps_trace_to_state);
+  for (size_t k = 0; k < d_subst_maps_state_to_trace.size(); ++ k) {
+    renaming += d_subst_maps_state_to_trace[k].memory_size();
+  }
+  for (size_t k = 0; k < d_subst_maps_trace_to_state.size(); ++ k) {
+    renaming += d_subst_maps_trace_to_state[k].memory_size();
+  }
+  report.add("system::trace::renaming", renaming);
+
+  if (!d_model.is_null()) {
+    report.add("system::trace::model", d_model->memory_size());
+  }
+}
+
 void trace_helper::clear_model() {
   d_model_size = 0;
   d_model = new expr::model(tm(), false);
@@ -187,125 +212,37 @@ void trace_helper::set_model(expr::model::ref m, size_t start, size_t end) {
   d_model_size = std::max(end + 1, d_model_size);
 }
 
-void trace_helper::to_stream_mcmt(std::ostream& out) const {
-  d_state_type->use_namespace();
-  d_state_type->use_namespace(state_type::STATE_CURRENT);
-  d_state_type->use_namespace(state_type::STATE_INPUT);
-
-  out << "(trace " << std::endl;
-
-  // Variables to use for printing names
-  const std::vector<expr::term_ref> state_vars = d_state_type->get_variables(state_type::STATE_CURRENT);
-  const std::vector<expr::term_ref> input_vars = d_state_type->get_variables(state_type::STATE_INPUT);
-
-  // Output the values
-  for (size_t k = 0; k < d_model_size; ++ k) {
-
-    out << "  ;; State at " << k << std::endl;
-
-    // The state variables
-    out << "  (state" << std::endl;
-    std::vector<expr::term_ref> state_vars_k;
-    get_struct_variables(d_state_variables_structs[k], state_vars_k);
-    assert(state_vars.size() == state_vars_k.size());
-    for (size_t i = 0; i < state_vars_k.size(); ++ i) {
-      const expr::value& v = d_model->get_variable_value(state_vars_k[i]);
-      if (v.is_algebraic()) {
-        out << "    (" << state_vars[i] << " " << v.get_algebraic().approx() << ") ;; " << v << std::endl;
-      } else {
-        out << "    (" << state_vars[i] << " " << v << ")" << std::endl;
-      }
-    }
-    out << "  )" << std::endl;
-
-    // The input variables (except the last one)
-    if (k + 1 < d_model_size && input_vars.size() > 0) {
-      out << "  ;; Inputs for " << k << " -> " << k + 1 << std::endl;
-      out << "  (input" << std::endl;
-      std::vector<expr::term_ref> input_vars_k;
-      get_struct_variables(d_input_variables_structs[k], input_vars_k);
-      assert(input_vars.size() == input_vars_k.size());
-      for (size_t i = 0; i < input_vars_k.size(); ++ i) {
-        const expr::value& v = d_model->get_variable_value(input_vars_k[i]);
-        if (v.is_algebraic()) {
-          out << "    (" << input_vars[i] << " " << v.get_algebraic().approx() << ") ;; " << v << std::endl;
-        } else {
-          out << "    (" << input_vars[i] << " " << v << ")" << std::endl;
-        }
-      }
-      out << "  )" << std::endl;
-    }
-
+void trace_helper::get_values(const std::vector<expr::term_ref>& vars, std::vector<const expr::value*>& values) const {
+  values.resize(vars.size());
+  for (size_t i = 0; i < vars.size(); ++ i) {
+    values[i] = &d_model->get_variable_value_ref(vars[i]);
   }
-
-  out << ")";
-
-  d_state_type->tm().pop_namespace();
-  d_state_type->tm().pop_namespace();
-  d_state_type->tm().pop_namespace();
 }
 
-void trace_helper::to_stream_tab(std::ostream& out) const {
+void trace_helper::write(trace_writer& writer) const {
   d_state_type->use_namespace();
   d_state_type->use_namespace(state_type::STATE_CURRENT);
   d_state_type->use_namespace(state_type::STATE_INPUT);
 
-  // Separator to use
-  std::string sep = "\t";
-
-  // Variables to use for printing names
-  const std::vector<expr::term_ref> state_vars = d_state_type->get_variables(state_type::STATE_CURRENT);
-  const std::vector<expr::term_ref> input_vars = d_state_type->get_variables(state_type::STATE_INPUT);
-  size_t total_vars = state_vars.size() + input_vars.size();
-
-  // Step
-  out << "k" << sep;
-
-  // Print out all the variable names
-  for (size_t i = 0; i < state_vars.size(); ++ i) {
-    out << state_vars[i];
-    if (i + 1 != total_vars) {
-      out << sep;
-    }
-  }
-  for (size_t i = 0; i < input_vars.size(); ++ i) {
-    out << input_vars[i];
-    if (state_vars.size() + i + 1 != total_vars) {
-      out << sep;
-    }
-  }
-  out << std::endl;
-
-  // Output the values
-  for (size_t k = 0; k < d_model_size; ++ k) {
-
-    out << k << sep;
-
-    // The state variables
-    std::vector<expr::term_ref> state_vars_k;
-    get_struct_variables(d_state_variables_structs[k], state_vars_k);
-    assert(state_vars.size() == state_vars_k.size());
-    for (size_t i = 0; i < state_vars_k.size(); ++ i) {
-      out << d_model->get_variable_value(state_vars_k[i]);
-      if (i + 1 != total_vars) {
-        out << sep;
-      }
-    }
-
-    // The input variables (except the last one)
-    if (k + 1 < d_model_size && input_vars.size() > 0) {
-      std::vector<expr::term_ref> input_vars_k;
-      get_struct_variables(d_input_variables_structs[k], input_vars_k);
-      assert(input_vars.size() == input_vars_k.size());
-      for (size_t i = 0; i < input_vars_k.size(); ++ i) {
-        out << d_model->get_variable_value(input_vars_k[i]);
-        if (state_vars.size() + i + 1 != total_vars) {
-          out << sep;
-        }
+  try {
+    writer.begin(d_state_type);
+    // Values are taken from the model directly, no copies
+    std::vector<const expr::value*> values;
+    for (size_t k = 0; k < d_model_size; ++ k) {
+      get_values(d_state_variables[k], values);
+      writer.state(k, values);
+      // The input variables (except the last one)
+      if (k + 1 < d_model_size) {
+        get_values(d_input_variables[k], values);
+        writer.input(k, values);
       }
     }
-
-    out << std::endl;
+    writer.end();
+  } catch (...) {
+    d_state_type->tm().pop_namespace();
+    d_state_type->tm().pop_namespace();
+    d_state_type->tm().pop_namespace();
+    throw;
   }
 
   d_state_type->tm().pop_namespace();
@@ -313,12 +250,19 @@ void trace_helper::to_stream_tab(std::ostream& out) const {
   d_state_type->tm().pop_namespace();
 }
 
-void trace_helper::to_stream(std::ostream& out) const {
-  if (output::get_output_language(out) == output::MCMT_TAB) {
-    to_stream_tab(out);
-  } else {
-    to_stream_mcmt(out);
+void trace_helper::to_stream(std::ostream& out, trace_format format) const {
+  trace_writer* writer = trace_writer::mk_writer(format, out);
+  try {
+    write(*writer);
+  } catch (...) {
+    delete writer;
+    throw;
   }
+  delete writer;
+}
+
+void trace_helper::to_stream(std::ostream& out) const {
+  to_stream(out, TRACE_FULL);
 }
 
 bool trace_helper::is_true_in_frame(size_t frame, expr::term_ref f, expr::model::ref model) {
@@ -21,6 +21,7 @@
 #include "expr/model.h"
 #include "expr/gc_participant.h"
 #include "system/state_type.h"
+#include "system/trace_writer.h"
 #include "smt/solver.h"
 
 #include <vector>
@@ -96,11 +97,8 @@ class trace_helper : public expr::gc_participant {
   /** Make an equality x = v, where v is the value of x in the model */
   expr::term_ref mk_equality(expr::term_ref x, expr::model::ref m);
 
-  /** To stream with regular MCMT language */
-  void to_stream_mcmt(std::ostream& out) const;
-
-  /** To stream using CSV */
-  void to_stream_tab(std::ostream& out) const;
+  /** Get the values of the variables in the trace model (pointers into the model) */
+  void get_values(const std::vector<expr::term_ref>& vars, std::vector<const expr::value*>& values) const;
 
 public:
 
@@ -169,10 +167,20 @@ public:
   bool is_false_in_frame(size_t frame, expr::term_ref f, expr::model::ref model);
 
   /**
-   * Output the trace to the stream.
+   * Output the trace to the stream (all values, in the output language of
+   * the stream).
    */
   void to_stream(std::ostream& out) const;
 
+  /** Output the trace to the stream in the given format */
+  void to_stream(std::ostream& out, trace_format format) const;
+
+  /** Write the trace step by step to the writer */
+  void write(trace_writer& writer) const;
+
+  /** Add the memory of the frame variables, renamings and model to the report */
+  void memory_usage(utils::memory_report& report) const;
+
   /** Collect the terms */
   void gc_collect(const expr::gc_relocator& gc_reloc);
 
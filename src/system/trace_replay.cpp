@@ -0,0 +1,301 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "system/trace_replay.h"
+#include "utils/trace.h"
+
+#include <cassert>
+
+namespace sally {
+namespace system {
+
+trace_replay::trace_replay(const transition_system* ts, trace_helper* trace)
+: d_tm(ts->get_state_type()->tm())
+, d_transition_system(ts)
+, d_trace(trace)
+, d_current_vars(ts->get_state_type()->get_variables(state_type::STATE_CURRENT))
+, d_input_vars(ts->get_state_type()->get_variables(state_type::STATE_INPUT))
+, d_next_vars(ts->get_state_type()->get_variables(state_type::STATE_NEXT))
+, d_defined(0)
+{
+  for (size_t i = 0; i < d_current_vars.size(); ++ i) {
+    d_current_index[d_current_vars[i]] = i;
+    d_next_index[d_next_vars[i]] = i;
+  }
+  d_definitions.resize(d_next_vars.size());
+  d_definition_evaluators.resize(d_next_vars.size(), 0);
+  d_definition_support.resize(d_next_vars.size());
+
+  // Split the transition relation into definitions and constraints
+  std::vector<expr::term_ref> conjuncts;
+  d_tm.get_conjuncts(d_transition_system->get_transition_relation(), conjuncts);
+  for (size_t i = 0; i < conjuncts.size(); ++ i) {
+    add_conjunct(conjuncts[i]);
+  }
+  for (size_t i = 0; i < d_constraints.size(); ++ i) {
+    d_constraint_evaluators.push_back(new expr::model_evaluator(d_tm, d_constraints[i]));
+  }
+
+  TRACE("trace_replay") << "trace_replay: " << d_defined << " of " << d_next_vars.size() << " next state variables defined, " << d_constraints.size() << " constraints" << std::endl;
+}
+
+trace_replay::~trace_replay() {
+  for (size_t i = 0; i < d_definition_evaluators.size(); ++ i) {
+    delete d_definition_evaluators[i];
+  }
+  for (size_t i = 0; i < d_constraint_evaluators.size(); ++ i) {
+    delete d_constraint_evaluators[i];
+  }
+}
+
+size_t trace_replay::next_var_index(expr::term_ref x) const {
+  expr::term_ref_hash_map<size_t>::const_iterator find = d_next_index.find(x);
+  return find == d_next_index.end() ? d_next_vars.size() : find->second;
+}
+
+void trace_replay::add_conjunct(expr::term_ref f) {
+  const expr::term& f_term = d_tm.term_of(f);
+  size_t x = d_next_vars.size();
+  expr::term_ref definition;
+
+  // Find x' = definition
+  switch (f_term.op()) {
+  case expr::VARIABLE:
+    x = next_var_index(f);
+    definition = d_tm.mk_boolean_constant(true);
+    break;
+  case expr::TERM_NOT:
+    x = next_var_index(f_term[0]);
+    definition = d_tm.mk_boolean_constant(false);
+    break;
+  case expr::TERM_EQ:
+    x = next_var_index(f_term[0]);
+    definition = f_term[1];
+    if (x == d_next_vars.size() || !d_definitions[x].is_null()) {
+      x = next_var_index(f_term[1]);
+      definition = f_term[0];
+    }
+    break;
+  default:
+    break;
+  }
+
+  // Get the support of the definition (it can't have next state variables)
+  std::vector<size_t> support;
+  if (x < d_next_vars.size() && d_definitions[x].is_null()) {
+    std::vector<expr::term_ref> vars;
+    d_tm.get_variables(definition, vars);
+    for (size_t i = 0; i < vars.size(); ++ i) {
+      if (d_next_index.find(vars[i]) != d_next_index.end()) {
+        x = d_next_vars.size();
+        break;
+      }
+      expr::term_ref_hash_map<size_t>::const_iterator find = d_current_index.find(vars[i]);
+      support.push_back(find == d_current_index.end() ? d_current_vars.size() : find->second);
+    }
+  } else {
+    x = d_next_vars.size();
+  }
+
+  if (x < d_next_vars.size()) {
+    d_definitions[x] = definition;
+    d_definition_evaluators[x] = new expr::model_evaluator(d_tm, definition);
+    d_definition_support[x].swap(support);
+    d_defined ++;
+  } else {
+    d_constraints.push_back(f);
+  }
+}
+
+bool trace_replay::is_deterministic() const {
+  return d_defined == d_next_vars.size() && d_input_vars.empty();
+}
+
+expr::value trace_replay::get_choice(expr::model::ref m, expr::term_ref x) const {
+  if (!m.is_null() && m->has_value(x)) {
+    return m->get_variable_value(x);
+  }
+  return expr::value(d_tm, d_tm.get_default_value(d_tm.type_of(x)));
+}
+
+bool trace_replay::evaluate(size_t start, size_t steps, expr::term_ref goal, expr::model::ref choices, expr::model::ref out) {
+
+  expr::model::ref trace_model = d_trace->get_model();
+
+  // Variables of the steps (the vectors are not moved after this)
+  d_trace->get_state_variables(start + steps);
+
+  // Model of a step, over the variables of the state type
+  expr::model step(d_tm, false);
+  const std::vector<expr::term_ref>& x_start = d_trace->get_state_variables(start);
+  for (size_t i = 0; i < x_start.size(); ++ i) {
+    const expr::value& v = trace_model->get_variable_value_ref(x_start[i]);
+    step.set_variable_value(d_current_vars[i], v);
+    out->set_variable_value(x_start[i], v);
+  }
+
+  for (size_t k = start; k < start + steps; ++ k) {
+    // Inputs are chosen
+    const std::vector<expr::term_ref>& i_k = d_trace->get_input_variables(k);
+    for (size_t i = 0; i < i_k.size(); ++ i) {
+      expr::value v = get_choice(choices, i_k[i]);
+      step.set_variable_value(d_input_vars[i], v);
+      out->set_variable_value(i_k[i], v);
+    }
+    // Next state is evaluated, or chosen
+    const std::vector<expr::term_ref>& x_next = d_trace->get_state_variables(k + 1);
+    for (size_t i = 0; i < x_next.size(); ++ i) {
+      expr::value v = d_definitions[i].is_null() ? get_choice(choices, x_next[i]) : d_definition_evaluators[i]->evaluate(step);
+      step.set_variable_value(d_next_vars[i], v);
+      out->set_variable_value(x_next[i], v);
+    }
+    // Check the constraints
+    for (size_t i = 0; i < d_constraint_evaluators.size(); ++ i) {
+      if (!d_constraint_evaluators[i]->is_true(step)) {
+        TRACE("trace_replay") << "trace_replay: constraint " << d_constraints[i] << " false at " << k << std::endl;
+        return false;
+      }
+    }
+    // Move to the next state
+    for (size_t i = 0; i < x_next.size(); ++ i) {
+      step.set_variable_value(d_current_vars[i], out->get_variable_value_ref(x_next[i]));
+    }
+  }
+
+  // Check the goal
+  if (!step.is_true(goal)) {
+    TRACE("trace_replay") << "trace_replay: goal false at " << start + steps << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool trace_replay::mk_choices_query(size_t start, size_t steps, expr::term_ref goal, std::vector<expr::term_ref>& out) {
+
+  expr::model::ref trace_model = d_trace->get_model();
+  bool choices = false;
+
+  // Variables of the steps (the vectors are not moved after this)
+  d_trace->get_state_variables(start + steps);
+
+  // The state as terms, and whether they are concrete (constants)
+  std::vector<expr::term_ref> state(d_current_vars.size());
+  std::vector<bool> concrete(d_current_vars.size(), true);
+  std::vector<expr::term_ref> next_state(d_current_vars.size());
+  std::vector<bool> next_concrete(d_current_vars.size());
+
+  // Model of the concrete part of the state (over state type variables)
+  expr::model step(d_tm, false);
+  const std::vector<expr::term_ref>& x_start = d_trace->get_state_variables(start);
+  for (size_t i = 0; i < x_start.size(); ++ i) {
+    const expr::value& v = trace_model->get_variable_value_ref(x_start[i]);
+    step.set_variable_value(d_current_vars[i], v);
+    state[i] = v.to_term(d_tm);
+  }
+
+  for (size_t k = start; k < start + steps; ++ k) {
+    expr::term_manager::substitution_map subst;
+    for (size_t i = 0; i < d_current_vars.size(); ++ i) {
+      subst[d_current_vars[i]] = state[i];
+    }
+    const std::vector<expr::term_ref>& i_k = d_trace->get_input_variables(k);
+    for (size_t i = 0; i < i_k.size(); ++ i) {
+      subst[d_input_vars[i]] = i_k[i];
+      choices = true;
+    }
+    // Evaluate the definitions over concrete values, substitute the others
+    const std::vector<expr::term_ref>& x_next = d_trace->get_state_variables(k + 1);
+    for (size_t i = 0; i < x_next.size(); ++ i) {
+      if (d_definitions[i].is_null()) {
+        next_state[i] = x_next[i];
+        next_concrete[i] = false;
+        choices = true;
+        continue;
+      }
+      const std::vector<size_t>& support = d_definition_support[i];
+      next_concrete[i] = true;
+      for (size_t j = 0; next_concrete[i] && j < support.size(); ++ j) {
+        next_concrete[i] = support[j] < concrete.size() && concrete[support[j]];
+      }
+      if (next_concrete[i]) {
+        next_state[i] = d_definition_evaluators[i]->evaluate(step).to_term(d_tm);
+      } else {
+        next_state[i] = d_tm.substitute(d_definitions[i], subst);
+      }
+    }
+    for (size_t i = 0; i < d_next_vars.size(); ++ i) {
+      subst[d_next_vars[i]] = next_state[i];
+    }
+    // The constraints
+    for (size_t i = 0; i < d_constraints.size(); ++ i) {
+      out.push_back(d_tm.substitute(d_constraints[i], subst));
+    }
+    // Move to the next state
+    for (size_t i = 0; i < next_state.size(); ++ i) {
+      if (next_concrete[i]) {
+        step.set_variable_value(d_current_vars[i], expr::value(d_tm, next_state[i]));
+      }
+    }
+    state.swap(next_state);
+    concrete.swap(next_concrete);
+  }
+
+  // The goal
+  expr::term_manager::substitution_map subst;
+  for (size_t i = 0; i < d_current_vars.size(); ++ i) {
+    subst[d_current_vars[i]] = state[i];
+  }
+  out.push_back(d_tm.substitute(goal, subst));
+
+  return choices;
+}
+
+bool trace_replay::extend(size_t start, size_t steps, expr::term_ref goal, smt::solver* solver) {
+
+  expr::model::ref choices;
+
+  // Pick the choices, if any
+  if (!is_deterministic()) {
+    std::vector<expr::term_ref> query;
+    if (mk_choices_query(start, steps, goal, query)) {
+      TRACE("trace_replay") << "trace_replay: choosing from " << start << " to " << start + steps << std::endl;
+      smt::solver_scope scope(solver);
+      scope.push();
+      for (size_t i = 0; i < query.size(); ++ i) {
+        solver->add(query[i], smt::solver::CLASS_A);
+      }
+      if (solver->check() != smt::solver::SAT) {
+        return false;
+      }
+      choices = solver->get_model();
+    }
+  }
+
+  // Evaluate the steps with the choices
+  expr::model::ref out = new expr::model(d_tm, false);
+  if (!evaluate(start, steps, goal, choices, out)) {
+    return false;
+  }
+  d_trace->set_model(out, start, start + steps);
+
+  return true;
+}
+
+}
+}
@@ -0,0 +1,138 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "system/transition_system.h"
+#include "system/trace_helper.h"
+#include "expr/model_evaluator.h"
+#include "expr/term_map.h"
+#include "smt/solver.h"
+
+#include <vector>
+
+namespace sally {
+namespace system {
+
+/**
+ * Extends a counter-example trace by concrete evaluation of the transition
+ * relation. The transition relation is split into its conjuncts once: a
+ * conjunct x' = f(x, i) (or x' and (not x') for Boolean x), where f has no
+ * next-state variables, defines x'. The other conjuncts are constraints.
+ * The inputs and the next-state variables without a definition are the
+ * choices of a step.
+ *
+ * To extend the trace by some steps, the definitions are evaluated step by
+ * step from the last state of the trace. If the steps have choices, they
+ * are picked with one solver query, where the definitions that only depend
+ * on concrete values are already evaluated and the rest are substituted, so
+ * that the query is only over the choices. The steps are then evaluated with
+ * the chosen values, which also validates the constraints and the goal.
+ *
+ * The replay keeps weak references to terms, so it shouldn't live across
+ * garbage collection.
+ */
+class trace_replay {
+
+  /** The term manager */
+  expr::term_manager& d_tm;
+
+  /** The transition system */
+  const transition_system* d_transition_system;
+
+  /** The trace */
+  trace_helper* d_trace;
+
+  /** Current state variables of the state type */
+  const std::vector<expr::term_ref>& d_current_vars;
+
+  /** Input variables of the state type */
+  const std::vector<expr::term_ref>& d_input_vars;
+
+  /** Next state variables of the state type */
+  const std::vector<expr::term_ref>& d_next_vars;
+
+  /** Index of the current state variables */
+  expr::term_ref_hash_map<size_t> d_current_index;
+
+  /** Index of the next state variables */
+  expr::term_ref_hash_map<size_t> d_next_index;
+
+  /** Definitions of the next state variables (null if a choice) */
+  std::vector<expr::term_ref> d_definitions;
+
+  /** Compiled definitions (null if a choice) */
+  std::vector<expr::model_evaluator*> d_definition_evaluators;
+
+  /**
+   * Support of the definitions, as indices of the current variables. A
+   * definition with input variables is marked with an index past the end.
+   */
+  std::vector< std::vector<size_t> > d_definition_support;
+
+  /** Constraints of the transition relation */
+  std::vector<expr::term_ref> d_constraints;
+
+  /** Compiled constraints */
+  std::vector<expr::model_evaluator*> d_constraint_evaluators;
+
+  /** Number of the defined next state variables */
+  size_t d_defined;
+
+  /** Analyze the transition relation */
+  void add_conjunct(expr::term_ref f);
+
+  /** Returns the index of the next state variable, or the size if not one */
+  size_t next_var_index(expr::term_ref x) const;
+
+  /** Get the value of the choice variable in the model, or the default if not there */
+  expr::value get_choice(expr::model::ref m, expr::term_ref x) const;
+
+  /**
+   * Evaluate the steps from start, with the choices from the model (can be
+   * null if no choices). Puts the values of all steps in out. Returns false
+   * if a constraint or the goal is false.
+   */
+  bool evaluate(size_t start, size_t steps, expr::term_ref goal, expr::model::ref choices, expr::model::ref out);
+
+  /** Make the query over the choices for the steps from start, returns false if there are no choices */
+  bool mk_choices_query(size_t start, size_t steps, expr::term_ref goal, std::vector<expr::term_ref>& out);
+
+public:
+
+  /** Prepare the replay of the system, the trace model is extended */
+  trace_replay(const transition_system* ts, trace_helper* trace);
+  ~trace_replay();
+
+  /** Does the transition relation define any next state variables */
+  bool has_definitions() const { return d_defined > 0; }
+
+  /** Are all next state variables defined and no inputs (no choices) */
+  bool is_deterministic() const;
+
+  /**
+   * Extend the trace model from step start (must be in the model) by the
+   * given number of steps, so that the goal (a state formula) holds at the
+   * end. The solver is used for the choices (it must have all the trace
+   * variables). Returns false if the extension can't be found this way.
+   */
+  bool extend(size_t start, size_t steps, expr::term_ref goal, smt::solver* solver);
+};
+
+}
+}
@@ -0,0 +1,556 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "system/trace_writer.h"
+#include "system/state_type.h"
+#include "utils/output.h"
+#include "utils/exception.h"
+
+#include <iostream>
+#include <cassert>
+
+namespace sally {
+namespace system {
+
+trace_writer::trace_writer(std::ostream& out)
+: d_out(out)
+{
+  // Print the values and names as they would be printed to out
+  d_scratch.copyfmt(out);
+  output::language lang = output::get_output_language(out);
+  d_mcmt_values = lang == output::MCMT || lang == output::MCMT_TAB || lang == output::HORN;
+}
+
+trace_writer::~trace_writer() {
+  flush();
+}
+
+void trace_writer::flush() {
+  if (!d_buffer.empty()) {
+    d_out.write(d_buffer.data(), d_buffer.size());
+    d_buffer.clear();
+  }
+}
+
+void trace_writer::begin(const state_type* st) {
+  const std::vector<expr::term_ref>& state_vars = st->get_variables(state_type::STATE_CURRENT);
+  const std::vector<expr::term_ref>& input_vars = st->get_variables(state_type::STATE_INPUT);
+  d_state_names.clear();
+  d_input_names.clear();
+  for (size_t i = 0; i < state_vars.size(); ++ i) {
+    d_scratch.str("");
+    d_scratch << state_vars[i];
+    d_state_names.push_back(d_scratch.str());
+  }
+  for (size_t i = 0; i < input_vars.size(); ++ i) {
+    d_scratch.str("");
+    d_scratch << input_vars[i];
+    d_input_names.push_back(d_scratch.str());
+  }
+}
+
+void trace_writer::append_uint(uint64_t n) {
+  char digits[24];
+  size_t i = sizeof(digits);
+  do {
+    digits[-- i] = '0' + (n % 10);
+    n /= 10;
+  } while (n > 0);
+  d_buffer.append(digits + i, sizeof(digits) - i);
+}
+
+void trace_writer::append_value(const expr::value& v) {
+  // Fast paths for the common values
+  if (v.is_bool()) {
+    d_buffer.append(v.get_bool() ? "true" : "false");
+    return;
+  }
+  if (d_mcmt_values && v.is_bitvector() && v.get_bitvector().is_word()) {
+    const expr::bitvector& bv = v.get_bitvector();
+    d_buffer.append("(_ bv");
+    append_uint(bv.get_word());
+    d_buffer.push_back(' ');
+    append_uint(bv.size());
+    d_buffer.push_back(')');
+    return;
+  }
+  d_scratch.str("");
+  d_scratch << v;
+  d_buffer.append(d_scratch.str());
+}
+
+void trace_writer::get_changed(std::vector<const expr::value*>& previous, const std::vector<const expr::value*>& values, std::vector<size_t>& changed) {
+  changed.clear();
+  if (previous.size() != values.size()) {
+    // First step, everything changed
+    for (size_t i = 0; i < values.size(); ++ i) {
+      changed.push_back(i);
+    }
+  } else {
+    for (size_t i = 0; i < values.size(); ++ i) {
+      if (previous[i] != values[i] && *previous[i] != *values[i]) {
+        changed.push_back(i);
+      }
+    }
+  }
+  previous = values;
+}
+
+/** All the values at every step, as (trace (state ...) (input ...) ...) */
+class trace_writer_mcmt : public trace_writer {
+
+  void append_assignment(const std::string& name, const expr::value& v) {
+    d_buffer.append("    (");
+    d_buffer.append(name);
+    d_buffer.push_back(' ');
+    if (v.is_algebraic()) {
+      append_value(expr::value(v.get_algebraic().approx()));
+      d_buffer.append(") ;; ");
+      append_value(v);
+      d_buffer.push_back('\n');
+    } else {
+      append_value(v);
+      d_buffer.append(")\n");
+    }
+  }
+
+public:
+
+  trace_writer_mcmt(std::ostream& out)
+  : trace_writer(out) {}
+
+  void begin(const state_type* st) {
+    trace_writer::begin(st);
+    d_buffer.append("(trace \n");
+  }
+
+  void state(size_t k, const std::vector<const expr::value*>& values) {
+    d_buffer.append("  ;; State at ");
+    append_uint(k);
+    d_buffer.append("\n  (state\n");
+    for (size_t i = 0; i < values.size(); ++ i) {
+      append_assignment(d_state_names[i], *values[i]);
+      flush_if_full();
+    }
+    d_buffer.append("  )\n");
+  }
+
+  void input(size_t k, const std::vector<const expr::value*>& values) {
+    if (values.empty()) {
+      return;
+    }
+    d_buffer.append("  ;; Inputs for ");
+    append_uint(k);
+    d_buffer.append(" -> ");
+    append_uint(k + 1);
+    d_buffer.append("\n  (input\n");
+    for (size_t i = 0; i < values.size(); ++ i) {
+      append_assignment(d_input_names[i], *values[i]);
+      flush_if_full();
+    }
+    d_buffer.append("  )\n");
+  }
+
+  void end() {
+    d_buffer.append(")");
+    flush();
+  }
+};
+
+/** All the values at every step, one step per line, separated by tabs */
+class trace_writer_tab : public trace_writer {
+
+  /** Total number of columns (without the step) */
+  size_t d_columns;
+
+  /** Is the line of a step open */
+  bool d_line_open;
+
+  /** Append the values from the given column on */
+  void append_values(size_t column, const std::vector<const expr::value*>& values) {
+    for (size_t i = 0; i < values.size(); ++ i) {
+      append_value(*values[i]);
+      if (column + i + 1 != d_columns) {
+        d_buffer.push_back('\t');
+      }
+    }
+    flush_if_full();
+  }
+
+public:
+
+  trace_writer_tab(std::ostream& out)
+  : trace_writer(out), d_columns(0), d_line_open(false) {}
+
+  void begin(const state_type* st) {
+    trace_writer::begin(st);
+    d_columns = d_state_names.size() + d_input_names.size();
+    d_buffer.append("k\t");
+    for (size_t i = 0; i < d_columns; ++ i) {
+      d_buffer.append(i < d_state_names.size() ? d_state_names[i] : d_input_names[i - d_state_names.size()]);
+      if (i + 1 != d_columns) {
+        d_buffer.push_back('\t');
+      }
+    }
+    d_buffer.push_back('\n');
+  }
+
+  void state(size_t k, const std::vector<const expr::value*>& values) {
+    if (d_line_open) {
+      d_buffer.push_back('\n');
+    }
+    append_uint(k);
+    d_buffer.push_back('\t');
+    append_values(0, values);
+    d_line_open = true;
+  }
+
+  void input(size_t k, const std::vector<const expr::value*>& values) {
+    append_values(d_state_names.size(), values);
+  }
+
+  void end() {
+    if (d_line_open) {
+      d_buffer.push_back('\n');
+    }
+    flush();
+  }
+};
+
+/**
+ * Only the values that changed, one step per line, as
+ *
+ *   (trace-delta
+ *     (state 0 (x 0) (y 0))
+ *     (input 0 (i 1))
+ *     (state 1 (x 1))
+ *     ...
+ *   )
+ *
+ * The first state and input have all the values. Algebraic values are given
+ * by their rational approximation.
+ */
+class trace_writer_delta : public trace_writer {
+
+  std::vector<const expr::value*> d_previous_state;
+  std::vector<const expr::value*> d_previous_input;
+  std::vector<size_t> d_changed;
+
+  void append_step(const char* what, size_t k, const std::vector<std::string>& names, const std::vector<const expr::value*>& values) {
+    d_buffer.append("  (");
+    d_buffer.append(what);
+    d_buffer.push_back(' ');
+    append_uint(k);
+    for (size_t i = 0; i < d_changed.size(); ++ i) {
+      const expr::value& v = *values[d_changed[i]];
+      d_buffer.append(" (");
+      d_buffer.append(names[d_changed[i]]);
+      d_buffer.push_back(' ');
+      if (v.is_algebraic()) {
+        append_value(expr::value(v.get_algebraic().approx()));
+      } else {
+        append_value(v);
+      }
+      d_buffer.push_back(')');
+      flush_if_full();
+    }
+    d_buffer.append(")\n");
+  }
+
+public:
+
+  trace_writer_delta(std::ostream& out)
+  : trace_writer(out) {}
+
+  void begin(const state_type* st) {
+    trace_writer::begin(st);
+    d_buffer.append("(trace-delta\n");
+  }
+
+  void state(size_t k, const std::vector<const expr::value*>& values) {
+    get_changed(d_previous_state, values, d_changed);
+    append_step("state", k, d_state_names, values);
+  }
+
+  void input(size_t k, const std::vector<const expr::value*>& values) {
+    if (values.empty()) {
+      return;
+    }
+    get_changed(d_previous_input, values, d_changed);
+    append_step("input", k, d_input_names, values);
+  }
+
+  void end() {
+    d_buffer.append(")");
+    flush();
+  }
+};
+
+/**
+ * BTOR2 witness. Each frame k has the state part #k and the input part @k,
+ * with lines "<index> <bits> <name>", where index is the position of the
+ * variable in the state (or input) type. The state part of frame 0 is
+ * complete, the later ones only have the variables that changed. The last
+ * frame has no input values, since the trace doesn't constrain them.
+ */
+class trace_writer_btor2 : public trace_writer {
+
+  std::vector<const expr::value*> d_previous_state;
+  std::vector<size_t> d_changed;
+  size_t d_last_step;
+
+  void append_bits(const expr::value& v) {
+    if (v.is_bool()) {
+      d_buffer.push_back(v.get_bool() ? '1' : '0');
+    } else if (v.is_bitvector()) {
+      const expr::bitvector& bv = v.get_bitvector();
+      if (bv.is_word()) {
+        uint64_t word = bv.get_word();
+        for (size_t i = bv.size(); i > 0; -- i) {
+          d_buffer.push_back(((word >> (i - 1)) & 1) ? '1' : '0');
+        }
+      } else {
+        for (size_t i = bv.size(); i > 0; -- i) {
+          d_buffer.push_back(bv.get_bit(i - 1) ? '1' : '0');
+        }
+      }
+    } else {
+      throw exception("BTOR2 witnesses can only have Boolean and bit-vector values, got ") << v;
+    }
+  }
+
+  void append_assignment(size_t index, const std::string& name, const expr::value& v) {
+    append_uint(index);
+    d_buffer.push_back(' ');
+    append_bits(v);
+    d_buffer.push_back(' ');
+    d_buffer.append(name);
+    d_buffer.push_back('\n');
+    flush_if_full();
+  }
+
+public:
+
+  trace_writer_btor2(std::ostream& out)
+  : trace_writer(out), d_last_step(0) {}
+
+  void begin(const state_type* st) {
+    trace_writer::begin(st);
+    d_buffer.append("sat\nb0\n");
+  }
+
+  void state(size_t k, const std::vector<const expr::value*>& values) {
+    get_changed(d_previous_state, values, d_changed);
+    d_last_step = k;
+    if (k > 0 && d_changed.empty()) {
+      return;
+    }
+    d_buffer.push_back('#');
+    append_uint(k);
+    d_buffer.push_back('\n');
+    for (size_t i = 0; i < d_changed.size(); ++ i) {
+      append_assignment(d_changed[i], d_state_names[d_changed[i]], *values[d_changed[i]]);
+    }
+  }
+
+  void input(size_t k, const std::vector<const expr::value*>& values) {
+    d_buffer.push_back('@');
+    append_uint(k);
+    d_buffer.push_back('\n');
+    for (size_t i = 0; i < values.size(); ++ i) {
+      append_assignment(i, d_input_names[i], *values[i]);
+    }
+  }
+
+  void end() {
+    d_buffer.push_back('@');
+    append_uint(d_last_step);
+    d_buffer.append("\n.");
+    flush();
+  }
+};
+
+/**
+ * Binary trace. Numbers are unsigned LEB128, strings are given by their size
+ * and bytes. The header is the magic "STRC", the version (1), and the names
+ * of the state and the input variables (count, then the names). Then come
+ * the steps: 'S' (or 'I' for inputs), the step, the number of values that
+ * changed, and the changed values as (index, value). The trace ends with
+ * 'E'. A value is its type (expr::value::type) and then
+ *
+ *   bool: 0 or 1
+ *   bit-vector: the size and the value (a number if the size is at most 64,
+ *     otherwise the number of bytes and the bytes, least significant first)
+ *   rational: the sign (0 or 1 for negative), numerator and denominator (as
+ *     the number of bytes and the bytes, least significant first)
+ *   enum: the index of the constant
+ *
+ * Algebraic numbers are written as their rational approximation.
+ */
+class trace_writer_binary : public trace_writer {
+
+  std::vector<const expr::value*> d_previous_state;
+  std::vector<const expr::value*> d_previous_input;
+  std::vector<size_t> d_changed;
+
+  void write_uint(uint64_t value) {
+    // LEB128: 7 bits at a time, high bit set if more to come
+    while (value >= 0x80) {
+      d_buffer.push_back((char) ((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    d_buffer.push_back((char) value);
+  }
+
+  void write_string(const std::string& s) {
+    write_uint(s.size());
+    d_buffer.append(s);
+  }
+
+  void write_bytes(const mpz_class& z) {
+    size_t size = sgn(z) == 0 ? 0 : (mpz_sizeinbase(z.get_mpz_t(), 2) + 7) / 8;
+    write_uint(size);
+    if (size > 0) {
+      size_t offset = d_buffer.size();
+      size_t count = 0;
+      d_buffer.resize(offset + size);
+      mpz_export(&d_buffer[offset], &count, -1, 1, 0, 0, z.get_mpz_t());
+      assert(count == size);
+    }
+  }
+
+  void write_rational(const expr::rational& q) {
+    mpq_class mpq = q.mpq();
+    write_uint(expr::value::VALUE_RATIONAL);
+    write_uint(sgn(mpq) < 0 ? 1 : 0);
+    write_bytes(abs(mpq.get_num()));
+    write_bytes(mpq.get_den());
+  }
+
+  void write_value(const expr::value& v) {
+    switch (v.value_type()) {
+    case expr::value::VALUE_BOOL:
+      write_uint(expr::value::VALUE_BOOL);
+      write_uint(v.get_bool());
+      break;
+    case expr::value::VALUE_BITVECTOR: {
+      const expr::bitvector& bv = v.get_bitvector();
+      write_uint(expr::value::VALUE_BITVECTOR);
+      write_uint(bv.size());
+      if (bv.is_word()) {
+        write_uint(bv.get_word());
+      } else {
+        write_bytes(bv.mpz());
+      }
+      break;
+    }
+    case expr::value::VALUE_RATIONAL:
+      write_rational(v.get_rational());
+      break;
+    case expr::value::VALUE_ALGEBRAIC:
+      write_rational(v.get_algebraic().approx());
+      break;
+    case expr::value::VALUE_ENUM:
+      write_uint(expr::value::VALUE_ENUM);
+      write_uint(v.get_enum_value().index());
+      break;
+    default:
+      throw exception("Can't write value to a binary trace: ") << v;
+    }
+  }
+
+  void write_step(char what, size_t k, const std::vector<const expr::value*>& values) {
+    d_buffer.push_back(what);
+    write_uint(k);
+    write_uint(d_changed.size());
+    for (size_t i = 0; i < d_changed.size(); ++ i) {
+      write_uint(d_changed[i]);
+      write_value(*values[d_changed[i]]);
+      flush_if_full();
+    }
+  }
+
+public:
+
+  trace_writer_binary(std::ostream& out)
+  : trace_writer(out) {}
+
+  void begin(const state_type* st) {
+    trace_writer::begin(st);
+    d_buffer.append("STRC");
+    write_uint(1);
+    write_uint(d_state_names.size());
+    for (size_t i = 0; i < d_state_names.size(); ++ i) {
+      write_string(d_state_names[i]);
+    }
+    write_uint(d_input_names.size());
+    for (size_t i = 0; i < d_input_names.size(); ++ i) {
+      write_string(d_input_names[i]);
+    }
+  }
+
+  void state(size_t k, const std::vector<const expr::value*>& values) {
+    get_changed(d_previous_state, values, d_changed);
+    write_step('S', k, values);
+  }
+
+  void input(size_t k, const std::vector<const expr::value*>& values) {
+    get_changed(d_previous_input, values, d_changed);
+    write_step('I', k, values);
+  }
+
+  void end() {
+    d_buffer.push_back('E');
+    flush();
+  }
+};
+
+trace_writer* trace_writer::mk_writer(trace_format format, std::ostream& out) {
+  switch (format) {
+  case TRACE_FULL:
+    if (output::get_output_language(out) == output::MCMT_TAB) {
+      return new trace_writer_tab(out);
+    } else {
+      return new trace_writer_mcmt(out);
+    }
+  case TRACE_DELTA:
+    return new trace_writer_delta(out);
+  case TRACE_BTOR2:
+    return new trace_writer_btor2(out);
+  case TRACE_BINARY:
+    return new trace_writer_binary(out);
+  }
+  assert(false);
+  return 0;
+}
+
+trace_format trace_writer::format_from_string(std::string name) {
+  if (name == "full") {
+    return TRACE_FULL;
+  } else if (name == "delta") {
+    return TRACE_DELTA;
+  } else if (name == "btor2") {
+    return TRACE_BTOR2;
+  } else if (name == "binary") {
+    return TRACE_BINARY;
+  }
+  throw exception("Unknown trace format: ") << name;
+}
+
+}
+}
@@ -0,0 +1,122 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "expr/value.h"
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iosfwd>
+
+namespace sally {
+namespace system {
+
+class state_type;
+
+/** Formats of the counter-example traces */
+enum trace_format {
+  /** All values at every step, in MCMT (or tab-separated with MCMT_TAB) */
+  TRACE_FULL,
+  /** MCMT values, only the variables that changed from the previous step */
+  TRACE_DELTA,
+  /** BTOR2 witness (Boolean and bit-vector variables only) */
+  TRACE_BTOR2,
+  /** Binary, delta encoded */
+  TRACE_BINARY
+};
+
+/**
+ * A trace writer gets the values of the trace step by step and writes them
+ * out as they come. The values are taken by pointer, and must stay valid
+ * until end() (the writers keep the pointers to the previous values to
+ * encode deltas). The output is collected in a buffer and written to the
+ * stream in large blocks.
+ *
+ * The calls are begin(), then state(k, ...) for each step k, each one except
+ * the last followed by input(k, ...), and finally end().
+ */
+class trace_writer {
+
+  /** The output */
+  std::ostream& d_out;
+
+protected:
+
+  /** The buffer to write to */
+  std::string d_buffer;
+
+  /** Stream for the values without a fast path (with the output settings) */
+  std::stringstream d_scratch;
+
+  /** Are the values printed as in MCMT (fast path for bit-vectors) */
+  bool d_mcmt_values;
+
+  /** Names of the state variables */
+  std::vector<std::string> d_state_names;
+
+  /** Names of the input variables */
+  std::vector<std::string> d_input_names;
+
+  /** Write the buffer to the output if it's large enough */
+  void flush_if_full() {
+    if (d_buffer.size() >= 65536) { flush(); }
+  }
+
+  /** Append the value, as printed in MCMT */
+  void append_value(const expr::value& v);
+
+  /** Append the number */
+  void append_uint(uint64_t n);
+
+  /**
+   * Get the indices of the values that changed from the previous ones (all of
+   * them if there are no previous values), and make values the previous ones.
+   */
+  static void get_changed(std::vector<const expr::value*>& previous, const std::vector<const expr::value*>& values, std::vector<size_t>& changed);
+
+public:
+
+  trace_writer(std::ostream& out);
+  virtual ~trace_writer();
+
+  /** Start the trace of the given state type */
+  virtual void begin(const state_type* st);
+
+  /** The values of the state variables at step k */
+  virtual void state(size_t k, const std::vector<const expr::value*>& values) = 0;
+
+  /** The values of the input variables from step k to step k + 1 */
+  virtual void input(size_t k, const std::vector<const expr::value*>& values) = 0;
+
+  /** Finish the trace (and flush) */
+  virtual void end() = 0;
+
+  /** Write the buffer to the output */
+  void flush();
+
+  /** Make a writer for the given format (the caller owns it) */
+  static trace_writer* mk_writer(trace_format format, std::ostream& out);
+
+  /** Get the format from its name (full, delta, btor2, binary) */
+  static trace_format format_from_string(std::string name);
+};
+
+}
+}
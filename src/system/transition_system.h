@@ -45,11 +45,6 @@ class transition_system {
   /** Any assumptions */
   std::vector<state_formula*> d_assumptions_state;
 
-  /** Get all the individual assumptions */
-  const std::vector<state_formula*>& get_state_assumptions() const {
-    return d_assumptions_state;
-  }
-
   /** Do we have assumptions */
   bool has_state_assumptions() const {
     return !d_assumptions_state.empty();
@@ -58,11 +53,6 @@ class transition_system {
   /** Any assumptions */
   std::vector<transition_formula*> d_assumptions_transition;
 
-  /** Get all the individual assumptions */
-  const std::vector<transition_formula*>& get_transition_assumptions() const {
-    return d_assumptions_transition;
-  }
-
   /** Do we have assumptions */
   bool has_transition_assumptions() const {
     return !d_assumptions_transition.empty();
@@ -93,6 +83,31 @@ public:
   /** Get the initial states */
   expr::term_ref get_initial_states() const;
 
+  /** Get the initial states formula, as given (no assumptions or invariant) */
+  const state_formula* get_initial_states_formula() const {
+    return d_initial_states;
+  }
+
+  /** Get the transition relation formula, as given (no assumptions or invariant) */
+  const transition_formula* get_transition_relation_formula() const {
+    return d_transition_relation;
+  }
+
+  /** Get the invariant formula (conjunction of the added invariants) */
+  const state_formula* get_invariant_formula() const {
+    return d_invariant;
+  }
+
+  /** Get all the individual state assumptions */
+  const std::vector<state_formula*>& get_state_assumptions() const {
+    return d_assumptions_state;
+  }
+
+  /** Get all the individual transition assumptions */
+  const std::vector<transition_formula*>& get_transition_assumptions() const {
+    return d_assumptions_transition;
+  }
+
   /** Get the whole transition relation (disjunction) */
   expr::term_ref get_transition_relation() const;
 
@@ -80,6 +80,11 @@ public:
   template<typename T>
   T& object_of(ref o_ref) { return *((T*)(d_memory + o_ref.d_ref)); }
 
+  /** Bytes of memory allocated */
+  virtual size_t memory_size() const {
+    return d_capacity;
+  }
+
   /** Print out some info */
   virtual void to_stream(std::ostream& out) const {
     out << "(size = " << d_size << ", capacity = " << d_capacity << ")";
@@ -172,6 +177,11 @@ public:
   /** Returns the number of allocated objects */
   size_t size() const { return d_allocated.size(); }
 
+  /** Bytes of memory allocated, including the list of objects */
+  size_t memory_size() const {
+    return allocator_base::memory_size() + d_allocated.capacity()*sizeof(alloc::ref);
+  }
+
   /**
    * Allocate T with children from begin .. end, with potentially extra
    * children. The extras are not destructed automatically so use only for
@@ -19,6 +19,9 @@
 #pragma once
 
 #include <string>
+#include <cstring>
+#include <stdint.h>
+
 #include "utils/string.h"
 
 namespace sally {
@@ -35,7 +38,20 @@ struct hash {
   }
 };
 
-/** Hasher for a sequence of hashes */
+/**
+ * Finalizer of splitmix64. All bits of the input affect all bits of the
+ * output, so that small and clustered values (indices, sizes, child hashes)
+ * spread over the whole range.
+ */
+inline
+size_t hash_mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  x = x ^ (x >> 31);
+  return (size_t) x;
+}
+
+/** Hasher for a sequence of hashes (order dependent, each step is mixed) */
 class sequence_hash {
   size_t d_hash;
 public:
@@ -43,7 +59,7 @@ public:
 
   template <typename T>
   void add(const T& t) {
-    d_hash ^= hash<T>()(t) + 0x9e3779b9 + (d_hash << 6) + (d_hash >> 2);
+    d_hash = hash_mix(d_hash + 0x9e3779b97f4a7c15ULL + hash<T>()(t));
   }
   size_t get() const { return d_hash; }
 
@@ -55,23 +71,35 @@ public:
   }
 };
 
+/** Hash of a sequence of bytes, 8 bytes at a time */
+inline
+size_t hash_bytes(const char* data, size_t size) {
+  sequence_hash seq;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data + i, sizeof(uint64_t));
+    seq.add(word);
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, data + i, size - i);
+  seq.add(tail ^ size);
+  return seq.get();
+}
+
 /** String hash. */
 template<>
 struct hash<std::string> {
-  size_t operator()(std::string value) const {
-    sequence_hash seq;
-    seq.add(value.begin(), value.end());
-    return seq.get();
+  size_t operator()(const std::string& value) const {
+    return hash_bytes(value.data(), value.size());
   }
 };
 
 /** String hash. */
 template<>
 struct hash<utils::string> {
-  size_t operator()(utils::string value) const {
-    sequence_hash seq;
-    seq.add(value.begin(), value.end());
-    return seq.get();
+  size_t operator()(const utils::string& value) const {
+    return hash_bytes(value.begin(), value.size());
   }
 };
 
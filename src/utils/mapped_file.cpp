@@ -0,0 +1,87 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/mapped_file.h"
+#include "utils/exception.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace sally {
+namespace utils {
+
+mapped_file::mapped_file(std::string filename)
+: d_filename(filename)
+, d_data(0)
+, d_size(0)
+, d_mapped(false)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw exception("can't open ") << filename << ": " << strerror(errno);
+  }
+
+  // Map regular files
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      madvise(data, st.st_size, MADV_SEQUENTIAL);
+      d_data = (const char*) data;
+      d_size = st.st_size;
+      d_mapped = true;
+      close(fd);
+      return;
+    }
+  }
+
+  // Read everything otherwise
+  char chunk[65536];
+  for (;;) {
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      int error = errno;
+      close(fd);
+      throw exception("can't read ") << filename << ": " << strerror(error);
+    }
+    if (n == 0) {
+      break;
+    }
+    d_buffer.insert(d_buffer.end(), chunk, chunk + n);
+  }
+  close(fd);
+  d_size = d_buffer.size();
+  d_data = d_size > 0 ? &d_buffer[0] : 0;
+}
+
+mapped_file::~mapped_file() {
+  if (d_mapped) {
+    munmap((void*) d_data, d_size);
+  }
+}
+
+}
+}
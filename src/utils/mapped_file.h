@@ -0,0 +1,78 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+namespace sally {
+namespace utils {
+
+/**
+ * Read-only view of the whole content of a file. The file is memory mapped
+ * when possible, and read into a buffer otherwise (pipes, special files).
+ * Throws an exception if the file can't be read.
+ */
+class mapped_file {
+
+  /** The name of the file */
+  std::string d_filename;
+
+  /** The content */
+  const char* d_data;
+
+  /** Size of the content */
+  size_t d_size;
+
+  /** Is the content mapped (otherwise it's in the buffer) */
+  bool d_mapped;
+
+  /** The buffer, if not mapped */
+  std::vector<char> d_buffer;
+
+  mapped_file(const mapped_file&);
+  mapped_file& operator = (const mapped_file&);
+
+public:
+
+  /** Map the file */
+  explicit mapped_file(std::string filename);
+
+  /** Unmap the file */
+  ~mapped_file();
+
+  /** Start of the content */
+  const char* begin() const { return d_data; }
+
+  /** End of the content */
+  const char* end() const { return d_data + d_size; }
+
+  /** Size of the content */
+  size_t size() const { return d_size; }
+
+  /** Is the content memory mapped */
+  bool is_mapped() const { return d_mapped; }
+
+  /** The name of the file */
+  const std::string& get_filename() const { return d_filename; }
+};
+
+}
+}
@@ -0,0 +1,117 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/memory.h"
+#include "utils/statistics.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <unistd.h>
+#include <sys/resource.h>
+
+namespace sally {
+namespace utils {
+
+size_t get_resident_memory() {
+  // Pages of resident memory are the second field in /proc/self/statm
+  std::ifstream statm("/proc/self/statm");
+  size_t size = 0, resident = 0;
+  if (statm >> size >> resident) {
+    return resident * sysconf(_SC_PAGESIZE);
+  }
+  return 0;
+}
+
+size_t get_peak_resident_memory() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return usage.ru_maxrss * 1024;
+#endif
+  }
+  return 0;
+}
+
+void memory_report::add(std::string subsystem, size_t bytes) {
+  d_bytes[subsystem] += bytes;
+}
+
+void memory_report::set(std::string subsystem, size_t bytes) {
+  d_bytes[subsystem] = bytes;
+}
+
+size_t memory_report::total() const {
+  size_t total = 0;
+  std::map<std::string, size_t>::const_iterator it = d_bytes.begin();
+  for (; it != d_bytes.end(); ++ it) {
+    total += it->second;
+  }
+  return total;
+}
+
+size_t memory_report::get(std::string subsystem) const {
+  std::map<std::string, size_t>::const_iterator find = d_bytes.find(subsystem);
+  return find == d_bytes.end() ? 0 : find->second;
+}
+
+/** Print bytes as kilobytes, right aligned */
+static
+void kb_to_stream(std::ostream& out, size_t bytes) {
+  out << std::setw(12) << (bytes + 1023) / 1024 << " KB";
+}
+
+void memory_report::to_stream(std::ostream& out) const {
+  size_t total = this->total();
+  size_t resident = get_resident_memory();
+
+  out << "Memory report:" << std::endl;
+  std::map<std::string, size_t>::const_iterator it = d_bytes.begin();
+  for (; it != d_bytes.end(); ++ it) {
+    kb_to_stream(out, it->second);
+    out << "  " << it->first << std::endl;
+  }
+  kb_to_stream(out, total);
+  out << "  total accounted" << std::endl;
+  kb_to_stream(out, resident > total ? resident - total : 0);
+  out << "  not accounted" << std::endl;
+  kb_to_stream(out, resident);
+  out << "  resident" << std::endl;
+  kb_to_stream(out, get_peak_resident_memory());
+  out << "  peak resident" << std::endl;
+}
+
+std::ostream& operator << (std::ostream& out, const memory_report& report) {
+  report.to_stream(out);
+  return out;
+}
+
+memory_stats::memory_stats(statistics& stats)
+: d_resident(static_cast<stat_int*>(stats.register_stat("utils::memory::resident")))
+, d_peak(static_cast<stat_int*>(stats.register_stat("utils::memory::peak")))
+{}
+
+void memory_stats::update() {
+  d_resident->set_value(get_resident_memory() / 1024);
+  d_peak->set_value(get_peak_resident_memory() / 1024);
+}
+
+}
+}
@@ -0,0 +1,94 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+namespace sally {
+namespace utils {
+
+class statistics;
+class stat_int;
+
+/** Current resident memory of the process in bytes (0 if not available) */
+size_t get_resident_memory();
+
+/** Peak resident memory of the process in bytes (0 if not available) */
+size_t get_peak_resident_memory();
+
+/** Memory allocated by the vector (not counting the elements' own memory) */
+template <typename T>
+size_t memory_of(const std::vector<T>& v) {
+  return v.capacity()*sizeof(T);
+}
+
+/**
+ * Bytes used by each subsystem. Subsystems add their memory under a name of
+ * the form "module::part", and adding to the same name accumulates. The
+ * numbers are what the subsystems account for (their arenas, tables and
+ * caches, and native solver memory where the solver reports it), so the
+ * difference to the resident memory is what is not accounted for.
+ */
+class memory_report {
+
+  /** Bytes by subsystem */
+  std::map<std::string, size_t> d_bytes;
+
+public:
+
+  /** Add bytes to the subsystem */
+  void add(std::string subsystem, size_t bytes);
+
+  /** Set the bytes of a subsystem shared by several reporters */
+  void set(std::string subsystem, size_t bytes);
+
+  /** Total of all subsystems */
+  size_t total() const;
+
+  /** Bytes of the subsystem (0 if not there) */
+  size_t get(std::string subsystem) const;
+
+  /** Print the subsystems, the total, and the process memory */
+  void to_stream(std::ostream& out) const;
+};
+
+std::ostream& operator << (std::ostream& out, const memory_report& report);
+
+/**
+ * Statistics of the process memory (in kilobytes). The values are read when
+ * update() is called, which is safe from any thread.
+ */
+class memory_stats {
+
+  stat_int* d_resident;
+  stat_int* d_peak;
+
+public:
+
+  memory_stats(statistics& stats);
+
+  /** Read the current process memory into the statistics */
+  void update();
+};
+
+}
+}
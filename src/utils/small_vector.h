@@ -0,0 +1,112 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+namespace sally {
+namespace utils {
+
+/**
+ * A vector that keeps the first N elements inline (e.g. on the stack) and
+ * only allocates on the heap when it grows beyond that. Meant for small
+ * temporary buffers of copyable values such as term references.
+ */
+template <typename T, size_t N>
+class small_vector {
+
+  /** Inline storage */
+  T d_inline[N];
+
+  /** The elements (d_inline or heap) */
+  T* d_data;
+
+  /** Number of elements */
+  size_t d_size;
+
+  /** Capacity of d_data */
+  size_t d_capacity;
+
+  small_vector(const small_vector&);
+  small_vector& operator = (const small_vector&);
+
+  void grow() {
+    size_t capacity = 2*d_capacity;
+    T* data = new T[capacity];
+    std::copy(d_data, d_data + d_size, data);
+    if (d_data != d_inline) {
+      delete[] d_data;
+    }
+    d_data = data;
+    d_capacity = capacity;
+  }
+
+public:
+
+  typedef T* iterator;
+  typedef const T* const_iterator;
+
+  small_vector()
+  : d_data(d_inline), d_size(0), d_capacity(N) {}
+
+  ~small_vector() {
+    if (d_data != d_inline) {
+      delete[] d_data;
+    }
+  }
+
+  void push_back(const T& t) {
+    if (d_size == d_capacity) {
+      grow();
+    }
+    d_data[d_size ++] = t;
+  }
+
+  void pop_back() {
+    assert(d_size > 0);
+    d_size --;
+  }
+
+  void clear() { d_size = 0; }
+
+  size_t size() const { return d_size; }
+  bool empty() const { return d_size == 0; }
+
+  T& operator [] (size_t i) { assert(i < d_size); return d_data[i]; }
+  const T& operator [] (size_t i) const { assert(i < d_size); return d_data[i]; }
+
+  T& back() { assert(d_size > 0); return d_data[d_size - 1]; }
+  const T& back() const { assert(d_size > 0); return d_data[d_size - 1]; }
+
+  iterator begin() { return d_data; }
+  iterator end() { return d_data + d_size; }
+  const_iterator begin() const { return d_data; }
+  const_iterator end() const { return d_data + d_size; }
+
+  /** Sort the elements and remove the duplicates (same as inserting into a set) */
+  void sort_unique() {
+    std::sort(begin(), end());
+    d_size = std::unique(begin(), end()) - begin();
+  }
+};
+
+}
+}
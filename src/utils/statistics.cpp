@@ -17,62 +17,168 @@
  */
 
 #include "utils/statistics.h"
+#include "utils/exception.h"
 
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
 namespace sally {
 namespace utils {
 
+void stat_string::to_stream(std::ostream& out) const {
+  out << get_value();
+}
+
+std::string stat_string::get_value() const {
+  std::lock_guard<std::mutex> lock(d_mutex);
+  return d_value;
+}
+
+void stat_string::set_value(std::string value) {
+  std::lock_guard<std::mutex> lock(d_mutex);
+  d_value = value;
+}
+
 void stat_double::to_stream(std::ostream& out) const {
-  out << d_value;
+  out << get_value();
 }
 
 void stat_int::to_stream(std::ostream& out) const {
-  out << d_value;
+  out << get_value();
 }
 
-
 stat_timer::stat_timer(std::string id, std::string format_id, std::string description)
 : stat(id, format_id, description)
 , d_elapsed(0)
 , d_started(false)
 , d_start_time(std::clock())
+, d_sequence(0)
 {
 }
 
 void stat_timer::start() {
-  if (!d_started) {
-    d_start_time = std::clock();
-    d_started = true;
+  if (!d_started.load(std::memory_order_relaxed)) {
+    uint64_t seq = d_sequence.load(std::memory_order_relaxed);
+    d_sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    d_start_time.store(std::clock(), std::memory_order_relaxed);
+    d_started.store(true, std::memory_order_relaxed);
+    d_sequence.store(seq + 2, std::memory_order_release);
   }
 }
 
 void stat_timer::stop() {
-  if (d_started) {
-    d_elapsed += (std::clock() - d_start_time) / (double) CLOCKS_PER_SEC;
-    d_started = false;
+  if (d_started.load(std::memory_order_relaxed)) {
+    double interval = (std::clock() - d_start_time.load(std::memory_order_relaxed)) / (double) CLOCKS_PER_SEC;
+    uint64_t seq = d_sequence.load(std::memory_order_relaxed);
+    d_sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    d_elapsed.store(d_elapsed.load(std::memory_order_relaxed) + interval, std::memory_order_relaxed);
+    d_started.store(false, std::memory_order_relaxed);
+    d_sequence.store(seq + 2, std::memory_order_release);
   }
 }
 
-void stat_timer::to_stream(std::ostream& out) const {
-  double total = d_elapsed;
-  if (d_started) {
-    total += (std::clock() - d_start_time) / (double) CLOCKS_PER_SEC;
+double stat_timer::get_elapsed() const {
+  for (;;) {
+    uint64_t seq = d_sequence.load(std::memory_order_acquire);
+    double total = d_elapsed.load(std::memory_order_relaxed);
+    bool started = d_started.load(std::memory_order_relaxed);
+    std::clock_t start_time = d_start_time.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq % 2 == 0 && d_sequence.load(std::memory_order_relaxed) == seq) {
+      if (started) {
+        total += (std::clock() - start_time) / (double) CLOCKS_PER_SEC;
+      }
+      return total;
+    }
   }
-  out << total;
+}
+
+void stat_timer::to_stream(std::ostream& out) const {
+  out << get_elapsed();
 }
 
 std::string stat_timer::to_string() const {
-  double total = d_elapsed;
-  if (d_started) {
-    total += (std::clock() - d_start_time) / (double) CLOCKS_PER_SEC;
+  return std::to_string(get_elapsed());
+}
+
+stat_histogram::stat_histogram(std::string name, std::string format_id, std::string description)
+: stat(name, format_id, description)
+, d_count(0)
+, d_total_us(0)
+, d_max_us(0)
+{
+  for (size_t i = 0; i < BUCKETS; ++ i) {
+    d_buckets[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void stat_histogram::record(double seconds) {
+  uint64_t us = seconds > 0 ? (uint64_t) (seconds * 1e6) : 0;
+  // Bucket i > 0 has the durations in [2^(i-1), 2^i) microseconds
+  size_t bucket = 0;
+  for (uint64_t x = us; x > 0 && bucket + 1 < BUCKETS; x >>= 1) {
+    bucket ++;
+  }
+  d_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  d_count.fetch_add(1, std::memory_order_relaxed);
+  d_total_us.fetch_add(us, std::memory_order_relaxed);
+  uint64_t max = d_max_us.load(std::memory_order_relaxed);
+  while (us > max && !d_max_us.compare_exchange_weak(max, us, std::memory_order_relaxed)) {}
+}
+
+double stat_histogram::percentile(const uint64_t* buckets, uint64_t count, double p) {
+  uint64_t below = 0;
+  for (size_t i = 0; i < BUCKETS; ++ i) {
+    below += buckets[i];
+    if (below > 0 && below >= p * count) {
+      return i == 0 ? 0 : ((uint64_t) 1 << i) / 1e6;
+    }
+  }
+  return 0;
+}
+
+void stat_histogram::snapshot(std::vector<stat_value>& out) const {
+  // Count from the buckets, so that the percentiles are consistent
+  uint64_t buckets[BUCKETS];
+  uint64_t count = 0;
+  for (size_t i = 0; i < BUCKETS; ++ i) {
+    buckets[i] = d_buckets[i].load(std::memory_order_relaxed);
+    count += buckets[i];
+  }
+  double total = get_total();
+  double max = d_max_us.load(std::memory_order_relaxed) / 1e6;
+  std::string name = get_name();
+  out.push_back(stat_value(name + "::count", std::to_string(count), true));
+  out.push_back(stat_value(name + "::mean", std::to_string(count ? total / count : 0), true));
+  out.push_back(stat_value(name + "::p50", std::to_string(std::min(max, percentile(buckets, count, 0.5))), true));
+  out.push_back(stat_value(name + "::p90", std::to_string(std::min(max, percentile(buckets, count, 0.9))), true));
+  out.push_back(stat_value(name + "::p99", std::to_string(std::min(max, percentile(buckets, count, 0.99))), true));
+  out.push_back(stat_value(name + "::max", std::to_string(max), true));
+}
+
+void stat_histogram::to_stream(std::ostream& out) const {
+  std::vector<stat_value> values;
+  snapshot(values);
+  for (size_t i = 0; i < values.size(); ++ i) {
+    if (i) {
+      out << " ";
+    }
+    out << values[i].name.substr(get_name().length() + 2) << "=" << values[i].value;
   }
-  return std::to_string(total);
+}
+
+std::string stat_histogram::to_string() const {
+  std::stringstream ss;
+  to_stream(ss);
+  return ss.str();
 }
 
 statistics::statistics()
 : d_locked(false)
+, d_start(std::chrono::steady_clock::now())
 {
   add_string("filename", "f", "Name of the input file");
   add_string("engine", "e", "Engine to use");
@@ -80,10 +186,38 @@ statistics::statistics()
   add_string("result", "r", "Result of the last query");
   add_timer("time", "t", "Total time");
 
-  add_int("expr::term_manager_internal::memory_size", "tmms", "Memory size of term table");
+  add_int("utils::memory::resident", "memr", "Resident memory of the process (KB)");
+  add_int("utils::memory::peak", "memp", "Peak resident memory of the process (KB)");
+
+  add_int("expr::term_manager_internal::memory_size", "tmms", "Number of terms in the term table");
+  add_int("expr::term_manager_internal::term_memory", "tmtm", "Memory of the term arena (KB)");
+  add_int("expr::term_manager_internal::payload_memory", "tmpm", "Memory of the term payload arenas (KB)");
   add_int("expr::term_manager_internal::bool_vars", "tmbv", "Number of boolean variables");
   add_int("expr::term_manager_internal::real_vars", "tmrv", "Number of real variables");
   add_int("expr::term_manager_internal::int_vars", "tmiv", "Number of integer variables");
+  add_double("expr::term_pool::load_factor", "tplf", "Load factor of the term pool");
+  add_double("expr::term_pool::avg_probes", "tpap", "Average number of slots inspected per term pool lookup");
+  add_int("expr::term_pool::max_probes", "tpmp", "Maximal number of slots inspected by a term pool lookup");
+  add_int("expr::term_pool::collisions", "tpc", "Number of term pool comparisons of different terms with the same hash");
+
+  add_int("smt::incremental_wrapper::rebuilds", "iwrb", "Number of times a non-incremental solver was recreated");
+  add_int("smt::incremental_wrapper::replays", "iwrp", "Number of non-incremental checks that reused the current solver");
+  add_int("smt::incremental_wrapper::assertions", "iwas", "Number of assertions added to non-incremental solvers");
+
+  add_int("smt::query_cache::hits", "qch", "Number of solver queries answered from the cache");
+  add_int("smt::query_cache::persistent_hits", "qcph", "Number of solver queries answered from the persistent cache");
+  add_int("smt::query_cache::misses", "qcm", "Number of solver queries not in the cache");
+  add_double("smt::query_cache::hit_rate", "qchr", "Ratio of solver queries answered from the cache");
+
+  add_int("smt::bitblast::checks", "bbc", "Number of checks of the bit-blasting solver");
+  add_int("smt::bitblast::sat_vars", "bbv", "Number of SAT variables created by the bit-blaster");
+  add_int("smt::bitblast::sat_clauses", "bbcl", "Number of SAT clauses created by the bit-blaster");
+  add_int("smt::bitblast::conflicts", "bbcf", "Number of conflicts in the bit-blasting SAT solver");
+  add_int("smt::bitblast::decisions", "bbd", "Number of decisions in the bit-blasting SAT solver");
+
+  add_int("smt::mbp::projections", "mbpp", "Number of model-based projections");
+  add_int("smt::mbp::eliminated", "mbpe", "Number of variables eliminated by model-based projection");
+  add_int("smt::mbp::substituted", "mbps", "Number of variables substituted with model values in model-based projection");
 
   add_int("pdkind::frame_index", "pdkfi", "Current frame index");
   add_int("pdkind::induction_depth", "pdkid", "Current induction depth");
@@ -91,10 +225,14 @@ statistics::statistics()
   add_int("pdkind::frame_pushed", "pdkfp", "Number of formulas pushed to current frame");
   add_int("pdkind::queue_size", "pdkqs", "Size of obligation queue");
   add_int("pdkind::max_cex_depth", "pdkmcd", "Maximum depth of counter-example found");
+  add_int("pdkind::cex_replayed", "pdkcr", "Number of counter-example steps constructed by evaluation");
 
   add_int("pdkind::reachable", "pdkrr", "Number of reachability queries that were proven reachable");
   add_int("pdkind::unreachable", "pdkru", "Number of reachability queries that were proven unreachable");
   add_int("pdkind::queries", "pdkrq", "Number of reachability queries");
+  add_histogram("pdkind::query_time", "pdkqt", "Time of the reachability queries (seconds)");
+  add_int("pdkind::minimizations", "pdkmn", "Number of generalization and interpolant minimizations");
+  add_int("pdkind::minimization_checks", "pdkmc", "Number of solver checks done by minimization");
 }
 
 statistics::~statistics() {
@@ -107,7 +245,9 @@ std::string statistics::get_help_string() const {
   std::stringstream help;
   help << "Statistics:\n";
   help << "  To show statistics after every command, use the --stats option.\n";
-  help << "  To show live statistics, use the --live-stats option.\n";
+  help << "  To show live statistics, use the --live-stats option. The --live-stats-format option selects\n";
+  help << "    the output: table (tab separated), csv, or json (one object per line). Histograms (e.g.\n";
+  help << "    query times) are shown as count, mean, p50, p90, p99 and max.\n";
   help << "  To show statistics in a custom format after every query, use the --stats-format option. This \n";
   help << "    option takes a string and replaces all occurrences of %<format_id> with the value of the \n";
   help << "    statistic. For example, to show the input filename and the result of the last query with a \n";
@@ -163,40 +303,139 @@ void statistics::add_timer(std::string name, std::string format_id, std::string
   }
 }
 
+void statistics::add_histogram(std::string name, std::string format_id, std::string description) {
+  if (d_stats.find(name) == d_stats.end()) {
+    d_stats[name] = new stat_histogram(name, format_id, description);
+  }
+}
+
 stat* statistics::register_stat(std::string name) {
+  std::lock_guard<std::mutex> lock(d_mutex);
   if (d_stats.find(name) == d_stats.end()) {
     add_timer(name, "", "");
   }
   return d_stats[name];
 }
 
+stat_int* statistics::register_int(std::string name, std::string description) {
+  std::lock_guard<std::mutex> lock(d_mutex);
+  add_int(name, "", description);
+  stat_int* s = dynamic_cast<stat_int*>(d_stats[name]);
+  if (s == 0) {
+    throw exception("Statistic ") << name << " is not an integer";
+  }
+  return s;
+}
+
+stat_histogram* statistics::register_histogram(std::string name, std::string description) {
+  std::lock_guard<std::mutex> lock(d_mutex);
+  add_histogram(name, "", description);
+  stat_histogram* s = dynamic_cast<stat_histogram*>(d_stats[name]);
+  if (s == 0) {
+    throw exception("Statistic ") << name << " is not a histogram";
+  }
+  return s;
+}
+
 void statistics::lock() {
   d_locked = true;
 }
 
-void statistics::headers_to_stream(std::ostream& out) const {
-  bool first = true;
+void statistics::snapshot(std::vector<stat_value>& out) const {
+  double timestamp = std::chrono::duration<double>(std::chrono::steady_clock::now() - d_start).count();
+  out.push_back(stat_value("timestamp", std::to_string(timestamp), true));
+  std::lock_guard<std::mutex> lock(d_mutex);
   for (auto& stat : d_stats) {
-    if (!first) {
-      out << "\t";
+    stat.second->snapshot(out);
+  }
+}
+
+/** Write the string in quotes, escaping the characters in escapes with the first of them */
+static void write_quoted(std::ostream& out, const std::string& s, char quote, const char* escapes) {
+  out << quote;
+  for (size_t i = 0; i < s.size(); ++ i) {
+    if (s[i] == '\n') {
+      out << "\\n";
+    } else if (s[i] && strchr(escapes, s[i])) {
+      out << escapes[0] << s[i];
+    } else {
+      out << s[i];
     }
-    out << stat.second->get_name();
-    first = false;
   }
+  out << quote;
 }
 
-void statistics::values_to_stream(std::ostream& out) const {
-  bool first = true;
-  for (auto& stat : d_stats) {
-    if (!first) {
-      out << "\t";
+void statistics::snapshot_to_stream(std::ostream& out, stats_format format, bool header) const {
+  std::vector<stat_value> values;
+  snapshot(values);
+  switch (format) {
+  case STATS_TABLE:
+  case STATS_CSV: {
+    const char* separator = format == STATS_TABLE ? "\t" : ",";
+    if (header) {
+      for (size_t i = 0; i < values.size(); ++ i) {
+        out << (i ? separator : "") << values[i].name;
+      }
+      out << std::endl;
     }
-    out << stat.second->get_name();
-    first = false;
+    for (size_t i = 0; i < values.size(); ++ i) {
+      out << (i ? separator : "");
+      if (format == STATS_CSV && !values[i].numeric) {
+        // CSV doubles the quotes
+        write_quoted(out, values[i].value, '"', "\"");
+      } else {
+        out << values[i].value;
+      }
+    }
+    out << std::endl;
+    break;
+  }
+  case STATS_JSON:
+    out << "{";
+    for (size_t i = 0; i < values.size(); ++ i) {
+      out << (i ? ", " : "");
+      write_quoted(out, values[i].name, '"', "\\\"");
+      out << ": ";
+      if (values[i].numeric) {
+        out << values[i].value;
+      } else {
+        write_quoted(out, values[i].value, '"', "\\\"");
+      }
+    }
+    out << "}" << std::endl;
+    break;
+  }
+}
+
+stats_format statistics::format_from_string(std::string name) {
+  if (name == "table") {
+    return STATS_TABLE;
+  } else if (name == "csv") {
+    return STATS_CSV;
+  } else if (name == "json") {
+    return STATS_JSON;
+  }
+  throw exception("Unknown statistics format: ") << name;
+}
+
+void statistics::headers_to_stream(std::ostream& out) const {
+  std::vector<stat_value> values;
+  snapshot(values);
+  for (size_t i = 0; i < values.size(); ++ i) {
+    out << (i ? "\t" : "") << values[i].name;
+  }
+}
+
+void statistics::values_to_stream(std::ostream& out) const {
+  std::vector<stat_value> values;
+  snapshot(values);
+  for (size_t i = 0; i < values.size(); ++ i) {
+    out << (i ? "\t" : "") << values[i].value;
   }
 }
 
 void statistics::to_stream(std::string prefix, std::ostream& out) const {
+  std::lock_guard<std::mutex> lock(d_mutex);
   for (auto& stat : d_stats) {
     out << prefix << stat.second->get_name() << "\t" << *stat.second << std::endl;
   }
@@ -205,8 +444,12 @@ void statistics::to_stream(std::string prefix, std::ostream& out) const {
 std::string statistics::format(std::string& str) const {
   // Replace all the %<format_id> with the stat name
   // If the format_id is not found, leave it as is
+  std::lock_guard<std::mutex> lock(d_mutex);
   std::string format = str;
   for (auto& stat : d_stats) {
+    if (stat.second->get_format_id().empty()) {
+      continue;
+    }
     size_t pos = format.find("%" + stat.second->get_format_id());
     if (pos != std::string::npos) {
       format.replace(pos, stat.second->get_format_id().length() + 1, stat.second->to_string());
@@ -18,14 +18,39 @@
 
 #pragma once
 
+#include <map>
+#include <mutex>
+#include <atomic>
 #include <string>
+#include <vector>
 #include <iosfwd>
 #include <ctime>
+#include <chrono>
+#include <cstdint>
 #include <boost/program_options.hpp>
 
 namespace sally {
 namespace utils {
 
+/**
+ * A value of a statistic at the time of a snapshot. Numeric values are
+ * written as numbers in JSON, the others as strings.
+ */
+struct stat_value {
+  std::string name;
+  std::string value;
+  bool numeric;
+  stat_value(std::string name, std::string value, bool numeric)
+  : name(name), value(value), numeric(numeric) {}
+};
+
+/**
+ * A statistic. Statistics are updated by the thread that owns the component
+ * they measure and can be read at any time by other threads (e.g. the live
+ * statistics): the numeric statistics are relaxed atomics, so that updates on
+ * the hot path are plain memory operations, and each read sees a value that
+ * was written (but reads of different statistics are not synchronized).
+ */
 class stat {
   std::string d_name;
   std::string d_format_id;
@@ -38,77 +63,137 @@ public:
   std::string get_description() const { return d_description; }
   virtual void to_stream(std::ostream& out) const = 0;
   virtual std::string to_string() const = 0;
+  /** Add the current value(s) to the snapshot */
+  virtual void snapshot(std::vector<stat_value>& out) const { out.push_back(stat_value(d_name, to_string(), true)); }
 };
 
 std::ostream& operator << (std::ostream& out, const stat& s);
 
-/** String valued statistic */
+/** String valued statistic (set rarely, guarded by a lock) */
 class stat_string : public stat {
   std::string d_value;
+  mutable std::mutex d_mutex;
 public:
   stat_string(std::string name, std::string format_id, std::string description)
   : stat(name, format_id, description)
   { d_value = ""; }
-  std::string& get_value() { return d_value; }
-  void set_value(std::string value) { d_value = value; }
-  void to_stream(std::ostream& out) const { out << d_value; }
-  std::string to_string() const { return d_value; }
+  std::string get_value() const;
+  void set_value(std::string value);
+  void to_stream(std::ostream& out) const;
+  std::string to_string() const { return get_value(); }
+  void snapshot(std::vector<stat_value>& out) const { out.push_back(stat_value(get_name(), get_value(), false)); }
 };
 
 /** Double valued statistic */
 class stat_double : public stat {
-  double d_value;
+  std::atomic<double> d_value;
 public:
   stat_double(std::string name, std::string format_id, std::string description)
-  : stat(name, format_id, description) 
-  { d_value = 0; }
-  double& get_value() { return d_value; }
-  void set_value(double value) { d_value = value; }
+  : stat(name, format_id, description), d_value(0) {}
+  double get_value() const { return d_value.load(std::memory_order_relaxed); }
+  void set_value(double value) { d_value.store(value, std::memory_order_relaxed); }
   void to_stream(std::ostream& out) const;
-  std::string to_string() const { return std::to_string(d_value); }
+  std::string to_string() const { return std::to_string(get_value()); }
 };
 
-/** Integer valued statistic */
+/** Integer valued statistic (64 bits) */
 class stat_int : public stat {
-  int d_value;
+  std::atomic<int64_t> d_value;
 public:
   stat_int(std::string name, std::string format_id, std::string description)
-  : stat(name, format_id, description) 
-  { d_value = 0; }
-  int& get_value() { return d_value; }
-  void set_value(int value) { d_value = value; }
+  : stat(name, format_id, description), d_value(0) {}
+  int64_t get_value() const { return d_value.load(std::memory_order_relaxed); }
+  void set_value(int64_t value) { d_value.store(value, std::memory_order_relaxed); }
+  /** Add to the value (safe with several writers) */
+  void add(int64_t value) { d_value.fetch_add(value, std::memory_order_relaxed); }
+  /** Add one to the value */
+  void increment() { add(1); }
   void to_stream(std::ostream& out) const;
-  std::string to_string() const { return std::to_string(d_value); }
+  std::string to_string() const { return std::to_string(get_value()); }
 };
 
-/** Timer statistic */
+/**
+ * Timer statistic. Only the owner starts and stops the timer. Readers get
+ * the elapsed time including the running interval, the start and elapsed
+ * time are read under a sequence counter so that a stop() in between
+ * doesn't count the interval twice.
+ */
 class stat_timer : public stat {
-  double d_elapsed;
-  bool d_started;
-  std::clock_t d_start_time;
+  std::atomic<double> d_elapsed;
+  std::atomic<bool> d_started;
+  std::atomic<std::clock_t> d_start_time;
+  std::atomic<uint64_t> d_sequence;
 public:
   stat_timer(std::string name, std::string format_id, std::string description);
   void start();
   void stop();
-  double get_elapsed() const { return d_elapsed; }
+  /** Elapsed time, including the current interval if running */
+  double get_elapsed() const;
   void to_stream(std::ostream& out) const;  
   std::string to_string() const;
 };
 
+/**
+ * Histogram of durations (e.g. the time of each solver check). Durations
+ * are counted in buckets of powers of two microseconds, so that recording
+ * is a few atomic increments. Reported as the count, mean, maximum and the
+ * 50th, 90th and 99th percentiles (as the upper bound of their bucket).
+ */
+class stat_histogram : public stat {
+public:
+  /** Number of buckets, the last one collects everything longer */
+  static const size_t BUCKETS = 40;
+private:
+  std::atomic<uint64_t> d_buckets[BUCKETS];
+  std::atomic<uint64_t> d_count;
+  std::atomic<uint64_t> d_total_us;
+  std::atomic<uint64_t> d_max_us;
+  /** The duration (in seconds) below which p of the samples are, given the bucket counts */
+  static double percentile(const uint64_t* buckets, uint64_t count, double p);
+public:
+  stat_histogram(std::string name, std::string format_id, std::string description);
+  /** Record a duration in seconds */
+  void record(double seconds);
+  /** Number of recorded durations */
+  uint64_t get_count() const { return d_count.load(std::memory_order_relaxed); }
+  /** Total of the recorded durations in seconds */
+  double get_total() const { return d_total_us.load(std::memory_order_relaxed) / 1e6; }
+  void to_stream(std::ostream& out) const;
+  std::string to_string() const;
+  void snapshot(std::vector<stat_value>& out) const;
+};
+
+/** Formats of the statistics output */
+enum stats_format {
+  /** Tab separated, one line per snapshot */
+  STATS_TABLE,
+  /** Comma separated with a header, one line per snapshot */
+  STATS_CSV,
+  /** A JSON object per line */
+  STATS_JSON
+};
+
 /** Collection of statistics */
 class statistics {
 
   /** Statistics by name */
   std::map<std::string, stat*> d_stats;
 
+  /** Protects the map, taken by registration and reads (not by updates) */
+  mutable std::mutex d_mutex;
+
   /** If locked, we can not add more statistics */
   bool d_locked;
 
+  /** Time of creation, for the timestamps of snapshots */
+  std::chrono::steady_clock::time_point d_start;
+
   /** Add a statistic to d_stats. If a statistic with the same name already exists, no action is taken. */
   void add_string(std::string name, std::string format_id, std::string description);
   void add_double(std::string name, std::string format_id, std::string description);
   void add_int(std::string name, std::string format_id, std::string description);
   void add_timer(std::string name, std::string format_id, std::string description);
+  void add_histogram(std::string name, std::string format_id, std::string description);
 
 public:
 
@@ -121,6 +206,12 @@ public:
   /** Take over the pointer to the statistic. If the statistic does not exist, one is created. */
   stat* register_stat(std::string name);
 
+  /** Get the integer statistic with the name, created with the description if it does not exist */
+  stat_int* register_int(std::string name, std::string description);
+
+  /** Get the histogram with the name, created with the description if it does not exist */
+  stat_histogram* register_histogram(std::string name, std::string description);
+
   /** Lock, i.e. no more additional statistics */
   void lock();
 
@@ -139,6 +230,15 @@ public:
   /** Return formatted string of all statistics */
   std::string format(std::string& str) const;
 
+  /** Read all the statistics, the first value is the time in seconds since creation */
+  void snapshot(std::vector<stat_value>& out) const;
+
+  /** Write a snapshot as one line in the format, with the header line if asked (table and CSV only) */
+  void snapshot_to_stream(std::ostream& out, stats_format format, bool header) const;
+
+  /** The format with the given name (table, csv, json) */
+  static stats_format format_from_string(std::string name);
+
 };
 
 std::ostream& operator << (std::ostream& out, const statistics& stats);
@@ -0,0 +1,188 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+/**
+ * Minimal harness for the micro-benchmarks. Each benchmark is run a few
+ * times for warm-up and then for the given number of repetitions, timing
+ * only the part between stopwatch start() and stop() (so that the setup of
+ * each repetition is not measured). The results are printed as a table and
+ * optionally written as JSON, in the format that sally_bench.py collects and
+ * bench_compare.py compares:
+ *
+ *   { "suite": ..., "benchmarks": [ { "name": ..., "ops": ..., "status": "ok",
+ *     "times": [...], "min": ..., "median": ..., "mean": ... }, ... ] }
+ *
+ * Options: --warmup N, --repetitions N, --filter SUBSTRING, --json FILE (- for
+ * stdout, in which case the table goes to stderr).
+ */
+namespace bench {
+
+typedef std::chrono::steady_clock bench_clock;
+
+/** Times the measured part of a repetition */
+class stopwatch {
+
+  bench_clock::time_point d_start;
+  double d_elapsed;
+
+public:
+
+  stopwatch(): d_elapsed(0) {}
+
+  void start() { d_start = bench_clock::now(); }
+
+  void stop() { d_elapsed += std::chrono::duration<double>(bench_clock::now() - d_start).count(); }
+
+  /** Elapsed seconds */
+  double elapsed() const { return d_elapsed; }
+};
+
+/** Result of one benchmark */
+struct result {
+  std::string name;
+  size_t ops;
+  std::vector<double> times;
+  double min, median, mean;
+};
+
+/** A set of benchmarks with common settings */
+class suite {
+
+  std::string d_name;
+  size_t d_warmup;
+  size_t d_repetitions;
+  std::string d_filter;
+  std::string d_json;
+  std::vector<result> d_results;
+
+  /** The table output */
+  std::ostream& out() const {
+    return d_json == "-" ? std::cerr : std::cout;
+  }
+
+  static void write_json_string(std::ostream& out, const std::string& s) {
+    out << '"';
+    for (size_t i = 0; i < s.size(); ++ i) {
+      if (s[i] == '"' || s[i] == '\\') out << '\\';
+      out << s[i];
+    }
+    out << '"';
+  }
+
+  void write_json(std::ostream& out) const {
+    out << std::setprecision(9);
+    out << "{" << std::endl;
+    out << "  \"suite\": "; write_json_string(out, d_name); out << "," << std::endl;
+    out << "  \"warmup\": " << d_warmup << "," << std::endl;
+    out << "  \"repetitions\": " << d_repetitions << "," << std::endl;
+    out << "  \"benchmarks\": [";
+    for (size_t i = 0; i < d_results.size(); ++ i) {
+      const result& r = d_results[i];
+      out << (i ? "," : "") << std::endl << "    { \"name\": "; write_json_string(out, r.name);
+      out << ", \"ops\": " << r.ops << ", \"status\": \"ok\", \"times\": [";
+      for (size_t j = 0; j < r.times.size(); ++ j) {
+        out << (j ? ", " : "") << r.times[j];
+      }
+      out << "], \"min\": " << r.min << ", \"median\": " << r.median << ", \"mean\": " << r.mean << " }";
+    }
+    out << std::endl << "  ]" << std::endl << "}" << std::endl;
+  }
+
+public:
+
+  suite(std::string name, int argc, char* argv[])
+  : d_name(name), d_warmup(1), d_repetitions(5)
+  {
+    for (int i = 1; i < argc; ++ i) {
+      std::string arg = argv[i];
+      if (i + 1 < argc && arg == "--warmup") {
+        d_warmup = atol(argv[++ i]);
+      } else if (i + 1 < argc && arg == "--repetitions") {
+        d_repetitions = std::max(1L, atol(argv[++ i]));
+      } else if (i + 1 < argc && arg == "--filter") {
+        d_filter = argv[++ i];
+      } else if (i + 1 < argc && arg == "--json") {
+        d_json = argv[++ i];
+      } else {
+        std::cerr << "usage: " << argv[0] << " [--warmup N] [--repetitions N] [--filter SUBSTRING] [--json FILE]" << std::endl;
+        exit(1);
+      }
+    }
+  }
+
+  /**
+   * Run the benchmark: f(stopwatch&) is one repetition that does ops
+   * operations. Returns false if filtered out.
+   */
+  template <typename F>
+  bool run(std::string name, size_t ops, F f) {
+    if (name.find(d_filter) == std::string::npos) {
+      return false;
+    }
+    for (size_t i = 0; i < d_warmup; ++ i) {
+      stopwatch sw;
+      f(sw);
+    }
+    result r;
+    r.name = name;
+    r.ops = ops;
+    for (size_t i = 0; i < d_repetitions; ++ i) {
+      stopwatch sw;
+      f(sw);
+      r.times.push_back(sw.elapsed());
+    }
+    std::vector<double> sorted = r.times;
+    std::sort(sorted.begin(), sorted.end());
+    r.min = sorted[0];
+    r.median = sorted.size() % 2 ? sorted[sorted.size() / 2] : (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2;
+    r.mean = 0;
+    for (size_t i = 0; i < sorted.size(); ++ i) {
+      r.mean += sorted[i] / sorted.size();
+    }
+    d_results.push_back(r);
+    out() << std::left << std::setw(50) << name
+          << std::right << std::setw(12) << std::fixed << std::setprecision(3) << r.median * 1000 << " ms"
+          << std::setw(12) << std::setprecision(1) << (ops ? r.median * 1e9 / ops : 0) << " ns/op"
+          << std::setw(10) << std::setprecision(1) << (r.median > 0 ? 100 * (sorted.back() - sorted[0]) / r.median : 0) << " % spread"
+          << std::endl;
+    return true;
+  }
+
+  /** Write the JSON output if asked */
+  ~suite() {
+    if (d_json == "-") {
+      write_json(std::cout);
+    } else if (!d_json.empty()) {
+      std::ofstream json(d_json.c_str());
+      write_json(json);
+    }
+  }
+};
+
+}
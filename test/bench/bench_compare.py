@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+#
+# This file is part of sally.
+# Copyright (C) 2015 SRI International.
+#
+# Sally is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Sally is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with sally.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+"""
+Compares two result files of sally_bench.py (or of a micro-benchmark with
+--json), and reports the benchmarks that got slower or faster by more than the
+threshold, changed status (e.g. ok to timeout), or are missing. Exits with 1 if
+anything got slower or stopped working, so that it can gate a change.
+
+Example:
+
+  bench_compare.py --threshold 0.05 baseline.json bench.json
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(filename):
+    with open(filename) as f:
+        return {b['name']: b for b in json.load(f)['benchmarks']}
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare two benchmark results.')
+    parser.add_argument('baseline', help='the baseline results')
+    parser.add_argument('current', help='the current results')
+    parser.add_argument('--threshold', type=float, default=0.10, help='relative change to report (default: 0.10)')
+    parser.add_argument('--metric', default='median', choices=['min', 'median', 'mean'], help='time to compare (default: median)')
+    parser.add_argument('--all', action='store_true', help='show all benchmarks, not only the changed ones')
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = 0
+    improvements = 0
+    for name in sorted(set(baseline) | set(current)):
+        if name not in current:
+            print('%-70s %s' % (name, 'missing'))
+            regressions += 1
+            continue
+        if name not in baseline:
+            print('%-70s %s' % (name, 'new'))
+            continue
+        old, new = baseline[name], current[name]
+        old_status, new_status = old.get('status', 'ok'), new.get('status', 'ok')
+        if old_status != new_status:
+            print('%-70s %s -> %s' % (name, old_status, new_status))
+            if new_status != 'ok':
+                regressions += 1
+            continue
+        if new_status != 'ok':
+            continue
+        if old.get('result', '') != new.get('result', ''):
+            print('%-70s result %s -> %s' % (name, old.get('result'), new.get('result')))
+            regressions += 1
+            continue
+        before, after = old[args.metric], new[args.metric]
+        change = (after - before) / before if before > 0 else 0
+        if change > args.threshold:
+            tag = 'SLOWER'
+            regressions += 1
+        elif change < -args.threshold:
+            tag = 'faster'
+            improvements += 1
+        elif args.all:
+            tag = ''
+        else:
+            continue
+        print('%-70s %10.4f s -> %10.4f s %+7.1f %% %s' % (name, before, after, 100 * change, tag))
+
+    print('%d regressions, %d improvements (threshold %.0f %%, %s)' % (regressions, improvements, 100 * args.threshold, args.metric))
+    sys.exit(1 if regressions else 0)
+
+
+if __name__ == '__main__':
+    main()
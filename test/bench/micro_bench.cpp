@@ -0,0 +1,211 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Micro-benchmarks of the core operations on a random bit-vector formula:
+ * term construction and hash-consing, substitution, model evaluation,
+ * unrolling of a transition relation with the trace helper, and translation
+ * of the formula into each of the available solvers. Every repetition works
+ * in a fresh term manager, so that the caches of earlier repetitions don't
+ * help. See bench.h for the options.
+ */
+
+#include "bench.h"
+
+#include "expr/term_manager.h"
+#include "expr/model.h"
+#include "expr/value.h"
+#include "system/state_type.h"
+#include "system/trace_helper.h"
+#include "system/transition_system.h"
+#include "smt/factory.h"
+#include "utils/options.h"
+#include "utils/statistics.h"
+
+#include <sstream>
+
+using namespace sally;
+using namespace expr;
+
+/** Size of the formulas */
+static const size_t formula_size = 100000;
+
+/** Size of the formulas for the solvers (bit-blasting is expensive) */
+static const size_t translation_size = 5000;
+
+/** Number of variables */
+static const size_t variables_count = 50;
+
+/** Bit-width of the variables */
+static const size_t bv_width = 32;
+
+/** Random bit-vector terms over the variables, returns the conjunction of some comparisons */
+static term_ref mk_formula(term_manager& tm, const std::vector<term_ref>& vars, size_t n) {
+  static const term_op ops[] = { TERM_BV_ADD, TERM_BV_SUB, TERM_BV_MUL, TERM_BV_XOR, TERM_BV_AND, TERM_BV_OR };
+  srand(0);
+  std::vector<term_ref> terms(vars);
+  for (size_t i = 0; i < n; ++ i) {
+    term_ref a = terms[rand() % terms.size()];
+    term_ref b = terms[rand() % terms.size()];
+    terms.push_back(tm.mk_term(ops[rand() % (sizeof(ops) / sizeof(ops[0]))], a, b));
+  }
+  std::vector<term_ref> atoms;
+  for (size_t i = terms.size() - 100; i + 1 < terms.size(); ++ i) {
+    atoms.push_back(tm.mk_term(TERM_BV_ULEQ, terms[i], terms[i + 1]));
+  }
+  return tm.mk_and(atoms);
+}
+
+static void mk_variables(term_manager& tm, std::vector<term_ref>& vars, const char* prefix) {
+  for (size_t i = 0; i < variables_count; ++ i) {
+    std::stringstream name;
+    name << prefix << i;
+    vars.push_back(tm.mk_variable(name.str(), tm.bitvector_type(bv_width)));
+  }
+}
+
+static void bench_construction(bench::suite& suite) {
+  suite.run("expr::construction", formula_size, [](bench::stopwatch& sw) {
+    utils::statistics stats;
+    term_manager tm(stats);
+    std::vector<term_ref> x;
+    mk_variables(tm, x, "x");
+    sw.start();
+    mk_formula(tm, x, formula_size);
+    sw.stop();
+  });
+  suite.run("expr::hash_consing", formula_size, [](bench::stopwatch& sw) {
+    utils::statistics stats;
+    term_manager tm(stats);
+    std::vector<term_ref> x;
+    mk_variables(tm, x, "x");
+    mk_formula(tm, x, formula_size);
+    // Same terms again, all found in the pool
+    sw.start();
+    mk_formula(tm, x, formula_size);
+    sw.stop();
+  });
+}
+
+static void bench_substitute(bench::suite& suite) {
+  suite.run("expr::substitute", formula_size, [](bench::stopwatch& sw) {
+    utils::statistics stats;
+    term_manager tm(stats);
+    std::vector<term_ref> x, y;
+    mk_variables(tm, x, "x");
+    mk_variables(tm, y, "y");
+    term_ref f = mk_formula(tm, x, formula_size);
+    term_manager::substitution_map subst;
+    for (size_t i = 0; i < x.size(); ++ i) {
+      subst[x[i]] = y[i];
+    }
+    sw.start();
+    tm.substitute(f, subst);
+    sw.stop();
+  });
+}
+
+static void bench_model(bench::suite& suite) {
+  suite.run("expr::model_evaluation", formula_size, [](bench::stopwatch& sw) {
+    utils::statistics stats;
+    term_manager tm(stats);
+    std::vector<term_ref> x;
+    mk_variables(tm, x, "x");
+    term_ref f = mk_formula(tm, x, formula_size);
+    model m(tm, false);
+    for (size_t i = 0; i < x.size(); ++ i) {
+      m.set_variable_value(x[i], value(bitvector(bv_width, (long) rand())));
+    }
+    sw.start();
+    m.get_term_value(f);
+    sw.stop();
+  });
+}
+
+/** Transition x_i' = x_i + x_{i+1} (rotating), unrolled k times */
+static void bench_unrolling(bench::suite& suite) {
+  const size_t k = 100;
+  suite.run("system::trace_helper::get_transition_formula", k * variables_count, [k](bench::stopwatch& sw) {
+    utils::statistics stats;
+    term_manager tm(stats);
+    std::vector<std::string> names;
+    std::vector<term_ref> types;
+    for (size_t i = 0; i < variables_count; ++ i) {
+      std::stringstream name;
+      name << "x" << i;
+      names.push_back(name.str());
+      types.push_back(tm.bitvector_type(bv_width));
+    }
+    term_ref state_type_var = tm.mk_struct_type(names, types);
+    term_ref input_type_var = tm.mk_struct_type(std::vector<std::string>(), std::vector<term_ref>());
+    system::state_type st("bench", tm, state_type_var, input_type_var);
+    const std::vector<term_ref>& current = st.get_variables(system::state_type::STATE_CURRENT);
+    const std::vector<term_ref>& next = st.get_variables(system::state_type::STATE_NEXT);
+    std::vector<term_ref> transitions;
+    for (size_t i = 0; i < current.size(); ++ i) {
+      term_ref sum = tm.mk_term(TERM_BV_ADD, current[i], current[(i + 1) % current.size()]);
+      transitions.push_back(tm.mk_term(TERM_EQ, next[i], sum));
+    }
+    term_ref T = tm.mk_and(transitions);
+    system::state_formula* I = new system::state_formula(tm, &st, tm.mk_boolean_constant(true));
+    system::transition_formula* TF = new system::transition_formula(tm, &st, T);
+    system::transition_system ts(&st, I, TF);
+    system::trace_helper* trace = ts.get_trace_helper();
+    sw.start();
+    for (size_t i = 0; i < k; ++ i) {
+      trace->get_transition_formula(T, i);
+    }
+    sw.stop();
+  });
+}
+
+/** Translation of the formula when asserted to each solver */
+static void bench_translation(bench::suite& suite) {
+  std::vector<std::string> solvers;
+  smt::factory::get_solvers(solvers);
+  for (size_t i = 0; i < solvers.size(); ++ i) {
+    std::string id = solvers[i];
+    try {
+      suite.run("smt::" + id + "::add", translation_size, [id](bench::stopwatch& sw) {
+        utils::statistics stats;
+        term_manager tm(stats);
+        options opts;
+        std::vector<term_ref> x;
+        mk_variables(tm, x, "x");
+        term_ref f = mk_formula(tm, x, translation_size);
+        smt::solver* solver = smt::factory::mk_solver(id, tm, opts, stats);
+        sw.start();
+        solver->add(f, smt::solver::CLASS_A);
+        sw.stop();
+        delete solver;
+      });
+    } catch (const sally::exception& e) {
+      std::cerr << "smt::" << id << ": skipped (" << e.get_message() << ")" << std::endl;
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  bench::suite suite("micro_bench", argc, argv);
+  bench_construction(suite);
+  bench_substitute(suite);
+  bench_model(suite);
+  bench_unrolling(suite);
+  bench_translation(suite);
+  return 0;
+}
@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+#
+# This file is part of sally.
+# Copyright (C) 2015 SRI International.
+#
+# Sally is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Sally is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with sally.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+"""
+Runs the benchmarks and collects the results into one JSON file.
+
+Micro-benchmarks are executables that take the options of bench.h and print
+their results as JSON (--json -). Macro-benchmarks run sally on the input
+files (directories are searched for inputs): a file with a .options file next
+to it (as in the regressions) is run with those options, other files are run
+with each of the engines given with --engines (an engine can have extra
+options after a ':', e.g. "bmc:--bmc-max 10"). Each run has a time limit,
+runs over the limit are reported with status "timeout" and are not repeated.
+
+Example:
+
+  sally_bench.py --sally build/src/sally --micro build/test/bench/micro_bench \\
+    --json bench.json test/regress/bmc/beem examples
+"""
+
+import argparse
+import json
+import os
+import shlex
+import subprocess
+import sys
+import time
+
+INPUT_EXTENSIONS = ('.mcmt', '.btor', '.btor2', '.sal', '.aig')
+
+
+def find_inputs(paths):
+    """The input files in the paths, sorted (directories are searched)"""
+    inputs = []
+    for path in paths:
+        if os.path.isdir(path):
+            for root, _, files in os.walk(path):
+                inputs.extend(os.path.join(root, f) for f in files if f.endswith(INPUT_EXTENSIONS))
+        else:
+            inputs.append(path)
+    return sorted(inputs)
+
+
+def summarize(name, times, status, ops=1, extra=None):
+    """A benchmark result in the format of bench.h"""
+    result = {'name': name, 'ops': ops, 'status': status, 'times': times}
+    if times:
+        ordered = sorted(times)
+        n = len(ordered)
+        result['min'] = ordered[0]
+        result['median'] = ordered[n // 2] if n % 2 else (ordered[n // 2 - 1] + ordered[n // 2]) / 2
+        result['mean'] = sum(ordered) / n
+    if extra:
+        result.update(extra)
+    return result
+
+
+def run_micro(executable, args):
+    """Run a micro-benchmark executable, returns its results"""
+    command = [executable, '--json', '-', '--warmup', str(args.warmup), '--repetitions', str(args.repetitions)]
+    if args.filter:
+        command += ['--filter', args.filter]
+    output = subprocess.run(command, stdout=subprocess.PIPE, check=True, universal_newlines=True).stdout
+    suite = json.loads(output)
+    for result in suite['benchmarks']:
+        result['name'] = 'micro/' + result['name']
+    return suite['benchmarks']
+
+
+def run_sally(args, options, filename):
+    """Run sally once, returns (seconds, status, output)"""
+    command = [args.sally] + options + [filename]
+    start = time.perf_counter()
+    try:
+        process = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                                 timeout=args.timeout, universal_newlines=True)
+    except subprocess.TimeoutExpired:
+        return time.perf_counter() - start, 'timeout', ''
+    elapsed = time.perf_counter() - start
+    return elapsed, 'ok' if process.returncode == 0 else 'error', process.stdout
+
+
+def run_macro(args, filename, engine, options):
+    """Run the benchmark with warm-up and repetitions"""
+    name = 'macro/%s/%s' % (os.path.relpath(filename, args.root), engine)
+    if args.filter and args.filter not in name:
+        return None
+    for _ in range(args.warmup):
+        elapsed, status, _ = run_sally(args, options, filename)
+        if status != 'ok':
+            return summarize(name, [], status)
+    times = []
+    output = ''
+    for _ in range(args.repetitions):
+        elapsed, status, output = run_sally(args, options, filename)
+        if status != 'ok':
+            return summarize(name, [], status)
+        times.append(elapsed)
+    # The last line of output is the result of the last query
+    lines = output.split()
+    return summarize(name, times, 'ok', extra={'result': lines[-1] if lines else ''})
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Run the sally benchmarks.')
+    parser.add_argument('inputs', nargs='*', help='input files or directories for the macro-benchmarks')
+    parser.add_argument('--sally', help='the sally executable (needed for the macro-benchmarks)')
+    parser.add_argument('--micro', action='append', default=[], help='a micro-benchmark executable (repeatable)')
+    parser.add_argument('--engines', default='pdkind', help='engines for inputs without options, comma separated (default: pdkind)')
+    parser.add_argument('--options', default='', help='extra sally options for all runs')
+    parser.add_argument('--warmup', type=int, default=1, help='warm-up runs (default: 1)')
+    parser.add_argument('--repetitions', type=int, default=3, help='measured runs (default: 3)')
+    parser.add_argument('--timeout', type=float, default=60, help='time limit of a sally run in seconds (default: 60)')
+    parser.add_argument('--filter', default='', help='only run the benchmarks whose name contains this')
+    parser.add_argument('--root', default=os.getcwd(), help='names of the inputs are relative to this')
+    parser.add_argument('--json', help='write the results to this file')
+    args = parser.parse_args()
+
+    results = []
+
+    for executable in args.micro:
+        print('Running %s' % executable, file=sys.stderr)
+        results.extend(run_micro(executable, args))
+
+    inputs = find_inputs(args.inputs)
+    if inputs and not args.sally:
+        parser.error('--sally is needed to run the inputs')
+    engines = [e.strip() for e in args.engines.split(',') if e.strip()]
+    extra = shlex.split(args.options)
+    for filename in inputs:
+        runs = []
+        options_file = filename + '.options'
+        if os.path.exists(options_file):
+            with open(options_file) as f:
+                options = shlex.split(f.read())
+            engine = options[options.index('--engine') + 1] if '--engine' in options[:-1] else 'default'
+            runs.append((engine, options))
+        else:
+            for spec in engines:
+                engine, _, engine_options = spec.partition(':')
+                runs.append((engine, ['--engine', engine] + shlex.split(engine_options)))
+        for engine, options in runs:
+            result = run_macro(args, filename, engine, extra + options)
+            if result is None:
+                continue
+            if 'median' in result:
+                print('%-70s %10.3f s' % (result['name'], result['median']), file=sys.stderr)
+            else:
+                print('%-70s %12s' % (result['name'], result['status']), file=sys.stderr)
+            results.append(result)
+
+    suite = {
+        'suite': 'sally_bench',
+        'warmup': args.warmup,
+        'repetitions': args.repetitions,
+        'benchmarks': results,
+    }
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(suite, f, indent=2)
+    else:
+        json.dump(suite, sys.stdout, indent=2)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,133 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Benchmark of term construction. First builds random Boolean and
+ * arithmetic terms through the term manager (half of the constructions hit
+ * the hash-consing pool), then parses the files given on the command line
+ * and reports the number of terms created per second.
+ */
+
+#include "expr/term_manager.h"
+#include "system/context.h"
+#include "parser/parser.h"
+#include "utils/options.h"
+#include "utils/statistics.h"
+
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+
+using namespace sally;
+using namespace expr;
+
+typedef std::chrono::steady_clock bench_clock;
+
+/** Elapsed seconds since start */
+static double elapsed_s(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+static void report(const std::string& name, size_t terms, double s) {
+  std::cout << std::left << std::setw(50) << name
+            << std::right << std::setw(10) << terms << " terms"
+            << std::setw(10) << std::fixed << std::setprecision(3) << s << " s"
+            << std::setw(14) << std::setprecision(0) << (s > 0 ? terms / s : 0) << " terms/s" << std::endl;
+}
+
+/** Report the hash quality of the term pool */
+static void report_hashing(term_manager& tm, utils::statistics& stats) {
+  std::string format = "  pool: load %tplf, avg probes %tpap, max probes %tpmp, collisions %tpc";
+  tm.update_hash_statistics();
+  std::cout << stats.format(format) << std::endl;
+}
+
+/** Number of terms created so far (ids are consecutive) */
+static size_t terms_created(term_manager& tm) {
+  return tm.id_of(tm.mk_variable(tm.boolean_type()));
+}
+
+/** Random conjunctions, disjunctions and sums over a few variables */
+static void bench_construction(size_t n) {
+
+  utils::statistics stats;
+  term_manager tm(stats);
+
+  std::vector<term_ref> bools, reals;
+  for (size_t i = 0; i < 20; ++ i) {
+    bools.push_back(tm.mk_variable(tm.boolean_type()));
+    reals.push_back(tm.mk_variable(tm.real_type()));
+  }
+
+  size_t start_terms = terms_created(tm);
+  bench_clock::time_point start = bench_clock::now();
+  for (size_t i = 0; i < n; ++ i) {
+    term_ref x = bools[rand() % bools.size()];
+    term_ref y = bools[rand() % bools.size()];
+    term_ref f = (i % 2) ? tm.mk_and(x, tm.mk_not(y)) : tm.mk_or(tm.mk_not(x), y);
+    if (bools.size() < 5000) {
+      bools.push_back(f);
+    }
+    term_ref a = reals[rand() % reals.size()];
+    term_ref b = reals[rand() % reals.size()];
+    term_ref sum = tm.mk_term(TERM_ADD, a, b);
+    if (reals.size() < 5000) {
+      reals.push_back(sum);
+    }
+    tm.mk_term(TERM_LEQ, sum, a);
+  }
+  report("construction (and/or/not/+/<=)", terms_created(tm) - start_terms, elapsed_s(start));
+  report_hashing(tm, stats);
+}
+
+/** Parse the file and report the terms created */
+static void bench_parse(const char* filename) {
+
+  utils::statistics stats;
+  term_manager tm(stats);
+  options opts;
+  system::context ctx(tm, opts, stats);
+
+  size_t start_terms = terms_created(tm);
+  bench_clock::time_point start = bench_clock::now();
+  parser::parser p(ctx, parser::parser::guess_language(filename), filename);
+  for (cmd::command* cmd = p.parse_command(); cmd != 0; cmd = p.parse_command()) {
+    delete cmd;
+  }
+  report(filename, terms_created(tm) - start_terms, elapsed_s(start));
+  report_hashing(tm, stats);
+}
+
+int main(int argc, char* argv[]) {
+
+  srand(0);
+
+  bench_construction(1000000);
+
+  for (int i = 1; i < argc; ++ i) {
+    try {
+      bench_parse(argv[i]);
+    } catch (sally::exception& e) {
+      std::cerr << argv[i] << ": " << e << std::endl;
+    }
+  }
+
+  return 0;
+}
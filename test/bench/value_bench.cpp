@@ -0,0 +1,157 @@
+/**
+ * This file is part of sally.
+ * Copyright (C) 2015 SRI International.
+ *
+ * Sally is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Sally is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with sally.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Micro-benchmark of the value representation. The expr::rational and
+ * expr::bitvector operations are compared against the plain GMP ones (the
+ * representation they had before the machine word fast paths), and
+ * model::get_term_value is timed on terms with small and with large values.
+ */
+
+#include "expr/term_manager.h"
+#include "expr/model.h"
+#include "expr/value.h"
+#include "utils/statistics.h"
+
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+
+using namespace sally;
+using namespace expr;
+
+typedef std::chrono::steady_clock bench_clock;
+
+/** Elapsed milliseconds since start */
+static double elapsed_ms(bench_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+}
+
+static void report(const char* name, double ms, size_t n) {
+  std::cout << std::left << std::setw(40) << name
+            << std::right << std::setw(12) << std::fixed << std::setprecision(2) << ms << " ms"
+            << std::setw(12) << std::setprecision(1) << (ms * 1e6 / n) << " ns/op" << std::endl;
+}
+
+/** Sum of a/(i+1) for i < n, with the numerator reduced to keep values small */
+static void bench_rational(size_t n) {
+  bench_clock::time_point start = bench_clock::now();
+  rational sum;
+  for (size_t i = 0; i < n; ++ i) {
+    rational q((long) (i % 17) - 8, (i % 5) + 1);
+    sum += q * q - q;
+    if (sum.get_denominator() > integer(1000L)) {
+      sum = sum.floor();
+    }
+  }
+  report("rational (int64 fast path)", elapsed_ms(start), n);
+
+  start = bench_clock::now();
+  mpq_class gmp_sum;
+  for (size_t i = 0; i < n; ++ i) {
+    mpq_class q((long) (i % 17) - 8, (i % 5) + 1);
+    q.canonicalize();
+    gmp_sum += q * q - q;
+    if (gmp_sum.get_den() > 1000) {
+      mpz_class floor;
+      mpz_fdiv_q(floor.get_mpz_t(), gmp_sum.get_num_mpz_t(), gmp_sum.get_den_mpz_t());
+      gmp_sum = floor;
+    }
+  }
+  report("rational (mpq_class)", elapsed_ms(start), n);
+
+  if (sum.mpq() != gmp_sum) {
+    std::cerr << "rational results differ: " << sum << " vs " << gmp_sum << std::endl;
+    exit(1);
+  }
+}
+
+/** Mixed 32-bit operations */
+static void bench_bitvector(size_t n) {
+  bench_clock::time_point start = bench_clock::now();
+  bitvector x(32, 12345), c(32, 2654435761L);
+  for (size_t i = 0; i < n; ++ i) {
+    x = x.mul(c).add(bitvector(32, (long) i)).bvxor(x.lshr(bitvector(32, 7)));
+  }
+  report("bitvector 32 (word fast path)", elapsed_ms(start), n);
+
+  start = bench_clock::now();
+  mpz_class y(12345), d(2654435761UL);
+  for (size_t i = 0; i < n; ++ i) {
+    mpz_class t = y * d + (unsigned long) i;
+    mpz_fdiv_r_2exp(t.get_mpz_t(), t.get_mpz_t(), 32);
+    y = t ^ (y >> 7);
+  }
+  report("bitvector 32 (mpz_class)", elapsed_ms(start), n);
+
+  if (x.mpz() != y) {
+    std::cerr << "bit-vector results differ: " << x << " vs " << y << std::endl;
+    exit(1);
+  }
+}
+
+/** Evaluate sum c_i*x_i <= k in many models */
+static void bench_model(term_manager& tm, const char* name, long scale, size_t n) {
+  size_t vars = 20;
+  std::vector<term_ref> xs, monomials;
+  for (size_t i = 0; i < vars; ++ i) {
+    term_ref x = tm.mk_variable(tm.real_type());
+    rational c(mpq_class(mpz_class(scale) * (long) (i + 1), 3));
+    xs.push_back(x);
+    monomials.push_back(tm.mk_term(TERM_MUL, tm.mk_rational_constant(c), x));
+  }
+  term_ref f = tm.mk_term(TERM_LEQ, tm.mk_term(TERM_ADD, monomials), tm.mk_rational_constant(rational(scale, 1)));
+
+  std::vector<model::ref> models;
+  for (size_t k = 0; k < 100; ++ k) {
+    model::ref m = new model(tm, false);
+    for (size_t i = 0; i < vars; ++ i) {
+      m->set_variable_value(xs[i], value(rational((long) (rand() % 100) - 50, 7)));
+    }
+    models.push_back(m);
+  }
+
+  bench_clock::time_point start = bench_clock::now();
+  size_t count = 0;
+  for (size_t i = 0; i < n; ++ i) {
+    count += models[i % models.size()]->get_term_value(f).get_bool();
+  }
+  report(name, elapsed_ms(start), n);
+  if (count > n) {
+    exit(1);
+  }
+}
+
+int main(int argc, char* argv[]) {
+
+  size_t n = argc > 1 ? atol(argv[1]) : 1000000;
+
+  srand(0);
+
+  bench_rational(n);
+  bench_bitvector(n);
+
+  utils::statistics stats;
+  term_manager tm(stats);
+  bench_model(tm, "model evaluation (small values)", 1, n / 100);
+  bench_model(tm, "model evaluation (GMP values)", 1L << 62, n / 100);
+
+  return 0;
+}
@@ -0,0 +1,341 @@
+#!/usr/bin/env python3
+#
+# This file is part of sally.
+# Copyright (C) 2015 SRI International.
+#
+# Sally is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Sally is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with sally.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+"""
+Runs the regressions in parallel and keeps the results in a database.
+
+Each regression is a model with a .options file (one line of options) and
+optionally a .gold file (a regular expression that the output must match, as
+in the ctest regressions). The models are run in parallel, each with a time
+limit and a memory limit. For each run we record the status (pass, fail,
+error, timeout, memout), the result, the wall time, the peak resident memory,
+and the number of solver checks (from the --solver-profile statistics), under
+the current commit, in an SQLite database (and optionally a CSV file).
+
+After the run, the times are compared to the last other commit in the
+database (or --baseline): per family, i.e. per directory component of the
+models (beem, bv, kind, pdkind, nra, ...), and per model. Only models that
+pass in both runs are compared.
+
+Example:
+
+  regress.py --sally build/src/sally --jobs 8 --db regress.db test/regress
+  regress.py --db regress.db --report-only --baseline 1a2b3c4
+"""
+
+import argparse
+import csv
+import datetime
+import json
+import os
+import re
+import shlex
+import signal
+import sqlite3
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+MODEL_EXTENSIONS = ('.mcmt', '.btor', '.btor2', '.sal')
+
+COLUMNS = ['commit_id', 'date', 'model', 'family', 'options', 'status', 'result',
+           'wall', 'peak_rss_kb', 'solver_checks']
+
+
+def find_models(paths):
+    """The models with options in the paths, sorted"""
+    models = []
+    for path in paths:
+        if os.path.isdir(path):
+            for root, _, files in os.walk(path):
+                models.extend(os.path.join(root, f) for f in files
+                              if f.endswith(MODEL_EXTENSIONS) and os.path.exists(os.path.join(root, f + '.options')))
+        else:
+            models.append(path)
+    return sorted(models)
+
+
+def available_solvers(sally):
+    """The solvers sally was built with, from the help"""
+    output = subprocess.run([sally, '--help'], stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                            universal_newlines=True).stdout
+    match = re.search(r'The SMT solver to use: ([^\n]*)', output)
+    return set(s.strip() for s in match.group(1).split(',')) if match else set()
+
+
+def current_commit(root):
+    """The commit of the source tree, with -dirty if it has changes"""
+    try:
+        commit = subprocess.run(['git', '-C', root, 'rev-parse', '--short', 'HEAD'], stdout=subprocess.PIPE,
+                                stderr=subprocess.DEVNULL, universal_newlines=True, check=True).stdout.strip()
+        changes = subprocess.run(['git', '-C', root, 'status', '--porcelain', '--untracked-files=no'],
+                                 stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, universal_newlines=True).stdout
+        return commit + ('-dirty' if changes.strip() else '')
+    except (OSError, subprocess.CalledProcessError):
+        return 'unknown'
+
+
+def family_of(model, root):
+    """The family of the model (its directory relative to the root)"""
+    return os.path.dirname(os.path.relpath(model, root)) or '.'
+
+
+def solver_checks(stats_file):
+    """Number of solver checks from the last line of the JSON live statistics"""
+    try:
+        with open(stats_file) as f:
+            lines = [line for line in f if line.strip()]
+        stats = json.loads(lines[-1]) if lines else {}
+    except (OSError, ValueError):
+        return None
+    return sum(int(v) for k, v in stats.items() if k.startswith('smt::profile::') and k.endswith('::check_time::count'))
+
+
+def run_model(args, model):
+    """Run sally on the model, returns the row for the database"""
+    with open(model + '.options') as f:
+        options = shlex.split(f.readline())
+    gold = None
+    if os.path.exists(model + '.gold'):
+        with open(model + '.gold') as f:
+            gold = f.read()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        stats_file = os.path.join(tmp, 'stats.json')
+        output_file = os.path.join(tmp, 'output')
+        command = [args.sally] + options + ['--solver-profile', '--live-stats', stats_file,
+                                            '--live-stats-format', 'json', '--live-stats-time', '1000', model]
+        if args.memory:
+            # Limit the address space in a shell that then becomes sally
+            command = ['sh', '-c', 'ulimit -v %d && exec "$@"' % (args.memory * 1024), 'sh'] + command
+
+        start = time.perf_counter()
+        with open(output_file, 'w') as out:
+            process = subprocess.Popen(command, stdout=out, stderr=subprocess.STDOUT, cwd=tmp, start_new_session=True)
+        timed_out = threading.Event()
+
+        def kill():
+            timed_out.set()
+            try:
+                os.killpg(process.pid, signal.SIGKILL)
+            except OSError:
+                pass
+
+        # Wait with wait4() to get the resources of the process
+        timer = threading.Timer(args.timeout, kill)
+        timer.start()
+        _, status, rusage = os.wait4(process.pid, 0)
+        timer.cancel()
+        wall = time.perf_counter() - start
+        process.returncode = status
+
+        with open(output_file) as f:
+            output = f.read()
+        checks = solver_checks(stats_file)
+
+    # ru_maxrss is in kilobytes on Linux
+    peak = rusage.ru_maxrss
+    lines = output.split()
+    result = lines[-1] if lines else ''
+    if timed_out.is_set():
+        outcome = 'timeout'
+    elif process.returncode != 0:
+        outcome = 'memout' if re.search(r'bad_alloc|out of memory', output, re.IGNORECASE) else 'error'
+    elif gold is not None and not re.search(gold, output):
+        outcome = 'fail'
+    else:
+        outcome = 'pass'
+
+    return {
+        'commit_id': args.commit,
+        'date': args.date,
+        'model': os.path.relpath(model, args.root),
+        'family': family_of(model, args.root),
+        'options': ' '.join(options),
+        'status': outcome,
+        'result': result,
+        'wall': wall,
+        'peak_rss_kb': peak,
+        'solver_checks': checks,
+    }
+
+
+def open_db(filename):
+    db = sqlite3.connect(filename)
+    db.execute('CREATE TABLE IF NOT EXISTS runs (commit_id TEXT, date TEXT, model TEXT, family TEXT, options TEXT, '
+               'status TEXT, result TEXT, wall REAL, peak_rss_kb INTEGER, solver_checks INTEGER)')
+    db.execute('CREATE INDEX IF NOT EXISTS runs_commit ON runs (commit_id, model)')
+    return db
+
+
+def latest_runs(db, commit):
+    """The last run of each model at the commit"""
+    rows = db.execute('SELECT model, family, status, wall, peak_rss_kb, solver_checks, result FROM runs '
+                      'WHERE commit_id = ? ORDER BY date', (commit,)).fetchall()
+    runs = {}
+    for model, family, status, wall, peak, checks, result in rows:
+        runs[model] = {'family': family, 'status': status, 'wall': wall, 'peak': peak, 'checks': checks, 'result': result}
+    return runs
+
+
+def previous_commit(db, commit):
+    """The most recent other commit in the database"""
+    row = db.execute('SELECT commit_id FROM runs WHERE commit_id != ? GROUP BY commit_id ORDER BY MAX(date) DESC LIMIT 1',
+                     (commit,)).fetchone()
+    return row[0] if row else None
+
+
+def family_keys(family):
+    """The families a model counts in: every component of its directory"""
+    return [part for part in family.split('/') if part and part != '.'] or ['.']
+
+
+def report(db, commit, baseline, threshold, min_delta):
+    """Compare the commit to the baseline, returns the number of regressions"""
+    current = latest_runs(db, commit)
+    before = latest_runs(db, baseline)
+    print('Comparing %s to %s' % (commit, baseline))
+
+    regressions = 0
+    changes = [(m, before[m]['status'], current[m]['status']) for m in sorted(current)
+               if m in before and before[m]['status'] != current[m]['status']]
+    for model, old, new in changes:
+        print('  %-70s %s -> %s' % (model, old, new))
+        if new != 'pass':
+            regressions += 1
+
+    families = {}
+    slower = []
+    for model in sorted(current):
+        if model not in before or current[model]['status'] != 'pass' or before[model]['status'] != 'pass':
+            continue
+        old, new = before[model]['wall'], current[model]['wall']
+        for key in family_keys(current[model]['family']):
+            total = families.setdefault(key, [0, 0.0, 0.0, 0, 0])
+            total[0] += 1
+            total[1] += old
+            total[2] += new
+            total[3] += before[model]['checks'] or 0
+            total[4] += current[model]['checks'] or 0
+        if new - old > min_delta and new > old * (1 + threshold):
+            slower.append((new - old, model, old, new))
+
+    print('  %-24s %7s %12s %12s %8s %14s %14s' % ('family', 'models', 'before (s)', 'after (s)', 'change', 'checks before', 'checks after'))
+    for key in sorted(families):
+        count, old, new, old_checks, new_checks = families[key]
+        change = (new - old) / old if old > 0 else 0
+        tag = ''
+        if new - old > min_delta and change > threshold:
+            tag = 'SLOWER'
+            regressions += 1
+        elif old - new > min_delta and change < -threshold:
+            tag = 'faster'
+        print('  %-24s %7d %12.2f %12.2f %+7.1f%% %14d %14d %s' % (key, count, old, new, 100 * change, old_checks, new_checks, tag))
+
+    if slower:
+        print('  Slowest models:')
+        for delta, model, old, new in sorted(slower, reverse=True)[:10]:
+            print('    %-70s %8.2f s -> %8.2f s' % (model, old, new))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Run the regressions in parallel and record the results.')
+    parser.add_argument('paths', nargs='*', help='models or directories of models')
+    parser.add_argument('--sally', help='the sally executable')
+    parser.add_argument('--jobs', '-j', type=int, default=os.cpu_count() or 1, help='number of parallel runs')
+    parser.add_argument('--timeout', type=float, default=60, help='time limit per model in seconds (default: 60)')
+    parser.add_argument('--memory', type=int, default=4096, help='memory limit per model in MB (default: 4096, 0 for none)')
+    parser.add_argument('--filter', default='', help='only run the models whose path contains this')
+    parser.add_argument('--db', default='regress.db', help='the results database (default: regress.db)')
+    parser.add_argument('--csv', help='also append the results to this CSV file')
+    parser.add_argument('--root', help='model names are relative to this (default: the common directory)')
+    parser.add_argument('--commit', help='record the results under this commit (default: from git)')
+    parser.add_argument('--baseline', help='compare to this commit (default: the previous one in the database)')
+    parser.add_argument('--threshold', type=float, default=0.10, help='relative slowdown to report (default: 0.10)')
+    parser.add_argument('--min-delta', type=float, default=0.5, help='ignore changes smaller than this many seconds (default: 0.5)')
+    parser.add_argument('--report-only', action='store_true', help='only compare the results in the database')
+    parser.add_argument('--fail-on-regression', action='store_true', help='exit with 1 on timing regressions too')
+    args = parser.parse_args()
+
+    source = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+    args.commit = args.commit or current_commit(source)
+    args.date = datetime.datetime.now().isoformat(timespec='seconds')
+    db = open_db(args.db)
+
+    failures = 0
+    if not args.report_only:
+        if not args.sally:
+            parser.error('--sally is needed to run the models')
+        args.sally = os.path.abspath(args.sally)
+        models = [os.path.abspath(m) for m in find_models(args.paths) if args.filter in m]
+        if not models:
+            parser.error('no models to run')
+        if not args.root:
+            directories = [p for p in args.paths if os.path.isdir(p)]
+            args.root = directories[0] if len(directories) == 1 else os.path.commonpath([os.path.dirname(m) for m in models])
+        args.root = os.path.abspath(args.root)
+
+        # Skip the models that need solvers we don't have
+        solvers = available_solvers(args.sally)
+        runnable = []
+        for model in models:
+            with open(model + '.options') as f:
+                options = shlex.split(f.readline())
+            needed = [options[i + 1] for i, o in enumerate(options[:-1]) if o == '--solver']
+            if all(s in solvers for s in needed):
+                runnable.append(model)
+
+        print('Running %d models (%d skipped) at %s with %d jobs' % (len(runnable), len(models) - len(runnable), args.commit, args.jobs))
+        rows = []
+        with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+            for row in pool.map(lambda m: run_model(args, m), runnable):
+                print('  %-70s %-8s %8.2f s %8d KB' % (row['model'], row['status'], row['wall'], row['peak_rss_kb']))
+                sys.stdout.flush()
+                rows.append(row)
+                if row['status'] != 'pass':
+                    failures += 1
+
+        db.executemany('INSERT INTO runs VALUES (%s)' % ', '.join('?' * len(COLUMNS)),
+                       [tuple(row[c] for c in COLUMNS) for row in rows])
+        db.commit()
+        if args.csv:
+            exists = os.path.exists(args.csv)
+            with open(args.csv, 'a', newline='') as f:
+                writer = csv.DictWriter(f, fieldnames=COLUMNS)
+                if not exists:
+                    writer.writeheader()
+                writer.writerows(rows)
+        print('%d passed, %d failed' % (len(rows) - failures, failures))
+
+    baseline = args.baseline or previous_commit(db, args.commit)
+    regressions = 0
+    if baseline:
+        regressions = report(db, args.commit, baseline, args.threshold, args.min_delta)
+    else:
+        print('No baseline to compare to')
+
+    sys.exit(1 if failures or (args.fail_on_regression and regressions) else 0)
+
+
+if __name__ == '__main__':
+    main()
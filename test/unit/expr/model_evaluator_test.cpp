@@ -0,0 +1,196 @@
+#include <boost/test/unit_test.hpp>
+
+#include "expr/term.h"
+#include "expr/term_manager.h"
+#include "expr/model.h"
+#include "expr/model_evaluator.h"
+
+#include "utils/statistics.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cassert>
+
+using namespace std;
+using namespace sally;
+using namespace expr;
+
+struct model_evaluator_test_fixture {
+
+  utils::statistics stats;
+  term_manager tm;
+
+public:
+  model_evaluator_test_fixture()
+  : tm(stats)
+  {
+    cout << set_tm(tm);
+  }
+
+  /** Evaluate the operation on constants with expr::bitvector */
+  value evaluate(term_op op, const bitvector& a, const bitvector& b) {
+    switch (op) {
+    case TERM_BV_ADD: return a.add(b);
+    case TERM_BV_SUB: return a.sub(b);
+    case TERM_BV_MUL: return a.mul(b);
+    case TERM_BV_UDIV: return a.udiv(b);
+    case TERM_BV_SDIV: return a.sdiv(b);
+    case TERM_BV_UREM: return a.urem(b);
+    case TERM_BV_SREM: return a.srem(b);
+    case TERM_BV_SMOD: return a.smod(b);
+    case TERM_BV_SHL: return a.shl(b);
+    case TERM_BV_LSHR: return a.lshr(b);
+    case TERM_BV_ASHR: return a.ashr(b);
+    case TERM_BV_XOR: return a.bvxor(b);
+    case TERM_BV_AND: return a.bvand(b);
+    case TERM_BV_OR: return a.bvor(b);
+    case TERM_BV_CONCAT: return a.concat(b);
+    case TERM_BV_ULEQ: return a.uleq(b);
+    case TERM_BV_SLEQ: return a.sleq(b);
+    case TERM_BV_ULT: return a.ult(b);
+    case TERM_BV_SLT: return a.slt(b);
+    case TERM_BV_UGEQ: return a.ugeq(b);
+    case TERM_BV_SGEQ: return a.sgeq(b);
+    case TERM_BV_UGT: return a.ugt(b);
+    case TERM_BV_SGT: return a.sgt(b);
+    default:
+      assert(false);
+    }
+    return value();
+  }
+
+  /** Random bit-vector, with the corner cases */
+  bitvector random_bitvector(size_t size, size_t k) {
+    switch (k) {
+    case 0: return bitvector(size);
+    case 1: return bitvector::one(size);
+    case 2: return bitvector(size, 1);
+    default: {
+      integer z;
+      for (size_t i = 0; i < size; i += 16) {
+        z = z*integer(1L << 16) + integer((long) (rand() % (1 << 16)));
+      }
+      return bitvector(size, z);
+    }
+    }
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(model_evaluator_tests, model_evaluator_test_fixture)
+
+BOOST_AUTO_TEST_CASE(bitvector_operations) {
+
+  term_op ops[] = {
+      TERM_BV_ADD, TERM_BV_SUB, TERM_BV_MUL, TERM_BV_UDIV, TERM_BV_SDIV,
+      TERM_BV_UREM, TERM_BV_SREM, TERM_BV_SMOD, TERM_BV_SHL, TERM_BV_LSHR,
+      TERM_BV_ASHR, TERM_BV_XOR, TERM_BV_AND, TERM_BV_OR, TERM_BV_CONCAT,
+      TERM_BV_ULEQ, TERM_BV_SLEQ, TERM_BV_ULT, TERM_BV_SLT,
+      TERM_BV_UGEQ, TERM_BV_SGEQ, TERM_BV_UGT, TERM_BV_SGT
+  };
+  size_t ops_size = sizeof(ops) / sizeof(term_op);
+
+  // Words, words with wide concatenation, and values
+  size_t sizes[] = { 1, 3, 8, 33, 64, 70 };
+
+  srand(0);
+
+  for (size_t s = 0; s < 6; ++ s) {
+    size_t size = sizes[s];
+    term_ref x = tm.mk_variable(tm.bitvector_type(size));
+    term_ref y = tm.mk_variable(tm.bitvector_type(size));
+    for (size_t k = 0; k < 20; ++ k) {
+      bitvector a = random_bitvector(size, k);
+      bitvector b = random_bitvector(size, (k + 3) % 20);
+      model m(tm, false);
+      m.set_variable_value(x, a);
+      m.set_variable_value(y, b);
+      for (size_t i = 0; i < ops_size; ++ i) {
+        term_ref t = tm.mk_term(ops[i], x, y);
+        model_evaluator evaluator(tm, t);
+        value expected = evaluate(ops[i], a, b);
+        value actual = evaluator.evaluate(m);
+        if (!(expected == actual)) {
+          cout << ops[i] << "(" << a << ", " << b << "): expected " << expected << ", got " << actual << endl;
+        }
+        BOOST_CHECK(expected == actual);
+      }
+      // Extract and extend
+      term_ref low = tm.mk_bitvector_extract(x, bitvector_extract(size - 1, size / 2));
+      BOOST_CHECK(model_evaluator(tm, low).evaluate(m) == value(a.extract(size / 2, size - 1)));
+      term_ref sext = tm.mk_bitvector_sgn_extend(x, bitvector_sgn_extend(5));
+      term_ref sext_expected = tm.mk_term(TERM_BV_CONCAT, tm.mk_term(TERM_ITE,
+          tm.mk_term(TERM_BV_SLT, x, tm.mk_bitvector_constant(bitvector(size))),
+          tm.mk_bitvector_constant(bitvector::one(5)), tm.mk_bitvector_constant(bitvector(5))), x);
+      BOOST_CHECK(model_evaluator(tm, sext).evaluate(m) == model_evaluator(tm, sext_expected).evaluate(m));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(arithmetic) {
+
+  term_ref x = tm.mk_variable("x", tm.real_type());
+  term_ref y = tm.mk_variable("y", tm.integer_type());
+  term_ref b = tm.mk_variable("b", tm.boolean_type());
+  term_ref half = tm.mk_rational_constant(rational(1, 2));
+
+  // ite(b, x + 1/2, y) <= 2*y and to_int(x) = y
+  term_ref sum = tm.mk_term(TERM_ADD, x, half);
+  term_ref ite = tm.mk_term(TERM_ITE, b, sum, tm.mk_term(TERM_TO_REAL, y));
+  term_ref leq = tm.mk_term(TERM_LEQ, ite, tm.mk_term(TERM_MUL, tm.mk_rational_constant(rational(2, 1)), y));
+  term_ref eq = tm.mk_term(TERM_EQ, tm.mk_term(TERM_TO_INT, x), y);
+  term_ref f = tm.mk_and(leq, eq);
+
+  model m(tm, false);
+  m.set_variable_value(x, value(rational(3, 2)));
+  m.set_variable_value(y, value(rational(1, 1)));
+  m.set_variable_value(b, value(true));
+
+  model_evaluator evaluator(tm, f);
+  BOOST_CHECK(evaluator.is_true(m));
+  BOOST_CHECK(model_evaluator(tm, ite).evaluate(m) == value(rational(2, 1)));
+
+  // Reuse the program with another value
+  m.set_variable_value(x, value(rational(5, 2)));
+  BOOST_CHECK(!evaluator.is_true(m));
+  m.set_variable_value(b, value(false));
+  m.set_variable_value(y, value(rational(2, 1)));
+  BOOST_CHECK(evaluator.is_true(m));
+}
+
+BOOST_AUTO_TEST_CASE(batch_and_renaming) {
+
+  term_ref x = tm.mk_variable("x", tm.bitvector_type(16));
+  term_ref x_next = tm.mk_variable("x_next", tm.bitvector_type(16));
+  term_ref one = tm.mk_bitvector_constant(bitvector(16, 1));
+
+  // x_next = x + 1
+  term_ref f = tm.mk_term(TERM_EQ, x_next, tm.mk_term(TERM_BV_ADD, x, one));
+
+  // Many models, every third one satisfies f
+  std::vector<model::ref> models;
+  for (size_t i = 0; i < 150; ++ i) {
+    model::ref m = new model(tm, false);
+    m->set_variable_value(x, value(bitvector(16, i)));
+    m->set_variable_value(x_next, value(bitvector(16, i % 3 == 0 ? i + 1 : i)));
+    models.push_back(m);
+  }
+
+  model_evaluator evaluator(tm, f);
+  std::vector<bool> results;
+  evaluator.is_true(models, results);
+  BOOST_CHECK_EQUAL(results.size(), models.size());
+  for (size_t i = 0; i < models.size(); ++ i) {
+    BOOST_CHECK_EQUAL(results[i], i % 3 == 0);
+    BOOST_CHECK_EQUAL(results[i], models[i]->is_true(f));
+  }
+
+  // Evaluate x + 1 = x_next, with x_next renamed to x: never true
+  term_manager::substitution_map renaming;
+  renaming[x_next] = x;
+  model_evaluator renamed(tm, f, renaming);
+  for (size_t i = 0; i < models.size(); ++ i) {
+    BOOST_CHECK(!renamed.is_true(*models[i]));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
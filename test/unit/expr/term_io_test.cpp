@@ -0,0 +1,105 @@
+#include <boost/test/unit_test.hpp>
+
+#include "expr/term.h"
+#include "expr/term_manager.h"
+#include "expr/term_io.h"
+
+#include "utils/statistics.h"
+#include "utils/exception.h"
+
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace sally;
+using namespace expr;
+
+struct term_io_test_fixture {
+
+  utils::statistics stats;
+  term_manager tm;
+  term_manager tm_read;
+
+  term_io_test_fixture()
+  : tm(stats), tm_read(stats)
+  {}
+
+  /** Print the term of the term manager */
+  static string to_string(term_manager& tm, term_ref t) {
+    stringstream ss;
+    ss << set_tm(tm) << t;
+    return ss.str();
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(term_io_tests, term_io_test_fixture)
+
+BOOST_AUTO_TEST_CASE(round_trip) {
+
+  term_ref x = tm.mk_variable("x", tm.real_type());
+  term_ref b = tm.mk_variable("b", tm.boolean_type());
+  term_ref v = tm.mk_variable("v", tm.bitvector_type(100));
+
+  std::vector<term_ref> terms;
+  terms.push_back(tm.mk_term(TERM_LEQ, tm.mk_term(TERM_ADD, x, tm.mk_rational_constant(rational(-7, 3))), x));
+  terms.push_back(tm.mk_term(TERM_ITE, b, x, tm.mk_rational_constant(rational(123456789, 1) * rational(987654321, 1))));
+  terms.push_back(tm.mk_term(TERM_EQ, v, tm.mk_bitvector_constant(bitvector(100, integer("12345678901234567890123", 10)))));
+  terms.push_back(tm.mk_bitvector_extract(v, bitvector_extract(70, 3)));
+  terms.push_back(tm.mk_term(TERM_AND, b, tm.mk_term(TERM_NOT, b)));
+  terms.push_back(term_ref());
+
+  term_writer writer(tm);
+  std::string out;
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < terms.size(); ++ i) {
+    indices.push_back(writer.add_term(terms[i]));
+  }
+  // Adding again gives the same index
+  BOOST_CHECK_EQUAL(writer.add_term(terms[0]), indices[0]);
+  writer.write_records(out);
+  for (size_t i = 0; i < indices.size(); ++ i) {
+    write_uint(out, indices[i]);
+  }
+
+  term_reader reader(tm_read);
+  reader.set_input(out.data(), out.data() + out.size());
+  reader.read_records();
+  for (size_t i = 0; i < terms.size(); ++ i) {
+    term_ref t = reader.read_term();
+    BOOST_CHECK_EQUAL(t.is_null(), terms[i].is_null());
+    if (!t.is_null()) {
+      BOOST_CHECK_EQUAL(to_string(tm_read, t), to_string(tm, terms[i]));
+      BOOST_CHECK_EQUAL(to_string(tm_read, tm_read.type_of(t)), to_string(tm, tm.type_of(terms[i])));
+    }
+  }
+  BOOST_CHECK(reader.at_end());
+}
+
+BOOST_AUTO_TEST_CASE(indexed_terms) {
+
+  term_ref x = tm.mk_variable("x", tm.integer_type());
+  term_ref x_read = tm_read.mk_variable("y", tm_read.integer_type());
+
+  // x is indexed on both sides, so it's not written
+  term_writer writer(tm);
+  BOOST_CHECK(writer.index_term(x));
+  BOOST_CHECK(!writer.index_term(x));
+  std::string out;
+  size_t index = writer.add_term(tm.mk_term(TERM_GT, x, tm.mk_rational_constant(rational(2, 1))));
+  writer.write_records(out);
+  write_uint(out, index);
+
+  term_reader reader(tm_read);
+  reader.index_term(x_read);
+  reader.set_input(out.data(), out.data() + out.size());
+  reader.read_records();
+  term_ref t = reader.read_term();
+  BOOST_CHECK_EQUAL(t, tm_read.mk_term(TERM_GT, x_read, tm_read.mk_rational_constant(rational(2, 1))));
+
+  // Truncated input
+  term_reader truncated(tm_read);
+  truncated.set_input(out.data(), out.data() + out.size() - 2);
+  BOOST_CHECK_THROW(truncated.read_records(), sally::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
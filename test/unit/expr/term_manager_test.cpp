@@ -2,10 +2,13 @@
 
 #include "expr/term.h"
 #include "expr/term_manager.h"
+#include "expr/term_definitions.h"
 
 #include "utils/statistics.h"
+#include "utils/exception.h"
 
 #include <iostream>
+#include <sstream>
 
 using namespace std;
 using namespace sally;
@@ -304,4 +307,148 @@ BOOST_AUTO_TEST_CASE(term_manager_hashconsing) {
 
 }
 
+BOOST_AUTO_TEST_CASE(inline_types) {
+
+  cout << set_tm(tm);
+
+  term_ref x = tm.mk_variable("x", tm.integer_type());
+  term_ref y = tm.mk_variable("y", tm.real_type());
+  term_ref b = tm.mk_variable("b", tm.boolean_type());
+
+  // Types of terms and types
+  term_ref sum = tm.mk_term(TERM_ADD, x, y);
+  BOOST_CHECK_EQUAL(tm.type_of(sum), tm.real_type());
+  BOOST_CHECK_EQUAL(tm.type_of(tm.mk_term(TERM_ADD, x, x)), tm.integer_type());
+  BOOST_CHECK_EQUAL(tm.type_of(tm.mk_term(TERM_LEQ, sum, x)), tm.boolean_type());
+  BOOST_CHECK_EQUAL(tm.type_of(tm.integer_type()), tm.type_of(tm.real_type()));
+  BOOST_CHECK_EQUAL(tm.base_type_of(x), tm.real_type());
+
+  // Compound types keep their base type
+  std::vector<term_ref> args;
+  args.push_back(tm.integer_type());
+  args.push_back(tm.boolean_type());
+  term_ref tuple = tm.tuple_type(args);
+  args[0] = tm.real_type();
+  BOOST_CHECK_EQUAL(tm.base_type_of(tuple), tm.tuple_type(args));
+
+  // Ill-typed terms are reported when type-checked
+  BOOST_CHECK_THROW(tm.mk_term(TERM_AND, b, x), sally::exception);
+  BOOST_CHECK_THROW(tm.mk_term(TERM_NOT, tm.mk_term(TERM_ADD, x, b)), sally::exception);
+}
+
+BOOST_AUTO_TEST_CASE(definitions) {
+
+  cout << set_tm(tm);
+
+  term_ref x = tm.mk_variable("x", tm.real_type());
+  term_ref y = tm.mk_variable("y", tm.real_type());
+  term_ref sum = tm.mk_term(TERM_ADD, x, y);
+  term_ref mul = tm.mk_term(TERM_MUL, tm.mk_rational_constant(rational(2, 1)), sum);
+  term_ref f = tm.mk_term(TERM_LEQ, sum, mul);
+
+  // Variable names starting with the prefix change the prefix
+  tm.mk_variable("d1", tm.real_type());
+  term_definitions defs(tm, "d");
+
+  // Compound subterms are defined once, children first
+  std::vector<term_ref> definitions;
+  defs.add(f, definitions);
+  BOOST_CHECK_EQUAL(definitions.size(), 3);
+  BOOST_CHECK_EQUAL(definitions[0], sum);
+  BOOST_CHECK_EQUAL(definitions[1], mul);
+  BOOST_CHECK_EQUAL(definitions[2], f);
+  definitions.clear();
+  defs.add(f, definitions);
+  BOOST_CHECK_EQUAL(definitions.size(), 0);
+  BOOST_CHECK(!defs.is_defined(x));
+
+  // Defined terms are printed by name
+  std::stringstream name, body;
+  tm.term_of(f).to_stream_smt_without_let(name, tm, defs);
+  tm.term_of(f).to_stream_smt_without_let(body, tm, defs, false);
+  BOOST_CHECK_EQUAL(name.str(), "d_" + std::to_string(tm.id_of(f)));
+  BOOST_CHECK_EQUAL(body.str(), "(<= d_" + std::to_string(tm.id_of(sum)) + " d_" + std::to_string(tm.id_of(mul)) + ")");
+
+  // Definitions are scoped
+  defs.push();
+  term_ref g = tm.mk_term(TERM_AND, f, tm.mk_term(TERM_LEQ, x, y));
+  defs.add(g, definitions);
+  BOOST_CHECK_EQUAL(definitions.size(), 2);
+  BOOST_CHECK(defs.is_defined(g));
+  defs.pop();
+  BOOST_CHECK(!defs.is_defined(g));
+  BOOST_CHECK(defs.is_defined(f));
+  BOOST_CHECK_EQUAL(defs.size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(substitution) {
+
+  cout << set_tm(tm);
+
+  term_ref x = tm.mk_variable("x", tm.real_type());
+  term_ref y = tm.mk_variable("y", tm.real_type());
+  term_ref z = tm.mk_variable("z", tm.real_type());
+  term_ref f = tm.mk_term(TERM_LEQ, tm.mk_term(TERM_ADD, x, y), x);
+
+  // Lookups and insertion order
+  term_manager::substitution_map subst;
+  BOOST_CHECK(subst.find(x) == subst.end());
+  subst[x] = z;
+  BOOST_CHECK(subst.insert(std::make_pair(x, y)).second == false);
+  BOOST_CHECK_EQUAL(subst.find(x)->second, z);
+  BOOST_CHECK_EQUAL(subst.count(y), 0);
+  BOOST_CHECK_EQUAL(subst.begin()->first, x);
+
+  // Substitution caches all the subterms in the map
+  term_ref f_subst = tm.substitute(f, subst);
+  BOOST_CHECK_EQUAL(f_subst, tm.mk_term(TERM_LEQ, tm.mk_term(TERM_ADD, z, y), z));
+  BOOST_CHECK_EQUAL(subst.size(), 1);
+  BOOST_CHECK_EQUAL(tm.substitute_and_cache(f, subst), f_subst);
+  BOOST_CHECK_EQUAL(subst.size(), 5); // x, y, their type, the sum, and f
+  BOOST_CHECK_EQUAL(subst.find(y)->second, y);
+
+  // Many keys, with copies
+  std::vector<term_ref> vars;
+  term_manager::substitution_map big;
+  for (size_t i = 0; i < 1000; ++ i) {
+    vars.push_back(tm.mk_variable(tm.real_type()));
+    big[vars[i]] = vars[i / 2];
+  }
+  term_manager::substitution_map big_copy(big);
+  big.clear();
+  BOOST_CHECK(big.empty());
+  BOOST_CHECK_EQUAL(big_copy.size(), 1000);
+  for (size_t i = 0; i < 1000; ++ i) {
+    BOOST_CHECK_EQUAL(big_copy[vars[i]], vars[i / 2]);
+    BOOST_CHECK_EQUAL((big_copy.begin() + i)->first, vars[i]);
+  }
+  BOOST_CHECK_EQUAL(big_copy.size(), 1000);
+}
+
+BOOST_AUTO_TEST_CASE(memory_usage) {
+
+  utils::memory_report before;
+  tm.memory_usage(before);
+  BOOST_CHECK(before.get("expr::terms") > 0);
+  BOOST_CHECK(before.get("expr::term_pool") > 0);
+
+  // Many terms, some with payloads
+  term_ref sum = tm.mk_rational_constant(rational(0, 1));
+  for (size_t i = 0; i < 10000; ++ i) {
+    term_ref c = tm.mk_rational_constant(rational(i, 1));
+    sum = tm.mk_term(TERM_ADD, sum, tm.mk_term(TERM_MUL, c, tm.mk_variable(tm.real_type())));
+  }
+
+  utils::memory_report after;
+  tm.memory_usage(after);
+  BOOST_CHECK(after.get("expr::terms") > before.get("expr::terms"));
+  BOOST_CHECK(after.get("expr::payloads::CONST_RATIONAL") > 0);
+  BOOST_CHECK(after.total() > before.total());
+  BOOST_CHECK_EQUAL(after.get("none"), 0);
+
+  // The statistics follow the arenas
+  utils::stat_int* term_memory = static_cast<utils::stat_int*>(stats.register_stat("expr::term_manager_internal::term_memory"));
+  BOOST_CHECK_EQUAL((size_t) term_memory->get_value(), after.get("expr::terms") / 1024);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
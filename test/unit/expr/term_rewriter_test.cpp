@@ -0,0 +1,193 @@
+#include <boost/test/unit_test.hpp>
+
+#include "expr/term.h"
+#include "expr/term_manager.h"
+#include "expr/term_rewriter.h"
+#include "expr/model.h"
+
+#include "utils/statistics.h"
+
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+using namespace sally;
+using namespace expr;
+
+struct term_rewriter_test_fixture {
+
+  utils::statistics stats;
+  term_manager tm;
+  term_rewriter rewriter;
+
+public:
+  term_rewriter_test_fixture()
+  : tm(stats)
+  , rewriter(tm)
+  {
+    cout << set_tm(tm);
+  }
+
+  term_ref mk_rational(long p, unsigned long q) {
+    return tm.mk_rational_constant(rational(p, q));
+  }
+
+  /** Check that the rewritten term has the same value in random models */
+  void check_equivalent(term_ref t, const std::vector<term_ref>& vars) {
+    term_ref t_rewritten = rewriter.rewrite(t);
+    for (size_t k = 0; k < 20; ++ k) {
+      model m(tm, false);
+      for (size_t i = 0; i < vars.size(); ++ i) {
+        term_ref type = tm.type_of(vars[i]);
+        if (tm.is_boolean_type(type)) {
+          m.set_variable_value(vars[i], value(rand() % 2 == 0));
+        } else if (tm.is_bitvector_type(type)) {
+          m.set_variable_value(vars[i], value(bitvector(tm.get_bitvector_type_size(type), (long) rand())));
+        } else if (tm.is_integer_type(type)) {
+          m.set_variable_value(vars[i], value(rational((long) (rand() % 11) - 5, 1)));
+        } else {
+          m.set_variable_value(vars[i], value(rational((long) (rand() % 11) - 5, (rand() % 3) + 1)));
+        }
+      }
+      BOOST_CHECK(m.get_term_value(t) == m.get_term_value(t_rewritten));
+    }
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(term_rewriter_tests, term_rewriter_test_fixture)
+
+BOOST_AUTO_TEST_CASE(boolean) {
+
+  term_ref x = tm.mk_variable("x", tm.boolean_type());
+  term_ref y = tm.mk_variable("y", tm.boolean_type());
+  term_ref t = tm.mk_boolean_constant(true);
+  term_ref f = tm.mk_boolean_constant(false);
+
+  std::vector<term_ref> and_children;
+  and_children.push_back(x);
+  and_children.push_back(t);
+  and_children.push_back(x);
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_AND, and_children)), x);
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_OR, x, tm.mk_term(TERM_NOT, x))), t);
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_NOT, tm.mk_term(TERM_NOT, y))), y);
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_ITE, tm.mk_term(TERM_NOT, f), x, y)), x);
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_IMPLIES, x, f)), tm.mk_term(TERM_NOT, x));
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_EQ, tm.mk_term(TERM_XOR, x, x), f)), t);
+
+  // Nested and is flattened
+  term_ref nested = tm.mk_term(TERM_AND, x, tm.mk_term(TERM_AND, y, t));
+  BOOST_CHECK_EQUAL(rewriter.rewrite(nested), tm.mk_term(TERM_AND, x, y));
+}
+
+BOOST_AUTO_TEST_CASE(arithmetic) {
+
+  term_ref x = tm.mk_variable("x", tm.real_type());
+  term_ref y = tm.mk_variable("y", tm.real_type());
+  term_ref n = tm.mk_variable("n", tm.integer_type());
+  term_ref one = mk_rational(1, 1);
+
+  // (x + 1) + (x - 1) = 2*x
+  term_ref sum = tm.mk_term(TERM_ADD, tm.mk_term(TERM_ADD, x, one), tm.mk_term(TERM_SUB, x, one));
+  BOOST_CHECK_EQUAL(rewriter.rewrite(sum), tm.mk_term(TERM_MUL, mk_rational(2, 1), x));
+
+  // x + 1 <= y + 1 is x <= y
+  term_ref leq = tm.mk_term(TERM_LEQ, tm.mk_term(TERM_ADD, x, one), tm.mk_term(TERM_ADD, y, one));
+  BOOST_CHECK_EQUAL(rewriter.rewrite(leq), tm.mk_term(TERM_LEQ, x, y));
+
+  // 2*x >= 2*y is the same atom
+  term_ref geq = tm.mk_term(TERM_GEQ, tm.mk_term(TERM_MUL, mk_rational(2, 1), y), tm.mk_term(TERM_MUL, mk_rational(2, 1), x));
+  BOOST_CHECK_EQUAL(rewriter.rewrite(geq), rewriter.rewrite(leq));
+
+  // Integers: 2*n < 5 is n <= 2, 2*n = 3 is false
+  term_ref two_n = tm.mk_term(TERM_MUL, mk_rational(2, 1), n);
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_LT, two_n, mk_rational(5, 1))), tm.mk_term(TERM_LEQ, n, mk_rational(2, 1)));
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_EQ, two_n, mk_rational(3, 1))), tm.mk_boolean_constant(false));
+
+  // Constant atoms
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_LT, mk_rational(1, 2), one)), tm.mk_boolean_constant(true));
+
+  // Equivalence on random models
+  std::vector<term_ref> vars;
+  vars.push_back(x);
+  vars.push_back(y);
+  vars.push_back(n);
+  term_ref half_x = tm.mk_term(TERM_DIV, x, mk_rational(2, 1));
+  term_ref f1 = tm.mk_term(TERM_GT, tm.mk_term(TERM_SUB, half_x, y), tm.mk_term(TERM_MUL, mk_rational(-3, 1), n));
+  term_ref f2 = tm.mk_term(TERM_EQ, tm.mk_term(TERM_ADD, n, n), tm.mk_term(TERM_SUB, mk_rational(4, 1), n));
+  term_ref f3 = tm.mk_term(TERM_GEQ, tm.mk_term(TERM_SUB, two_n), mk_rational(-3, 1));
+  check_equivalent(f1, vars);
+  check_equivalent(f2, vars);
+  check_equivalent(f3, vars);
+  check_equivalent(tm.mk_term(TERM_ITE, f1, sum, tm.mk_term(TERM_MUL, x, y)), vars);
+}
+
+BOOST_AUTO_TEST_CASE(arithmetic_negative) {
+
+  term_ref x = tm.mk_variable("x", tm.real_type());
+  term_ref y = tm.mk_variable("y", tm.real_type());
+  term_ref n = tm.mk_variable("n", tm.integer_type());
+
+  // Single variable bounds stay as they are
+  term_ref x_geq = tm.mk_term(TERM_GEQ, x, mk_rational(5, 1));
+  BOOST_CHECK_EQUAL(rewriter.rewrite(x_geq), x_geq);
+  term_ref y_gt = tm.mk_term(TERM_GT, y, mk_rational(5, 1));
+  BOOST_CHECK_EQUAL(rewriter.rewrite(y_gt), y_gt);
+
+  // -x <= 3 is x >= -3
+  term_ref neg_leq = tm.mk_term(TERM_LEQ, tm.mk_term(TERM_SUB, x), mk_rational(3, 1));
+  BOOST_CHECK_EQUAL(rewriter.rewrite(neg_leq), tm.mk_term(TERM_GEQ, x, mk_rational(-3, 1)));
+
+  // Integers: n > 2 is n >= 3
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_GT, n, mk_rational(2, 1))), tm.mk_term(TERM_GEQ, n, mk_rational(3, 1)));
+
+  // Equivalence on random models, all coefficients negative
+  std::vector<term_ref> vars;
+  vars.push_back(x);
+  vars.push_back(y);
+  vars.push_back(n);
+  term_ref neg_sum = tm.mk_term(TERM_SUB, tm.mk_term(TERM_MUL, mk_rational(-2, 1), x), tm.mk_term(TERM_MUL, mk_rational(3, 1), y));
+  check_equivalent(tm.mk_term(TERM_GEQ, x, mk_rational(1, 1)), vars);
+  check_equivalent(tm.mk_term(TERM_GT, y, mk_rational(-1, 2)), vars);
+  check_equivalent(tm.mk_term(TERM_LEQ, tm.mk_term(TERM_SUB, x), mk_rational(2, 1)), vars);
+  check_equivalent(tm.mk_term(TERM_LEQ, neg_sum, mk_rational(1, 1)), vars);
+  check_equivalent(tm.mk_term(TERM_LT, neg_sum, mk_rational(-3, 2)), vars);
+  check_equivalent(tm.mk_term(TERM_LT, tm.mk_term(TERM_MUL, mk_rational(-3, 1), n), mk_rational(4, 1)), vars);
+  check_equivalent(tm.mk_term(TERM_GEQ, n, mk_rational(2, 1)), vars);
+}
+
+BOOST_AUTO_TEST_CASE(bitvectors) {
+
+  term_ref x = tm.mk_variable("x", tm.bitvector_type(8));
+  term_ref y = tm.mk_variable("y", tm.bitvector_type(8));
+  term_ref zero = tm.mk_bitvector_constant(bitvector(8));
+
+  // Neutral and absorbing elements
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_BV_ADD, x, zero)), x);
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_BV_AND, x, zero)), zero);
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_BV_XOR, y, y)), zero);
+
+  // Constant folding
+  term_ref c = tm.mk_term(TERM_BV_MUL, tm.mk_bitvector_constant(bitvector(8, 20)), tm.mk_bitvector_constant(bitvector(8, 13)));
+  BOOST_CHECK_EQUAL(rewriter.rewrite(c), tm.mk_bitvector_constant(bitvector(8, 4)));
+
+  // Extract of concat, extract of extract
+  term_ref xy = tm.mk_term(TERM_BV_CONCAT, x, y);
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_bitvector_extract(xy, bitvector_extract(7, 0))), y);
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_bitvector_extract(xy, bitvector_extract(14, 9))), tm.mk_bitvector_extract(x, bitvector_extract(6, 1)));
+  term_ref x_high = tm.mk_bitvector_extract(x, bitvector_extract(7, 2));
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_bitvector_extract(x_high, bitvector_extract(3, 1))), tm.mk_bitvector_extract(x, bitvector_extract(5, 3)));
+
+  // Fusion of adjacent extracts
+  term_ref x_low = tm.mk_bitvector_extract(x, bitvector_extract(1, 0));
+  BOOST_CHECK_EQUAL(rewriter.rewrite(tm.mk_term(TERM_BV_CONCAT, x_high, x_low)), x);
+
+  // Equivalence on random models
+  std::vector<term_ref> vars;
+  vars.push_back(x);
+  vars.push_back(y);
+  term_ref f = tm.mk_term(TERM_BV_ULT, tm.mk_term(TERM_BV_SUB, tm.mk_term(TERM_BV_OR, x, zero), y),
+      tm.mk_bitvector_extract(tm.mk_term(TERM_BV_CONCAT, y, tm.mk_term(TERM_BV_NOT, tm.mk_term(TERM_BV_NOT, x))), bitvector_extract(11, 4)));
+  check_equivalent(f, vars);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,115 @@
+#include <boost/test/unit_test.hpp>
+
+#include "expr/term.h"
+#include "expr/term_manager.h"
+#include "expr/term_traversal.h"
+
+#include "utils/statistics.h"
+
+#include <iostream>
+#include <algorithm>
+
+using namespace std;
+using namespace sally;
+using namespace expr;
+
+/** Records the visit order, doesn't go into variables */
+struct order_visitor {
+
+  term_manager& tm;
+  std::vector<term_ref> visited;
+
+  order_visitor(term_manager& tm): tm(tm) {}
+
+  visitor_match_result match(term_ref t) {
+    if (tm.term_of(t).op() == VARIABLE) {
+      return VISIT_AND_BREAK;
+    }
+    return VISIT_AND_CONTINUE;
+  }
+
+  void visit(term_ref t) {
+    visited.push_back(t);
+  }
+
+  /** Position of t in the visit order (size if not visited) */
+  size_t position(term_ref t) const {
+    return std::find(visited.begin(), visited.end(), t) - visited.begin();
+  }
+};
+
+struct term_traversal_test_fixture {
+
+  utils::statistics stats;
+  term_manager tm;
+
+public:
+  term_traversal_test_fixture()
+  : tm(stats)
+  {
+    cout << set_tm(tm);
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(term_traversal_tests, term_traversal_test_fixture)
+
+BOOST_AUTO_TEST_CASE(post_order) {
+
+  term_ref x = tm.mk_variable("x", tm.real_type());
+  term_ref y = tm.mk_variable("y", tm.real_type());
+  term_ref sum = tm.mk_term(TERM_ADD, x, y);
+  term_ref f = tm.mk_term(TERM_LEQ, sum, tm.mk_term(TERM_MUL, sum, x));
+
+  order_visitor v(tm);
+  term_traversal traversal(tm);
+  traversal.run(v, f);
+
+  // Each term once, children first, types of variables not visited
+  BOOST_CHECK_EQUAL(v.visited.size(), 5);
+  BOOST_CHECK_EQUAL(v.visited.back(), f);
+  BOOST_CHECK(v.position(x) < v.position(sum));
+  BOOST_CHECK(v.position(sum) < v.position(tm.mk_term(TERM_MUL, sum, x)));
+  BOOST_CHECK(v.position(tm.real_type()) == v.visited.size());
+
+  // Running again visits everything again
+  v.visited.clear();
+  traversal.run(v, f);
+  BOOST_CHECK_EQUAL(v.visited.size(), 5);
+
+  // Several roots share the visited subterms
+  std::vector<term_ref> roots;
+  roots.push_back(sum);
+  roots.push_back(f);
+  roots.push_back(x);
+  v.visited.clear();
+  traversal.run(v, roots.begin(), roots.end());
+  BOOST_CHECK_EQUAL(v.visited.size(), 5);
+  BOOST_CHECK(traversal.is_reached(f));
+  BOOST_CHECK(!traversal.is_reached(tm.real_type()));
+}
+
+BOOST_AUTO_TEST_CASE(nested) {
+
+  // The traversal marks are independent when traversals are nested
+  term_ref x = tm.mk_variable("x", tm.boolean_type());
+  term_ref f = tm.mk_term(TERM_AND, x, tm.mk_term(TERM_NOT, x));
+
+  order_visitor v1(tm);
+  term_traversal traversal1(tm);
+  traversal1.run(v1, f);
+  {
+    order_visitor v2(tm);
+    term_traversal traversal2(tm);
+    traversal2.run(v2, tm.mk_term(TERM_OR, x, f));
+    BOOST_CHECK_EQUAL(v2.visited.size(), 4);
+  }
+  BOOST_CHECK(traversal1.is_reached(f));
+  BOOST_CHECK(!traversal1.is_reached(tm.mk_term(TERM_OR, x, f)));
+
+  // Subterm collection takes its own marks too
+  std::vector<term_ref> subterms;
+  tm.get_subterms(f, subterms);
+  BOOST_CHECK_EQUAL(subterms.size(), 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,155 @@
+#include <boost/test/unit_test.hpp>
+
+#include "expr/value.h"
+#include "expr/rational.h"
+#include "expr/bitvector.h"
+#include "utils/exception.h"
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <limits>
+
+using namespace std;
+using namespace sally;
+using namespace expr;
+
+/** Check that q has the value of the GMP reference */
+static void check_rational(const rational& q, const mpq_class& expected) {
+  BOOST_CHECK(q.mpq() == expected);
+  BOOST_CHECK(q == rational(expected));
+  BOOST_CHECK_EQUAL(q.hash(), rational(expected).hash());
+  BOOST_CHECK_EQUAL(q.sgn(), sgn(expected));
+  BOOST_CHECK_EQUAL(q.is_integer(), expected.get_den() == 1);
+}
+
+BOOST_AUTO_TEST_SUITE(value_tests)
+
+BOOST_AUTO_TEST_CASE(rational_arithmetic) {
+
+  long big = numeric_limits<long>::max();
+  long small = numeric_limits<long>::min();
+
+  // Corner cases, including the ones overflowing 64 bits
+  rational qs[] = {
+      rational(), rational(1, 1), rational(-1, 1), rational(1, 2), rational(-7, 3),
+      rational(big, 1), rational(small, 1), rational(1, big), rational(big, big - 1),
+      rational(mpq_class(mpz_class(big) * 4, 3)), rational(mpq_class(1, mpz_class(big) * mpz_class(big)))
+  };
+  size_t n = sizeof(qs) / sizeof(rational);
+
+  for (size_t i = 0; i < n; ++ i) {
+    mpq_class a = qs[i].mpq();
+    check_rational(qs[i].negate(), -a);
+    mpz_class floor_a, ceiling_a;
+    mpz_fdiv_q(floor_a.get_mpz_t(), a.get_num_mpz_t(), a.get_den_mpz_t());
+    mpz_cdiv_q(ceiling_a.get_mpz_t(), a.get_num_mpz_t(), a.get_den_mpz_t());
+    check_rational(qs[i].floor(), mpq_class(floor_a));
+    check_rational(qs[i].ceiling(), mpq_class(ceiling_a));
+    if (a != 0) {
+      check_rational(qs[i].invert(), 1 / a);
+    }
+    for (size_t j = 0; j < n; ++ j) {
+      mpq_class b = qs[j].mpq();
+      check_rational(qs[i] + qs[j], a + b);
+      check_rational(qs[i] - qs[j], a - b);
+      check_rational(qs[i] * qs[j], a * b);
+      if (b != 0) {
+        check_rational(qs[i] / qs[j], a / b);
+      }
+      BOOST_CHECK_EQUAL(qs[i] < qs[j], a < b);
+      BOOST_CHECK_EQUAL(qs[i] <= qs[j], a <= b);
+      BOOST_CHECK_EQUAL(qs[i] == qs[j], a == b);
+    }
+  }
+
+  // Rounding of negative non-integers goes down for floor and up for ceiling
+  check_rational(rational(-7, 3).floor(), mpq_class(-3));
+  check_rational(rational(-7, 3).ceiling(), mpq_class(-2));
+  check_rational(rational(7, 3).floor(), mpq_class(2));
+  check_rational(rational(7, 3).ceiling(), mpq_class(3));
+  check_rational(rational(mpq_class(-mpz_class(big) * 4, 3)).floor(), mpq_class(mpz_class(-(mpz_class(big) * 4 + 2) / 3)));
+  check_rational(rational(mpq_class(-mpz_class(big) * 4, 3)).ceiling(), mpq_class(mpz_class(-(mpz_class(big) * 4 - 1) / 3)));
+
+  // Overflow and back
+  rational q(big, 1);
+  q += rational(1, 1);
+  check_rational(q, mpq_class(mpz_class(big) + 1));
+  q -= rational(2, 1);
+  check_rational(q, mpq_class(mpz_class(big) - 1));
+
+  // Output is the same in both representations
+  stringstream small_out, big_out;
+  small_out << rational(-7, 3);
+  big_out << (rational(mpq_class(mpz_class(big) * 7, 3)) / rational(-big, 1));
+  BOOST_CHECK_EQUAL(small_out.str(), big_out.str());
+}
+
+BOOST_AUTO_TEST_CASE(bitvector_words) {
+
+  srand(0);
+
+  // Words against the wide representation, through concatenation with 0
+  size_t sizes[] = { 1, 7, 32, 63, 64 };
+  for (size_t s = 0; s < 5; ++ s) {
+    size_t size = sizes[s];
+    for (size_t k = 0; k < 50; ++ k) {
+      bitvector a(size, (long) rand() * rand());
+      bitvector b(size, (long) rand() % (size + 2));
+      bitvector zero(65 - size);
+      bitvector a_wide = zero.concat(a), b_wide = zero.concat(b);
+      BOOST_CHECK(a.is_word() && !a_wide.is_word());
+      BOOST_CHECK(a.add(b) == a_wide.add(b_wide).extract(0, size - 1));
+      BOOST_CHECK(a.mul(b) == a_wide.mul(b_wide).extract(0, size - 1));
+      BOOST_CHECK(a.sub(b) == a_wide.sub(b_wide).extract(0, size - 1));
+      BOOST_CHECK(a.udiv(b) == a_wide.udiv(b_wide).extract(0, size - 1));
+      BOOST_CHECK(a.urem(b) == a_wide.urem(b_wide).extract(0, size - 1));
+      BOOST_CHECK(a.shl(b) == a_wide.shl(b_wide).extract(0, size - 1));
+      BOOST_CHECK(a.lshr(b) == a_wide.lshr(b_wide).extract(0, size - 1));
+      BOOST_CHECK(a.bvnot() == a_wide.bvnot().extract(0, size - 1));
+      BOOST_CHECK(a.mpz() == a_wide.mpz());
+      BOOST_CHECK_EQUAL(a.ult(b), a_wide.ult(b_wide));
+      BOOST_CHECK(a.get_signed() == (a.msb() ? integer(a.mpz() - (mpz_class(1) << size)) : integer(a.mpz())));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(value_semantics) {
+
+  value v(rational(mpq_class(mpz_class(numeric_limits<long>::max()) * 3, 2)));
+  value w(v);
+  BOOST_CHECK(v == w);
+
+  // Move leaves the source destructible and assignable
+  value moved(std::move(w));
+  BOOST_CHECK(moved == v);
+  w = value(bitvector(8, 5));
+  BOOST_CHECK(w.is_bitvector());
+  w = moved;
+  BOOST_CHECK(w == v);
+  w = value(true);
+  BOOST_CHECK(w.is_bool() && w.get_bool());
+  w = value();
+  BOOST_CHECK(w.is_null());
+}
+
+BOOST_AUTO_TEST_CASE(value_types) {
+
+  value q(rational(1, 2));
+  value b(true);
+  value bv(bitvector(8, 5));
+
+  // Reading another member than the one of the type is an error
+  BOOST_CHECK_THROW(b.get_rational(), sally::exception);
+  BOOST_CHECK_THROW(bv.get_rational(), sally::exception);
+  BOOST_CHECK_THROW(q.get_bitvector(), sally::exception);
+  BOOST_CHECK_THROW(q.get_bool(), sally::exception);
+  BOOST_CHECK_EQUAL(q.get_rational(), rational(1, 2));
+
+  // Only arithmetic values of different types can be combined
+  BOOST_CHECK_THROW(b + bv, sally::exception);
+  BOOST_CHECK_THROW(q < b, sally::exception);
+  BOOST_CHECK_THROW(bv.cmp(q), sally::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,226 @@
+#include <boost/test/unit_test.hpp>
+
+#include "expr/term.h"
+#include "expr/term_manager.h"
+
+#include "smt/factory.h"
+
+#include "utils/options.h"
+#include "utils/statistics.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+
+
+using namespace std;
+using namespace sally;
+using namespace expr;
+using namespace smt;
+
+struct term_manager_with_bitblast_test_fixture {
+
+  utils::statistics stats;
+  term_manager tm;
+  solver* bitblast;
+  options opts;
+
+public:
+
+  term_manager_with_bitblast_test_fixture()
+  : tm(stats)
+  {
+    bitblast = factory::mk_solver("bitblast", tm, opts, stats);
+    cout << set_tm(tm);
+    cerr << set_tm(tm);
+  }
+
+  ~term_manager_with_bitblast_test_fixture() {
+    delete bitblast;
+  }
+
+  /** Evaluate the operation on constants with expr::bitvector */
+  bitvector evaluate(term_op op, const bitvector& a, const bitvector& b) {
+    switch (op) {
+    case TERM_BV_ADD: return a.add(b);
+    case TERM_BV_SUB: return a.sub(b);
+    case TERM_BV_MUL: return a.mul(b);
+    case TERM_BV_UDIV: return a.udiv(b);
+    case TERM_BV_SDIV: return a.sdiv(b);
+    case TERM_BV_UREM: return a.urem(b);
+    case TERM_BV_SREM: return a.srem(b);
+    case TERM_BV_SMOD: return a.smod(b);
+    case TERM_BV_SHL: return a.shl(b);
+    case TERM_BV_LSHR: return a.lshr(b);
+    case TERM_BV_ASHR: return a.ashr(b);
+    case TERM_BV_XOR: return a.bvxor(b);
+    case TERM_BV_AND: return a.bvand(b);
+    case TERM_BV_OR: return a.bvor(b);
+    default:
+      assert(false);
+    }
+    return a;
+  }
+
+  bool evaluate_predicate(term_op op, const bitvector& a, const bitvector& b) {
+    switch (op) {
+    case TERM_BV_ULEQ: return a.uleq(b);
+    case TERM_BV_SLEQ: return a.sleq(b);
+    case TERM_BV_ULT: return a.ult(b);
+    case TERM_BV_SLT: return a.slt(b);
+    case TERM_BV_UGEQ: return a.ugeq(b);
+    case TERM_BV_SGEQ: return a.sgeq(b);
+    case TERM_BV_UGT: return a.ugt(b);
+    case TERM_BV_SGT: return a.sgt(b);
+    default:
+      assert(false);
+    }
+    return false;
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(smt_tests, term_manager_with_bitblast_test_fixture)
+
+BOOST_AUTO_TEST_CASE(bitblast_basic_asserts) {
+
+  term_ref x = tm.mk_variable("x", tm.bitvector_type(8));
+  term_ref y = tm.mk_variable("y", tm.bitvector_type(8));
+  term_ref b = tm.mk_variable("b", tm.boolean_type());
+  term_ref three = tm.mk_bitvector_constant(bitvector(8, 3));
+
+  // b and x + y = 3 and x < y
+  term_ref sum = tm.mk_term(TERM_BV_ADD, x, y);
+  term_ref eq = tm.mk_term(TERM_EQ, sum, three);
+  term_ref lt = tm.mk_term(TERM_BV_ULT, x, y);
+
+  bitblast->add(b, smt::solver::CLASS_A);
+  bitblast->add(eq, smt::solver::CLASS_A);
+  bitblast->add(lt, smt::solver::CLASS_A);
+
+  solver::result result = bitblast->check();
+  cout << "Check result: " << result << endl;
+  BOOST_CHECK_EQUAL(result, solver::SAT);
+
+  expr::model::ref m = bitblast->get_model();
+  cout << "Model: " << *m << endl;
+  BOOST_CHECK(m->is_true(b));
+  BOOST_CHECK(m->is_true(eq));
+  BOOST_CHECK(m->is_true(lt));
+
+  // Not b makes it unsat, but only with b
+  bitblast->push();
+  term_ref not_b = tm.mk_term(TERM_NOT, b);
+  bitblast->add(not_b, smt::solver::CLASS_A);
+  result = bitblast->check();
+  cout << "Check result: " << result << endl;
+  BOOST_CHECK_EQUAL(result, solver::UNSAT);
+
+  std::vector<term_ref> core;
+  bitblast->get_unsat_core(core);
+  BOOST_CHECK_EQUAL(core.size(), 2);
+  BOOST_CHECK(std::find(core.begin(), core.end(), b) != core.end());
+  BOOST_CHECK(std::find(core.begin(), core.end(), not_b) != core.end());
+  bitblast->pop();
+
+  // Back to sat
+  result = bitblast->check();
+  BOOST_CHECK_EQUAL(result, solver::SAT);
+
+  // x = y is unsat with x < y
+  bitblast->add(tm.mk_term(TERM_EQ, x, y), smt::solver::CLASS_A);
+  result = bitblast->check();
+  BOOST_CHECK_EQUAL(result, solver::UNSAT);
+}
+
+BOOST_AUTO_TEST_CASE(bitblast_operations) {
+
+  term_op ops[] = {
+      TERM_BV_ADD, TERM_BV_SUB, TERM_BV_MUL, TERM_BV_UDIV, TERM_BV_SDIV,
+      TERM_BV_UREM, TERM_BV_SREM, TERM_BV_SMOD, TERM_BV_SHL, TERM_BV_LSHR,
+      TERM_BV_ASHR, TERM_BV_XOR, TERM_BV_AND, TERM_BV_OR
+  };
+  size_t ops_size = sizeof(ops) / sizeof(term_op);
+
+  term_op predicates[] = {
+      TERM_BV_ULEQ, TERM_BV_SLEQ, TERM_BV_ULT, TERM_BV_SLT,
+      TERM_BV_UGEQ, TERM_BV_SGEQ, TERM_BV_UGT, TERM_BV_SGT
+  };
+  size_t predicates_size = sizeof(predicates) / sizeof(term_op);
+
+  size_t sizes[] = { 1, 3, 8 };
+
+  srand(0);
+
+  for (size_t s = 0; s < 3; ++ s) {
+    size_t size = sizes[s];
+    term_ref x = tm.mk_variable(tm.bitvector_type(size));
+    term_ref y = tm.mk_variable(tm.bitvector_type(size));
+    for (size_t k = 0; k < 20; ++ k) {
+      // Some values, including 0 for division
+      bitvector a(size, k == 0 ? 0 : rand() % (1 << size));
+      bitvector b(size, k == 1 ? 0 : rand() % (1 << size));
+      bitblast->push();
+      bitblast->add(tm.mk_term(TERM_EQ, x, tm.mk_bitvector_constant(a)), smt::solver::CLASS_A);
+      bitblast->add(tm.mk_term(TERM_EQ, y, tm.mk_bitvector_constant(b)), smt::solver::CLASS_A);
+      BOOST_CHECK_EQUAL(bitblast->check(), solver::SAT);
+      expr::model::ref m = bitblast->get_model();
+      for (size_t i = 0; i < ops_size; ++ i) {
+        term_ref t = tm.mk_term(ops[i], x, y);
+        bitblast->push();
+        term_ref z = tm.mk_variable(tm.bitvector_type(size));
+        bitblast->add(tm.mk_term(TERM_EQ, z, t), smt::solver::CLASS_A);
+        BOOST_CHECK_EQUAL(bitblast->check(), solver::SAT);
+        bitvector expected = evaluate(ops[i], a, b);
+        bitvector actual = bitblast->get_model()->get_variable_value(z).get_bitvector();
+        if (!(expected == actual)) {
+          cout << ops[i] << "(" << a << ", " << b << "): expected " << expected << ", got " << actual << endl;
+        }
+        BOOST_CHECK(expected == actual);
+        bitblast->pop();
+      }
+      for (size_t i = 0; i < predicates_size; ++ i) {
+        term_ref t = tm.mk_term(predicates[i], x, y);
+        bitblast->push();
+        bitblast->add(t, smt::solver::CLASS_A);
+        solver::result expected = evaluate_predicate(predicates[i], a, b) ? solver::SAT : solver::UNSAT;
+        BOOST_CHECK_EQUAL(bitblast->check(), expected);
+        bitblast->pop();
+      }
+      bitblast->pop();
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(bitblast_search) {
+
+  // Factor 143 = 11 * 13 with 8-bit factors (no overflow)
+  term_ref x = tm.mk_variable("x", tm.bitvector_type(16));
+  term_ref y = tm.mk_variable("y", tm.bitvector_type(16));
+  term_ref one = tm.mk_bitvector_constant(bitvector(16, 1));
+  term_ref max = tm.mk_bitvector_constant(bitvector(16, 255));
+  term_ref n = tm.mk_bitvector_constant(bitvector(16, 143));
+
+  term_ref mul = tm.mk_term(TERM_BV_MUL, x, y);
+  bitblast->add(tm.mk_term(TERM_BV_UGT, x, one), smt::solver::CLASS_A);
+  bitblast->add(tm.mk_term(TERM_BV_UGT, y, one), smt::solver::CLASS_A);
+  bitblast->add(tm.mk_term(TERM_BV_ULEQ, x, max), smt::solver::CLASS_A);
+  bitblast->add(tm.mk_term(TERM_BV_ULEQ, y, max), smt::solver::CLASS_A);
+  bitblast->add(tm.mk_term(TERM_BV_ULEQ, x, y), smt::solver::CLASS_A);
+
+  bitblast->push();
+  bitblast->add(tm.mk_term(TERM_EQ, mul, n), smt::solver::CLASS_A);
+  BOOST_CHECK_EQUAL(bitblast->check(), solver::SAT);
+  expr::model::ref m = bitblast->get_model();
+  cout << "Model: " << *m << endl;
+  BOOST_CHECK(m->get_variable_value(x).get_bitvector() == bitvector(16, 11));
+  BOOST_CHECK(m->get_variable_value(y).get_bitvector() == bitvector(16, 13));
+  bitblast->pop();
+
+  // 251 is prime
+  term_ref p = tm.mk_bitvector_constant(bitvector(16, 251));
+  bitblast->add(tm.mk_term(TERM_EQ, mul, p), smt::solver::CLASS_A);
+  BOOST_CHECK_EQUAL(bitblast->check(), solver::UNSAT);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
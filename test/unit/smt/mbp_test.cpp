@@ -0,0 +1,209 @@
+#include <boost/test/unit_test.hpp>
+
+#include "expr/term.h"
+#include "expr/term_manager.h"
+#include "expr/model.h"
+
+#include "smt/factory.h"
+#include "smt/mbp/model_based_projection.h"
+
+#include "utils/options.h"
+#include "utils/statistics.h"
+
+#include <iostream>
+#include <algorithm>
+
+
+using namespace std;
+using namespace sally;
+using namespace expr;
+using namespace smt;
+
+struct term_manager_with_mbp_test_fixture {
+
+  utils::statistics stats;
+  term_manager tm;
+  model_based_projection mbp;
+  options opts;
+
+public:
+
+  term_manager_with_mbp_test_fixture()
+  : tm(stats)
+  , mbp(tm, stats)
+  {
+    cout << set_tm(tm);
+    cerr << set_tm(tm);
+  }
+
+  /** Project and check that the result is true in the model, and without vars */
+  void project(const std::vector<term_ref>& F, const std::set<term_ref>& vars, model::ref m, std::vector<term_ref>& G) {
+    mbp.project(F, vars, m, G);
+    cout << "Projection:" << endl;
+    for (size_t i = 0; i < G.size(); ++ i) {
+      cout << G[i] << endl;
+      BOOST_CHECK(m->is_true(G[i]));
+      std::set<term_ref> G_vars;
+      tm.get_variables(G[i], G_vars);
+      std::set<term_ref>::const_iterator it = vars.begin();
+      for (; it != vars.end(); ++ it) {
+        BOOST_CHECK(G_vars.count(*it) == 0);
+      }
+    }
+  }
+
+  bool contains(const std::vector<term_ref>& G, term_ref f) {
+    return std::find(G.begin(), G.end(), f) != G.end();
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE(smt_tests, term_manager_with_mbp_test_fixture)
+
+BOOST_AUTO_TEST_CASE(mbp_real) {
+
+  term_ref x = tm.mk_variable("x", tm.real_type());
+  term_ref y = tm.mk_variable("y", tm.real_type());
+  term_ref z = tm.mk_variable("z", tm.real_type());
+  term_ref one = tm.mk_rational_constant(rational(1, 1));
+  term_ref ten = tm.mk_rational_constant(rational(10, 1));
+
+  model::ref m = new model(tm, false);
+  m->set_variable_value(x, value(rational(0, 1)));
+  m->set_variable_value(y, value(rational(1, 1)));
+  m->set_variable_value(z, value(rational(2, 1)));
+
+  std::set<term_ref> vars;
+  vars.insert(y);
+
+  // x < y < z: projection is x < z
+  std::vector<term_ref> F, G;
+  F.push_back(tm.mk_term(TERM_LT, x, y));
+  F.push_back(tm.mk_term(TERM_LT, y, z));
+  project(F, vars, m, G);
+  BOOST_CHECK_EQUAL(G.size(), 1);
+  BOOST_CHECK(contains(G, tm.mk_term(TERM_LT, x, z)));
+
+  // x < y, y < z, y != 1/2, y <= 10: disequality is a bound in the model
+  F.push_back(tm.mk_term(TERM_NOT, tm.mk_term(TERM_EQ, y, tm.mk_rational_constant(rational(1, 2)))));
+  F.push_back(tm.mk_term(TERM_LEQ, y, ten));
+  G.clear();
+  project(F, vars, m, G);
+  BOOST_CHECK(!G.empty());
+
+  // Equality in the model: (y = x + 1 or y > 10) and y < z
+  F.clear();
+  F.push_back(tm.mk_term(TERM_OR, tm.mk_term(TERM_EQ, y, tm.mk_term(TERM_ADD, x, one)), tm.mk_term(TERM_GT, y, ten)));
+  F.push_back(tm.mk_term(TERM_LT, y, z));
+  G.clear();
+  project(F, vars, m, G);
+  BOOST_CHECK_EQUAL(G.size(), 1);
+
+  // Non-linear, falls back to the value of y
+  F.clear();
+  F.push_back(tm.mk_term(TERM_LT, tm.mk_term(TERM_MUL, x, y), z));
+  G.clear();
+  project(F, vars, m, G);
+  BOOST_CHECK_EQUAL(G.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(mbp_integer) {
+
+  term_ref x = tm.mk_variable("x", tm.integer_type());
+  term_ref y = tm.mk_variable("y", tm.integer_type());
+  term_ref z = tm.mk_variable("z", tm.integer_type());
+  term_ref two = tm.mk_rational_constant(rational(2, 1));
+
+  model::ref m = new model(tm, false);
+  m->set_variable_value(x, value(rational(0, 1)));
+  m->set_variable_value(y, value(rational(3, 1)));
+  m->set_variable_value(z, value(rational(5, 1)));
+
+  std::set<term_ref> vars;
+  vars.insert(y);
+
+  // x <= y <= z: projection is x <= z
+  std::vector<term_ref> F, G;
+  F.push_back(tm.mk_term(TERM_LEQ, x, y));
+  F.push_back(tm.mk_term(TERM_LEQ, y, z));
+  project(F, vars, m, G);
+  BOOST_CHECK_EQUAL(G.size(), 1);
+  BOOST_CHECK(contains(G, tm.mk_term(TERM_LEQ, x, z)));
+
+  // x < y < z: projection is x + 2 <= z
+  F.clear();
+  F.push_back(tm.mk_term(TERM_LT, x, y));
+  F.push_back(tm.mk_term(TERM_LT, y, z));
+  G.clear();
+  project(F, vars, m, G);
+  BOOST_CHECK_EQUAL(G.size(), 1);
+  BOOST_CHECK(contains(G, tm.mk_term(TERM_LEQ, x, tm.mk_term(TERM_ADD, z, tm.mk_rational_constant(rational(-2, 1))))));
+
+  // 2*y <= z, x <= y: glb has unit coefficient, 2*x <= z
+  F.clear();
+  F.push_back(tm.mk_term(TERM_LEQ, tm.mk_term(TERM_MUL, two, y), tm.mk_term(TERM_ADD, z, tm.mk_rational_constant(rational(1, 1)))));
+  F.push_back(tm.mk_term(TERM_LEQ, x, y));
+  G.clear();
+  project(F, vars, m, G);
+  BOOST_CHECK_EQUAL(G.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(mbp_bitvector) {
+
+  term_ref x = tm.mk_variable("x", tm.bitvector_type(8));
+  term_ref y = tm.mk_variable("y", tm.bitvector_type(8));
+  term_ref b = tm.mk_variable("b", tm.boolean_type());
+  term_ref one = tm.mk_bitvector_constant(bitvector(8, 1));
+
+  model::ref m = new model(tm, false);
+  m->set_variable_value(x, value(bitvector(8, 3)));
+  m->set_variable_value(y, value(bitvector(8, 4)));
+  m->set_variable_value(b, value(true));
+
+  std::set<term_ref> vars;
+  vars.insert(y);
+  vars.insert(b);
+
+  // b and y = x + 1 and (ite b y x) < 10: projection is x + 1 < 10
+  std::vector<term_ref> F, G;
+  term_ref x_plus_one = tm.mk_term(TERM_BV_ADD, x, one);
+  F.push_back(b);
+  F.push_back(tm.mk_term(TERM_EQ, y, x_plus_one));
+  F.push_back(tm.mk_term(TERM_BV_ULT, tm.mk_term(TERM_ITE, b, y, x), tm.mk_bitvector_constant(bitvector(8, 10))));
+  project(F, vars, m, G);
+  BOOST_CHECK_EQUAL(G.size(), 1);
+  BOOST_CHECK(contains(G, tm.mk_term(TERM_BV_ULT, x_plus_one, tm.mk_bitvector_constant(bitvector(8, 10)))));
+}
+
+BOOST_AUTO_TEST_CASE(mbp_solver_generalize) {
+
+  // The bit-blaster doesn't generalize, so it gets the projection
+  solver* s = factory::mk_solver("bitblast", tm, opts, stats);
+  BOOST_CHECK(s->supports(solver::GENERALIZATION));
+
+  term_ref x = tm.mk_variable("x", tm.bitvector_type(8));
+  term_ref y = tm.mk_variable("y", tm.bitvector_type(8));
+  s->add_variable(x, solver::CLASS_A);
+  s->add_variable(y, solver::CLASS_B);
+
+  // x < 5 and y = 2*x and y > 4
+  term_ref two = tm.mk_bitvector_constant(bitvector(8, 2));
+  s->add(tm.mk_term(TERM_BV_ULT, x, tm.mk_bitvector_constant(bitvector(8, 5))), solver::CLASS_A);
+  s->add(tm.mk_term(TERM_EQ, y, tm.mk_term(TERM_BV_MUL, two, x)), solver::CLASS_B);
+  s->add(tm.mk_term(TERM_BV_UGT, y, tm.mk_bitvector_constant(bitvector(8, 4))), solver::CLASS_B);
+  BOOST_CHECK_EQUAL(s->check(), solver::SAT);
+
+  std::vector<term_ref> G;
+  s->generalize(solver::GENERALIZE_BACKWARD, G);
+  model::ref m = s->get_model();
+  for (size_t i = 0; i < G.size(); ++ i) {
+    cout << G[i] << endl;
+    BOOST_CHECK(m->is_true(G[i]));
+    std::set<term_ref> G_vars;
+    tm.get_variables(G[i], G_vars);
+    BOOST_CHECK(G_vars.count(y) == 0);
+  }
+
+  delete s;
+}
+
+BOOST_AUTO_TEST_SUITE_END()